@@ -0,0 +1,28 @@
+#-----------------------------------------------------------------
+# Build Tools
+#-----------------------------------------------------------------
+
+# Headless batch demo analyzer
+add_executable(etldemo ${DEMOTOOL_SRC})
+target_link_libraries(etldemo ${OS_LIBRARIES})
+
+set_target_properties(etldemo PROPERTIES FOLDER Tools)
+
+install(TARGETS etldemo RUNTIME DESTINATION "${INSTALL_DEFAULT_BINDIR}")
+
+# Connectionless packet load generator, for the network front-end
+add_executable(etlloadgen ${LOADGEN_SRC})
+target_link_libraries(etlloadgen ${OS_LIBRARIES})
+
+set_target_properties(etlloadgen PROPERTIES FOLDER Tools)
+
+install(TARGETS etlloadgen RUNTIME DESTINATION "${INSTALL_DEFAULT_BINDIR}")
+
+# Deterministic Pmove replay harness and benchmark, for server-side demos recorded with sv_demoUsercmds
+add_executable(etlpmove ${PMOVETOOL_SRC})
+target_compile_definitions(etlpmove PRIVATE GAMEDLL)
+target_link_libraries(etlpmove ${OS_LIBRARIES})
+
+set_target_properties(etlpmove PROPERTIES FOLDER Tools)
+
+install(TARGETS etlpmove RUNTIME DESTINATION "${INSTALL_DEFAULT_BINDIR}")
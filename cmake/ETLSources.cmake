@@ -175,3 +175,35 @@ FILE(GLOB IRC_CLIENT_FILES
 	"src/irc/htable.h"
 	"src/irc/irc_client.c"
 )
+
+FILE(GLOB DEMOTOOL_SRC
+	"src/tools/demo/*.c"
+	"src/tools/demo/*.h"
+	"src/qcommon/msg.c"
+	"src/qcommon/huffman.c"
+	"src/qcommon/q_shared.c"
+	"src/qcommon/q_math.c"
+)
+
+FILE(GLOB LOADGEN_SRC
+	"src/tools/loadgen/*.c"
+)
+
+FILE(GLOB PMOVETOOL_SRC
+	"src/tools/pmove/*.c"
+	"src/qcommon/cm_load.c"
+	"src/qcommon/cm_patch.c"
+	"src/qcommon/cm_polylib.c"
+	"src/qcommon/cm_test.c"
+	"src/qcommon/cm_trace.c"
+	"src/qcommon/md4.c"
+	"src/qcommon/msg.c"
+	"src/qcommon/huffman.c"
+	"src/qcommon/q_shared.c"
+	"src/qcommon/q_math.c"
+	"src/game/bg_animation.c"
+	"src/game/bg_classes.c"
+	"src/game/bg_misc.c"
+	"src/game/bg_pmove.c"
+	"src/game/bg_slidemove.c"
+)
@@ -95,6 +95,42 @@ public:
 	}
 };
 
+// class: obTraceRequest
+//		The arguments of one <IEngineInterface::TraceLine> in a <IEngineInterface::TraceLines> batch.
+class obTraceRequest
+{
+public:
+	// float: m_Start
+	//		Where the trace starts
+	float m_Start[3];
+	// float: m_End
+	//		Where the trace ends
+	float m_End[3];
+	// AABB: m_BBox
+	//		The box moved along the trace, if m_UseBBox
+	AABB m_BBox;
+	// obBool: m_UseBBox
+	//		Trace m_BBox instead of a line
+	obBool m_UseBBox;
+	// int: m_Mask
+	//		Trace mask, see <TraceMasks>
+	int m_Mask;
+	// int: m_User
+	//		Entity the trace ignores
+	int m_User;
+	// obBool: m_UsePVS
+	//		Don't trace if the end isn't in the PVS of the start
+	obBool m_UsePVS;
+
+	obTraceRequest() :
+		m_UseBBox(False),
+		m_Mask(0),
+		m_User(0),
+		m_UsePVS(False)
+	{
+	}
+};
+
 class obPlayerInfo
 {
 public:
@@ -410,6 +446,28 @@ public:
 	virtual ~IEngineInterface()
 	{
 	}
+
+	// Function: TraceLines
+	//		Performs _count <TraceLine>s in one call, _status may be null. Returns the number of Success.
+	//		Only call it when the game answers ET_MSG_TRACELINES, mods built before it lack this entry.
+	virtual int TraceLines(const obTraceRequest *_requests, obTraceResult *_results, obResult *_status, int _count)
+	{
+		int n = 0;
+		for (int i = 0; i < _count; ++i)
+		{
+			const obTraceRequest &r = _requests[i];
+			obResult             res = TraceLine(_results[i], r.m_Start, r.m_End, r.m_UseBBox ? &r.m_BBox : 0, r.m_Mask, r.m_User, r.m_UsePVS);
+			if (_status)
+			{
+				_status[i] = res;
+			}
+			if (res == Success)
+			{
+				++n;
+			}
+		}
+		return n;
+	}
 };
 
 class IEngineInterface71
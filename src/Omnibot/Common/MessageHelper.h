@@ -52,6 +52,16 @@ public:
 		return m_MessageId;
 	}
 
+	void *GetBlock() const
+	{
+		return m_pVoid;
+	}
+
+	obuint32 GetBlockSize() const
+	{
+		return m_BlockSize;
+	}
+
 	operator bool() const
 	{
 		return (m_MessageId != 0);
@@ -108,6 +108,7 @@ typedef enum eET_Msgs
 	ET_MSG_SETCVAR,
 	ET_MSG_GETCVAR,
 	ET_MSG_DISABLEBOTPUSH,
+	ET_MSG_TRACELINES,          // check if IEngineInterface::TraceLines is there
 
 	ET_MSG_END
 } ET_Msg;
@@ -242,6 +242,11 @@ struct ET_DisableBotPush
 	int m_Push;
 };
 
+struct ET_TraceLines
+{
+	int m_MaxBatch;             // traces done per engine call, more are split
+};
+
 #pragma pack(pop)
 
 #endif
@@ -395,6 +395,33 @@ rescan:
 		goto rescan;
 	}
 
+	if (!strcmp(cmd, "csp"))
+	{
+		static char splice[BIG_INFO_STRING];
+		int         index = atoi(Cmd_Argv(1));
+
+		if (index < 0 || index >= MAX_CONFIGSTRINGS)
+		{
+			Com_Error(ERR_DROP, "configstring < 0 or configstring >= MAX_CONFIGSTRINGS");
+		}
+
+		// the rest of the string is kept from the value we hold
+		if (!Com_SpliceString(splice, sizeof(splice) - 16, cl.gameState.stringData + cl.gameState.stringOffsets[index],
+		                      atoi(Cmd_Argv(2)), atoi(Cmd_Argv(3)), atoi(Cmd_Argv(4)), Cmd_Argv(5)))
+		{
+			// a demo may start after the update the splice was made against
+			if (clc.demoplaying)
+			{
+				return qfalse;
+			}
+			Com_Error(ERR_DROP, "CL_GetServerCommand: configstring %i splice doesn't match", index);
+		}
+
+		Com_sprintf(bigConfigString, BIG_INFO_STRING, "cs %i \"%s\"", index, splice);
+		s = bigConfigString;
+		goto rescan;
+	}
+
 	if (!strcmp(cmd, "cs"))
 	{
 		CL_ConfigstringModified();
@@ -1150,6 +1177,7 @@ void CL_InitCGame(void)
 	const char *info;
 	const char *mapname;
 	int        t1, t2;
+	hunkTag_t  oldTag;
 
 	t1 = Sys_Milliseconds();
 
@@ -1161,6 +1189,8 @@ void CL_InitCGame(void)
 	mapname = Info_ValueForKey(info, "mapname");
 	Com_sprintf(cl.mapname, sizeof(cl.mapname), "maps/%s.bsp", mapname);
 
+	oldTag = Hunk_SetTag(HUNK_TAG_GAME);
+
 	// load the dll
 	cgvm = VM_Create("cgame", qtrue, CL_CgameSystemCalls, VMI_NATIVE);
 	if (!cgvm)
@@ -1175,6 +1205,8 @@ void CL_InitCGame(void)
 	// bani - added clc.demoplaying, since some mods need this at init time, and drawactiveframe is too late for them
 	VM_Call(cgvm, CG_INIT, clc.serverMessageSequence, clc.lastExecutedServerCommand, clc.clientNum, clc.demoplaying, qtrue, (clc.demoplaying ? &dpi : 0), ETLEGACY_VERSION_INT);
 
+	Hunk_SetTag(oldTag);
+
 	// reset any CVAR_CHEAT cvars registered by cgame
 	if (!clc.demoplaying && !cl_connectedToCheatServer)
 	{
@@ -1189,6 +1221,9 @@ void CL_InitCGame(void)
 
 	Com_Printf("CL_InitCGame: %5.2f seconds\n", (t2 - t1) / 1000.0);
 
+	// mapname may have been overwritten by Info_ValueForKey calls during cgame init
+	Hunk_DumpStats(Info_ValueForKey(cl.gameState.stringData + cl.gameState.stringOffsets[CS_SERVERINFO], "mapname"));
+
 	// have the renderer touch all its images, so they are present
 	// on the card even if the driver does deferred loading
 	re.EndRegistration();
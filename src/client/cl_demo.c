@@ -90,13 +90,69 @@ typedef struct
 	int numSnaps;
 } rewindBackups_t;
 
+#define DEMO_INDEX_MAGIC        0x58444944  ///< "DIDX"
+#define DEMO_INDEX_VERSION      1
+#define DEMO_INDEX_EXT          "idx"
+#define DEMO_INDEX_HEADER_INTS  9
+#define DEMO_INDEX_MAX_SNAPS    8           ///< snapshots stored per checkpoint, covers the delta window of laggy demos
+
+/**
+ * @struct demoCheckpoint_t
+ * @brief Seek point of the demo index, the offsets point into demoIndex.data
+ *
+ * @note Holds ints only, it is written to the sidecar file as is
+ */
+typedef struct
+{
+	int serverTime;
+	int seekPoint;                  ///< demo file offset of the message following the checkpoint
+	int serverMessageSequence;
+	int serverCommandSequence;
+	int firstMessageNum;            ///< oldest snapshot stored with the checkpoint
+	int csOfs;                      ///< configstrings changed since the previous checkpoint
+	int csLen;
+	int snapOfs;                    ///< stored snapshots, delta compressed against each other
+	int snapLen;
+} demoCheckpoint_t;
+
+#define DEMO_CHECKPOINT_INTS (int)(sizeof(demoCheckpoint_t) / sizeof(int))
+
+/**
+ * @struct demoIndex_t
+ * @brief Seek index of the playing demo, saved next to the demo as a sidecar file
+ */
+typedef struct
+{
+	demoCheckpoint_t *checkpoints;
+	int numCheckpoints;
+	int maxCheckpoints;
+
+	byte *data;
+	int dataSize;
+	int maxDataSize;
+
+	int interval;                   ///< msec between checkpoints, 0 if the index is disabled
+
+	// state of the scan building the index
+	qboolean unconfirmed;           ///< the last checkpoint is dropped if a later delta reaches past its snapshots
+	int numGamestates;
+	qboolean csChanged[MAX_CONFIGSTRINGS];
+	char *cs[MAX_CONFIGSTRINGS];
+	char bigConfigString[BIG_INFO_STRING];
+	qboolean bigConfigStringPending;
+} demoIndex_t;
+
 cvar_t *cl_maxRewindBackups;
+cvar_t *cl_demoIndex;
 
 demoInfo_t      di;
 rewindBackups_t *rewindBackups   = NULL;
 int             maxRewindBackups = 0;
+demoIndex_t     demoIndex;
 #endif
 
+cvar_t *cl_demoCompress;
+
 demoPlayInfo_t dpi = { 0, 0 };
 
 /**
@@ -104,15 +160,16 @@ demoPlayInfo_t dpi = { 0, 0 };
  * @param[in] arg
  * @param[in,out] name
  * @param[in,out] demofile
+ * @param[out] length
  * @return
  */
-static int CL_WalkDemoExt(const char *arg, char *name, int *demofile)
+static int CL_WalkDemoExt(const char *arg, char *name, int *demofile, long *length)
 {
 	int i = 0;
 	*demofile = 0;
 
 	Com_sprintf(name, MAX_OSPATH, "demos/%s.%s%d", arg, DEMOEXT, PROTOCOL_VERSION);
-	FS_FOpenFileRead(name, demofile, qtrue);
+	*length = FS_FOpenFileRead(name, demofile, qtrue);
 
 	if (*demofile)
 	{
@@ -130,7 +187,7 @@ static int CL_WalkDemoExt(const char *arg, char *name, int *demofile)
 		}
 
 		Com_sprintf(name, MAX_OSPATH, "demos/%s.%s%d", arg, DEMOEXT, demo_protocols[i]);
-		FS_FOpenFileRead(name, demofile, qtrue);
+		*length = FS_FOpenFileRead(name, demofile, qtrue);
 		if (*demofile)
 		{
 			Com_FuncPrinf("Demo file: %s\n", name);
@@ -453,6 +510,144 @@ static void CL_DemoFastForward(double wantedTime)
 	di.firstNonDeltaMessageNumWritten = -1;
 }
 
+/**
+ * @brief Restore the state of the demo index checkpoint preceding the wanted time
+ * and fast forward from there
+ * @param[in] wantedTime
+ */
+static void CL_DemoIndexRewind(double wantedTime)
+{
+	const char       *cs[MAX_CONFIGSTRINGS];
+	demoCheckpoint_t *cp;
+	clSnapshot_t     snap, *old;
+	msg_t            msg;
+	byte             *p, *end;
+	int              lo, hi, mid, k, i, len, numSnaps;
+
+	// go back a second before wanted time in order to have snapshot backups available for screen matching
+	k  = 0;
+	lo = 0;
+	hi = demoIndex.numCheckpoints - 1;
+	while (lo <= hi)
+	{
+		mid = (lo + hi) / 2;
+		if ((double)demoIndex.checkpoints[mid].serverTime < wantedTime - 1000.0)
+		{
+			k  = mid;
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid - 1;
+		}
+	}
+	cp = &demoIndex.checkpoints[k];
+
+	if (wantedTime < (double)cp->serverTime)
+	{
+		wantedTime = cp->serverTime;
+	}
+
+	// configstrings are stored as changes against the previous checkpoint
+	Com_Memset(cs, 0, sizeof(cs));
+	for (i = 0; i <= k; i++)
+	{
+		p   = demoIndex.data + demoIndex.checkpoints[i].csOfs;
+		end = p + demoIndex.checkpoints[i].csLen;
+		while (p < end)
+		{
+			cs[p[0] | (p[1] << 8)] = (const char *)p + 2;
+			p                     += 2 + strlen((const char *)p + 2) + 1;
+		}
+	}
+
+	Com_Memset(&cl.gameState, 0, sizeof(cl.gameState));
+	cl.gameState.dataCount = 1;
+	for (i = 0; i < MAX_CONFIGSTRINGS; i++)
+	{
+		if (!cs[i] || !cs[i][0])
+		{
+			continue;
+		}
+
+		len = strlen(cs[i]);
+		if (len + 1 + cl.gameState.dataCount > MAX_GAMESTATE_CHARS)
+		{
+			Com_FuncDrop("MAX_GAMESTATE_CHARS exceeded");
+		}
+
+		cl.gameState.stringOffsets[i] = cl.gameState.dataCount;
+		Com_Memcpy(cl.gameState.stringData + cl.gameState.dataCount, cs[i], len + 1);
+		cl.gameState.dataCount += len + 1;
+	}
+
+	// the stored snapshots are parsed like a server message so the following
+	// demo messages find the frames they delta from
+	for (i = 0; i < PACKET_BACKUP; i++)
+	{
+		cl.snapshots[i].valid = qfalse;
+	}
+	cl.parseEntitiesNum = 0;
+
+	MSG_Init(&msg, demoIndex.data + cp->snapOfs, cp->snapLen);
+	MSG_Bitstream(&msg);
+	msg.cursize = cp->snapLen;
+
+	old      = NULL;
+	numSnaps = MSG_ReadByte(&msg);
+	for (i = 0; i < numSnaps; i++)
+	{
+		Com_Memset(&snap, 0, sizeof(snap));
+		snap.messageNum       = MSG_ReadLong(&msg);
+		snap.serverTime       = MSG_ReadLong(&msg);
+		snap.snapFlags        = MSG_ReadByte(&msg);
+		snap.serverCommandNum = MSG_ReadLong(&msg);
+
+		len = MSG_ReadByte(&msg);
+		if (len > sizeof(snap.areamask))
+		{
+			Com_FuncDrop("Invalid size %d for areamask.", len);
+		}
+		MSG_ReadData(&msg, &snap.areamask, len);
+
+		MSG_ReadDeltaPlayerstate(&msg, old ? &old->ps : NULL, &snap.ps);
+		CL_ParsePacketEntities(&msg, old, &snap);
+
+		snap.valid    = qtrue;
+		snap.deltaNum = old ? old->messageNum : -1;
+		snap.ping     = 999;
+
+		old  = &cl.snapshots[snap.messageNum & PACKET_MASK];
+		*old = snap;
+	}
+
+	if (!old || msg.readcount > msg.cursize)
+	{
+		Com_FuncDrop("demo index checkpoint %d is corrupt", k);
+	}
+
+	cl.snap               = *old;
+	cl.newSnapshots       = qtrue;
+	cl.serverTime         = cl.snap.serverTime;
+	cl.oldServerTime      = cl.snap.serverTime;
+	cl.oldFrameServerTime = cl.snap.serverTime;
+
+	clc.serverMessageSequence     = cp->serverMessageSequence;
+	clc.serverCommandSequence     = cp->serverCommandSequence;
+	clc.lastExecutedServerCommand = cp->serverCommandSequence;
+	Com_Memset(clc.serverCommands, 0, sizeof(clc.serverCommands));
+
+	(void) FS_Seek(clc.demofile, cp->seekPoint, FS_SEEK_SET);
+	di.Overf = 0;
+
+	cls.state        = CA_ACTIVE;
+	cls.keyCatchers |= KEYCATCH_CGAME;
+
+	DEMODEBUG("restored checkpoint %d (%d)\n", k, cp->serverTime);
+
+	CL_DemoFastForward(wantedTime);
+}
+
 /**
  * @brief CL_RewindDemo
  * @param[in] wantedTime
@@ -473,7 +668,13 @@ static void CL_RewindDemo(double wantedTime)
 		wantedTime = di.firstServerTime;
 	}
 
-	if (!rewindBackups[0].valid || di.snapCount == 0)
+	if (demoIndex.numCheckpoints)
+	{
+		CL_DemoIndexRewind(wantedTime);
+		return;
+	}
+
+	if (!rewindBackups || !rewindBackups[0].valid || di.snapCount == 0)
 	{
 		CL_DemoFastForward(wantedTime);
 		return;
@@ -671,20 +872,569 @@ static void CL_ParseDemoSnapShotSimple(msg_t *msg)
 	cl.newSnapshots                                = qtrue;
 }
 
+/**
+ * @brief CL_DemoIndexFreeConfigstrings
+ */
+static void CL_DemoIndexFreeConfigstrings(void)
+{
+	int i;
+
+	for (i = 0; i < MAX_CONFIGSTRINGS; i++)
+	{
+		if (demoIndex.cs[i])
+		{
+			Com_Dealloc(demoIndex.cs[i]);
+			demoIndex.cs[i] = NULL;
+		}
+	}
+}
+
+/**
+ * @brief CL_DemoIndexFree
+ */
+static void CL_DemoIndexFree(void)
+{
+	CL_DemoIndexFreeConfigstrings();
+
+	if (demoIndex.checkpoints)
+	{
+		Com_Dealloc(demoIndex.checkpoints);
+	}
+
+	if (demoIndex.data)
+	{
+		Com_Dealloc(demoIndex.data);
+	}
+
+	Com_Memset(&demoIndex, 0, sizeof(demoIndex));
+}
+
+/**
+ * @brief Make room for size bytes at the end of the index data
+ * @param[in] size
+ * @return Pointer to the end of the index data
+ */
+static byte *CL_DemoIndexReserve(int size)
+{
+	if (demoIndex.dataSize + size > demoIndex.maxDataSize)
+	{
+		int  maxDataSize = MAX(demoIndex.maxDataSize * 2, demoIndex.dataSize + size + 0x10000);
+		byte *data       = (byte *)Com_Allocate(maxDataSize);
+
+		if (!data)
+		{
+			Com_FuncError("couldn't allocate %.2f MB for the demo index\n", MEGABYTES(maxDataSize));
+		}
+
+		if (demoIndex.data)
+		{
+			Com_Memcpy(data, demoIndex.data, demoIndex.dataSize);
+			Com_Dealloc(demoIndex.data);
+		}
+
+		demoIndex.data        = data;
+		demoIndex.maxDataSize = maxDataSize;
+	}
+
+	return demoIndex.data + demoIndex.dataSize;
+}
+
+/**
+ * @brief Track a configstring of the scanned demo
+ * @param[in] index
+ * @param[in] s
+ */
+static void CL_DemoIndexSetConfigstring(int index, const char *s)
+{
+	size_t len;
+
+	if (index < 0 || index >= MAX_CONFIGSTRINGS)
+	{
+		Com_FuncDrop("configstring < 0 or configstring >= MAX_CONFIGSTRINGS");
+	}
+
+	if (demoIndex.cs[index])
+	{
+		if (!strcmp(demoIndex.cs[index], s))
+		{
+			return;
+		}
+
+		Com_Dealloc(demoIndex.cs[index]);
+		demoIndex.cs[index] = NULL;
+	}
+	else if (!s[0])
+	{
+		return;
+	}
+
+	if (s[0])
+	{
+		len                 = strlen(s) + 1;
+		demoIndex.cs[index] = (char *)Com_Allocate(len);
+		if (!demoIndex.cs[index])
+		{
+			Com_FuncError("couldn't allocate configstring %d\n", index);
+		}
+		Com_Memcpy(demoIndex.cs[index], s, len);
+	}
+
+	demoIndex.csChanged[index] = qtrue;
+}
+
+/**
+ * @brief Apply the configstring changes of a server command of the scanned demo
+ * @param[in] s
+ *
+ * @note Mirrors the cs/bcs/csp handling of CL_GetServerCommand
+ */
+static void CL_DemoIndexServerCommand(const char *s)
+{
+	char *cmd;
+
+	Cmd_TokenizeString(s);
+rescan:
+	cmd = Cmd_Argv(0);
+
+	if (!strcmp(cmd, "bcs0"))
+	{
+		Com_sprintf(demoIndex.bigConfigString, sizeof(demoIndex.bigConfigString), "cs %s \"%s", Cmd_Argv(1), Cmd_Argv(2));
+		demoIndex.bigConfigStringPending = qtrue;
+	}
+	else if (!strcmp(cmd, "bcs1"))
+	{
+		Q_strcat(demoIndex.bigConfigString, sizeof(demoIndex.bigConfigString), Cmd_Argv(2));
+	}
+	else if (!strcmp(cmd, "bcs2"))
+	{
+		Q_strcat(demoIndex.bigConfigString, sizeof(demoIndex.bigConfigString), Cmd_Argv(2));
+		Q_strcat(demoIndex.bigConfigString, sizeof(demoIndex.bigConfigString), "\"");
+		demoIndex.bigConfigStringPending = qfalse;
+		Cmd_TokenizeString(demoIndex.bigConfigString);
+		goto rescan;
+	}
+	else if (!strcmp(cmd, "csp"))
+	{
+		char splice[BIG_INFO_STRING];
+		int  index = atoi(Cmd_Argv(1));
+
+		if (index < 0 || index >= MAX_CONFIGSTRINGS)
+		{
+			Com_FuncDrop("configstring < 0 or configstring >= MAX_CONFIGSTRINGS");
+		}
+
+		if (Com_SpliceString(splice, sizeof(splice), demoIndex.cs[index] ? demoIndex.cs[index] : "",
+		                     atoi(Cmd_Argv(2)), atoi(Cmd_Argv(3)), atoi(Cmd_Argv(4)), Cmd_Argv(5)))
+		{
+			CL_DemoIndexSetConfigstring(index, splice);
+		}
+	}
+	else if (!strcmp(cmd, "cs"))
+	{
+		CL_DemoIndexSetConfigstring(atoi(Cmd_Argv(1)), Cmd_ArgsFrom(2));
+	}
+}
+
+/**
+ * @brief Write the entities of a snapshot delta compressed against another one
+ * @param[in,out] msg
+ * @param[in] from
+ * @param[in] to
+ *
+ * @note Same layout as SV_EmitPacketEntities so CL_ParsePacketEntities can read it back
+ */
+static void CL_DemoIndexEmitEntities(msg_t *msg, clSnapshot_t *from, clSnapshot_t *to)
+{
+	entityState_t *oldent = NULL, *newent = NULL;
+	int           oldindex = 0, newindex = 0;
+	int           oldnum, newnum;
+	int           from_num_entities = from ? from->numEntities : 0;
+
+	while (newindex < to->numEntities || oldindex < from_num_entities)
+	{
+		if (newindex >= to->numEntities)
+		{
+			newnum = 9999;
+		}
+		else
+		{
+			newent = &cl.parseEntities[(to->parseEntitiesNum + newindex) & (MAX_PARSE_ENTITIES - 1)];
+			newnum = newent->number;
+		}
+
+		if (oldindex >= from_num_entities)
+		{
+			oldnum = 9999;
+		}
+		else
+		{
+			oldent = &cl.parseEntities[(from->parseEntitiesNum + oldindex) & (MAX_PARSE_ENTITIES - 1)];
+			oldnum = oldent->number;
+		}
+
+		if (newnum == oldnum)
+		{
+			MSG_WriteDeltaEntity(msg, oldent, newent, qfalse);
+			oldindex++;
+			newindex++;
+		}
+		else if (newnum < oldnum)
+		{
+			MSG_WriteDeltaEntity(msg, &cl.entityBaselines[newnum], newent, qtrue);
+			newindex++;
+		}
+		else
+		{
+			MSG_WriteDeltaEntity(msg, oldent, NULL, qtrue);
+			oldindex++;
+		}
+	}
+
+	MSG_WriteBits(msg, (MAX_GENTITIES - 1), GENTITYNUM_BITS);
+}
+
+/**
+ * @brief Store the current state of the scan as a checkpoint
+ * @param[in] seekPoint demo file offset of the next message
+ */
+static void CL_DemoIndexAddCheckpoint(int seekPoint)
+{
+	static byte      msgData[MAX_MSGLEN * 2];
+	clSnapshot_t     *snaps[DEMO_INDEX_MAX_SNAPS], *from, *to;
+	demoCheckpoint_t *cp;
+	msg_t            msg;
+	byte             *out;
+	int              i, numSnaps = 0, messageNum, len;
+
+	// keep every frame the following messages may still delta from
+	for (messageNum = cl.snap.messageNum - DEMO_INDEX_MAX_SNAPS + 1; messageNum <= cl.snap.messageNum; messageNum++)
+	{
+		to = &cl.snapshots[messageNum & PACKET_MASK];
+		if (to->valid && to->messageNum == messageNum && cl.parseEntitiesNum - to->parseEntitiesNum <= MAX_PARSE_ENTITIES - 128)
+		{
+			snaps[numSnaps++] = to;
+		}
+	}
+
+	if (!numSnaps)
+	{
+		return;
+	}
+
+	MSG_Init(&msg, msgData, sizeof(msgData));
+	MSG_Bitstream(&msg);
+	MSG_WriteByte(&msg, numSnaps);
+
+	from = NULL;
+	for (i = 0; i < numSnaps; i++)
+	{
+		to = snaps[i];
+		MSG_WriteLong(&msg, to->messageNum);
+		MSG_WriteLong(&msg, to->serverTime);
+		MSG_WriteByte(&msg, to->snapFlags);
+		MSG_WriteLong(&msg, to->serverCommandNum);
+		MSG_WriteByte(&msg, sizeof(to->areamask));
+		MSG_WriteData(&msg, to->areamask, sizeof(to->areamask));
+		MSG_WriteDeltaPlayerstate(&msg, from ? &from->ps : NULL, &to->ps);
+		CL_DemoIndexEmitEntities(&msg, from, to);
+		from = to;
+	}
+
+	if (msg.overflowed)
+	{
+		Com_FuncDPrinf("checkpoint at %d overflowed\n", cl.snap.serverTime);
+		return;
+	}
+
+	if (demoIndex.numCheckpoints == demoIndex.maxCheckpoints)
+	{
+		demoCheckpoint_t *checkpoints;
+
+		demoIndex.maxCheckpoints = demoIndex.maxCheckpoints ? demoIndex.maxCheckpoints * 2 : 256;
+		checkpoints              = (demoCheckpoint_t *)Com_Allocate(demoIndex.maxCheckpoints * sizeof(demoCheckpoint_t));
+		if (!checkpoints)
+		{
+			Com_FuncError("couldn't allocate %d demo checkpoints\n", demoIndex.maxCheckpoints);
+		}
+
+		if (demoIndex.checkpoints)
+		{
+			Com_Memcpy(checkpoints, demoIndex.checkpoints, demoIndex.numCheckpoints * sizeof(demoCheckpoint_t));
+			Com_Dealloc(demoIndex.checkpoints);
+		}
+		demoIndex.checkpoints = checkpoints;
+	}
+
+	cp                        = &demoIndex.checkpoints[demoIndex.numCheckpoints++];
+	cp->serverTime            = cl.snap.serverTime;
+	cp->seekPoint             = seekPoint;
+	cp->serverMessageSequence = clc.serverMessageSequence;
+	cp->serverCommandSequence = clc.serverCommandSequence;
+	cp->firstMessageNum       = snaps[0]->messageNum;
+
+	// configstrings as (short index, string) pairs
+	cp->csOfs = demoIndex.dataSize;
+	for (i = 0; i < MAX_CONFIGSTRINGS; i++)
+	{
+		const char *s;
+
+		if (!demoIndex.csChanged[i])
+		{
+			continue;
+		}
+
+		s      = demoIndex.cs[i] ? demoIndex.cs[i] : "";
+		len    = strlen(s) + 1;
+		out    = CL_DemoIndexReserve(2 + len);
+		out[0] = i & 0xff;
+		out[1] = i >> 8;
+		Com_Memcpy(out + 2, s, len);
+		demoIndex.dataSize += 2 + len;
+
+		demoIndex.csChanged[i] = qfalse;
+	}
+	cp->csLen = demoIndex.dataSize - cp->csOfs;
+
+	cp->snapOfs = demoIndex.dataSize;
+	cp->snapLen = msg.cursize;
+	out         = CL_DemoIndexReserve(msg.cursize);
+	Com_Memcpy(out, msg.data, msg.cursize);
+	demoIndex.dataSize += msg.cursize;
+
+	demoIndex.unconfirmed = qtrue;
+}
+
+/**
+ * @brief Drop the last checkpoint, its configstring changes move on to the next one
+ */
+static void CL_DemoIndexDropCheckpoint(void)
+{
+	demoCheckpoint_t *cp = &demoIndex.checkpoints[--demoIndex.numCheckpoints];
+	byte             *p  = demoIndex.data + cp->csOfs;
+	byte             *end = p + cp->csLen;
+
+	while (p < end)
+	{
+		demoIndex.csChanged[p[0] | (p[1] << 8)] = qtrue;
+		p                                      += 2 + strlen((const char *)p + 2) + 1;
+	}
+
+	demoIndex.dataSize    = cp->csOfs;
+	demoIndex.unconfirmed = qfalse;
+}
+
+/**
+ * @brief Called by the scan for every message carrying a valid snapshot
+ * @param[in] seekPoint demo file offset of the next message
+ */
+static void CL_DemoIndexScanSnapshot(int seekPoint)
+{
+	demoCheckpoint_t *cp;
+
+	if (demoIndex.unconfirmed)
+	{
+		cp = &demoIndex.checkpoints[demoIndex.numCheckpoints - 1];
+
+		if (cl.snap.deltaNum > 0 && cl.snap.deltaNum < cp->firstMessageNum)
+		{
+			CL_DemoIndexDropCheckpoint();
+		}
+		else if (cl.snap.deltaNum <= 0 || cl.snap.deltaNum > cp->serverMessageSequence)
+		{
+			demoIndex.unconfirmed = qfalse;
+		}
+	}
+
+	// baselines of later gamestates aren't kept, neither are half received big configstrings
+	if (demoIndex.unconfirmed || demoIndex.numGamestates != 1 || demoIndex.bigConfigStringPending
+	    || (cl.snap.snapFlags & SNAPFLAG_NOT_ACTIVE))
+	{
+		return;
+	}
+
+	if (demoIndex.numCheckpoints && cl.snap.serverTime - demoIndex.checkpoints[demoIndex.numCheckpoints - 1].serverTime < demoIndex.interval)
+	{
+		return;
+	}
+
+	CL_DemoIndexAddCheckpoint(seekPoint);
+}
+
+/**
+ * @brief CL_DemoIndexWrite
+ * @param[in] name
+ * @param[in] demoLength
+ */
+static void CL_DemoIndexWrite(const char *name, long demoLength)
+{
+	fileHandle_t f;
+	int          header[DEMO_INDEX_HEADER_INTS];
+	int          ints[DEMO_CHECKPOINT_INTS];
+	int          i, j;
+
+	f = FS_FOpenFileWrite(va("%s.%s", name, DEMO_INDEX_EXT));
+	if (!f)
+	{
+		Com_FuncPrinf("couldn't write demo index %s.%s\n", name, DEMO_INDEX_EXT);
+		return;
+	}
+
+	header[0] = LittleLong(DEMO_INDEX_MAGIC);
+	header[1] = LittleLong(DEMO_INDEX_VERSION);
+	header[2] = LittleLong((int)demoLength);
+	header[3] = LittleLong(demoIndex.interval);
+	header[4] = LittleLong(di.firstServerTime);
+	header[5] = LittleLong(di.lastServerTime);
+	header[6] = LittleLong(di.snapsInDemo);
+	header[7] = LittleLong(demoIndex.numCheckpoints);
+	header[8] = LittleLong(demoIndex.dataSize);
+	(void) FS_Write(header, sizeof(header), f);
+
+	for (i = 0; i < demoIndex.numCheckpoints; i++)
+	{
+		for (j = 0; j < DEMO_CHECKPOINT_INTS; j++)
+		{
+			ints[j] = LittleLong(((int *)&demoIndex.checkpoints[i])[j]);
+		}
+		(void) FS_Write(ints, sizeof(ints), f);
+	}
+
+	(void) FS_Write(demoIndex.data, demoIndex.dataSize, f);
+	FS_FCloseFile(f);
+
+	Com_FuncPrinf("wrote %d checkpoints (%.2f MB) to %s.%s\n", demoIndex.numCheckpoints, MEGABYTES(demoIndex.dataSize), name, DEMO_INDEX_EXT);
+}
+
+/**
+ * @brief Load the sidecar index of a demo if it is still valid for it
+ * @param[in] name
+ * @param[in] demoLength
+ * @return qtrue if the index was loaded
+ */
+static qboolean CL_DemoIndexLoad(const char *name, long demoLength)
+{
+	fileHandle_t     f;
+	long             len;
+	int              header[DEMO_INDEX_HEADER_INTS];
+	int              ints[DEMO_CHECKPOINT_INTS];
+	int              i, j;
+	demoCheckpoint_t *cp;
+	qboolean         valid = qfalse;
+
+	len = FS_FOpenFileRead(va("%s.%s", name, DEMO_INDEX_EXT), &f, qtrue);
+	if (!f)
+	{
+		return qfalse;
+	}
+
+	if (len >= (long)sizeof(header) && FS_Read(header, sizeof(header), f) == sizeof(header))
+	{
+		for (i = 0; i < DEMO_INDEX_HEADER_INTS; i++)
+		{
+			header[i] = LittleLong(header[i]);
+		}
+
+		valid = header[0] == DEMO_INDEX_MAGIC && header[1] == DEMO_INDEX_VERSION
+		        && header[2] == (int)demoLength && header[3] == demoIndex.interval
+		        && header[7] > 0 && header[8] > 0
+		        && len == (long)sizeof(header) + header[7] * (long)sizeof(demoCheckpoint_t) + header[8];
+	}
+
+	if (valid)
+	{
+		demoIndex.numCheckpoints = demoIndex.maxCheckpoints = header[7];
+		demoIndex.dataSize       = demoIndex.maxDataSize = header[8];
+		demoIndex.checkpoints    = (demoCheckpoint_t *)Com_Allocate(demoIndex.numCheckpoints * sizeof(demoCheckpoint_t));
+		demoIndex.data           = (byte *)Com_Allocate(demoIndex.dataSize);
+		if (!demoIndex.checkpoints || !demoIndex.data)
+		{
+			Com_FuncError("couldn't allocate %.2f MB for the demo index\n", MEGABYTES(len));
+		}
+
+		for (i = 0; i < demoIndex.numCheckpoints && valid; i++)
+		{
+			cp    = &demoIndex.checkpoints[i];
+			valid = FS_Read(ints, sizeof(ints), f) == sizeof(ints);
+			for (j = 0; j < DEMO_CHECKPOINT_INTS; j++)
+			{
+				((int *)cp)[j] = LittleLong(ints[j]);
+			}
+
+			valid = valid && cp->csOfs >= 0 && cp->csLen >= 0 && cp->csOfs + cp->csLen <= demoIndex.dataSize
+			        && cp->snapOfs >= 0 && cp->snapLen > 0 && cp->snapOfs + cp->snapLen <= demoIndex.dataSize
+			        && cp->seekPoint > 0 && cp->seekPoint < demoLength;
+		}
+
+		valid = valid && FS_Read(demoIndex.data, demoIndex.dataSize, f) == demoIndex.dataSize;
+
+		// configstring records must stay inside their checkpoint
+		for (i = 0; i < demoIndex.numCheckpoints && valid; i++)
+		{
+			byte *p   = demoIndex.data + demoIndex.checkpoints[i].csOfs;
+			byte *end = p + demoIndex.checkpoints[i].csLen;
+
+			while (p < end && valid)
+			{
+				byte *s = p + 2;
+
+				valid = s < end && (p[0] | (p[1] << 8)) < MAX_CONFIGSTRINGS && memchr(s, 0, end - s) != NULL;
+				p     = valid ? s + strlen((const char *)s) + 1 : end;
+			}
+		}
+	}
+
+	FS_FCloseFile(f);
+
+	if (!valid)
+	{
+		Com_FuncPrinf("ignoring outdated demo index %s.%s\n", name, DEMO_INDEX_EXT);
+		CL_DemoIndexFree();
+		return qfalse;
+	}
+
+	di.firstServerTime = header[4];
+	di.lastServerTime  = header[5];
+	di.snapsInDemo     = header[6];
+
+	Com_FuncPrinf("loaded %d checkpoints from %s.%s\n", demoIndex.numCheckpoints, name, DEMO_INDEX_EXT);
+	return qtrue;
+}
+
 /**
  * @brief Do very shallow parse of the demo (could be extended) just to get times and snapshot count
+ *
+ * The scan also builds the seek index of the demo, a valid sidecar index saves the scan.
+ *
+ * @param[in] name
+ * @param[in] demoLength
  */
-static void CL_ParseDemo(void)
+static void CL_ParseDemo(const char *name, long demoLength)
 {
 	int tstart   = 0;
 	int demofile = 0;
+	int count    = 0;
+	int recent[BASELINE_DELTA_BACKUP];
 
 	// Reset our demo data
 	Com_Memset(&di, 0, sizeof(di));
+	CL_DemoIndexFree();
 
 	// Parse start
 	di.gameStartTime = -1;
 	di.gameEndTime   = -1;
+
+	if (cl_demoIndex->integer > 0)
+	{
+		demoIndex.interval = cl_demoIndex->integer * 1000;
+
+		if (CL_DemoIndexLoad(name, demoLength))
+		{
+			dpi.firstTime = di.firstServerTime;
+			dpi.lastTime  = di.lastServerTime;
+			return;
+		}
+	}
+
 	(void) FS_Seek(clc.demofile, 0, FS_SEEK_SET);
 	tstart = Sys_Milliseconds();
 
@@ -777,12 +1527,25 @@ static void CL_ParseDemo(void)
 			case svc_nop:
 				break;
 			case svc_serverCommand:
-				MSG_ReadLong(msg);
-				MSG_ReadString(msg);
-				break;
+			{
+				int  seq = MSG_ReadLong(msg);
+				char *str = MSG_ReadString(msg);
+
+				if (seq > clc.serverCommandSequence)
+				{
+					clc.serverCommandSequence = seq;
+					if (demoIndex.interval)
+					{
+						CL_DemoIndexServerCommand(str);
+					}
+				}
+			}
+			break;
 			case svc_gamestate:
 				clc.serverCommandSequence = MSG_ReadLong(msg);
 				cl.gameState.dataCount    = 1;
+				demoIndex.numGamestates++;
+				count = 0;
 				while (qtrue)
 				{
 					int cmd2 = MSG_ReadByte(msg);
@@ -792,16 +1555,41 @@ static void CL_ParseDemo(void)
 					}
 					if (cmd2 == svc_configstring)
 					{
-						MSG_ReadShort(msg);
-						MSG_ReadBigString(msg);
+						int  index = MSG_ReadShort(msg);
+						char *str  = MSG_ReadBigString(msg);
+
+						if (demoIndex.interval && demoIndex.numGamestates == 1)
+						{
+							CL_DemoIndexSetConfigstring(index, str);
+						}
 					}
 					else if (cmd2 == svc_baseline)
 					{
-						entityState_t s1, s2;
-						Com_Memset(&s1, 0, sizeof(s1));
-						Com_Memset(&s2, 0, sizeof(s2));
-						MSG_ReadBits(msg, GENTITYNUM_BITS);
-						MSG_ReadDeltaEntity(msg, &s1, &s2, 0);
+						// keep the baselines, the snapshots of the scan delta from them
+						entityState_t nullstate;
+						int           newnum = MSG_ReadBits(msg, GENTITYNUM_BITS);
+
+						if (newnum < 0 || newnum >= MAX_GENTITIES)
+						{
+							Com_FuncDrop("Baseline number out of range: %i", newnum);
+						}
+						Com_Memset(&nullstate, 0, sizeof(nullstate));
+						MSG_ReadDeltaEntity(msg, &nullstate, &cl.entityBaselines[newnum], newnum);
+
+						recent[count++ & (BASELINE_DELTA_BACKUP - 1)] = newnum;
+					}
+					else if (cmd2 == svc_baselineDelta)
+					{
+						int back   = MSG_ReadBits(msg, BASELINE_DELTA_BITS);
+						int newnum = MSG_ReadBits(msg, GENTITYNUM_BITS);
+
+						if (back < 1 || back > count || newnum < 0 || newnum >= MAX_GENTITIES)
+						{
+							Com_FuncDrop("Baseline delta out of range: %i %i", back, newnum);
+						}
+						MSG_ReadDeltaEntity(msg, &cl.entityBaselines[recent[(count - back) & (BASELINE_DELTA_BACKUP - 1)]], &cl.entityBaselines[newnum], newnum);
+
+						recent[count++ & (BASELINE_DELTA_BACKUP - 1)] = newnum;
 					}
 					else
 					{
@@ -857,11 +1645,23 @@ static void CL_ParseDemo(void)
 		}
 
 		di.snapsInDemo++;
+
+		if (demoIndex.interval && cl.snap.messageNum == clc.serverMessageSequence)
+		{
+			CL_DemoIndexScanSnapshot(FS_FTell(clc.demofile));
+		}
 	}
 
 	Com_FuncPrinf("Snaps in demo: %i\n", di.snapsInDemo);
 	Com_FuncPrinf("last serverTime %d   total %f minutes\n", cl.snap.serverTime, (cl.snap.serverTime - di.firstServerTime) / 1000.0 / 60.0);
 	Com_FuncPrinf("parse time %f seconds\n", (double)(Sys_Milliseconds() - tstart) / 1000.0);
+
+	if (demoIndex.interval)
+	{
+		CL_DemoIndexFreeConfigstrings();
+		CL_DemoIndexWrite(name, demoLength);
+	}
+
 	(void) FS_Seek(clc.demofile, 0, FS_SEEK_SET);
 	clc.demoplaying = qfalse;
 	demofile        = clc.demofile;
@@ -886,6 +1686,9 @@ void CL_FreeDemoPoints(void)
 		Com_Dealloc(rewindBackups);
 		rewindBackups = NULL;
 	}
+	maxRewindBackups = 0;
+
+	CL_DemoIndexFree();
 }
 
 /**
@@ -918,6 +1721,275 @@ CLIENT SIDE DEMO RECORDING
 =======================================================================
 */
 
+/**
+ * @struct demoRecordPatch_t
+ * @brief Part of the parsed net message the demo gets in the old encoding
+ */
+typedef struct
+{
+	int start;                      ///< first bit of the part in the net message
+	int end;                        ///< bit following it
+	int num;                        ///< server command sequence, or entity number of the baseline
+	qboolean baseline;
+} demoRecordPatch_t;
+
+/**
+ * @struct demoRecord_t
+ * @brief Turns the "csp" splices and svc_baselineDelta of the recorded net messages back into "cs" and svc_baseline
+ *
+ * @details Players of the demo can't be expected to know UA_FEATURE_CSDELTA. The configstrings are tracked
+ * in the order the server sends them, each splice is written as the "cs" command it stands for.
+ */
+typedef struct
+{
+	char *cs[MAX_CONFIGSTRINGS];
+	char bigConfigString[BIG_INFO_STRING];
+	int sequence;                                               ///< last server command applied to cs
+
+	char commands[MAX_RELIABLE_COMMANDS][MAX_STRING_CHARS];     ///< "cs" command of a splice, resent splices are written alike
+	int commandSequences[MAX_RELIABLE_COMMANDS];
+
+	demoRecordPatch_t patches[MAX_GENTITIES + MAX_RELIABLE_COMMANDS];
+	int numPatches;
+	int end;                                                    ///< bit following the svc_EOF of the message
+	byte data[MAX_MSGLEN];
+} demoRecord_t;
+
+static demoRecord_t demoRecord;
+
+/**
+ * @brief Track a configstring of the recorded demo
+ * @param[in] index
+ * @param[in] s
+ */
+static void CL_DemoRecordSetConfigstring(int index, const char *s)
+{
+	size_t len;
+
+	if (demoRecord.cs[index])
+	{
+		Com_Dealloc(demoRecord.cs[index]);
+		demoRecord.cs[index] = NULL;
+	}
+
+	if (s[0])
+	{
+		len                  = strlen(s) + 1;
+		demoRecord.cs[index] = (char *)Com_Allocate(len);
+		if (!demoRecord.cs[index])
+		{
+			Com_FuncError("couldn't allocate configstring %d\n", index);
+		}
+		Com_Memcpy(demoRecord.cs[index], s, len);
+	}
+}
+
+/**
+ * @brief Take the tracked configstrings from the gamestate
+ * @param[in] sequence last server command the gamestate holds
+ */
+static void CL_DemoRecordSetGamestate(int sequence)
+{
+	int i;
+
+	for (i = 0; i < MAX_CONFIGSTRINGS; i++)
+	{
+		CL_DemoRecordSetConfigstring(i, cl.gameState.stringData + cl.gameState.stringOffsets[i]);
+	}
+
+	demoRecord.bigConfigString[0] = '\0';
+	demoRecord.sequence           = sequence;
+	Com_Memset(demoRecord.commandSequences, 0, sizeof(demoRecord.commandSequences));
+}
+
+/**
+ * @brief Apply the configstring changes of a server command, a splice also gets its "cs" command
+ * @param[in] sequence
+ * @param[in] s
+ *
+ * @note Mirrors the cs/bcs/csp handling of CL_GetServerCommand
+ */
+static void CL_DemoRecordServerCommand(int sequence, const char *s)
+{
+	static char splice[BIG_INFO_STRING];
+	char        *cmd;
+	int         index;
+
+	demoRecord.sequence = sequence;
+
+	Cmd_SaveCmdContext();
+	Cmd_TokenizeString(s);
+rescan:
+	cmd = Cmd_Argv(0);
+
+	if (!strcmp(cmd, "bcs0"))
+	{
+		Com_sprintf(demoRecord.bigConfigString, sizeof(demoRecord.bigConfigString), "cs %s \"%s", Cmd_Argv(1), Cmd_Argv(2));
+	}
+	else if (!strcmp(cmd, "bcs1"))
+	{
+		Q_strcat(demoRecord.bigConfigString, sizeof(demoRecord.bigConfigString), Cmd_Argv(2));
+	}
+	else if (!strcmp(cmd, "bcs2"))
+	{
+		Q_strcat(demoRecord.bigConfigString, sizeof(demoRecord.bigConfigString), Cmd_Argv(2));
+		Q_strcat(demoRecord.bigConfigString, sizeof(demoRecord.bigConfigString), "\"");
+		Cmd_TokenizeString(demoRecord.bigConfigString);
+		goto rescan;
+	}
+	else if (!strcmp(cmd, "csp"))
+	{
+		index = atoi(Cmd_Argv(1));
+
+		// a bad splice drops the connection when the client executes it
+		if (index >= 0 && index < MAX_CONFIGSTRINGS
+		    && Com_SpliceString(splice, sizeof(splice), demoRecord.cs[index] ? demoRecord.cs[index] : "",
+		                        atoi(Cmd_Argv(2)), atoi(Cmd_Argv(3)), atoi(Cmd_Argv(4)), Cmd_Argv(5)))
+		{
+			CL_DemoRecordSetConfigstring(index, splice);
+
+			// longer values would need bcs chunks which can't share one sequence, the splice is kept then
+			if (strlen(splice) + 16 < MAX_STRING_CHARS)
+			{
+				Com_sprintf(demoRecord.commands[sequence & (MAX_RELIABLE_COMMANDS - 1)], MAX_STRING_CHARS, "cs %i \"%s\"", index, splice);
+				demoRecord.commandSequences[sequence & (MAX_RELIABLE_COMMANDS - 1)] = sequence;
+			}
+		}
+	}
+	else if (!strcmp(cmd, "cs"))
+	{
+		index = atoi(Cmd_Argv(1));
+		if (index >= 0 && index < MAX_CONFIGSTRINGS)
+		{
+			CL_DemoRecordSetConfigstring(index, Cmd_ArgsFrom(2));
+		}
+	}
+
+	Cmd_RestoreCmdContext();
+}
+
+/**
+ * @brief Start tracking the configstrings of a new recording
+ *
+ * @details The gamestate of CL_Record() holds the executed server commands, the received ones are applied on top.
+ */
+static void CL_DemoRecordStart(void)
+{
+	int i;
+
+	CL_DemoRecordSetGamestate(clc.lastExecutedServerCommand);
+
+	for (i = clc.lastExecutedServerCommand + 1; i <= clc.serverCommandSequence; i++)
+	{
+		CL_DemoRecordServerCommand(i, clc.serverCommands[i & (MAX_RELIABLE_COMMANDS - 1)]);
+	}
+
+	demoRecord.numPatches = 0;
+}
+
+/**
+ * @brief Stop tracking the configstrings
+ */
+static void CL_DemoRecordStop(void)
+{
+	int i;
+
+	for (i = 0; i < MAX_CONFIGSTRINGS; i++)
+	{
+		CL_DemoRecordSetConfigstring(i, "");
+	}
+	demoRecord.numPatches = 0;
+}
+
+/**
+ * @brief A net message is parsed, forget the parts to rewrite of the previous one
+ */
+void CL_DemoRecordBeginMessage(void)
+{
+	demoRecord.numPatches = 0;
+}
+
+/**
+ * @brief A server command was parsed, a splice is rewritten as the "cs" command it stands for
+ * @param[in] msg
+ * @param[in] start bit of its svc_serverCommand
+ */
+void CL_DemoRecordCommand(msg_t *msg, int start)
+{
+	msg_t cmdMsg;
+	int   sequence;
+	char  *s;
+
+	if (!clc.demorecording)
+	{
+		return;
+	}
+
+	// CL_ParseCommandString kept only new commands, the splices must be rewritten each time they are resent
+	cmdMsg     = *msg;
+	cmdMsg.bit = start;
+	MSG_ReadByte(&cmdMsg);
+	sequence = MSG_ReadLong(&cmdMsg);
+	s        = MSG_ReadString(&cmdMsg);
+
+	if (sequence > demoRecord.sequence)
+	{
+		CL_DemoRecordServerCommand(sequence, s);
+	}
+
+	if (demoRecord.commandSequences[sequence & (MAX_RELIABLE_COMMANDS - 1)] == sequence && demoRecord.numPatches < (int)ARRAY_LEN(demoRecord.patches))
+	{
+		demoRecordPatch_t *patch = &demoRecord.patches[demoRecord.numPatches++];
+
+		patch->start    = start;
+		patch->end      = msg->bit;
+		patch->num      = sequence;
+		patch->baseline = qfalse;
+	}
+}
+
+/**
+ * @brief A svc_baselineDelta was parsed, it is rewritten as svc_baseline
+ * @param[in] msg
+ * @param[in] start bit of its svc_baselineDelta
+ * @param[in] num entity number of the baseline
+ */
+void CL_DemoRecordBaseline(msg_t *msg, int start, int num)
+{
+	demoRecordPatch_t *patch;
+
+	if (!clc.demorecording || demoRecord.numPatches >= (int)ARRAY_LEN(demoRecord.patches))
+	{
+		return;
+	}
+
+	patch           = &demoRecord.patches[demoRecord.numPatches++];
+	patch->start    = start;
+	patch->end      = msg->bit;
+	patch->num      = num;
+	patch->baseline = qtrue;
+}
+
+/**
+ * @brief A gamestate was parsed, the configstrings are tracked from it
+ */
+void CL_DemoRecordGamestate(void)
+{
+	if (clc.demorecording)
+	{
+		CL_DemoRecordSetGamestate(clc.serverCommandSequence);
+	}
+}
+
+/**
+ * @brief The svc_EOF of the net message was parsed
+ * @param[in] msg
+ */
+void CL_DemoRecordEndMessage(msg_t *msg)
+{
+	demoRecord.end = msg->bit;
+}
+
 /**
  * @brief Dumps the current net message, prefixed by the length
  * @param[in] msg
@@ -925,18 +1997,71 @@ CLIENT SIDE DEMO RECORDING
  */
 void CL_WriteDemoMessage(msg_t *msg, int headerBytes)
 {
-	int len, swlen;
+	int  len, swlen;
+	byte *data = msg->data + headerBytes;
+
+	len = msg->cursize - headerBytes;
+
+	if (demoRecord.numPatches)
+	{
+		msg_t         buf;
+		entityState_t nullstate;
+		int           i, ofs = headerBytes << 3;
+
+		MSG_Init(&buf, demoRecord.data, sizeof(demoRecord.data));
+		MSG_Bitstream(&buf);
+		Com_Memset(&nullstate, 0, sizeof(nullstate));
+
+		// the huffman codes don't depend on their position, the rest of the message is copied as is
+		for (i = 0; i < demoRecord.numPatches; i++)
+		{
+			demoRecordPatch_t *patch = &demoRecord.patches[i];
+
+			MSG_CopyBits(&buf, msg->data, ofs, patch->start - ofs);
+
+			if (patch->baseline)
+			{
+				MSG_WriteByte(&buf, svc_baseline);
+				MSG_WriteDeltaEntity(&buf, &nullstate, &cl.entityBaselines[patch->num], qtrue);
+			}
+			else
+			{
+				MSG_WriteByte(&buf, svc_serverCommand);
+				MSG_WriteLong(&buf, patch->num);
+				MSG_WriteString(&buf, demoRecord.commands[patch->num & (MAX_RELIABLE_COMMANDS - 1)]);
+			}
+			ofs = patch->end;
+		}
+		MSG_CopyBits(&buf, msg->data, ofs, demoRecord.end - ofs);
+
+		// the binary message follows the bitstream, see CL_ParseBinaryMessage
+		if (msg->cursize > msg->readcount)
+		{
+			MSG_Uncompressed(&buf);
+			MSG_WriteData(&buf, msg->data + msg->readcount, msg->cursize - msg->readcount);
+		}
+
+		if (buf.overflowed)
+		{
+			Com_FuncPrinf("WARNING: message too big to rewrite, recorded as received\n");
+		}
+		else
+		{
+			data = buf.data;
+			len  = buf.cursize;
+		}
+
+		demoRecord.numPatches = 0;
+	}
 
 	// write the packet sequence
-	len   = clc.serverMessageSequence;
-	swlen = LittleLong(len);
+	swlen = LittleLong(clc.serverMessageSequence);
 	(void) FS_Write(&swlen, 4, clc.demofile);
 
 	// skip the packet sequencing information
-	len   = msg->cursize - headerBytes;
 	swlen = LittleLong(len);
 	(void) FS_Write(&swlen, 4, clc.demofile);
-	(void) FS_Write(msg->data + headerBytes, len, clc.demofile);
+	(void) FS_Write(data, len, clc.demofile);
 }
 
 /**
@@ -959,6 +2084,8 @@ void CL_StopRecord_f(void)
 	FS_FCloseFile(clc.demofile);
 	clc.demofile = 0;
 
+	CL_DemoRecordStop();
+
 	clc.demorecording = qfalse;
 	Cvar_Set("cl_demorecording", "0");
 	Cvar_Set("cl_demofilename", "");
@@ -1060,6 +2187,11 @@ void CL_Record(const char *name)
 		return;
 	}
 
+	if (cl_demoCompress->integer > 0)
+	{
+		FS_SetBlockCompression(clc.demofile, cl_demoCompress->integer);
+	}
+
 	clc.demorecording = qtrue;
 	Cvar_Set("cl_demorecording", "1");    // fretn
 	Q_strncpyz(clc.demoName, demoName, sizeof(clc.demoName));
@@ -1125,6 +2257,8 @@ void CL_Record(const char *name)
 	(void) FS_Write(&len, 4, clc.demofile);
 	(void) FS_Write(buf.data, buf.cursize, clc.demofile);
 
+	CL_DemoRecordStart();
+
 	// the rest of the demo file will be copied from net messages
 }
 
@@ -1380,29 +2514,21 @@ static void CL_CompleteDemoName(char *args, int argNum)
 }
 
 /**
- * @brief Usage: demo \<demoname\>
+ * @brief Open a demo by its name, with or without the protocol extension
+ * @param[in] arg
+ * @param[out] name path of the opened demo
+ * @param[out] demofile
+ * @return Length of the demo file
  */
-void CL_PlayDemo_f(void)
+static long CL_OpenDemoFile(const char *arg, char *name, fileHandle_t *demofile)
 {
-	char name[MAX_OSPATH], retry[MAX_OSPATH];
-	char *arg, *ext_test;
-	int  protocol, i;
-
-	if (Cmd_Argc() != 2)
-	{
-		Com_FuncPrinf("playdemo <demoname>\n");
-		return;
-	}
-
-	// make sure a local server is killed
-	Cvar_Set("sv_killserver", "1");
-
-	CL_Disconnect(qtrue);
+	char       retry[MAX_OSPATH];
+	const char *ext_test;
+	int        protocol, i;
+	long       length = -1;
 
-	Cvar_Set("cl_autorecord", "0");
+	*demofile = 0;
 
-	// open the demo file
-	arg = Cmd_Argv(1);
 	// check for an extension .DEMOEXT_?? (?? is protocol)
 	ext_test = strrchr(arg, '.');
 
@@ -1420,8 +2546,8 @@ void CL_PlayDemo_f(void)
 
 		if (demo_protocols[i] || protocol == PROTOCOL_VERSION)
 		{
-			Com_sprintf(name, sizeof(name), "demos/%s", arg);
-			FS_FOpenFileRead(name, &clc.demofile, qtrue);
+			Com_sprintf(name, MAX_OSPATH, "demos/%s", arg);
+			length = FS_FOpenFileRead(name, demofile, qtrue);
 		}
 		else
 		{
@@ -1437,14 +2563,53 @@ void CL_PlayDemo_f(void)
 
 			Q_strncpyz(retry, arg, len + 1);
 			retry[len] = '\0';
-			protocol   = CL_WalkDemoExt(retry, name, &clc.demofile);
+			(void) CL_WalkDemoExt(retry, name, demofile, &length);
 		}
 	}
 	else
 	{
-		protocol = CL_WalkDemoExt(arg, name, &clc.demofile);
+		(void) CL_WalkDemoExt(arg, name, demofile, &length);
+	}
+
+	// compressed demos are read through their uncompressed stream
+	if (*demofile)
+	{
+		long rawLength = FS_DetectBlockCompression(*demofile);
+
+		if (rawLength >= 0)
+		{
+			length = rawLength;
+		}
+	}
+
+	return length;
+}
+
+/**
+ * @brief Usage: demo \<demoname\>
+ */
+void CL_PlayDemo_f(void)
+{
+	char name[MAX_OSPATH], arg[MAX_OSPATH];
+	long length;
+
+	if (Cmd_Argc() != 2)
+	{
+		Com_FuncPrinf("playdemo <demoname>\n");
+		return;
 	}
 
+	// make sure a local server is killed
+	Cvar_Set("sv_killserver", "1");
+
+	CL_Disconnect(qtrue);
+
+	Cvar_Set("cl_autorecord", "0");
+
+	// open the demo file, keep the name as the demo scan tokenizes server commands
+	Q_strncpyz(arg, Cmd_Argv(1), sizeof(arg));
+	length = CL_OpenDemoFile(arg, name, &clc.demofile);
+
 	if (!clc.demofile)
 	{
 		Com_FuncDrop("couldn't open %s", name);
@@ -1454,8 +2619,11 @@ void CL_PlayDemo_f(void)
 	Con_Close();
 
 #if NEW_DEMOFUNC
-	CL_AllocateDemoPoints();
-	CL_ParseDemo();
+	CL_ParseDemo(name, length);
+	if (!demoIndex.numCheckpoints)
+	{
+		CL_AllocateDemoPoints();
+	}
 #endif
 
 	cls.state       = CA_CONNECTED;
@@ -1501,6 +2669,47 @@ void CL_NextDemo(void)
 }
 
 #if NEW_DEMOFUNC
+/**
+ * @brief Usage: indexdemo \<demoname\>
+ *
+ * Builds the seek index of a demo without playing it
+ */
+void CL_IndexDemo_f(void)
+{
+	char name[MAX_OSPATH], arg[MAX_OSPATH];
+	long length;
+
+	if (Cmd_Argc() != 2)
+	{
+		Com_FuncPrinf("indexdemo <demoname>\n");
+		return;
+	}
+
+	if (cls.state != CA_DISCONNECTED || clc.demoplaying)
+	{
+		Com_FuncPrinf("can't index a demo while connected or playing one\n");
+		return;
+	}
+
+	if (cl_demoIndex->integer <= 0)
+	{
+		Com_FuncPrinf("demo index is disabled, see cl_demoIndex\n");
+		return;
+	}
+
+	Q_strncpyz(arg, Cmd_Argv(1), sizeof(arg));
+	length = CL_OpenDemoFile(arg, name, &clc.demofile);
+
+	if (!clc.demofile)
+	{
+		Com_FuncPrinf("couldn't open %s\n", name);
+		return;
+	}
+
+	CL_ParseDemo(name, length);
+	CL_DemoCleanUp();
+}
+
 /**
  * @brief CL_Rewind_f
  */
@@ -1784,6 +2993,8 @@ void CL_DemoInit(void)
 	Cmd_SetCommandCompletionFunc("demo", CL_CompleteDemoName);
 	Cmd_AddCommand("pausedemo", CL_PauseDemo_f);
 
+	cl_demoCompress = Cvar_Get("cl_demoCompress", "0", CVAR_ARCHIVE);
+
 #if NEW_DEMOFUNC
 	Cmd_AddCommand("rewind", CL_Rewind_f);
 	Cmd_AddCommand("fastforward", CL_FastForward_f);
@@ -1792,7 +3003,10 @@ void CL_DemoInit(void)
 	Cmd_AddCommand("seekend", CL_SeekEnd_f);
 	Cmd_AddCommand("seeknext", CL_SeekNext_f);
 	Cmd_AddCommand("seekprev", CL_SeekPrev_f);
+	Cmd_AddCommand("indexdemo", CL_IndexDemo_f);
+	Cmd_SetCommandCompletionFunc("indexdemo", CL_CompleteDemoName);
 
 	cl_maxRewindBackups = Cvar_Get("cl_maxRewindBackups", va("%i", MAX_REWIND_BACKUPS), CVAR_ARCHIVE | CVAR_LATCH);
+	cl_demoIndex        = Cvar_Get("cl_demoIndex", "5", CVAR_ARCHIVE);
 #endif
 }
@@ -2604,6 +2604,55 @@ void CL_RefTagFree(void)
 	return;
 }
 
+#ifdef HUNK_DEBUG
+/**
+ * @brief Hunk allocation accounted to the renderer sub-arena
+ * @param[in] size
+ * @param[in] pref
+ * @param[in] label
+ * @param[in] file
+ * @param[in] line
+ * @return
+ */
+static void *CL_RefHunkAllocDebug(unsigned int size, ha_pref pref, char *label, char *file, int line)
+{
+	hunkTag_t oldTag = Hunk_SetTag(HUNK_TAG_RENDERER);
+	void      *buf   = Hunk_AllocDebug(size, pref, label, file, line);
+
+	Hunk_SetTag(oldTag);
+	return buf;
+}
+#else
+/**
+ * @brief Hunk allocation accounted to the renderer sub-arena
+ * @param[in] size
+ * @param[in] pref
+ * @return
+ */
+static void *CL_RefHunkAlloc(unsigned int size, ha_pref pref)
+{
+	hunkTag_t oldTag = Hunk_SetTag(HUNK_TAG_RENDERER);
+	void      *buf   = Hunk_Alloc(size, pref);
+
+	Hunk_SetTag(oldTag);
+	return buf;
+}
+#endif
+
+/**
+ * @brief Temp hunk allocation accounted to the renderer sub-arena
+ * @param[in] size
+ * @return
+ */
+static void *CL_RefHunkAllocateTempMemory(size_t size)
+{
+	hunkTag_t oldTag = Hunk_SetTag(HUNK_TAG_RENDERER);
+	void      *buf   = Hunk_AllocateTempMemory(size);
+
+	Hunk_SetTag(oldTag);
+	return buf;
+}
+
 /**
  * @brief CL_ScaledMilliseconds
  * @return
@@ -2683,11 +2732,11 @@ void CL_InitRef(void)
 	ri.Tag_Free   = CL_RefTagFree;
 	ri.Hunk_Clear = Hunk_ClearToMark;
 #ifdef HUNK_DEBUG
-	ri.Hunk_AllocDebug = Hunk_AllocDebug;
+	ri.Hunk_AllocDebug = CL_RefHunkAllocDebug;
 #else
-	ri.Hunk_Alloc = Hunk_Alloc;
+	ri.Hunk_Alloc = CL_RefHunkAlloc;
 #endif
-	ri.Hunk_AllocateTempMemory = Hunk_AllocateTempMemory;
+	ri.Hunk_AllocateTempMemory = CL_RefHunkAllocateTempMemory;
 	ri.Hunk_FreeTempMemory     = Hunk_FreeTempMemory;
 
 	//ri.CM_ClusterPVS = CM_ClusterPVS;
@@ -2885,6 +2934,7 @@ void CL_Init(void)
 	Cvar_Get("rate", "25000", CVAR_USERINFO | CVAR_ARCHIVE);
 	Cvar_Get("snaps", "20", CVAR_USERINFO | CVAR_ARCHIVE);
 	Cvar_Get("etVersion", ET_VERSION, CVAR_USERINFO | CVAR_ROM);
+	Cvar_Get("etFeatures", va("%i", UA_FEATURES), CVAR_USERINFO | CVAR_ROM);
 
 	Cvar_Get("password", "", CVAR_USERINFO);
 	Cvar_Get("cg_predictItems", "1", CVAR_ARCHIVE);
@@ -3049,6 +3099,7 @@ void CL_Shutdown(void)
 	Cmd_RemoveCommand("seekend");
 	Cmd_RemoveCommand("seeknext");
 	Cmd_RemoveCommand("seekprev");
+	Cmd_RemoveCommand("indexdemo");
 #endif
 
 	Con_Shutdown();
@@ -46,7 +46,8 @@ const char *svc_strings[32] =
 	"svc_serverCommand",
 	"svc_download",
 	"svc_snapshot",
-	"svc_EOF"
+	"svc_EOF",
+	"svc_baselineDelta"
 };
 
 /**
@@ -724,7 +725,8 @@ void CL_ParseGamestate(msg_t *msg)
 	entityState_t *es;
 	int           newnum;
 	entityState_t nullstate;
-	int           cmd;
+	int           cmd, start, back, count = 0;
+	int           recent[BASELINE_DELTA_BACKUP];
 	char          *s;
 
 	// Con_Close();
@@ -741,7 +743,8 @@ void CL_ParseGamestate(msg_t *msg)
 	cl.gameState.dataCount = 1; // leave a 0 at the beginning for uninitialized configstrings
 	while (1)
 	{
-		cmd = MSG_ReadByte(msg);
+		start = msg->bit;
+		cmd   = MSG_ReadByte(msg);
 
 		if (cmd == svc_EOF)
 		{
@@ -780,6 +783,27 @@ void CL_ParseGamestate(msg_t *msg)
 			Com_Memset(&nullstate, 0, sizeof(nullstate));
 			es = &cl.entityBaselines[newnum];
 			MSG_ReadDeltaEntity(msg, &nullstate, es, newnum);
+
+			recent[count++ & (BASELINE_DELTA_BACKUP - 1)] = newnum;
+		}
+		else if (cmd == svc_baselineDelta)
+		{
+			back = MSG_ReadBits(msg, BASELINE_DELTA_BITS);
+			if (back < 1 || back > count)
+			{
+				Com_Error(ERR_DROP, "Baseline delta out of range: %i", back);
+			}
+			newnum = MSG_ReadBits(msg, GENTITYNUM_BITS);
+			if (newnum < 0 || newnum >= MAX_GENTITIES)
+			{
+				Com_Error(ERR_DROP, "Baseline number out of range: %i", newnum);
+			}
+			es = &cl.entityBaselines[newnum];
+			MSG_ReadDeltaEntity(msg, &cl.entityBaselines[recent[(count - back) & (BASELINE_DELTA_BACKUP - 1)]], es, newnum);
+
+			recent[count++ & (BASELINE_DELTA_BACKUP - 1)] = newnum;
+
+			CL_DemoRecordBaseline(msg, start, newnum);
 		}
 		else
 		{
@@ -1057,7 +1081,7 @@ void CL_ParseBinaryMessage(msg_t *msg)
  */
 void CL_ParseServerMessage(msg_t *msg)
 {
-	int cmd;
+	int cmd, start;
 
 	if (cl_shownet->integer == 1)
 	{
@@ -1069,6 +1093,7 @@ void CL_ParseServerMessage(msg_t *msg)
 	}
 
 	MSG_Bitstream(msg);
+	CL_DemoRecordBeginMessage();
 
 	// get the reliable sequence acknowledge number
 	clc.reliableAcknowledge = MSG_ReadLong(msg);
@@ -1086,7 +1111,8 @@ void CL_ParseServerMessage(msg_t *msg)
 			Com_Error(ERR_DROP, "CL_ParseServerMessage: read past end of server message");
 		}
 
-		cmd = MSG_ReadByte(msg);
+		start = msg->bit;
+		cmd   = MSG_ReadByte(msg);
 
 		if (cmd == svc_EOF)
 		{
@@ -1122,9 +1148,11 @@ void CL_ParseServerMessage(msg_t *msg)
 			break;
 		case svc_serverCommand:
 			CL_ParseCommandString(msg);
+			CL_DemoRecordCommand(msg, start);
 			break;
 		case svc_gamestate:
 			CL_ParseGamestate(msg);
+			CL_DemoRecordGamestate();
 			break;
 		case svc_snapshot:
 			CL_ParseSnapshot(msg);
@@ -1135,5 +1163,7 @@ void CL_ParseServerMessage(msg_t *msg)
 		}
 	}
 
+	CL_DemoRecordEndMessage(msg);
+
 	CL_ParseBinaryMessage(msg);
 }
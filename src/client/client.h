@@ -497,6 +497,11 @@ extern demoPlayInfo_t dpi;
 void CL_DemoCleanUp(void);
 void CL_DemoCompleted(void);
 void CL_WriteDemoMessage(msg_t *msg, int headerBytes);
+void CL_DemoRecordBeginMessage(void);
+void CL_DemoRecordCommand(msg_t *msg, int start);
+void CL_DemoRecordBaseline(msg_t *msg, int start, int num);
+void CL_DemoRecordGamestate(void);
+void CL_DemoRecordEndMessage(msg_t *msg);
 void CL_StopRecord_f(void);
 void CL_DemoRun(void);
 void CL_DemoInit(void);
@@ -242,6 +242,7 @@ qboolean S_LoadSound(sfx_t *sfx)
 	byte       *data;
 	short      *samples;
 	snd_info_t info;
+	hunkTag_t  oldTag;
 
 	// player specific sounds are never directly loaded
 	if (sfx->soundName[0] == '*')
@@ -264,10 +265,13 @@ qboolean S_LoadSound(sfx_t *sfx)
 		return qfalse;
 	}
 
+	oldTag = Hunk_SetTag(HUNK_TAG_SOUND);
+
 	// load it in
 	data = S_CodecLoad(sfx->soundName, &info);
 	if (!data)
 	{
+		Hunk_SetTag(oldTag);
 		return qfalse;
 	}
 
@@ -326,6 +330,8 @@ qboolean S_LoadSound(sfx_t *sfx)
 	Hunk_FreeTempMemory(samples);
 	Hunk_FreeTempMemory(data);
 
+	Hunk_SetTag(oldTag);
+
 	return qtrue;
 }
 
@@ -66,6 +66,38 @@ extern vmCvar_t g_pronedelay;
 pmove_t *pm;
 pml_t   pml;
 
+#define PM_TRACE_MEMO 8 ///< traces remembered during a Pmove
+
+/**
+ * @struct pmTraceMemoEntry_t
+ * @brief A trace of the current Pmove with its arguments
+ */
+typedef struct
+{
+	vec3_t start, end;
+	vec3_t mins, maxs;
+	int passEntityNum;
+	int contentMask;
+	trace_t trace;
+} pmTraceMemoEntry_t;
+
+/**
+ * @struct pmTraceMemo_t
+ * @brief The traces of a Pmove, the world doesn't change during a Pmove so the same arguments give the same trace
+ *
+ * @details The ground, duck and prone checks and the step traces often trace the same box from the same origin,
+ * the ground trace at the end of a PmoveSingle is the one of the next when the origin hasn't changed.
+ */
+typedef struct
+{
+	void (*trace)(trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentMask);
+	pmTraceMemoEntry_t entries[PM_TRACE_MEMO];
+	int numEntries;
+	int next;                   ///< entry replaced by the next trace
+} pmTraceMemo_t;
+
+static pmTraceMemo_t pmTraceMemo;
+
 // movement parameters
 float pm_stopspeed = 100;
 
@@ -5167,6 +5199,64 @@ void PmoveSingle(pmove_t *pmove)
 	pm->ps->stats[STAT_SPRINTTIME] = pm->pmext->sprintTime;
 }
 
+/**
+ * @brief Trace callback of a Pmove, answers the traces already done from the memo
+ * @param[out] results
+ * @param[in] start
+ * @param[in] mins
+ * @param[in] maxs
+ * @param[in] end
+ * @param[in] passEntityNum
+ * @param[in] contentMask
+ */
+static void PM_TraceMemo(trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentMask)
+{
+	pmTraceMemoEntry_t *entry;
+	int                i;
+
+	if (!mins)
+	{
+		mins = vec3_origin;
+	}
+	if (!maxs)
+	{
+		maxs = vec3_origin;
+	}
+
+	for (i = 0; i < pmTraceMemo.numEntries; i++)
+	{
+		entry = &pmTraceMemo.entries[i];
+
+		// bitwise, a trace from -0 isn't quite the same as one from 0
+		if (entry->passEntityNum == passEntityNum && entry->contentMask == contentMask
+		    && !memcmp(entry->start, start, sizeof(vec3_t)) && !memcmp(entry->end, end, sizeof(vec3_t))
+		    && !memcmp(entry->mins, mins, sizeof(vec3_t)) && !memcmp(entry->maxs, maxs, sizeof(vec3_t)))
+		{
+			*results = entry->trace;
+			pm->numTraceHits++;
+			return;
+		}
+	}
+
+	pmTraceMemo.trace(results, start, mins, maxs, end, passEntityNum, contentMask);
+	pm->numTraces++;
+
+	entry = &pmTraceMemo.entries[pmTraceMemo.next];
+	VectorCopy(start, entry->start);
+	VectorCopy(end, entry->end);
+	VectorCopy(mins, entry->mins);
+	VectorCopy(maxs, entry->maxs);
+	entry->passEntityNum = passEntityNum;
+	entry->contentMask   = contentMask;
+	entry->trace         = *results;
+
+	pmTraceMemo.next = (pmTraceMemo.next + 1) % PM_TRACE_MEMO;
+	if (pmTraceMemo.numEntries < PM_TRACE_MEMO)
+	{
+		pmTraceMemo.numEntries++;
+	}
+}
+
 /**
  * @brief Can be called by either the server or the client
  * @param[in] pmove
@@ -5192,6 +5282,17 @@ int Pmove(pmove_t *pmove)
 
 	pm = pmove;
 
+	// the traces of the move go through the memo
+	if (!pmove->noTraceMemo)
+	{
+		pmTraceMemo.trace      = pmove->trace;
+		pmTraceMemo.numEntries = 0;
+		pmTraceMemo.next       = 0;
+		pmove->trace           = PM_TraceMemo;
+	}
+	pmove->numTraces    = 0;
+	pmove->numTraceHits = 0;
+
 	// chop the move up if it is too long, to prevent framerate
 	// dependent behavior
 	while (pmove->ps->commandTime != finalTime)
@@ -5229,6 +5330,11 @@ int Pmove(pmove_t *pmove)
 		}
 	}
 
+	if (!pmove->noTraceMemo)
+	{
+		pmove->trace = pmTraceMemo.trace;
+	}
+
 	if ((pm->ps->stats[STAT_HEALTH] <= 0 || pm->ps->pm_type == PM_DEAD) && (pml.groundTrace.surfaceFlags & SURF_MONSTERSLICK))
 	{
 		return (pml.groundTrace.surfaceFlags);
@@ -177,6 +177,7 @@ extern vec3_t playerHeadProneMaxs;
 #define SVF_IGNOREBMODELEXTENTS     0x00004000  ///< just use origin for in pvs check for snapshots, ignore the bmodel extents
 #define SVF_SELF_PORTAL             0x00008000  ///< use self->origin2 as portal
 #define SVF_SELF_PORTAL_EXCLUSIVE   0x00010000  ///< use self->origin2 as portal and DONT add self->origin PVS ents
+#define SVF_SHAREDSNAPSHOT          0x00020000  ///< client may get the unculled snapshot the server shares between spectators
 
 /**
  * @struct svCvar_s
@@ -641,6 +642,12 @@ typedef struct
 	/// used to determine if the player move is for prediction if it is, the movement should trigger no events
 	qboolean predict;
 
+	qboolean noTraceMemo;          ///< run every trace through the callback, to check the memo against
+
+	// trace counters of the last Pmove (out)
+	int numTraces;                 ///< traces run through the trace callback
+	int numTraceHits;              ///< traces answered by the trace memo instead
+
 } pmove_t;
 
 // if a full pmove isn't done on the client, you can just update the angles
@@ -2108,6 +2108,22 @@ void ClientEndFrame(gentity_t *ent)
 	// Zero out here and set only for certain specs
 	ent->client->ps.powerups[PW_BLACKOUT] = 0;
 
+	// shoutcasters and multiview spectators see the whole map anyway,
+	// so let the server send them the snapshot it builds once for all of them
+	if (ent->client->sess.sessionTeam == TEAM_SPECTATOR &&
+	    (ent->client->sess.shoutcaster
+#ifdef FEATURE_MULTIVIEW
+	     || ent->client->pers.mvCount > 0
+#endif
+	    ))
+	{
+		ent->r.svFlags |= SVF_SHAREDSNAPSHOT;
+	}
+	else
+	{
+		ent->r.svFlags &= ~SVF_SHAREDSNAPSHOT;
+	}
+
 	if ((ent->client->sess.sessionTeam == TEAM_SPECTATOR) || (ent->client->ps.pm_flags & PMF_LIMBO))
 	{
 		SpectatorClientEndFrame(ent);
@@ -32,6 +32,7 @@
 
 #include <sstream>
 #include <iomanip>
+#include <vector>
 
 extern "C"
 {
@@ -67,10 +68,188 @@ struct BotEntity
 	obint16 m_HandleSerial;
 	bool m_NewEntity : 1;
 	bool m_Used : 1;
+	bool m_Queued : 1;      // in g_EntityJournal
 };
 
 BotEntity m_EntityHandles[MAX_GENTITIES];
 
+// entities spawned since the last update, instead of scanning m_EntityHandles for m_NewEntity
+int g_EntityJournal[MAX_GENTITIES];
+int g_NumEntityJournal = 0;
+
+// the fields _GetEntityClass and _GetEntityTeam read, a cached classification is valid while they don't change
+struct BotEntityKey
+{
+	const char *m_ClassName;
+	const gitem_t *m_Item;
+	const gclient_t *m_Client;
+	int m_EntityType;
+	int m_EntState;
+	int m_SessionTeam;
+	int m_PlayerType;
+	int m_Weapon;
+	int m_TeamNum;
+	int m_ModelIndex;       // BODY_TEAM of corpses
+	int m_SpawnFlags;
+	int m_Count;
+	int m_Breakable;        // health > 0 && takedamage
+	int m_WeaponClass;
+};
+
+struct BotEntityCache
+{
+	BotEntityKey m_Key;
+	int m_Class;
+	int m_Team;
+	bool m_Valid;
+
+	// _GetEntityName of non clients
+	const char *m_NameSource[4];
+	bool m_NameValid;
+	char m_Name[256];
+};
+
+BotEntityCache g_EntityCache[MAX_GENTITIES];
+
+//////////////////////////////////////////////////////////////////////////
+
+// With sv_botThread the engine runs the library update after the frame with GAME_BOT_THINK,
+// on a thread. The calls that would change the world are queued and applied in the next frame.
+enum BotThinkCallType
+{
+	BOT_CALL_INPUT,
+	BOT_CALL_COMMAND,
+	BOT_CALL_ADDBOT,
+	BOT_CALL_REMOVEBOT,
+	BOT_CALL_CHANGETEAM,
+	BOT_CALL_CHANGECLASS,
+	BOT_CALL_MESSAGE,
+	BOT_CALL_PRINT,
+	BOT_CALL_PRINTERROR
+};
+
+struct BotThinkCall
+{
+	BotThinkCallType m_Type;
+	int m_Client;           // -1 when not for a bot
+	int m_Value;            // team or class
+	int m_MessageId;        // 0 without a message
+	GameEntity m_Entity;
+	ClientInput m_Input;
+	std::string m_Data;     // command, text or message block
+};
+
+struct BotThink
+{
+	bool m_Pending;         // GAME_BOT_THINK is due
+	bool m_Deferring;       // inside GAME_BOT_THINK, queue the calls
+	bool m_Unsupported;     // the engine didn't run GAME_BOT_THINK
+	std::vector<BotThinkCall> m_Calls;
+};
+
+BotThink g_BotThink;
+
+static BotThinkCall &Bot_ThinkCall(BotThinkCallType _type, int _client)
+{
+	g_BotThink.m_Calls.push_back(BotThinkCall());
+
+	BotThinkCall &call = g_BotThink.m_Calls.back();
+	call.m_Type = _type;
+	call.m_Client = _client;
+	call.m_Value = 0;
+	call.m_MessageId = 0;
+	return call;
+}
+
+static void Bot_ThinkCallMessage(BotThinkCall &_call, const MessageHelper *_data)
+{
+	if (_data)
+	{
+		_call.m_MessageId = _data->GetMessageId();
+		if (_data->GetBlockSize())
+		{
+			_call.m_Data.assign((const char *)_data->GetBlock(), _data->GetBlockSize());
+		}
+	}
+}
+
+// messages which only act, they don't return anything to the think
+static bool Bot_ThinkDefersMessage(int _msgId)
+{
+	switch (_msgId)
+	{
+	case GEN_MSG_CHANGENAME:
+	case GEN_MSG_ENTITYKILL:
+	case GEN_MSG_SERVERCOMMAND:
+	case GEN_MSG_GOTOWAYPOINT:
+	case ET_MSG_FIRETEAM_CREATE:
+	case ET_MSG_FIRETEAM_DISBAND:
+	case ET_MSG_FIRETEAM_LEAVE:
+	case ET_MSG_FIRETEAM_APPLY:
+	case ET_MSG_FIRETEAM_INVITE:
+	case ET_MSG_FIRETEAM_WARN:
+	case ET_MSG_FIRETEAM_KICK:
+	case ET_MSG_FIRETEAM_PROPOSE:
+	case ET_MSG_SETCVAR:
+		return true;
+	default:
+		return false;
+	}
+}
+
+// apply what the last think queued, bots may have left in between
+static void Bot_ThinkApplyCalls()
+{
+	std::vector<BotThinkCall> calls;
+	calls.swap(g_BotThink.m_Calls);
+
+	for (size_t i = 0; i < calls.size(); ++i)
+	{
+		BotThinkCall &call = calls[i];
+		MessageHelper msg(call.m_MessageId, call.m_Data.empty() ? 0 : &call.m_Data[0], (obuint32)call.m_Data.size());
+
+		if (call.m_Client >= 0)
+		{
+			gentity_t *bot = &g_entities[call.m_Client];
+			if (!bot->inuse || !bot->client || !IsBot(bot))
+			{
+				continue;
+			}
+		}
+
+		switch (call.m_Type)
+		{
+		case BOT_CALL_INPUT:
+			g_InterfaceFunctions->UpdateBotInput(call.m_Client, call.m_Input);
+			break;
+		case BOT_CALL_COMMAND:
+			g_InterfaceFunctions->BotCommand(call.m_Client, call.m_Data.c_str());
+			break;
+		case BOT_CALL_ADDBOT:
+			g_InterfaceFunctions->AddBot(msg);
+			break;
+		case BOT_CALL_REMOVEBOT:
+			g_InterfaceFunctions->RemoveBot(msg);
+			break;
+		case BOT_CALL_CHANGETEAM:
+			g_InterfaceFunctions->ChangeTeam(call.m_Client, call.m_Value, call.m_MessageId ? &msg : NULL);
+			break;
+		case BOT_CALL_CHANGECLASS:
+			g_InterfaceFunctions->ChangeClass(call.m_Client, call.m_Value, call.m_MessageId ? &msg : NULL);
+			break;
+		case BOT_CALL_MESSAGE:
+			g_InterfaceFunctions->InterfaceSendMessage(msg, call.m_Entity);
+			break;
+		case BOT_CALL_PRINT:
+			g_InterfaceFunctions->PrintMessage(call.m_Data.c_str());
+			break;
+		case BOT_CALL_PRINTERROR:
+			g_InterfaceFunctions->PrintError(call.m_Data.c_str());
+			break;
+		}
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////
 
 // utils partly taken from id code
@@ -1411,7 +1590,7 @@ void Bot_Util_AddGoal(const char *_type, gentity_t *_ent, int _team, const char
 	}
 }
 
-static int _GetEntityTeam(gentity_t *_ent)
+static int _FindEntityTeam(gentity_t *_ent)
 {
 	// FIXME: hack, when the game joins clients again after warmup, they are temporarily ET_GENERAL entities(LAME)
 	if (_ent->client && (_ent - g_entities) < MAX_CLIENTS)
@@ -1440,7 +1619,7 @@ static int _GetEntityTeam(gentity_t *_ent)
 	return 0;
 }
 
-static int _GetEntityClass(gentity_t *_ent)
+static int _FindEntityClass(gentity_t *_ent)
 {
 	// hack, when the game joins clients again after warmup, they are temporarily ET_GENERAL entities(LAME)
 	int t = _ent->s.eType;
@@ -1686,6 +1865,62 @@ static int _GetEntityClass(gentity_t *_ent)
 	return 0;
 }
 
+static void _GetEntityKey(gentity_t *_ent, BotEntityKey &_key)
+{
+	memset(&_key, 0, sizeof(_key));
+
+	_key.m_ClassName = _ent->classname;
+	_key.m_Item = _ent->item;
+	_key.m_Client = _ent->client;
+	_key.m_EntityType = _ent->s.eType;
+	_key.m_EntState = _ent->entstate;
+	if (_ent->client)
+	{
+		_key.m_SessionTeam = _ent->client->sess.sessionTeam;
+		_key.m_PlayerType = _ent->client->sess.latchPlayerType;
+	}
+	_key.m_Weapon = _ent->s.weapon;
+	_key.m_TeamNum = _ent->s.teamNum;
+	_key.m_ModelIndex = _ent->s.modelindex;
+	_key.m_SpawnFlags = _ent->spawnflags;
+	_key.m_Count = _ent->count > 0;
+	_key.m_Breakable = (_ent->health > 0) && (_ent->takedamage == qtrue);
+	_key.m_WeaponClass = _ent->constructibleStats.weaponclass;
+}
+
+// classify again only when a field it depends on changed
+static BotEntityCache &_GetEntityCache(gentity_t *_ent)
+{
+	BotEntityCache &cache = g_EntityCache[_ent - g_entities];
+	BotEntityKey key;
+
+	_GetEntityKey(_ent, key);
+	if (!cache.m_Valid || memcmp(&key, &cache.m_Key, sizeof(key)))
+	{
+		cache.m_Key = key;
+		cache.m_Class = _FindEntityClass(_ent);
+		cache.m_Team = _FindEntityTeam(_ent);
+		cache.m_Valid = true;
+	}
+	return cache;
+}
+
+static int _GetEntityTeam(gentity_t *_ent)
+{
+	return _GetEntityCache(_ent).m_Team;
+}
+
+static int _GetEntityClass(gentity_t *_ent)
+{
+	return _GetEntityCache(_ent).m_Class;
+}
+
+static void _InvalidateEntityCache(int _entNum)
+{
+	g_EntityCache[_entNum].m_Valid = false;
+	g_EntityCache[_entNum].m_NameValid = false;
+}
+
 qboolean _TankIsMountable(gentity_t *_ent)
 {
 	if (!(_ent->spawnflags & 128))
@@ -1878,11 +2113,191 @@ qboolean InFieldOfVision(vec3_t viewangles, float fov, vec3_t angles)
 	return qtrue;
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Bot trace volume, see "bot tracestats"
+struct BotTraceStats
+{
+	int m_Traces;           // TraceLine and TraceLines requests
+	int m_Batched;          // of them through TraceLines
+	int m_Batches;          // TraceLines calls
+	int m_EngineTraces;     // traces that reached the engine
+	int m_EngineCalls;      // trap calls for them
+};
+
+static BotTraceStats g_BotTraceStats;       // current frame
+static BotTraceStats g_BotTraceLastFrame;
+static BotTraceStats g_BotTracePeak;
+static BotTraceStats g_BotTraceTotal;
+static int           g_BotTraceFrames = 0;
+
+// Game contents mask of a bot trace mask
+static int Bot_TraceMaskBotToGame(int _mask)
+{
+	int iMask = 0;
+
+	// Set up the collision masks
+	if (_mask & TR_MASK_ALL)
+	{
+		return MASK_ALL;
+	}
+
+	if (_mask & TR_MASK_SOLID)
+	{
+		iMask |= MASK_SOLID;
+	}
+	if (_mask & TR_MASK_PLAYER)
+	{
+		iMask |= MASK_PLAYERSOLID;
+	}
+	if (_mask & TR_MASK_SHOT)
+	{
+		iMask |= MASK_SHOT;
+	}
+	if (_mask & TR_MASK_OPAQUE)
+	{
+		iMask |= MASK_OPAQUE;
+	}
+	if (_mask & TR_MASK_WATER)
+	{
+		iMask |= MASK_WATER;
+	}
+	if (_mask & TR_MASK_PLAYERCLIP)
+	{
+		iMask |= CONTENTS_PLAYERCLIP;
+	}
+	if (_mask & (TR_MASK_FLOODFILL | TR_MASK_FLOODFILLENT))
+	{
+		iMask |= CONTENTS_PLAYERCLIP | CONTENTS_SOLID;
+	}
+	return iMask;
+}
+
+// The smoke bomb blocking a bot trace
+static gentity_t *Bot_TraceSmokeBlocker(const float _start[3], const float _end[3], int _mask)
+{
+	if ((_mask & TR_MASK_ALL) || !(_mask & TR_MASK_SMOKEBOMB))
+	{
+		return NULL;
+	}
+	return Bot_EntInvisibleBySmokeBomb((float *)_start, (float *)_end);
+}
+
+// Fill in a bot trace result
+static void Bot_TraceResultFromTrace(obTraceResult &_result, const trace_t &tr)
+{
+	if ((tr.entityNum != ENTITYNUM_WORLD) && (tr.entityNum != ENTITYNUM_NONE))
+	{
+		_result.m_HitEntity = HandleFromEntity(&g_entities[tr.entityNum]);
+	}
+	else
+	{
+		_result.m_HitEntity.Reset();
+	}
+
+	//_result.m_iUser1 = tr.surfaceFlags;
+
+	// Fill in the bot traceflag.
+	_result.m_Fraction = tr.fraction;
+	_result.m_StartSolid = tr.startsolid;
+	_result.m_Endpos[0] = tr.endpos[0];
+	_result.m_Endpos[1] = tr.endpos[1];
+	_result.m_Endpos[2] = tr.endpos[2];
+	_result.m_Normal[0] = tr.plane.normal[0];
+	_result.m_Normal[1] = tr.plane.normal[1];
+	_result.m_Normal[2] = tr.plane.normal[2];
+	_result.m_Contents = obUtilBotContentsFromGameContents(tr.contents);
+	_result.m_Surface = obUtilBotSurfaceFromGameSurface(tr.surfaceFlags);
+}
+
+// Run the pending traces of a TraceLines in one engine call, one call each on an engine without G_TRACEBATCH
+static void Bot_TraceBatch(const traceRequest_t *_requests, trace_t *_traces, const int *_index, int _count, obTraceResult *_results)
+{
+	if (level.engineFeatures & GAME_ENGINE_TRACEBATCH)
+	{
+		trap_TraceBatch(_traces, _requests, _count);
+		++g_BotTraceStats.m_EngineCalls;
+	}
+	else
+	{
+		for (int i = 0; i < _count; ++i)
+		{
+			trap_Trace(&_traces[i], _requests[i].start, _requests[i].mins, _requests[i].maxs, _requests[i].end,
+			           _requests[i].passEntityNum, _requests[i].contentmask);
+		}
+		g_BotTraceStats.m_EngineCalls += _count;
+	}
+
+	g_BotTraceStats.m_EngineTraces += _count;
+
+	for (int i = 0; i < _count; ++i)
+	{
+		Bot_TraceResultFromTrace(_results[_index[i]], _traces[i]);
+	}
+}
+
+// Close the trace counters of a frame
+static void Bot_TraceStatsFrame()
+{
+	g_BotTraceLastFrame = g_BotTraceStats;
+
+	g_BotTraceTotal.m_Traces += g_BotTraceStats.m_Traces;
+	g_BotTraceTotal.m_Batched += g_BotTraceStats.m_Batched;
+	g_BotTraceTotal.m_Batches += g_BotTraceStats.m_Batches;
+	g_BotTraceTotal.m_EngineTraces += g_BotTraceStats.m_EngineTraces;
+	g_BotTraceTotal.m_EngineCalls += g_BotTraceStats.m_EngineCalls;
+
+	if (g_BotTraceStats.m_Traces > g_BotTracePeak.m_Traces)
+	{
+		g_BotTracePeak = g_BotTraceStats;
+	}
+
+	++g_BotTraceFrames;
+	memset(&g_BotTraceStats, 0, sizeof(g_BotTraceStats));
+}
+
+// Print the trace counters, "bot tracestats reset" clears them
+static void Bot_TraceStatsPrint()
+{
+	char buffer[16] = {};
+	trap_Argv(2, buffer, sizeof(buffer));
+
+	if (!Q_stricmp(buffer, "reset"))
+	{
+		memset(&g_BotTraceLastFrame, 0, sizeof(g_BotTraceLastFrame));
+		memset(&g_BotTracePeak, 0, sizeof(g_BotTracePeak));
+		memset(&g_BotTraceTotal, 0, sizeof(g_BotTraceTotal));
+		g_BotTraceFrames = 0;
+		return;
+	}
+
+	G_Printf("frame    traces  batched  batches  engine traces  engine calls\n");
+	G_Printf("last   %7i  %7i  %7i  %13i  %12i\n", g_BotTraceLastFrame.m_Traces, g_BotTraceLastFrame.m_Batched,
+	         g_BotTraceLastFrame.m_Batches, g_BotTraceLastFrame.m_EngineTraces, g_BotTraceLastFrame.m_EngineCalls);
+	G_Printf("peak   %7i  %7i  %7i  %13i  %12i\n", g_BotTracePeak.m_Traces, g_BotTracePeak.m_Batched,
+	         g_BotTracePeak.m_Batches, g_BotTracePeak.m_EngineTraces, g_BotTracePeak.m_EngineCalls);
+	if (g_BotTraceFrames)
+	{
+		G_Printf("avg    %7i  %7i  %7i  %13i  %12i  (%i frames)\n", g_BotTraceTotal.m_Traces / g_BotTraceFrames,
+		         g_BotTraceTotal.m_Batched / g_BotTraceFrames, g_BotTraceTotal.m_Batches / g_BotTraceFrames,
+		         g_BotTraceTotal.m_EngineTraces / g_BotTraceFrames, g_BotTraceTotal.m_EngineCalls / g_BotTraceFrames,
+		         g_BotTraceFrames);
+	}
+}
+
 class ETInterface : public IEngineInterface
 {
 public:
+	// Connecting a client changes the client slots of the server, which its main thread walks
+	// while the think runs. So the think only queues the bot, it joins in the next frame and
+	// ClientConnect announces it to the library with GAME_CLIENTCONNECTED.
 	int AddBot(const MessageHelper &_data)
 	{
+		if (g_BotThink.m_Deferring)
+		{
+			Bot_ThinkCallMessage(Bot_ThinkCall(BOT_CALL_ADDBOT, -1), &_data);
+			return -1;
+		}
+
 		OB_GETMSG(Msg_Addbot);
 
 		int num = trap_BotAllocateClient(0);
@@ -1925,6 +2340,12 @@ public:
 
 	void RemoveBot(const MessageHelper &_data)
 	{
+		if (g_BotThink.m_Deferring)
+		{
+			Bot_ThinkCallMessage(Bot_ThinkCall(BOT_CALL_REMOVEBOT, -1), &_data);
+			return;
+		}
+
 		OB_GETMSG(Msg_Kickbot);
 		if (pMsg->m_GameId != Msg_Kickbot::InvalidGameId)
 		{
@@ -1970,6 +2391,14 @@ public:
 
 	obResult ChangeTeam(int _client, int _newteam, const MessageHelper *_data)
 	{
+		if (g_BotThink.m_Deferring)
+		{
+			BotThinkCall &call = Bot_ThinkCall(BOT_CALL_CHANGETEAM, _client);
+			call.m_Value = _newteam;
+			Bot_ThinkCallMessage(call, _data);
+			return Success;
+		}
+
 #ifdef NOQUARTER
 		const char *teamName;
 #else
@@ -2090,6 +2519,14 @@ public:
 
 	obResult ChangeClass(int _client, int _newclass, const MessageHelper *_data)
 	{
+		if (g_BotThink.m_Deferring)
+		{
+			BotThinkCall &call = Bot_ThinkCall(BOT_CALL_CHANGECLASS, _client);
+			call.m_Value = _newclass;
+			Bot_ThinkCallMessage(call, _data);
+			return Success;
+		}
+
 		gentity_t *bot = &g_entities[_client];
 
 		// find playerclass if we didn't got one
@@ -2295,6 +2732,12 @@ public:
 
 	void UpdateBotInput(int _client, const ClientInput &_input)
 	{
+		if (g_BotThink.m_Deferring)
+		{
+			Bot_ThinkCall(BOT_CALL_INPUT, _client).m_Input = _input;
+			return;
+		}
+
 		static usercmd_t cmd;
 		gentity_t *bot = &g_entities[_client];
 
@@ -2554,6 +2997,12 @@ public:
 
 	void BotCommand(int _client, const char *_cmd)
 	{
+		if (g_BotThink.m_Deferring)
+		{
+			Bot_ThinkCall(BOT_CALL_COMMAND, _client).m_Data = _cmd;
+			return;
+		}
+
 		trap_EA_Command(_client, (char *)_cmd);
 	}
 
@@ -2566,105 +3015,124 @@ public:
 	                   const AABB *_pBBox, int _mask, int _user, obBool _bUsePVS)
 	{
 		qboolean bInPVS = _bUsePVS ? trap_InPVS(_start, _end) : qtrue;
+
+		++g_BotTraceStats.m_Traces;
+
 		if (bInPVS)
 		{
-			int iMask = 0;
-
-			// Set up the collision masks
-			if (_mask & TR_MASK_ALL)
-			{
-				iMask = MASK_ALL;
-			}
-			else
+			gentity_t *pSmokeBlocker = Bot_TraceSmokeBlocker(_start, _end, _mask);
+			if (pSmokeBlocker)
 			{
-				if (_mask & TR_MASK_SOLID)
-				{
-					iMask |= MASK_SOLID;
-				}
-				if (_mask & TR_MASK_PLAYER)
-				{
-					iMask |= MASK_PLAYERSOLID;
-				}
-				if (_mask & TR_MASK_SHOT)
-				{
-					iMask |= MASK_SHOT;
-				}
-				if (_mask & TR_MASK_OPAQUE)
-				{
-					iMask |= MASK_OPAQUE;
-				}
-				if (_mask & TR_MASK_WATER)
-				{
-					iMask |= MASK_WATER;
-				}
-				if (_mask & TR_MASK_PLAYERCLIP)
-				{
-					iMask |= CONTENTS_PLAYERCLIP;
-				}
-				if (_mask & (TR_MASK_FLOODFILL | TR_MASK_FLOODFILLENT))
-				{
-					iMask |= CONTENTS_PLAYERCLIP | CONTENTS_SOLID;
-				}
-
-				if (_mask & TR_MASK_SMOKEBOMB)
-				{
-					gentity_t *pSmokeBlocker = Bot_EntInvisibleBySmokeBomb((float *)_start, (float *)_end);
-					if (pSmokeBlocker)
-					{
-						_result.m_Fraction = 0.0f;
-						_result.m_HitEntity = HandleFromEntity(pSmokeBlocker);
-						return Success;
-					}
-				}
+				_result.m_Fraction = 0.0f;
+				_result.m_HitEntity = HandleFromEntity(pSmokeBlocker);
+				return Success;
 			}
 
 			trace_t tr;
 
+			++g_BotTraceStats.m_EngineTraces;
+
 			if (_mask & TR_MASK_FLOODFILL)
 			{
 				trap_TraceNoEnts(&tr, _start,
 				                 _pBBox ? _pBBox->m_Mins : NULL,
 				                 _pBBox ? _pBBox->m_Maxs : NULL,
-				                 _end, _user, iMask);
+				                 _end, _user, Bot_TraceMaskBotToGame(_mask));
 			}
 			else
 			{
 				trap_Trace(&tr, _start,
 				           _pBBox ? _pBBox->m_Mins : NULL,
 				           _pBBox ? _pBBox->m_Maxs : NULL,
-				           _end, _user, iMask);
+				           _end, _user, Bot_TraceMaskBotToGame(_mask));
 			}
 
-			if ((tr.entityNum != ENTITYNUM_WORLD) && (tr.entityNum != ENTITYNUM_NONE))
+			Bot_TraceResultFromTrace(_result, tr);
+		}
+		else
+		{
+			// Not in PVS
+			_result.m_Fraction = 0.0f;
+			_result.m_HitEntity.Reset();
+		}
+		return bInPVS ? Success : OutOfPVS;
+	}
+
+	int TraceLines(const obTraceRequest *_requests, obTraceResult *_results, obResult *_status, int _count)
+	{
+		traceRequest_t requests[MAX_TRACE_BATCH];
+		trace_t        traces[MAX_TRACE_BATCH];
+		int            index[MAX_TRACE_BATCH];
+		int            pending = 0;
+		int            n = 0;
+
+		g_BotTraceStats.m_Traces += _count;
+		g_BotTraceStats.m_Batched += _count;
+		++g_BotTraceStats.m_Batches;
+
+		for (int i = 0; i < _count; ++i)
+		{
+			const obTraceRequest &r = _requests[i];
+			obResult res = Success;
+
+			if (r.m_UsePVS && !trap_InPVS(r.m_Start, r.m_End))
 			{
-				_result.m_HitEntity = HandleFromEntity(&g_entities[tr.entityNum]);
+				// Not in PVS
+				_results[i].m_Fraction = 0.0f;
+				_results[i].m_HitEntity.Reset();
+				res = OutOfPVS;
 			}
 			else
 			{
-				_result.m_HitEntity.Reset();
-			}
+				gentity_t *pSmokeBlocker = Bot_TraceSmokeBlocker(r.m_Start, r.m_End, r.m_Mask);
+				if (pSmokeBlocker)
+				{
+					_results[i].m_Fraction = 0.0f;
+					_results[i].m_HitEntity = HandleFromEntity(pSmokeBlocker);
+				}
+				else
+				{
+					traceRequest_t &req = requests[pending];
 
-			//_result.m_iUser1 = tr.surfaceFlags;
+					VectorCopy(r.m_Start, req.start);
+					VectorCopy(r.m_End, req.end);
+					if (r.m_UseBBox)
+					{
+						VectorCopy(r.m_BBox.m_Mins, req.mins);
+						VectorCopy(r.m_BBox.m_Maxs, req.maxs);
+					}
+					else
+					{
+						VectorClear(req.mins);
+						VectorClear(req.maxs);
+					}
+					req.passEntityNum = (r.m_Mask & TR_MASK_FLOODFILL) ? -2 : r.m_User;
+					req.contentmask = Bot_TraceMaskBotToGame(r.m_Mask);
+					index[pending++] = i;
 
-			// Fill in the bot traceflag.
-			_result.m_Fraction = tr.fraction;
-			_result.m_StartSolid = tr.startsolid;
-			_result.m_Endpos[0] = tr.endpos[0];
-			_result.m_Endpos[1] = tr.endpos[1];
-			_result.m_Endpos[2] = tr.endpos[2];
-			_result.m_Normal[0] = tr.plane.normal[0];
-			_result.m_Normal[1] = tr.plane.normal[1];
-			_result.m_Normal[2] = tr.plane.normal[2];
-			_result.m_Contents = obUtilBotContentsFromGameContents(tr.contents);
-			_result.m_Surface = obUtilBotSurfaceFromGameSurface(tr.surfaceFlags);
+					if (pending == MAX_TRACE_BATCH)
+					{
+						Bot_TraceBatch(requests, traces, index, pending, _results);
+						pending = 0;
+					}
+				}
+			}
+
+			if (_status)
+			{
+				_status[i] = res;
+			}
+			if (res == Success)
+			{
+				++n;
+			}
 		}
-		else
+
+		if (pending)
 		{
-			// Not in PVS
-			_result.m_Fraction = 0.0f;
-			_result.m_HitEntity.Reset();
+			Bot_TraceBatch(requests, traces, index, pending, _results);
 		}
-		return bInPVS ? Success : OutOfPVS;
+		return n;
 	}
 
 	int GetPointContents(const float _pos[3])
@@ -4498,6 +4966,14 @@ public:
 
 	obResult InterfaceSendMessage(const MessageHelper &_data, const GameEntity _ent)
 	{
+		if (g_BotThink.m_Deferring && Bot_ThinkDefersMessage(_data.GetMessageId()))
+		{
+			BotThinkCall &call = Bot_ThinkCall(BOT_CALL_MESSAGE, -1);
+			call.m_Entity = _ent;
+			Bot_ThinkCallMessage(call, &_data);
+			return Success;
+		}
+
 		gentity_t *pEnt = EntityFromHandle(_ent);
 
 		switch (_data.GetMessageId())
@@ -5623,6 +6099,16 @@ public:
 			}
 			break;
 		}
+		case ET_MSG_TRACELINES:
+		{
+			OB_GETMSG(ET_TraceLines);
+			if (pMsg)
+			{
+				// without G_TRACEBATCH the library traces line by line
+				pMsg->m_MaxBatch = (level.engineFeatures & GAME_ENGINE_TRACEBATCH) ? MAX_TRACE_BATCH : 0;
+			}
+			break;
+		}
 		case ET_MSG_DISABLEBOTPUSH:
 		{
 			OB_GETMSG(ET_DisableBotPush);
@@ -5652,7 +6138,11 @@ public:
 
 	void PrintError(const char *_error)
 	{
-		if (_error)
+		if (_error && g_BotThink.m_Deferring)
+		{
+			Bot_ThinkCall(BOT_CALL_PRINTERROR, -1).m_Data = _error;
+		}
+		else if (_error)
 		{
 			G_Printf("%s%s\n", S_COLOR_RED, _error);
 		}
@@ -5660,7 +6150,11 @@ public:
 
 	void PrintMessage(const char *_msg)
 	{
-		if (_msg)
+		if (_msg && g_BotThink.m_Deferring)
+		{
+			Bot_ThinkCall(BOT_CALL_PRINT, -1).m_Data = _msg;
+		}
+		else if (_msg)
 		{
 			// et console doesn't support tabs, so
 			const int BufferSize = 1024;
@@ -5904,7 +6398,13 @@ void Bot_Interface_InitHandles()
 		m_EntityHandles[i].m_HandleSerial = 1;
 		m_EntityHandles[i].m_NewEntity = false;
 		m_EntityHandles[i].m_Used = false;
+		m_EntityHandles[i].m_Queued = false;
+		_InvalidateEntityCache(i);
 	}
+	g_NumEntityJournal = 0;
+
+	g_BotThink.m_Pending = false;
+	g_BotThink.m_Calls.clear();
 }
 
 int Bot_Interface_Init()
@@ -5965,6 +6465,11 @@ void Bot_Interface_ConsoleCommand(void)
 			Bot_Interface_Init();
 			return;
 		}
+		else if (!Q_stricmp(buffer, "tracestats"))
+		{
+			Bot_TraceStatsPrint();
+			return;
+		}
 
 		Arguments args;
 		for (int i = 0; i < trap_Argc(); ++i)
@@ -5990,12 +6495,21 @@ void Bot_Interface_ConsoleCommand(void)
 }
 
 extern "C" void script_mover_spawn(gentity_t *ent);
-void Bot_Interface_Update()
+qboolean Bot_Interface_Update()
 {
 	if (IsOmnibotLoaded())
 	{
 		char buf[1024] = { 0 };
 
+		if (g_BotThink.m_Pending)
+		{
+			// sv_botThread set on an engine without GAME_BOT_THINK
+			G_Printf(S_COLOR_YELLOW "Omni-bot: the engine doesn't run the bot think, sv_botThread is ignored\n");
+			g_BotThink.m_Pending = false;
+			g_BotThink.m_Unsupported = true;
+		}
+		Bot_ThinkApplyCalls();
+
 //#if defined(ETLEGACY_DEBUG)
 //		trap_Cvar_Set( "sv_cheats", "1" );
 //		trap_Cvar_Update(&g_cheats);
@@ -6095,23 +6609,52 @@ void Bot_Interface_Update()
 
 		//////////////////////////////////////////////////////////////////////////
 		// Register any pending entity updates.
-		for (int i = 0; i < MAX_GENTITIES; ++i)
+		// Bot_Event_EntityCreated may spawn more, they are appended and handled in this loop too.
+		int iKept = 0;
+		for (int j = 0; j < g_NumEntityJournal; ++j)
 		{
+			const int i = g_EntityJournal[j];
 			if (m_EntityHandles[i].m_NewEntity && g_entities[i].inuse)
 			{
-				if (g_entities[i].think != script_mover_spawn)
+				if (g_entities[i].think == script_mover_spawn)
 				{
-					m_EntityHandles[i].m_NewEntity = false;
-					Bot_Event_EntityCreated(&g_entities[i]);
+					// not spawned yet, look again next frame
+					g_EntityJournal[iKept++] = i;
+					continue;
 				}
+				m_EntityHandles[i].m_NewEntity = false;
+				Bot_Event_EntityCreated(&g_entities[i]);
 			}
+			m_EntityHandles[i].m_Queued = false;
 		}
+		g_NumEntityJournal = iKept;
 		//SendDeferredGoals();
 		//////////////////////////////////////////////////////////////////////////
-		// Call the libraries update.
+		// Call the libraries update, or let the engine call it with GAME_BOT_THINK.
+		if (!g_BotThink.m_Unsupported && trap_Cvar_VariableIntegerValue("sv_botThread"))
+		{
+			g_BotThink.m_Pending = true;
+			return qtrue;
+		}
 		g_BotFunctions.pfnUpdate();
+		Bot_TraceStatsFrame();
 		//////////////////////////////////////////////////////////////////////////
 	}
+	return qfalse;
+}
+
+void Bot_Interface_Think()
+{
+	if (IsOmnibotLoaded() && g_BotThink.m_Pending)
+	{
+		g_BotThink.m_Pending = false;
+
+		g_BotThink.m_Deferring = true;
+		g_BotFunctions.pfnUpdate();
+		g_BotThink.m_Deferring = false;
+
+		Bot_TraceStatsFrame();
+	}
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -6130,7 +6673,7 @@ qboolean Bot_Util_AllowPush(int weaponId)
 }
 
 //////////////////////////////////////////////////////////////////////////
-const char *_GetEntityName(gentity_t *_ent)
+static const char *_FindEntityName(gentity_t *_ent)
 {
 	// For goal names.
 	//if(_ent)
@@ -6234,6 +6777,26 @@ const char *_GetEntityName(gentity_t *_ent)
 	}
 	return NULL;
 }
+
+const char *_GetEntityName(gentity_t *_ent)
+{
+	if (!_ent || (_ent->inuse && _ent->client))
+	{
+		return _FindEntityName(_ent);
+	}
+
+	// clean the name again only when it comes from another string
+	BotEntityCache &cache = g_EntityCache[_ent - g_entities];
+	const char *sources[4] = { _ent->track, _ent->scriptName, _ent->targetname, _ent->message };
+
+	if (!cache.m_NameValid || memcmp(sources, cache.m_NameSource, sizeof(sources)))
+	{
+		Q_strncpyz(cache.m_Name, _FindEntityName(_ent), sizeof(cache.m_Name));
+		memcpy(cache.m_NameSource, sources, sizeof(sources));
+		cache.m_NameValid = true;
+	}
+	return cache.m_Name;
+}
 //////////////////////////////////////////////////////////////////////////
 qboolean Bot_Util_CheckForSuicide(gentity_t *ent)
 {
@@ -6726,7 +7289,14 @@ void Bot_Queue_EntityCreated(gentity_t *pEnt)
 {
 	if (pEnt)
 	{
-		m_EntityHandles[pEnt - g_entities].m_NewEntity = true;
+		const int iEntNum = pEnt - g_entities;
+		m_EntityHandles[iEntNum].m_NewEntity = true;
+		if (!m_EntityHandles[iEntNum].m_Queued)
+		{
+			m_EntityHandles[iEntNum].m_Queued = true;
+			g_EntityJournal[g_NumEntityJournal++] = iEntNum;
+		}
+		_InvalidateEntityCache(iEntNum);
 	}
 }
 void Bot_Event_EntityDeleted(gentity_t *pEnt)
@@ -6741,6 +7311,7 @@ void Bot_Event_EntityDeleted(gentity_t *pEnt)
 		}
 		m_EntityHandles[iEntNum].m_Used = false;
 		m_EntityHandles[iEntNum].m_NewEntity = false;
+		_InvalidateEntityCache(iEntNum);
 		while (++m_EntityHandles[iEntNum].m_HandleSerial == 0)
 		{
 		}
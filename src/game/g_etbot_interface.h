@@ -63,7 +63,8 @@ int Bot_Interface_Init();
 void Bot_Interface_InitHandles();
 int Bot_Interface_Shutdown();
 
-void Bot_Interface_Update();
+qboolean Bot_Interface_Update();
+void Bot_Interface_Think();
 
 void Bot_Interface_ConsoleCommand(void);
 
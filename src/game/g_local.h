@@ -1128,6 +1128,41 @@ typedef struct spawnPointState_s
 	char description[128];
 } spawnPointState_t;
 
+/**
+ * @struct moverStats_t
+ * @brief Push work of the movers since the map started or the last moverstats command
+ */
+typedef struct
+{
+	int startFrame;             ///< framenum the counters start at
+	int queries;                ///< entity queries for the swept volumes of the mover teams
+	int tests;                  ///< position tests of the pushed entities
+	int maxTests;               ///< most position tests in a frame
+	int frameTests;             ///< position tests of the current frame
+	int frame;                  ///< framenum frameTests counts
+	int pushes;                 ///< mover parts pushing
+	int skips;                  ///< mover parts which didn't cross new space, no push needed
+} moverStats_t;
+
+/**
+ * @struct teamMapStats_t
+ * @brief Spotting work of the team map data since the map started or the last teammapstats command
+ */
+typedef struct
+{
+	int startFrame;             ///< framenum the counters start at
+	int viewers;                ///< spotting updates of field ops and covert ops
+	int targets;                ///< enemy players and landmines checked by the viewers
+	int cellCulls;              ///< target points rejected with their grid cell, before any test of their own
+	int points;                 ///< target points tested one by one
+	int frustumCulls;           ///< tested points outside of the frustum
+	int pvsCulls;               ///< tested points outside of the PVS
+	int traces;                 ///< tested points traced
+	int maxTraces;              ///< most traces in a frame
+	int frameTraces;            ///< traces of the current frame
+	int frame;                  ///< framenum frameTraces counts
+} teamMapStats_t;
+
 /**
  * @struct level_locals_s
  * @typedef level_locals_t
@@ -1146,6 +1181,7 @@ typedef struct level_locals_s
 	fileHandle_t logFile;
 
 	qboolean etLegacyServer;
+	int engineFeatures;                         ///< GAME_ENGINE_* syscalls the engine announced in GAME_INIT
 
 	char rawmapname[MAX_QPATH];
 
@@ -1221,7 +1257,6 @@ typedef struct level_locals_s
 	int covertopsChargeTime[2];
 
 	int lastMapEntityUpdate;
-	int lastMapSpottedMinesUpdate;
 	int objectiveStatsAllies[MAX_OBJECTIVES];
 	int objectiveStatsAxis[MAX_OBJECTIVES];
 
@@ -1324,6 +1359,9 @@ typedef struct level_locals_s
 #endif
 
 	int frameStartTime;
+
+	moverStats_t moverStats;
+	teamMapStats_t teamMapStats;
 } level_locals_t;
 
 /**
@@ -1536,6 +1574,10 @@ gentity_t *G_BuildLeg(gentity_t *ent, grefEntity_t *refent, qboolean newRefent);
 
 // g_missile.c
 void G_RunMissile(gentity_t *ent);
+void G_ResetMissileBatch(void);
+void G_MissileBatchTouch(gentity_t *ent);
+void G_MissileStressFrame(void);
+void Svcmd_MissileStress_f(void);
 int G_PredictMissile(gentity_t *ent, int duration, vec3_t endPos, qboolean allowBounce); // unused
 
 // server side flamethrower collision
@@ -1552,6 +1594,7 @@ gentity_t *fire_flamebarrel(gentity_t *self, vec3_t start, vec3_t dir);
 gentity_t *G_TestEntityPosition(gentity_t *ent);
 void G_RunMover(gentity_t *ent);
 qboolean G_MoverPush(gentity_t *pusher, vec3_t move, vec3_t amove, gentity_t **obstacle);
+void Svcmd_MoverStats_f(void);
 void Use_BinaryMover(gentity_t *ent, gentity_t *other, gentity_t *activator);
 
 void G_TryDoor(gentity_t *ent, gentity_t *other, gentity_t *activator);
@@ -1673,6 +1716,26 @@ void QDECL G_Printf(const char *fmt, ...) _attribute((format(printf, 1, 2)));
 void QDECL G_DPrintf(const char *fmt, ...) _attribute((format(printf, 1, 2)));
 void QDECL G_Error(const char *fmt, ...) __attribute__ ((noreturn, format(printf, 1, 2)));
 
+/**
+ * @enum gameProfilerSection_t
+ * @brief Sections of the game frame timed by the engine profiler, see com_profiler
+ */
+typedef enum
+{
+	GPROF_ENTITIES,
+	GPROF_CLIENTS,
+	GPROF_MISSILES,
+	GPROF_MOVERS,
+	GPROF_CLIENT_END_FRAME,
+	GPROF_TEAM_MAP_DATA,
+	GPROF_LUA,
+	GPROF_BOTS,
+	GPROF_MAX
+} gameProfilerSection_t;
+
+void G_ProfilerBegin(gameProfilerSection_t section);
+void G_ProfilerEnd(void);
+
 // g_client.c
 char *ClientConnect(int clientNum, qboolean firstTime, qboolean isBot);
 void ClientUserinfoChanged(int clientNum);
@@ -2072,8 +2135,12 @@ extern vmCvar_t g_customConfig;
 extern vmCvar_t g_moverScale;
 
 extern vmCvar_t g_debugHitboxes;
+extern vmCvar_t g_profiler;
 extern vmCvar_t g_debugPlayerHitboxes;
 
+extern vmCvar_t g_teamMapStaleness;
+extern vmCvar_t g_missileBatch;
+
 extern vmCvar_t g_voting; ///< see VOTEF_* defines
 
 extern vmCvar_t g_corpses;
@@ -2155,6 +2222,7 @@ void trap_Trace(trace_t *results, const vec3_t start, const vec3_t mins, const v
 void trap_TraceCapsule(trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask);
 void trap_TraceCapsuleNoEnts(trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask);
 void trap_TraceNoEnts(trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask);
+void trap_TraceBatch(trace_t *results, const traceRequest_t *requests, int count);
 int trap_PointContents(const vec3_t point, int passEntityNum);
 qboolean trap_InPVS(const vec3_t p1, const vec3_t p2);
 qboolean trap_InPVSIgnorePortals(const vec3_t p1, const vec3_t p2);
@@ -2188,6 +2256,10 @@ void trap_SnapVector(float *v);
 qboolean trap_SendMessage(int clientNum, char *buf, int buflen);
 messageStatus_t trap_MessageStatus(int clientNum);
 
+int trap_ProfilerRegister(const char *name);
+void trap_ProfilerBegin(int id);
+void trap_ProfilerEnd(void);
+
 void G_ExplodeMissile(gentity_t *ent);
 
 void Svcmd_StartMatch_f(void);
@@ -2255,6 +2327,7 @@ mapEntityData_t *G_FindMapEntityDataSingleClient(mapEntityData_Team_t *teamList,
 
 void G_ResetTeamMapData(void);
 void G_UpdateTeamMapData(void);
+void Svcmd_TeamMapStats_f(void);
 
 void G_SetupFrustum(gentity_t *ent);
 void G_SetupFrustum_ForBinoculars(gentity_t *ent);
@@ -328,8 +328,12 @@ vmCvar_t g_fixedphysicsfps;
 vmCvar_t g_pronedelay;
 
 vmCvar_t g_debugHitboxes;
+vmCvar_t g_profiler;
 vmCvar_t g_debugPlayerHitboxes;
 
+vmCvar_t g_teamMapStaleness;
+vmCvar_t g_missileBatch;
+
 vmCvar_t g_voting;        // see VOTEF_ defines
 
 vmCvar_t g_corpses; // dynamic body que FIXME: limit max bodies by var value
@@ -638,6 +642,9 @@ cvarTable_t gameCvarTable[] =
 	{ &g_corpses,                         "g_corpses",                         "0",                          CVAR_LATCH | CVAR_ARCHIVE,                       0, qfalse, qfalse },
 	{ &g_realHead,                        "g_realHead",                        "1",                          0,                                               0, qfalse, qfalse },
 	{ &sv_fps,                            "sv_fps",                            "20",                         CVAR_SYSTEMINFO,                                 0, qfalse, qfalse },
+	{ &g_profiler,                        "com_profiler",                      "0",                          0,                                               0, qfalse, qfalse },
+	{ &g_teamMapStaleness,                "g_teamMapStaleness",                "1000",                       0,                                               0, qfalse, qfalse }, // ms between two spotting updates of a field ops or covert ops
+	{ &g_missileBatch,                    "g_missileBatch",                    "1",                          0,                                               0, qfalse, qfalse }, // trace the missile sweeps of a frame together, when the engine has G_TRACEBATCH
 	{ &g_skipCorrection,                  "g_skipCorrection",                  "1",                          0,                                               0, qfalse, qfalse },
 	{ &g_extendedNames,                   "g_extendedNames",                   "1",                          0,                                               0, qfalse, qfalse },
 #ifdef FEATURE_RATING
@@ -665,7 +672,7 @@ static int gameCvarTableSize = sizeof(gameCvarTable) / sizeof(gameCvarTable[0]);
  */
 static int fActions = 0;
 
-void G_InitGame(int levelTime, int randomSeed, int restart, int legacyServer, int serverVersion);
+void G_InitGame(int levelTime, int randomSeed, int restart, int legacyServer, int serverVersion, int engineFeatures);
 void G_RunFrame(int levelTime);
 void G_ShutdownGame(int restart);
 void CheckExitRules(void);
@@ -717,7 +724,7 @@ Q_EXPORT intptr_t vmMain(intptr_t command, intptr_t arg0, intptr_t arg1, intptr_
 
 		Bot_Interface_InitHandles();
 #endif
-		G_InitGame(arg0, arg1, arg2, arg3, arg4);
+		G_InitGame(arg0, arg1, arg2, arg3, arg4, arg5);
 		G_Printf("Game Initialization completed in %.2f seconds\n", ((float)trap_Milliseconds() - time) / 1000.f);
 #ifdef FEATURE_OMNIBOT
 
@@ -761,7 +768,13 @@ Q_EXPORT intptr_t vmMain(intptr_t command, intptr_t arg0, intptr_t arg1, intptr_
 	case GAME_RUN_FRAME:
 		G_RunFrame(arg0);
 #ifdef FEATURE_OMNIBOT
-		Bot_Interface_Update();
+		G_ProfilerBegin(GPROF_BOTS);
+		if (Bot_Interface_Update())
+		{
+			G_ProfilerEnd();
+			return GAME_BOT_THINK;
+		}
+		G_ProfilerEnd();
 #endif
 		return 0;
 	case GAME_CONSOLE_COMMAND:
@@ -770,6 +783,11 @@ Q_EXPORT intptr_t vmMain(intptr_t command, intptr_t arg0, intptr_t arg1, intptr_
 		return G_SnapshotCallback(arg0, arg1);
 	case GAME_MESSAGERECEIVED:
 		return -1;
+	case GAME_BOT_THINK:
+#ifdef FEATURE_OMNIBOT
+		Bot_Interface_Think();
+#endif
+		return 0;
 	default:
 		G_Printf("Bad game export type: %ld\n", (long int) command);
 		break;
@@ -2304,8 +2322,9 @@ void G_GetMapXP(void)
  * @param[in] restart
  * @param[in] etLegacyServer
  * @param[in] serverVersion
+ * @param[in] engineFeatures - GAME_ENGINE_* bits, 0 from older engines
  */
-void G_InitGame(int levelTime, int randomSeed, int restart, int etLegacyServer, int serverVersion)
+void G_InitGame(int levelTime, int randomSeed, int restart, int etLegacyServer, int serverVersion, int engineFeatures)
 {
 	int    i;
 	char   cs[MAX_INFO_STRING];
@@ -2371,6 +2390,7 @@ void G_InitGame(int levelTime, int randomSeed, int restart, int etLegacyServer,
 	level.time            = levelTime;
 	level.startTime       = levelTime;
 	level.server_settings = i;
+	level.engineFeatures  = (etLegacyServer == qtrue) ? engineFeatures : 0;
 
 	for (i = 0; i < level.numConnectedClients; i++)
 	{
@@ -2586,6 +2606,7 @@ void G_InitGame(int levelTime, int randomSeed, int restart, int etLegacyServer,
 	}
 
 	G_ResetTeamMapData();
+	G_ResetMissileBatch();
 
 	// initialize all entities for this game
 	Com_Memset(g_entities, 0, MAX_GENTITIES * sizeof(g_entities[0]));
@@ -4950,6 +4971,84 @@ void G_DrawEntBBox(gentity_t *ent)
 	G_RailBox(ent->r.currentOrigin, mins, maxs, tv(0.f, 1.f, 0.f), ent->s.number);
 }
 
+/**
+ * @var profilerSectionNames
+ * @brief Names of the gameProfilerSection_t in the traces
+ */
+static const char *profilerSectionNames[GPROF_MAX] =
+{
+	"G_RunEntities",
+	"G_RunClient",
+	"G_RunMissile",
+	"G_RunMover",
+	"ClientEndFrame",
+	"G_UpdateTeamMapData",
+	"G_LuaHook_RunFrame",
+	"Bot_Interface_Update",
+};
+
+/**
+ * @struct gameProfiler_s
+ * @brief Section ids of the engine profiler
+ */
+static struct gameProfiler_s
+{
+	qboolean registered;
+	qboolean active;            ///< com_profiler, latched for the frame so the sections stay paired
+	int sections[GPROF_MAX];
+} gameProfiler;
+
+/**
+ * @brief Latch com_profiler for the frame, registers the sections the first time it is set
+ *
+ * An engine without the profiler syscalls would drop the server on them, the game only
+ * makes them when the engine announced GAME_ENGINE_PROFILER.
+ */
+static void G_ProfilerFrame(void)
+{
+	int i;
+
+	if (!(level.engineFeatures & GAME_ENGINE_PROFILER))
+	{
+		gameProfiler.active = qfalse;
+		return;
+	}
+
+	if (g_profiler.integer && !gameProfiler.registered)
+	{
+		for (i = 0; i < GPROF_MAX; i++)
+		{
+			gameProfiler.sections[i] = trap_ProfilerRegister(profilerSectionNames[i]);
+		}
+		gameProfiler.registered = qtrue;
+	}
+
+	gameProfiler.active = (g_profiler.integer != 0);
+}
+
+/**
+ * @brief Open a section of the engine profiler
+ * @param[in] section
+ */
+void G_ProfilerBegin(gameProfilerSection_t section)
+{
+	if (gameProfiler.active)
+	{
+		trap_ProfilerBegin(gameProfiler.sections[section]);
+	}
+}
+
+/**
+ * @brief Close the innermost section of the engine profiler
+ */
+void G_ProfilerEnd(void)
+{
+	if (gameProfiler.active)
+	{
+		trap_ProfilerEnd();
+	}
+}
+
 /**
  * @brief G_RunEntity
  * @param[in,out] ent
@@ -5070,7 +5169,9 @@ void G_RunEntity(gentity_t *ent, int msec)
 		// pausing
 		if (level.match_pause == PAUSE_NONE)
 		{
+			G_ProfilerBegin(GPROF_MISSILES);
 			G_RunMissile(ent);
+			G_ProfilerEnd();
 		}
 		else
 		{
@@ -5114,7 +5215,9 @@ void G_RunEntity(gentity_t *ent, int msec)
 
 	if (ent->s.eType == ET_MOVER || ent->s.eType == ET_PROP)
 	{
+		G_ProfilerBegin(GPROF_MOVERS);
 		G_RunMover(ent);
+		G_ProfilerEnd();
 
 		// hack for instantaneous velocity
 		VectorSubtract(ent->r.currentOrigin, ent->oldOrigin, ent->instantVelocity);
@@ -5125,7 +5228,9 @@ void G_RunEntity(gentity_t *ent, int msec)
 
 	if (ent - g_entities < MAX_CLIENTS)
 	{
+		G_ProfilerBegin(GPROF_CLIENTS);
 		G_RunClient(ent);
+		G_ProfilerEnd();
 
 		// hack for instantaneous velocity
 		VectorSubtract(ent->r.currentOrigin, ent->oldOrigin, ent->instantVelocity);
@@ -5227,6 +5332,8 @@ void G_RunFrame(int levelTime)
 	// get any cvar changes
 	G_UpdateCvars();
 
+	G_ProfilerFrame();
+
 	G_ConfigCheckLocked();
 
 	for (i = 0; i < level.num_entities; i++)
@@ -5235,15 +5342,19 @@ void G_RunFrame(int levelTime)
 	}
 
 	// go through all allocated objects
+	G_ProfilerBegin(GPROF_ENTITIES);
 	for (i = 0; i < level.num_entities; i++)
 	{
 		G_RunEntity(&g_entities[i], msec);
 	}
+	G_ProfilerEnd();
 
+	G_ProfilerBegin(GPROF_CLIENT_END_FRAME);
 	for (i = 0; i < level.numConnectedClients; i++)
 	{
 		ClientEndFrame(&g_entities[level.sortedClients[i]]);
 	}
+	G_ProfilerEnd();
 
 	CheckWolfMP();
 
@@ -5259,7 +5370,9 @@ void G_RunFrame(int levelTime)
 	// for tracking changes
 	CheckCvars();
 
+	G_ProfilerBegin(GPROF_TEAM_MAP_DATA);
 	G_UpdateTeamMapData();
+	G_ProfilerEnd();
 
 	if (level.gameManager)
 	{
@@ -5267,9 +5380,13 @@ void G_RunFrame(int levelTime)
 		level.gameManager->s.otherEntityNum2 = team_maxLandmines.integer - G_CountTeamLandmines(TEAM_ALLIES);
 	}
 #ifdef FEATURE_LUA
+	G_ProfilerBegin(GPROF_LUA);
 	G_LuaHook_RunFrame(levelTime);
+	G_ProfilerEnd();
 #endif
 
+	G_MissileStressFrame();
+
 	level.frameStartTime = trap_Milliseconds();
 }
 
@@ -472,6 +472,287 @@ void Landmine_Check_Ground(gentity_t *self)
 	}
 }
 
+#define MAX_BATCH_CHANGES   128
+
+/**
+ * @struct missileBatch_t
+ * @brief Sweeps of the missiles of a frame, traced together through G_TRACEBATCH
+ *
+ * @details The sweeps are traced when the first missile of the frame runs. A missile
+ * takes its result on its turn unless its sweep changed, an entity with contents got
+ * linked across it since, or the entity it hit got linked, unlinked or lost the contents.
+ * Then it traces again on its own.
+ */
+typedef struct
+{
+	traceRequest_t requests[MAX_GENTITIES];
+	trace_t results[MAX_GENTITIES];
+	vec3_t sweepMins[MAX_GENTITIES];        ///< space a sweep may hit something in
+	vec3_t sweepMaxs[MAX_GENTITIES];
+	int entities[MAX_GENTITIES];            ///< missile of a sweep
+	int count;
+	int slot[MAX_GENTITIES];                ///< sweep + 1 of a missile, 0 if it has none
+	int touched[MAX_GENTITIES];             ///< batch an entity was last linked or unlinked in
+	vec3_t changedMins[MAX_BATCH_CHANGES];  ///< entities with contents linked since the sweeps were traced
+	vec3_t changedMaxs[MAX_BATCH_CHANGES];
+	int numChanged;                         ///< more than MAX_BATCH_CHANGES when too much changed to keep track
+	int batch;                              ///< number of the current batch
+	int frame;                              ///< framenum of the current batch
+} missileBatch_t;
+
+/**
+ * @struct missileStats_t
+ * @brief Sweeps of the missiles since the map started
+ */
+typedef struct
+{
+	int batches;                ///< G_TRACEBATCH passes
+	int batched;                ///< sweeps traced in a batch
+	int used;                   ///< batched sweeps taken by their missile
+	int retraced;               ///< batched sweeps traced again, something changed since
+	int single;                 ///< sweeps traced on their own, no batch for them
+} missileStats_t;
+
+/**
+ * @struct missileStress_t
+ * @brief A missilestress run, from the spawn of its missiles until the last of them is gone
+ */
+typedef struct
+{
+	qboolean active;
+	int spawnTime;              ///< level.time the missiles were spawned at
+	int entities[MAX_GENTITIES];
+	int count;
+	int frames;
+	int msec;                   ///< game frame time summed over the run
+	int maxMsec;
+	missileStats_t stats;       ///< sweep counters at the start of the run
+} missileStress_t;
+
+static missileBatch_t  missileBatch;
+static missileStats_t  missileStats;
+static missileStress_t missileStress;
+
+/**
+ * @brief Forget the batch and the stress run of the previous map
+ */
+void G_ResetMissileBatch(void)
+{
+	missileBatch.frame   = -1;
+	missileStress.active = qfalse;
+}
+
+/**
+ * @brief The sweep of a missile from its last position to the current one
+ * @param[in] ent
+ * @param[in] origin current position
+ * @param[in] clipmask
+ * @param[out] req
+ */
+static void G_MissileSweepRequest(gentity_t *ent, const vec3_t origin, int clipmask, traceRequest_t *req)
+{
+	VectorCopy(ent->r.currentOrigin, req->start);
+	VectorCopy(origin, req->end);
+	VectorCopy(ent->r.mins, req->mins);
+	VectorCopy(ent->r.maxs, req->maxs);
+	req->passEntityNum = ent->r.ownerNum;
+	req->contentmask   = clipmask;
+}
+
+/**
+ * @brief Trace the sweeps of the missiles which haven't run yet this frame
+ * @param[in] first missile running now
+ */
+static void G_MissileBatchTrace(gentity_t *first)
+{
+	int            i, j, clipmask;
+	gentity_t      *ent;
+	vec3_t         origin;
+	traceRequest_t *req;
+
+	for (i = 0; i < missileBatch.count; i++)
+	{
+		missileBatch.slot[missileBatch.entities[i]] = 0;
+	}
+
+	missileBatch.count      = 0;
+	missileBatch.numChanged = 0;
+	missileBatch.batch++;
+	missileBatch.frame = level.framenum;
+
+	for (i = 0, ent = g_entities; i < level.num_entities; i++, ent++)
+	{
+		if (!ent->inuse || (ent->runthisframe && ent != first))
+		{
+			continue;
+		}
+
+		if (ent->s.eType != ET_MISSILE && ent->s.eType != ET_FLAMEBARREL && ent->s.eType != ET_RAMJET)
+		{
+			continue;
+		}
+
+		BG_EvaluateTrajectory(&ent->s.pos, level.time, origin, qfalse, ent->s.effect2Time);
+
+		// same as the body check of G_RunMissile, a sweep it doesn't match is traced again
+		clipmask = ent->clipmask;
+		if ((clipmask & CONTENTS_BODY) && (GetWeaponTableData(ent->s.weapon)->firingMode & WEAPON_FIRING_MODE_THROWABLE)
+		    && ent->s.pos.trDelta[0] == 0.f && ent->s.pos.trDelta[1] == 0.f && ent->s.pos.trDelta[2] == 0.f)
+		{
+			clipmask &= ~CONTENTS_BODY;
+		}
+
+		req = &missileBatch.requests[missileBatch.count];
+		G_MissileSweepRequest(ent, origin, clipmask, req);
+
+		for (j = 0; j < 3; j++)
+		{
+			missileBatch.sweepMins[missileBatch.count][j] = MIN(req->start[j], req->end[j]) + req->mins[j] - 1;
+			missileBatch.sweepMaxs[missileBatch.count][j] = MAX(req->start[j], req->end[j]) + req->maxs[j] + 1;
+		}
+
+		missileBatch.entities[missileBatch.count++] = i;
+	}
+
+	// a lone missile gains nothing from a batch
+	if (missileBatch.count < 2)
+	{
+		missileBatch.count = 0;
+		return;
+	}
+
+	for (i = 0; i < missileBatch.count; i += MAX_TRACE_BATCH)
+	{
+		trap_TraceBatch(&missileBatch.results[i], &missileBatch.requests[i], MIN(missileBatch.count - i, MAX_TRACE_BATCH));
+		missileStats.batches++;
+	}
+
+	for (i = 0; i < missileBatch.count; i++)
+	{
+		missileBatch.slot[missileBatch.entities[i]] = i + 1;
+	}
+
+	missileStats.batched += missileBatch.count;
+}
+
+/**
+ * @brief Note an entity linked or unlinked while the batched sweeps wait for their missiles
+ * @param[in] ent
+ */
+void G_MissileBatchTouch(gentity_t *ent)
+{
+	if (missileBatch.frame != level.framenum || !missileBatch.count)
+	{
+		return;
+	}
+
+	missileBatch.touched[ent - g_entities] = missileBatch.batch;
+
+	// only entities with contents can get in the way of a sweep
+	if (ent->r.linked && ent->r.contents)
+	{
+		if (missileBatch.numChanged < MAX_BATCH_CHANGES)
+		{
+			VectorCopy(ent->r.absmin, missileBatch.changedMins[missileBatch.numChanged]);
+			VectorCopy(ent->r.absmax, missileBatch.changedMaxs[missileBatch.numChanged]);
+		}
+		missileBatch.numChanged++;
+	}
+}
+
+/**
+ * @brief Is a batched sweep still what a trace would return now
+ * @param[in] sweep
+ * @param[in] req the sweep the missile wants
+ * @return
+ */
+static qboolean G_MissileBatchValid(int sweep, const traceRequest_t *req)
+{
+	trace_t   *tr = &missileBatch.results[sweep];
+	gentity_t *hit;
+	int       i;
+
+	if (memcmp(req, &missileBatch.requests[sweep], sizeof(*req)))
+	{
+		return qfalse;
+	}
+
+	if (missileBatch.numChanged > MAX_BATCH_CHANGES)
+	{
+		return qfalse;
+	}
+
+	for (i = 0; i < missileBatch.numChanged; i++)
+	{
+		if (missileBatch.changedMins[i][0] <= missileBatch.sweepMaxs[sweep][0] && missileBatch.changedMaxs[i][0] >= missileBatch.sweepMins[sweep][0]
+		    && missileBatch.changedMins[i][1] <= missileBatch.sweepMaxs[sweep][1] && missileBatch.changedMaxs[i][1] >= missileBatch.sweepMins[sweep][1]
+		    && missileBatch.changedMins[i][2] <= missileBatch.sweepMaxs[sweep][2] && missileBatch.changedMaxs[i][2] >= missileBatch.sweepMins[sweep][2])
+		{
+			return qfalse;
+		}
+	}
+
+	// entities out of the way going away don't change the result, the one it stopped at does
+	if (tr->entityNum != ENTITYNUM_NONE && tr->entityNum != ENTITYNUM_WORLD)
+	{
+		hit = &g_entities[tr->entityNum];
+
+		if (missileBatch.touched[tr->entityNum] == missileBatch.batch || !hit->inuse || !(hit->r.contents & req->contentmask))
+		{
+			return qfalse;
+		}
+	}
+
+	return qtrue;
+}
+
+/**
+ * @brief Trace the sweep of a missile, the batched result is taken when it's still valid
+ * @param[in] ent
+ * @param[in] origin current position
+ * @param[out] tr
+ */
+static void G_MissileSweep(gentity_t *ent, vec3_t origin, trace_t *tr)
+{
+	traceRequest_t req;
+	int            slot;
+
+	G_MissileSweepRequest(ent, origin, ent->clipmask, &req);
+
+	if (g_missileBatch.integer && (level.engineFeatures & GAME_ENGINE_TRACEBATCH))
+	{
+		if (missileBatch.frame != level.framenum)
+		{
+			G_MissileBatchTrace(ent);
+		}
+
+		slot = missileBatch.slot[ent - g_entities];
+		if (slot)
+		{
+			missileBatch.slot[ent - g_entities] = 0;
+
+			if (G_MissileBatchValid(slot - 1, &req))
+			{
+				*tr = missileBatch.results[slot - 1];
+				missileStats.used++;
+				return;
+			}
+
+			missileStats.retraced++;
+		}
+		else
+		{
+			missileStats.single++;
+		}
+	}
+	else
+	{
+		missileStats.single++;
+	}
+
+	trap_Trace(tr, req.start, req.mins, req.maxs, req.end, req.passEntityNum, req.contentmask);
+}
+
 /**
  * @brief G_RunMissile
  * @param[in,out] ent
@@ -619,7 +900,7 @@ void G_RunMissile(gentity_t *ent)
 
 	// trace a line from the previous position to the current position,
 	// ignoring interactions with the missile owner
-	trap_Trace(&tr, ent->r.currentOrigin, ent->r.mins, ent->r.maxs, origin, ent->r.ownerNum, ent->clipmask);
+	G_MissileSweep(ent, origin, &tr);
 
 	VectorCopy(tr.endpos, ent->r.currentOrigin);
 	VectorCopy(angle, ent->r.currentAngles);
@@ -1795,3 +2076,135 @@ gentity_t *fire_flamebarrel(gentity_t *self, vec3_t start, vec3_t dir)
 
 	return bolt;
 }
+
+#define MAX_STRESS_SPOTS    64
+#define STRESS_MAX_FRAMES   400
+
+/**
+ * @brief Spawn grenades bouncing around the spawn points and report the frame time
+ * until the last of them is gone
+ */
+void Svcmd_MissileStress_f(void)
+{
+	char      arg[MAX_TOKEN_CHARS];
+	gentity_t *spots[MAX_STRESS_SPOTS];
+	gentity_t *spot = NULL, *missile;
+	int       numSpots = 0, count, available, i;
+	vec3_t    start, dir;
+
+	if (trap_Argc() < 2)
+	{
+		G_Printf("usage: missilestress <count>\n");
+		return;
+	}
+
+	if (missileStress.active)
+	{
+		G_Printf("missilestress: a run is already going on\n");
+		return;
+	}
+
+	while ((spot = G_Find(spot, FOFS(classname), "info_player_deathmatch")) != NULL && numSpots < MAX_STRESS_SPOTS)
+	{
+		spots[numSpots++] = spot;
+	}
+
+	if (!numSpots)
+	{
+		G_Printf("missilestress: no spawn points to throw from\n");
+		return;
+	}
+
+	// leave room for what the game spawns meanwhile
+	for (i = MAX_CLIENTS, available = ENTITYNUM_MAX_NORMAL - level.num_entities; i < level.num_entities; i++)
+	{
+		if (!g_entities[i].inuse)
+		{
+			available++;
+		}
+	}
+
+	trap_Argv(1, arg, sizeof(arg));
+	count = MIN(atoi(arg), available - 128);
+
+	if (count <= 0)
+	{
+		G_Printf("missilestress: not enough free entities\n");
+		return;
+	}
+
+	missileStress.spawnTime = level.time;
+	missileStress.count     = 0;
+
+	for (i = 0; i < count; i++)
+	{
+		spot = spots[i % numSpots];
+
+		VectorCopy(spot->s.origin, start);
+		start[2] += 32;
+
+		dir[0] = crandom();
+		dir[1] = crandom();
+		dir[2] = 0.5f + random();
+		VectorNormalize(dir);
+		VectorScale(dir, 700, dir);
+
+		missile = fire_missile(&g_entities[ENTITYNUM_WORLD], start, dir, WP_GRENADE_LAUNCHER);
+		missileStress.entities[missileStress.count++] = missile - g_entities;
+	}
+
+	missileStress.active  = qtrue;
+	missileStress.frames  = 0;
+	missileStress.msec    = 0;
+	missileStress.maxMsec = 0;
+	missileStress.stats   = missileStats;
+
+	G_Printf("missilestress: %i grenades thrown from %i spawn points, g_missileBatch %i\n", count, numSpots, g_missileBatch.integer);
+}
+
+/**
+ * @brief Time a frame of the missilestress run, report when its missiles are gone
+ */
+void G_MissileStressFrame(void)
+{
+	gentity_t *ent;
+	int       msec, alive = 0, i;
+
+	if (!missileStress.active)
+	{
+		return;
+	}
+
+	msec = trap_Milliseconds() - level.frameTime;
+
+	missileStress.frames++;
+	missileStress.msec += msec;
+	if (msec > missileStress.maxMsec)
+	{
+		missileStress.maxMsec = msec;
+	}
+
+	for (i = 0; i < missileStress.count; i++)
+	{
+		ent = &g_entities[missileStress.entities[i]];
+
+		if (ent->inuse && ent->spawnTime == missileStress.spawnTime && ent->s.eType == ET_MISSILE)
+		{
+			alive++;
+		}
+	}
+
+	if (alive && missileStress.frames < STRESS_MAX_FRAMES)
+	{
+		return;
+	}
+
+	G_Printf("missilestress: %i grenades over %i frames\n", missileStress.count, missileStress.frames);
+	G_Printf("  frame time: %.2f msec average, %i msec at most\n", missileStress.msec / (float)missileStress.frames, missileStress.maxMsec);
+	G_Printf("  sweeps:     %i batched in %i passes, %i taken, %i traced again, %i traced alone\n",
+	         missileStats.batched - missileStress.stats.batched, missileStats.batches - missileStress.stats.batches,
+	         missileStats.used - missileStress.stats.used, missileStats.retraced - missileStress.stats.retraced,
+	         missileStats.single - missileStress.stats.single);
+
+	missileStress.active = qfalse;
+}
@@ -205,6 +205,31 @@ gentity_t *G_TestEntityPosition(gentity_t *ent)
 	return NULL;
 }
 
+/**
+ * @brief Position test of an entity pushed by a mover, counted for the moverstats command
+ * @param[in] ent
+ * @return
+ */
+static gentity_t *G_MoverTestEntityPosition(gentity_t *ent)
+{
+	moverStats_t *stats = &level.moverStats;
+
+	if (stats->frame != level.framenum)
+	{
+		stats->frame      = level.framenum;
+		stats->frameTests = 0;
+	}
+
+	stats->tests++;
+	stats->frameTests++;
+	if (stats->frameTests > stats->maxTests)
+	{
+		stats->maxTests = stats->frameTests;
+	}
+
+	return G_TestEntityPosition(ent);
+}
+
 /*
  * @brief G_TestEntityDropToFloor
  * @param[in,out] ent
@@ -367,7 +392,7 @@ qboolean G_TryPushingEntity(gentity_t *check, gentity_t *pusher, vec3_t move, ve
 		check->s.groundEntityNum = -1;
 	}
 
-	block = G_TestEntityPosition(check);
+	block = G_MoverTestEntityPosition(check);
 	if (!block)
 	{
 		// pushed ok
@@ -431,7 +456,7 @@ qboolean G_TryPushingEntity(gentity_t *check, gentity_t *pusher, vec3_t move, ve
 								}
 
 								// do the test
-								block = G_TestEntityPosition(check);
+								block = G_MoverTestEntityPosition(check);
 								if (!block)
 								{
 									// pushed ok
@@ -469,7 +494,7 @@ qboolean G_TryPushingEntity(gentity_t *check, gentity_t *pusher, vec3_t move, ve
 		VectorCopy((pushed_p - 1)->origin, check->client->ps.origin);
 	}
 	VectorCopy((pushed_p - 1)->angles, check->s.apos.trBase);
-	block = G_TestEntityPosition(check);
+	block = G_MoverTestEntityPosition(check);
 	if (!block)
 	{
 		check->s.groundEntityNum = -1;
@@ -481,79 +506,129 @@ qboolean G_TryPushingEntity(gentity_t *check, gentity_t *pusher, vec3_t move, ve
 	return qfalse;
 }
 
-// referenced in G_MoverPush()
+// referenced in G_MoverPushEntities()
 extern void LandMineTrigger(gentity_t *self);
 extern void GibEntity(gentity_t *self, int killer);
 
 /**
- * @brief Objects need to be moved back on a failed push,
- * otherwise riders would continue to slide.
+ * @struct moverBounds_t
+ * @brief Bounds of a mover part for a push
+ */
+typedef struct
+{
+	vec3_t mins, maxs;              ///< bounds at the destination
+	vec3_t proneMins, proneMaxs;    ///< the same for prone players, their legs stick out of their box
+	vec3_t totalMins, totalMaxs;    ///< bounds of the entire move
+} moverBounds_t;
+
+/**
+ * @brief Bounds of a mover part for a push
  *
- * @param[in,out] pusher
+ * @details A rotating part sweeps the sphere around its origin, but at its destination it is
+ * within its rotated box, which is what the entities to test are picked with.
+ *
+ * @param[in] pusher
  * @param[in] move
  * @param[in] amove
- * @param[in] obstacle
- *
- * @return If qfalse, *obstacle will be the blocking entity
+ * @param[out] bounds
  */
-qboolean G_MoverPush(gentity_t *pusher, vec3_t move, vec3_t amove, gentity_t **obstacle)
+static void G_MoverBounds(gentity_t *pusher, vec3_t move, vec3_t amove, moverBounds_t *bounds)
 {
-	int       i, e;
-	gentity_t *check;
-	vec3_t    mins, maxs;
-	pushed_t  *p;
-	pushed_t  *work;
-	int       entityList[MAX_GENTITIES];
-	int       moveList[MAX_GENTITIES];
-	int       listedEntities, moveEntities;
-	vec3_t    totalMins, totalMaxs;
-
-	*obstacle = NULL;
+	int i;
 
-	// mins/maxs are the bounds at the destination
-	// totalMins / totalMaxs are the bounds for the entire move
 	if (pusher->r.currentAngles[0] != 0.f || pusher->r.currentAngles[1] != 0.f || pusher->r.currentAngles[2] != 0.f
 	    || amove[0] != 0.f || amove[1] != 0.f || amove[2] != 0.f)
 	{
-		float radius;
+		vec3_t origin, angles, corner;
+		vec3_t matrix[3], transpose[3];
+		float  radius;
 
 		radius = RadiusFromBounds(pusher->r.mins, pusher->r.maxs);
 
+		VectorAdd(pusher->r.currentOrigin, move, origin);
+		VectorAdd(pusher->r.currentAngles, amove, angles);
+		CreateRotationMatrix(angles, matrix);
+		TransposeMatrix(matrix, transpose);
+
+		ClearBounds(bounds->mins, bounds->maxs);
+		for (i = 0; i < 8; i++)
+		{
+			corner[0] = (i & 1) ? pusher->r.maxs[0] : pusher->r.mins[0];
+			corner[1] = (i & 2) ? pusher->r.maxs[1] : pusher->r.mins[1];
+			corner[2] = (i & 4) ? pusher->r.maxs[2] : pusher->r.mins[2];
+			RotatePoint(corner, transpose);
+			VectorAdd(corner, origin, corner);
+			AddPointToBounds(corner, bounds->mins, bounds->maxs);
+		}
+
 		for (i = 0; i < 3; i++)
 		{
-			mins[i]      = pusher->r.currentOrigin[i] - radius + move[i];
-			maxs[i]      = pusher->r.currentOrigin[i] + radius + move[i];
-			totalMins[i] = pusher->r.currentOrigin[i] - radius;
-			totalMaxs[i] = pusher->r.currentOrigin[i] + radius;
+			bounds->proneMins[i] = origin[i] - radius;
+			bounds->proneMaxs[i] = origin[i] + radius;
+			bounds->totalMins[i] = pusher->r.currentOrigin[i] - radius;
+			bounds->totalMaxs[i] = pusher->r.currentOrigin[i] + radius;
+
+			// a unit to spare for the rounding of the rotation
+			bounds->mins[i] = MAX(bounds->mins[i] - 1, bounds->proneMins[i]);
+			bounds->maxs[i] = MIN(bounds->maxs[i] + 1, bounds->proneMaxs[i]);
 		}
 	}
 	else
 	{
 		for (i = 0; i < 3; i++)
 		{
-			mins[i] = pusher->r.absmin[i] + move[i];
-			maxs[i] = pusher->r.absmax[i] + move[i];
+			bounds->mins[i] = pusher->r.absmin[i] + move[i];
+			bounds->maxs[i] = pusher->r.absmax[i] + move[i];
 		}
 
-		VectorCopy(pusher->r.absmin, totalMins);
-		VectorCopy(pusher->r.absmax, totalMaxs);
+		VectorCopy(bounds->mins, bounds->proneMins);
+		VectorCopy(bounds->maxs, bounds->proneMaxs);
+		VectorCopy(pusher->r.absmin, bounds->totalMins);
+		VectorCopy(pusher->r.absmax, bounds->totalMaxs);
 	}
+
 	for (i = 0; i < 3; i++)
 	{
 		if (move[i] > 0)
 		{
-			totalMaxs[i] += move[i];
+			bounds->totalMaxs[i] += move[i];
 		}
 		else
 		{
-			totalMins[i] += move[i];
+			bounds->totalMins[i] += move[i];
 		}
 	}
+}
 
-	// unlink the pusher so we don't get it in the entityList
-	trap_UnlinkEntity(pusher);
+/**
+ * @brief Push the entities in the way of a mover part
+ *
+ * @details Objects need to be moved back on a failed push,
+ * otherwise riders would continue to slide.
+ *
+ * @param[in,out] pusher
+ * @param[in] move
+ * @param[in] amove
+ * @param[out] obstacle
+ * @param[in] bounds
+ * @param[in] entityList entities around the move, it may hold more than the ones in its bounds
+ * @param[in] listedEntities
+ *
+ * @return If qfalse, *obstacle will be the blocking entity
+ */
+static qboolean G_MoverPushEntities(gentity_t *pusher, vec3_t move, vec3_t amove, gentity_t **obstacle, moverBounds_t *bounds, int *entityList, int listedEntities)
+{
+	int       e;
+	gentity_t *check;
+	pushed_t  *p;
+	pushed_t  *work;
+	int       moveList[MAX_GENTITIES];
+	int       moveEntities;
+	float     *mins, *maxs;
+
+	*obstacle = NULL;
 
-	listedEntities = trap_EntitiesInBox(totalMins, totalMaxs, entityList, MAX_GENTITIES);
+	level.moverStats.pushes++;
 
 	// move the pusher to it's final position
 	VectorAdd(pusher->r.currentOrigin, move, pusher->r.currentOrigin);
@@ -566,6 +641,18 @@ qboolean G_MoverPush(gentity_t *pusher, vec3_t move, vec3_t amove, gentity_t **o
 	{
 		check = &g_entities[entityList[e]];
 
+		// the list may be the one of the whole team, taken before the other parts pushed
+		if (check == pusher || !check->inuse || !check->r.linked
+		    || check->r.absmin[0] > bounds->totalMaxs[0]
+		    || check->r.absmin[1] > bounds->totalMaxs[1]
+		    || check->r.absmin[2] > bounds->totalMaxs[2]
+		    || check->r.absmax[0] < bounds->totalMins[0]
+		    || check->r.absmax[1] < bounds->totalMins[1]
+		    || check->r.absmax[2] < bounds->totalMins[2])
+		{
+			continue;
+		}
+
 		if (check->s.eType == ET_ALARMBOX)
 		{
 			continue;
@@ -606,6 +693,17 @@ qboolean G_MoverPush(gentity_t *pusher, vec3_t move, vec3_t amove, gentity_t **o
 		// if the entity is standing on the pusher, it will definitely be moved
 		if (check->s.groundEntityNum != pusher->s.number)
 		{
+			if (check->client && (check->client->ps.eFlags & EF_PRONE))
+			{
+				mins = bounds->proneMins;
+				maxs = bounds->proneMaxs;
+			}
+			else
+			{
+				mins = bounds->mins;
+				maxs = bounds->maxs;
+			}
+
 			// see if the ent needs to be tested
 			if (check->r.absmin[0] >= maxs[0]
 			    || check->r.absmin[1] >= maxs[1]
@@ -618,7 +716,7 @@ qboolean G_MoverPush(gentity_t *pusher, vec3_t move, vec3_t amove, gentity_t **o
 			}
 			// see if the ent's bbox is inside the pusher's final position
 			// this does allow a fast moving object to pass through a thin entity...
-			if (G_TestEntityPosition(check) != pusher)
+			if (G_MoverTestEntityPosition(check) != pusher)
 			{
 				continue;
 			}
@@ -743,17 +841,105 @@ qboolean G_MoverPush(gentity_t *pusher, vec3_t move, vec3_t amove, gentity_t **o
 }
 
 /**
- * @brief G_MoverTeam
+ * @brief Push the entities in the way of a mover
+ *
+ * @param[in,out] pusher
+ * @param[in] move
+ * @param[in] amove
+ * @param[out] obstacle
+ *
+ * @return If qfalse, *obstacle will be the blocking entity
+ */
+qboolean G_MoverPush(gentity_t *pusher, vec3_t move, vec3_t amove, gentity_t **obstacle)
+{
+	moverBounds_t bounds;
+	int           entityList[MAX_GENTITIES];
+	int           listedEntities;
+
+	*obstacle = NULL;
+
+	// no new space crossed, nothing to push
+	if (VectorCompare(move, vec3_origin) && VectorCompare(amove, vec3_origin))
+	{
+		level.moverStats.skips++;
+		return qtrue;
+	}
+
+	G_MoverBounds(pusher, move, amove, &bounds);
+
+	// unlink the pusher so we don't get it in the entityList
+	trap_UnlinkEntity(pusher);
+
+	listedEntities = trap_EntitiesInBox(bounds.totalMins, bounds.totalMaxs, entityList, MAX_GENTITIES);
+	level.moverStats.queries++;
+
+	return G_MoverPushEntities(pusher, move, amove, obstacle, &bounds, entityList, listedEntities);
+}
+
+/**
+ * @brief Print the push work of the movers and start counting again
+ */
+void Svcmd_MoverStats_f(void)
+{
+	moverStats_t *stats = &level.moverStats;
+	int          frames = level.framenum - stats->startFrame;
+
+	if (frames <= 0)
+	{
+		G_Printf("No frames run since the last moverstats\n");
+		return;
+	}
+
+	G_Printf("Mover pushes over %i frames:\n", frames);
+	G_Printf("  pushes:         %.2f/frame, %i parts didn't move\n", stats->pushes / (float)frames, stats->skips);
+	G_Printf("  entity queries: %.2f/frame\n", stats->queries / (float)frames);
+	G_Printf("  push tests:     %.2f/frame, %i at most\n", stats->tests / (float)frames, stats->maxTests);
+
+	Com_Memset(stats, 0, sizeof(*stats));
+	stats->startFrame = level.framenum;
+}
+
+/**
+ * @brief Move a mover team, one entity query covers the moves of all its parts
  * @param[in] ent
  */
 void G_MoverTeam(gentity_t *ent)
 {
-	vec3_t    move, amove;
-	gentity_t *part, *obstacle;
-	vec3_t    origin, angles;
+	vec3_t        move, amove;
+	gentity_t     *part, *obstacle;
+	vec3_t        origin, angles;
+	moverBounds_t bounds;
+	vec3_t        teamMins, teamMaxs;
+	int           entityList[MAX_GENTITIES];
+	int           listedEntities = 0;
 
 	obstacle = NULL;
 
+	// the swept volume of the team, parts which don't move cross no new space
+	ClearBounds(teamMins, teamMaxs);
+	for (part = ent ; part ; part = part->teamchain)
+	{
+		BG_EvaluateTrajectory(&part->s.pos, level.time, origin, qfalse, ent->s.effect2Time);
+		BG_EvaluateTrajectory(&part->s.apos, level.time, angles, qtrue, ent->s.effect2Time);
+		VectorSubtract(origin, part->r.currentOrigin, move);
+		VectorSubtract(angles, part->r.currentAngles, amove);
+
+		if (VectorCompare(move, vec3_origin) && VectorCompare(amove, vec3_origin))
+		{
+			continue;
+		}
+
+		G_MoverBounds(part, move, amove, &bounds);
+		AddPointToBounds(bounds.totalMins, teamMins, teamMaxs);
+		AddPointToBounds(bounds.totalMaxs, teamMins, teamMaxs);
+	}
+
+	if (teamMins[0] <= teamMaxs[0])
+	{
+		listedEntities = trap_EntitiesInBox(teamMins, teamMaxs, entityList, MAX_GENTITIES);
+		level.moverStats.queries++;
+	}
+
 	// make sure all team slaves can move before commiting
 	// any moves or calling any think functions
 	// if the move is blocked, all moved objects will be backed out
@@ -771,7 +957,15 @@ void G_MoverTeam(gentity_t *ent)
 			part->s.eFlags &= ~EF_MOVER_BLOCKED;
 		}
 
-		if (!G_MoverPush(part, move, amove, &obstacle))
+		if (VectorCompare(move, vec3_origin) && VectorCompare(amove, vec3_origin))
+		{
+			level.moverStats.skips++;
+			continue;
+		}
+
+		G_MoverBounds(part, move, amove, &bounds);
+
+		if (!G_MoverPushEntities(part, move, amove, &obstacle, &bounds, entityList, listedEntities))
 		{
 			break;  // move was blocked
 		}
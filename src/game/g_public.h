@@ -42,6 +42,38 @@
 
 typedef qboolean (*addToSnapshotCallback)(int entityNum, int clientNum);
 
+/**
+ * @def MAX_TRACE_BATCH
+ * @brief Most traces of one G_TRACEBATCH call
+ */
+#define MAX_TRACE_BATCH     256
+
+/**
+ * @def GAME_ENGINE_TRACEBATCH
+ * @brief Engine feature bits, passed as the last argument of GAME_INIT
+ *
+ * An older engine doesn't pass them and drops the server on a syscall it doesn't know,
+ * the game only makes these syscalls when the engine announced them.
+ */
+#define GAME_ENGINE_TRACEBATCH  0x0001  ///< G_TRACEBATCH
+#define GAME_ENGINE_PROFILER    0x0002  ///< G_PROFILER_REGISTER, G_PROFILER_BEGIN and G_PROFILER_END
+
+#define GAME_ENGINE_FEATURES    (GAME_ENGINE_TRACEBATCH | GAME_ENGINE_PROFILER)
+
+/**
+ * @struct traceRequest_t
+ * @brief One trace of a G_TRACEBATCH call, the arguments of G_TRACE
+ */
+typedef struct
+{
+	vec3_t start;
+	vec3_t end;
+	vec3_t mins;
+	vec3_t maxs;
+	int passEntityNum;              ///< -2 for the world only, like trap_TraceNoEnts
+	int contentmask;
+} traceRequest_t;
+
 /**
   * @struct entityShared_s
   * @brief entityShared_t
@@ -263,6 +295,13 @@ typedef enum
 
 	G_SENDMESSAGE = 585,
 	G_MESSAGESTATUS,
+
+	G_TRACEBATCH,       ///< ( trace_t *results, const traceRequest_t *requests, int count );
+	///< G_TRACE for up to MAX_TRACE_BATCH traces, nearby traces share the entity lookup
+
+	G_PROFILER_REGISTER,    ///< ( const char *name ); returns the id of a section of the frame profiler
+	G_PROFILER_BEGIN,       ///< ( int id ); opens a section, the game runs its sections only with com_profiler set
+	G_PROFILER_END,         ///< ( void ); closes the innermost section
 } gameImport_t;
 
 
@@ -272,7 +311,7 @@ typedef enum
   */
 typedef enum
 {
-	GAME_INIT = 0,  ///< ( int levelTime, int randomSeed, int restart );
+	GAME_INIT = 0,  ///< ( int levelTime, int randomSeed, int restart, int etLegacyServer, int serverVersion, int engineFeatures );
 	///< init and shutdown will be called every single level
 	///< The game should call G_GET_ENTITY_TOKEN to parse through all the
 	///< entity configuration text and spawn gentities.
@@ -294,6 +333,8 @@ typedef enum
 	GAME_CLIENT_THINK,              ///< ( int clientNum );
 
 	GAME_RUN_FRAME,                 ///< ( int levelTime );
+	///< returns GAME_BOT_THINK when the game deferred its bot think to that call
+
 
 	GAME_CONSOLE_COMMAND,           ///< ( void );
 	///< ConsoleCommand will be called when a command has been issued
@@ -310,6 +351,12 @@ typedef enum
 
 	GAME_MESSAGERECEIVED = 14,      ///< ( int cno, const char *buf, int buflen, int commandTime );
 
+	GAME_BOT_THINK = 15,            ///< ( void );
+	///< Runs the bot think deferred by GAME_RUN_FRAME, once before the next game call.
+	///< With sv_botThread it runs on a thread after the snapshots went out, while the server
+	///< sleeps until the next frame. No other game call overlaps it, the server holds back
+	///< the packets it receives meanwhile.
+
 } gameExport_t;
 
 #endif // #ifndef INCLUDE_G_PUBLIC_H
@@ -2588,6 +2588,9 @@ static consoleCommandTable_t consoleCommandTable[] =
 	{ "csinfo",                     Svcmd_CSInfo_f                },
 	{ "forceteam",                  Svcmd_ForceTeam_f             },
 	{ "game_memory",                Svcmd_GameMem_f               },
+	{ "moverstats",                 Svcmd_MoverStats_f            },
+	{ "missilestress",              Svcmd_MissileStress_f         },
+	{ "teammapstats",               Svcmd_TeamMapStats_f          },
 	{ "addip",                      Svcmd_AddIP_f                 },
 	{ "removeip",                   Svcmd_RemoveIP_f              },
 	{ "listip",                     Svcmd_ListIp_f                },
@@ -367,6 +367,17 @@ void trap_Trace(trace_t *results, const vec3_t start, const vec3_t mins, const v
 	syscall(G_TRACE, results, start, mins, maxs, end, passEntityNum, contentmask);
 }
 
+/**
+ * @brief trap_Trace for up to MAX_TRACE_BATCH traces in one call
+ * @param[out] results
+ * @param[in] requests
+ * @param[in] count
+ */
+void trap_TraceBatch(trace_t *results, const traceRequest_t *requests, int count)
+{
+	syscall(G_TRACEBATCH, results, requests, count);
+}
+
 /**
  * @brief trap_TraceNoEnts
  * @param[out] results
@@ -473,6 +484,7 @@ qboolean trap_AreasConnected(int area1, int area2)
 void trap_LinkEntity(gentity_t *ent)
 {
 	syscall(G_LINKENTITY, ent);
+	G_MissileBatchTouch(ent);
 }
 
 /**
@@ -482,6 +494,7 @@ void trap_LinkEntity(gentity_t *ent)
 void trap_UnlinkEntity(gentity_t *ent)
 {
 	syscall(G_UNLINKENTITY, ent);
+	G_MissileBatchTouch(ent);
 }
 
 /**
@@ -809,3 +822,30 @@ messageStatus_t trap_MessageStatus(int clientNum)
 {
 	return (messageStatus_t)(syscall(G_MESSAGESTATUS, clientNum));
 }
+
+/**
+ * @brief Register a section of the engine frame profiler
+ * @param[in] name
+ * @return The id to pass to trap_ProfilerBegin
+ */
+int trap_ProfilerRegister(const char *name)
+{
+	return syscall(G_PROFILER_REGISTER, name);
+}
+
+/**
+ * @brief Open a section of the engine frame profiler
+ * @param[in] id
+ */
+void trap_ProfilerBegin(int id)
+{
+	syscall(G_PROFILER_BEGIN, id);
+}
+
+/**
+ * @brief Close the innermost section of the engine frame profiler
+ */
+void trap_ProfilerEnd(void)
+{
+	syscall(G_PROFILER_END);
+}
@@ -349,13 +349,14 @@ static qboolean G_CullPointAndRadius(vec3_t pt, float radius)
 }
 
 /**
- * @brief G_VisibleFromBinoculars
+ * @brief Visibility of a point of an entity through the eyes of a viewer, in the current frustum
  * @param[in] viewer
  * @param[in] ent
- * @param[in,out] origin
+ * @param[in] origin
+ * @param[in,out] stats counters of the tests, NULL to not count them
  * @return
  */
-qboolean G_VisibleFromBinoculars(gentity_t *viewer, gentity_t *ent, vec3_t origin)
+static qboolean G_SpotPoint(gentity_t *viewer, gentity_t *ent, vec3_t origin, teamMapStats_t *stats)
 {
 	vec3_t  vieworg;
 	trace_t trace;
@@ -363,16 +364,44 @@ qboolean G_VisibleFromBinoculars(gentity_t *viewer, gentity_t *ent, vec3_t origi
 	VectorCopy(viewer->client->ps.origin, vieworg);
 	vieworg[2] += viewer->client->ps.viewheight;
 
+	if (stats)
+	{
+		stats->points++;
+	}
+
 	if (!G_CullPointAndRadius(origin, 0))
 	{
+		if (stats)
+		{
+			stats->frustumCulls++;
+		}
 		return qfalse;
 	}
 
 	if (!trap_InPVS(vieworg, origin))
 	{
+		if (stats)
+		{
+			stats->pvsCulls++;
+		}
 		return qfalse;
 	}
 
+	if (stats)
+	{
+		if (stats->frame != level.framenum)
+		{
+			stats->frame       = level.framenum;
+			stats->frameTraces = 0;
+		}
+		stats->traces++;
+		stats->frameTraces++;
+		if (stats->frameTraces > stats->maxTraces)
+		{
+			stats->maxTraces = stats->frameTraces;
+		}
+	}
+
 	trap_Trace(&trace, vieworg, NULL, NULL, origin, viewer->s.number, MASK_SHOT);
 
 	if (trace.fraction != 1.f)
@@ -390,6 +419,340 @@ qboolean G_VisibleFromBinoculars(gentity_t *viewer, gentity_t *ent, vec3_t origi
 	return qtrue;
 }
 
+/**
+ * @brief G_VisibleFromBinoculars
+ * @param[in] viewer
+ * @param[in] ent
+ * @param[in,out] origin
+ * @return
+ */
+qboolean G_VisibleFromBinoculars(gentity_t *viewer, gentity_t *ent, vec3_t origin)
+{
+	return G_SpotPoint(viewer, ent, origin, NULL);
+}
+
+#define SPOT_CELL_SIZE  512.f
+#define SPOT_MAX_CELLS  256
+#define SPOT_HASH_SIZE  64      // power of two
+
+/**
+ * @struct spotCell_t
+ * @brief Cell of a spotting grid with the bounds of the points to test in it
+ */
+typedef struct
+{
+	int x, y;
+	vec3_t mins, maxs;
+	int next;                           ///< next cell in the hash chain, -1 ends it
+	qboolean inFrustum;                 ///< some of its points may be in the frustum of the current viewer
+} spotCell_t;
+
+/**
+ * @struct spotGrid_t
+ * @brief Players or armed landmines bucketed by their XY cell, a viewer's frustum
+ * rejects a whole cell before any point in it is tested
+ */
+typedef struct
+{
+	spotCell_t cells[SPOT_MAX_CELLS];
+	int numCells;
+	int hash[SPOT_HASH_SIZE];
+	int entities[MAX_GENTITIES];        ///< in the order they were added
+	int numEntities;
+	int cellOf[MAX_GENTITIES];          ///< cell + 1 of an entity, 0 when it isn't in a cell and can't be culled
+	int frame;                          ///< framenum the grid was built at
+} spotGrid_t;
+
+static spotGrid_t spotPlayers;          ///< alive players of both teams
+static spotGrid_t spotMines;            ///< armed landmines of both teams
+
+/**
+ * @brief Empty a spotting grid, it's built for the current frame
+ * @param[in,out] grid
+ */
+static void G_SpotGridClear(spotGrid_t *grid)
+{
+	int i;
+
+	for (i = 0; i < grid->numEntities; i++)
+	{
+		grid->cellOf[grid->entities[i]] = 0;
+	}
+
+	for (i = 0; i < SPOT_HASH_SIZE; i++)
+	{
+		grid->hash[i] = -1;
+	}
+
+	grid->numEntities = 0;
+	grid->numCells    = 0;
+	grid->frame       = level.framenum;
+}
+
+/**
+ * @brief Add an entity to the cell of its points, all of them are above each other
+ * @param[in,out] grid
+ * @param[in] ent
+ * @param[in] bottom lowest point to test
+ * @param[in] top highest point to test
+ */
+static void G_SpotGridAdd(spotGrid_t *grid, gentity_t *ent, vec3_t bottom, vec3_t top)
+{
+	int        x = (int)floor(bottom[0] / SPOT_CELL_SIZE);
+	int        y = (int)floor(bottom[1] / SPOT_CELL_SIZE);
+	int        h = (int)((unsigned int)(x * 31 + y) & (SPOT_HASH_SIZE - 1));
+	int        c;
+	spotCell_t *cell;
+
+	for (c = grid->hash[h]; c != -1; c = grid->cells[c].next)
+	{
+		if (grid->cells[c].x == x && grid->cells[c].y == y)
+		{
+			break;
+		}
+	}
+
+	if (c == -1 && grid->numCells < SPOT_MAX_CELLS)
+	{
+		c          = grid->numCells++;
+		cell       = &grid->cells[c];
+		cell->x    = x;
+		cell->y    = y;
+		cell->next = grid->hash[h];
+		ClearBounds(cell->mins, cell->maxs);
+		grid->hash[h] = c;
+	}
+
+	// out of cells, the entity is always tested
+	if (c != -1)
+	{
+		AddPointToBounds(bottom, grid->cells[c].mins, grid->cells[c].maxs);
+		AddPointToBounds(top, grid->cells[c].mins, grid->cells[c].maxs);
+		grid->cellOf[ent->s.number] = c + 1;
+	}
+
+	grid->entities[grid->numEntities++] = ent->s.number;
+}
+
+/**
+ * @brief Flag the cells of a grid which may have points in the current frustum
+ * @param[in,out] grid
+ */
+static void G_SpotGridCull(spotGrid_t *grid)
+{
+	int        i, j, k;
+	spotCell_t *cell;
+	vec3_t     corner;
+
+	for (i = 0, cell = grid->cells; i < grid->numCells; i++, cell++)
+	{
+		cell->inFrustum = qtrue;
+
+		for (j = 0; j < 4; j++)
+		{
+			// the corner of the bounds the farthest inside the plane
+			for (k = 0; k < 3; k++)
+			{
+				corner[k] = frustum[j].normal[k] > 0 ? cell->maxs[k] : cell->mins[k];
+			}
+
+			// keep a margin for the rounding, points in the frustum are tested on their own anyway
+			if (DotProduct(corner, frustum[j].normal) - frustum[j].dist < -1.f)
+			{
+				cell->inFrustum = qfalse;
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * @brief G_SpotGridInFrustum
+ * @param[in] grid
+ * @param[in] ent
+ * @return qfalse if the cell of the entity is out of the current frustum
+ */
+static qboolean G_SpotGridInFrustum(spotGrid_t *grid, gentity_t *ent)
+{
+	int c = grid->cellOf[ent->s.number];
+
+	return (!c || grid->cells[c - 1].inFrustum) ? qtrue : qfalse;
+}
+
+/**
+ * @brief Feet, origin and head of a player, the points a spotter may see
+ * @param[in] ent
+ * @param[out] pos
+ */
+static void G_SpotPlayerPoints(gentity_t *ent, vec3_t pos[3])
+{
+	VectorCopy(ent->client->ps.origin, pos[0]);
+	pos[0][2] += ent->client->ps.mins[2];
+	VectorCopy(ent->client->ps.origin, pos[1]);
+	VectorCopy(ent->client->ps.origin, pos[2]);
+	pos[2][2] += ent->client->ps.maxs[2];
+}
+
+/**
+ * @brief Build the grid of the alive players once per frame
+ */
+static void G_SpotGridPlayers(void)
+{
+	int       i;
+	gentity_t *ent;
+	vec3_t    pos[3];
+
+	if (spotPlayers.frame == level.framenum)
+	{
+		return;
+	}
+
+	G_SpotGridClear(&spotPlayers);
+
+	for (i = 0; i < level.numConnectedClients; i++)
+	{
+		ent = &g_entities[level.sortedClients[i]];
+
+		if (!ent->inuse || ent->s.eType != ET_PLAYER || ent->health <= 0)
+		{
+			continue;
+		}
+
+		if (ent->client->sess.sessionTeam != TEAM_AXIS && ent->client->sess.sessionTeam != TEAM_ALLIES)
+		{
+			continue;
+		}
+
+		G_SpotPlayerPoints(ent, pos);
+		G_SpotGridAdd(&spotPlayers, ent, pos[0], pos[2]);
+	}
+}
+
+/**
+ * @brief Build the grid of the armed landmines once per frame, they are listed in entity order
+ */
+static void G_SpotGridMines(void)
+{
+	int       i;
+	gentity_t *ent;
+
+	if (spotMines.frame == level.framenum)
+	{
+		return;
+	}
+
+	G_SpotGridClear(&spotMines);
+
+	for (i = 0, ent = g_entities; i < level.num_entities; i++, ent++)
+	{
+		if (!ent->inuse || ent->s.eType != ET_MISSILE || ent->methodOfDeath != MOD_LANDMINE || ent->s.effect1Time != 1)
+		{
+			continue;
+		}
+
+		G_SpotGridAdd(&spotMines, ent, ent->r.currentOrigin, ent->r.currentOrigin);
+	}
+}
+
+/**
+ * @brief Can a viewer see an enemy player, cells of the grid have been culled with the frustum of the viewer
+ * @param[in] viewer
+ * @param[in] ent
+ * @return
+ */
+static qboolean G_SpotPlayer(gentity_t *viewer, gentity_t *ent)
+{
+	teamMapStats_t *stats = &level.teamMapStats;
+	vec3_t         pos[3];
+
+	stats->targets++;
+
+	if (!G_SpotGridInFrustum(&spotPlayers, ent))
+	{
+		stats->cellCulls += 3;
+		return qfalse;
+	}
+
+	G_SpotPlayerPoints(ent, pos);
+
+	return (G_SpotPoint(viewer, ent, pos[0], stats) ||
+	        G_SpotPoint(viewer, ent, pos[1], stats) ||
+	        G_SpotPoint(viewer, ent, pos[2], stats)) ? qtrue : qfalse;
+}
+
+/**
+ * @brief Can a viewer see an enemy landmine, cells of the grid have been culled with the frustum of the viewer
+ * @param[in] viewer
+ * @param[in] ent
+ * @return
+ */
+static qboolean G_SpotLandMine(gentity_t *viewer, gentity_t *ent)
+{
+	teamMapStats_t *stats = &level.teamMapStats;
+
+	stats->targets++;
+
+	if (!G_SpotGridInFrustum(&spotMines, ent))
+	{
+		stats->cellCulls++;
+		return qfalse;
+	}
+
+	return G_SpotPoint(viewer, ent, ent->r.currentOrigin, stats);
+}
+
+/**
+ * @brief Time between two spotting updates of a viewer, and how long the team map keeps spotted players
+ * @return milliseconds
+ */
+static int G_TeamMapStaleness(void)
+{
+	return (int)Com_Clamp(100, 5000, g_teamMapStaleness.integer);
+}
+
+/**
+ * @brief Is it the turn of a viewer to spot this frame
+ *
+ * @details Each viewer is updated once per staleness period, with its own phase
+ * so the traces of all the viewers are spread over the frames of the period.
+ *
+ * @param[in] ent
+ * @param[in] staleness
+ * @return
+ */
+static qboolean G_TeamMapViewerDue(gentity_t *ent, int staleness)
+{
+	int phase = (int)(ent - g_entities) * staleness / MAX_CLIENTS;
+
+	return ((level.time + phase) / staleness != (level.previousTime + phase) / staleness) ? qtrue : qfalse;
+}
+
+/**
+ * @brief Print the spotting work of the team map data and start counting again
+ */
+void Svcmd_TeamMapStats_f(void)
+{
+	teamMapStats_t *stats = &level.teamMapStats;
+	int            frames = level.framenum - stats->startFrame;
+	int            saved  = stats->cellCulls + stats->frustumCulls + stats->pvsCulls;
+
+	if (frames <= 0)
+	{
+		G_Printf("No frames run since the last teammapstats\n");
+		return;
+	}
+
+	G_Printf("Team map spotting over %i frames:\n", frames);
+	G_Printf("  viewer updates: %.2f/frame\n", stats->viewers / (float)frames);
+	G_Printf("  targets:        %i, %i points\n", stats->targets, stats->cellCulls + stats->points);
+	G_Printf("  culled points:  %i by grid cell, %i by frustum, %i by PVS\n", stats->cellCulls, stats->frustumCulls, stats->pvsCulls);
+	G_Printf("  traces:         %.2f/frame, %i at most, %i saved (%.0f%%)\n", stats->traces / (float)frames, stats->maxTraces,
+	         saved, saved ? 100.f * saved / (saved + stats->traces) : 0.f);
+
+	Com_Memset(stats, 0, sizeof(*stats));
+	stats->startFrame = level.framenum;
+}
+
 /**
  * @brief G_ResetTeamMapData
  */
@@ -397,6 +760,10 @@ void G_ResetTeamMapData()
 {
 	G_InitMapEntityData(&mapEntityData[0]);
 	G_InitMapEntityData(&mapEntityData[1]);
+
+	// rebuild the spotting grids, the entities may be gone
+	spotPlayers.frame = -1;
+	spotMines.frame   = -1;
 }
 
 /**
@@ -914,7 +1281,7 @@ void G_SendSpectatorMapEntityInfo(gentity_t *e)
 		}
 		else
 		{
-			if (level.time - mEnt->startTime > 1000)
+			if (level.time - mEnt->startTime > G_TeamMapStaleness())
 			{
 				// we can free this player from the list now
 				if (mEnt->type == ME_PLAYER || mEnt->type == ME_PLAYER_REVIVE || mEnt->type == ME_PLAYER_OBJECTIVE)
@@ -956,7 +1323,7 @@ void G_SendSpectatorMapEntityInfo(gentity_t *e)
 		}
 		else
 		{
-			if (level.time - mEnt->startTime > 1000)
+			if (level.time - mEnt->startTime > G_TeamMapStaleness())
 			{
 				// we can free this player from the list now
 				if (mEnt->type == ME_PLAYER || mEnt->type == ME_PLAYER_REVIVE || mEnt->type == ME_PLAYER_OBJECTIVE)
@@ -1061,7 +1428,7 @@ void G_SendMapEntityInfo(gentity_t *e)
 	mEnt = teamList->activeMapEntityData.next;
 	while (mEnt && mEnt != &teamList->activeMapEntityData)
 	{
-		if (level.time - mEnt->startTime > 1000)
+		if (level.time - mEnt->startTime > G_TeamMapStaleness())
 		{
 			// we can free this player from the list now
 			if (mEnt->type == ME_PLAYER || mEnt->type == ME_PLAYER_REVIVE || mEnt->type == ME_PLAYER_OBJECTIVE)
@@ -1133,18 +1500,13 @@ void G_PopupMessageForMines(gentity_t *player) // int sound
 
 /**
  * @brief G_CheckSpottedLandMines
+ * @param[in] staleness
  */
-void G_CheckSpottedLandMines(void)
+static void G_CheckSpottedLandMines(int staleness)
 {
 	int       i, j;
 	gentity_t *ent, *ent2;
 
-	if (level.time - level.lastMapSpottedMinesUpdate < 1000)
-	{
-		return;
-	}
-	level.lastMapSpottedMinesUpdate = level.time;
-
 	for (i = 0; i < level.numConnectedClients; i++)
 	{
 		ent = &g_entities[level.sortedClients[i]];
@@ -1170,106 +1532,91 @@ void G_CheckSpottedLandMines(void)
 			continue;
 		}
 
-		if (ent->client->sess.playerType == PC_COVERTOPS && (ent->client->ps.eFlags & EF_ZOOMING))
+		if (ent->client->sess.playerType == PC_COVERTOPS && (ent->client->ps.eFlags & EF_ZOOMING) && G_TeamMapViewerDue(ent, staleness))
 		{
+			G_SpotGridMines();
 			G_SetupFrustum_ForBinoculars(ent);
+			G_SpotGridCull(&spotMines);
+			level.teamMapStats.viewers++;
 
-			for (j = 0, ent2 = g_entities; j < level.num_entities; j++, ent2++)
+			for (j = 0; j < spotMines.numEntities; j++)
 			{
-				if (!ent2->inuse || ent2 == ent)
-				{
-					continue;
-				}
+				ent2 = &g_entities[spotMines.entities[j]];
 
-				if (ent2->s.eType != ET_MISSILE)
+				if (ent2->s.teamNum == ent->client->sess.sessionTeam)
 				{
 					continue;
 				}
 
-				if (ent2->methodOfDeath == MOD_LANDMINE)
+				// as before, we can only detect a mine if we can see it from our binoculars
+				if (G_SpotLandMine(ent, ent2))
 				{
-					if (ent2->s.effect1Time == 1 && (ent2->s.teamNum != ent->client->sess.sessionTeam))
+					G_UpdateTeamMapData_LandMine(ent2);
+
+					switch (ent2->s.teamNum)
 					{
-						// as before, we can only detect a mine if we can see it from our binoculars
-						if (G_VisibleFromBinoculars(ent, ent2, ent2->r.currentOrigin))
+					case TEAM_AXIS:
+					case TEAM_ALLIES:
+						if (!ent2->s.modelindex2)
 						{
-							G_UpdateTeamMapData_LandMine(ent2);
+							ent->client->landmineSpottedTime = level.time;
+							ent->client->landmineSpotted     = ent2;
+							ent2->s.density                  = ent - g_entities + 1;
+							ent2->missionLevel               = level.time;
 
-							switch (ent2->s.teamNum)
+							ent->client->landmineSpotted->count2 += 50 * staleness / 1000; // @sv_fps - revealed after 5 seconds in sight
+							if (ent->client->landmineSpotted->count2 >= 250)
 							{
-							case TEAM_AXIS:
-							case TEAM_ALLIES:
-								if (!ent2->s.modelindex2)
-								{
-									ent->client->landmineSpottedTime = level.time;
-									ent->client->landmineSpotted     = ent2;
-									ent2->s.density                  = ent - g_entities + 1;
-									ent2->missionLevel               = level.time;
-
-									ent->client->landmineSpotted->count2 += 50; // @sv_fps
-									if (ent->client->landmineSpotted->count2 >= 250)
-									{
-										ent->client->landmineSpotted->count2 = 250;
+								ent->client->landmineSpotted->count2 = 250;
 
-										ent->client->landmineSpotted->s.modelindex2 = 1;
+								ent->client->landmineSpotted->s.modelindex2 = 1;
 
-										ent->client->landmineSpotted->takedamage = qtrue;
+								ent->client->landmineSpotted->takedamage = qtrue;
 
-										ent->client->landmineSpotted->r.snapshotCallback = qfalse;
+								ent->client->landmineSpotted->r.snapshotCallback = qfalse;
 
-										// for marker
-										// Landmine flags shouldn't block our view
-										// don't do this if the mine has been triggered.
-										if (!G_LandmineTriggered(ent->client->landmineSpotted))
-										{
-											ent->client->landmineSpotted->s.frame    = rand() % 20;
-											ent->client->landmineSpotted->r.contents = CONTENTS_TRANSLUCENT;
-											trap_LinkEntity(ent->client->landmineSpotted);
-										}
+								// for marker
+								// Landmine flags shouldn't block our view
+								// don't do this if the mine has been triggered.
+								if (!G_LandmineTriggered(ent->client->landmineSpotted))
+								{
+									ent->client->landmineSpotted->s.frame    = rand() % 20;
+									ent->client->landmineSpotted->r.contents = CONTENTS_TRANSLUCENT;
+									trap_LinkEntity(ent->client->landmineSpotted);
+								}
 
-										G_PopupMessageForMines(ent);
+								G_PopupMessageForMines(ent);
 
-										trap_SendServerCommand(ent - g_entities, "cp \"Landmine revealed\"");
+								trap_SendServerCommand(ent - g_entities, "cp \"Landmine revealed\"");
 
-										G_AddSkillPoints(ent, SK_MILITARY_INTELLIGENCE_AND_SCOPED_WEAPONS, 3.f);
-										G_DebugAddSkillPoints(ent, SK_MILITARY_INTELLIGENCE_AND_SCOPED_WEAPONS, 3.f, "spotting a landmine");
-									}
-								}
-								break;
-							default:
-								break;
+								G_AddSkillPoints(ent, SK_MILITARY_INTELLIGENCE_AND_SCOPED_WEAPONS, 3.f);
+								G_DebugAddSkillPoints(ent, SK_MILITARY_INTELLIGENCE_AND_SCOPED_WEAPONS, 3.f, "spotting a landmine");
 							}
 						}
-						else
-						{
-							// if we can't see the mine from our binoculars, make sure we clear out the landmineSpotted ptr,
-							// because bots looking for mines are getting confused
-							ent->client->landmineSpotted = NULL;
-						}
+						break;
+					default:
+						break;
 					}
 				}
+				else
+				{
+					// if we can't see the mine from our binoculars, make sure we clear out the landmineSpotted ptr,
+					// because bots looking for mines are getting confused
+					ent->client->landmineSpotted = NULL;
+				}
 			}
 		}
 	}
 }
 
 /**
- * @brief G_UpdateTeamMapData
+ * @brief Common update of the team map data of all entities
  */
-void G_UpdateTeamMapData(void)
+static void G_UpdateTeamMapData_Entities(void)
 {
 	int             i, j;
-	gentity_t       *ent, *ent2;
+	gentity_t       *ent;
 	mapEntityData_t *mEnt;
-	qboolean        f1, f2;
-
-	G_CheckSpottedLandMines();
-
-	if (level.time - level.lastMapEntityUpdate < 1000)
-	{
-		return;
-	}
-	level.lastMapEntityUpdate = level.time;
 
 	// all ents - comon update
 	for (i = 0; i < level.num_entities; i++)
@@ -1330,8 +1677,27 @@ void G_UpdateTeamMapData(void)
 			break;
 		}
 	}
+}
+
+/**
+ * @brief G_UpdateTeamMapData
+ */
+void G_UpdateTeamMapData(void)
+{
+	int       i, j;
+	gentity_t *ent, *ent2;
+	qboolean  f1, f2;
+	int       staleness = G_TeamMapStaleness();
+
+	G_CheckSpottedLandMines(staleness);
+
+	if (level.time - level.lastMapEntityUpdate >= staleness)
+	{
+		level.lastMapEntityUpdate = level.time;
+		G_UpdateTeamMapData_Entities();
+	}
 
-	// clients again - do special stuff for field- and covert ops
+	// clients again - do special stuff for field- and covert ops, a slice of them per frame
 	for (i = 0; i < level.numConnectedClients; i++)
 	{
 		ent = &g_entities[level.sortedClients[i]];
@@ -1360,11 +1726,17 @@ void G_UpdateTeamMapData(void)
 			continue;
 		}
 
-		if (ent->client->sess.playerType == PC_FIELDOPS && (ent->client->ps.eFlags & EF_ZOOMING) && ent->client->sess.skill[SK_SIGNALS] >= 4)
+		if (!G_TeamMapViewerDue(ent, staleness))
 		{
-			vec3_t pos[3];
+			continue;
+		}
 
+		if (ent->client->sess.playerType == PC_FIELDOPS && (ent->client->ps.eFlags & EF_ZOOMING) && ent->client->sess.skill[SK_SIGNALS] >= 4)
+		{
+			G_SpotGridPlayers();
 			G_SetupFrustum_ForBinoculars(ent);
+			G_SpotGridCull(&spotPlayers);
+			level.teamMapStats.viewers++;
 
 			for (j = 0; j < level.numConnectedClients; j++)
 			{
@@ -1393,15 +1765,7 @@ void G_UpdateTeamMapData(void)
 					continue;
 				}
 
-				VectorCopy(ent2->client->ps.origin, pos[0]);
-				pos[0][2] += ent2->client->ps.mins[2];
-				VectorCopy(ent2->client->ps.origin, pos[1]);
-				VectorCopy(ent2->client->ps.origin, pos[2]);
-				pos[2][2] += ent2->client->ps.maxs[2];
-
-				if (G_VisibleFromBinoculars(ent, ent2, pos[0]) ||
-				    G_VisibleFromBinoculars(ent, ent2, pos[1]) ||
-				    G_VisibleFromBinoculars(ent, ent2, pos[2]))
+				if (G_SpotPlayer(ent, ent2))
 				{
 					G_UpdateTeamMapData_DisguisedPlayer(ent, ent2, f1, f2);
 				}
@@ -1409,9 +1773,10 @@ void G_UpdateTeamMapData(void)
 		}
 		else if (ent->client->sess.playerType == PC_COVERTOPS)
 		{
-			vec3_t pos[3];
-
+			G_SpotGridPlayers();
 			G_SetupFrustum(ent);
+			G_SpotGridCull(&spotPlayers);
+			level.teamMapStats.viewers++;
 
 			for (j = 0; j < level.numConnectedClients; j++)
 			{
@@ -1446,15 +1811,7 @@ void G_UpdateTeamMapData(void)
 					continue;
 				}
 
-				VectorCopy(ent2->client->ps.origin, pos[0]);
-				pos[0][2] += ent2->client->ps.mins[2];
-				VectorCopy(ent2->client->ps.origin, pos[1]);
-				VectorCopy(ent2->client->ps.origin, pos[2]);
-				pos[2][2] += ent2->client->ps.maxs[2];
-
-				if (G_VisibleFromBinoculars(ent, ent2, pos[0]) ||
-				    G_VisibleFromBinoculars(ent, ent2, pos[1]) ||
-				    G_VisibleFromBinoculars(ent, ent2, pos[2]))
+				if (G_SpotPlayer(ent, ent2))
 				{
 					G_UpdateTeamMapData_Player(ent2, f1, f2);
 				}
@@ -620,6 +620,7 @@ void CM_LoadMap(const char *name, qboolean clientload, unsigned int *checksum)
 	dheader_t       header;
 	int             length;
 	static unsigned last_checksum;
+	hunkTag_t       oldTag;
 
 	if (!name || !name[0])
 	{
@@ -653,6 +654,8 @@ void CM_LoadMap(const char *name, qboolean clientload, unsigned int *checksum)
 		return;
 	}
 
+	oldTag = Hunk_SetTag(HUNK_TAG_COLLISION);
+
 	// load the file
 	length = FS_ReadFile(name, &buf.v);
 
@@ -699,6 +702,8 @@ void CM_LoadMap(const char *name, qboolean clientload, unsigned int *checksum)
 
 	CM_FloodAreaConnections();
 
+	Hunk_SetTag(oldTag);
+
 	// allow this to be cached if it is loaded by the server
 	if (!clientload)
 	{
@@ -40,19 +40,27 @@
 #include "../client/client.h"
 #endif
 
-#define MAX_CMD_BUFFER  131072
+#define MIN_CMD_BUFFER  131072                  ///< initial size of the command ring buffer, must be a power of two
+#define MAX_CMD_BUFFER  (16 * MIN_CMD_BUFFER)   ///< the ring buffer doubles up to this size before refusing text
 #define MAX_CMD_LINE    1024
 
+/**
+ * @struct cmd_t
+ * @brief Ring buffer of pending command text
+ */
 typedef struct
 {
 	byte *data;
-	unsigned int maxsize;
+	unsigned int maxsize;           ///< always a power of two
+	unsigned int head;              ///< read position
 	unsigned int cursize;
 } cmd_t;
 
 int   cmd_wait;
 cmd_t cmd_text;
-byte  cmd_text_buf[MAX_CMD_BUFFER];
+byte  cmd_text_buf[MIN_CMD_BUFFER];
+
+#define CBUF_CHAR(i) ((char)cmd_text.data[(cmd_text.head + (i)) & (cmd_text.maxsize - 1)])
 
 //=============================================================================
 
@@ -91,13 +99,98 @@ void Cmd_Wait_f(void)
 void Cbuf_Init(void)
 {
 	cmd_text.data    = cmd_text_buf;
-	cmd_text.maxsize = MAX_CMD_BUFFER;
+	cmd_text.maxsize = MIN_CMD_BUFFER;
+	cmd_text.head    = 0;
 	cmd_text.cursize = 0;
 }
 
+/**
+ * @brief Copies text into the ring buffer starting at the given position, wrapping as needed
+ * @param[in] pos
+ * @param[in] text
+ * @param[in] len
+ */
+static void Cbuf_Write(unsigned int pos, const char *text, unsigned int len)
+{
+	unsigned int first;
+
+	pos  &= cmd_text.maxsize - 1;
+	first = cmd_text.maxsize - pos;
+
+	if (len <= first)
+	{
+		Com_Memcpy(cmd_text.data + pos, text, len);
+	}
+	else
+	{
+		Com_Memcpy(cmd_text.data + pos, text, first);
+		Com_Memcpy(cmd_text.data, text + first, len - first);
+	}
+}
+
+/**
+ * @brief Makes room for len more bytes by growing the ring buffer
+ * @param[in] len
+ * @return qfalse if the buffer is at MAX_CMD_BUFFER and the text doesn't fit
+ */
+static qboolean Cbuf_Reserve(size_t len)
+{
+	unsigned int newsize;
+	byte         *newdata;
+
+	if (cmd_text.cursize + len <= cmd_text.maxsize)
+	{
+		return qtrue;
+	}
+
+	newsize = cmd_text.maxsize;
+	while (cmd_text.cursize + len > newsize)
+	{
+		newsize <<= 1;
+		if (newsize > MAX_CMD_BUFFER)
+		{
+			return qfalse;
+		}
+	}
+
+	newdata = Com_Allocate(newsize);
+	if (!newdata)
+	{
+		return qfalse;
+	}
+
+	// linearize the pending text at the start of the new buffer
+	if (cmd_text.head + cmd_text.cursize <= cmd_text.maxsize)
+	{
+		Com_Memcpy(newdata, cmd_text.data + cmd_text.head, cmd_text.cursize);
+	}
+	else
+	{
+		unsigned int first = cmd_text.maxsize - cmd_text.head;
+
+		Com_Memcpy(newdata, cmd_text.data + cmd_text.head, first);
+		Com_Memcpy(newdata + first, cmd_text.data, cmd_text.cursize - first);
+	}
+
+	if (cmd_text.data != cmd_text_buf)
+	{
+		Com_Dealloc(cmd_text.data);
+	}
+
+	Com_DPrintf("Cbuf_Reserve: command buffer grown to %u bytes\n", newsize);
+
+	cmd_text.data    = newdata;
+	cmd_text.maxsize = newsize;
+	cmd_text.head    = 0;
+
+	return qtrue;
+}
+
 /**
  * @brief Adds command text at the end of the buffer, does NOT add a final \\n
  * @param text
+ *
+ * @note Text that doesn't fit once the buffer reached MAX_CMD_BUFFER is dropped with a message
  */
 void Cbuf_AddText(const char *text)
 {
@@ -105,12 +198,13 @@ void Cbuf_AddText(const char *text)
 
 	l = strlen(text);
 
-	if (cmd_text.cursize + l >= cmd_text.maxsize)
+	if (!Cbuf_Reserve(l))
 	{
-		Com_Printf("Cbuf_AddText: overflow\n");
+		Com_Printf("Cbuf_AddText: command buffer full, %i bytes not queued\n", (int)l);
 		return;
 	}
-	Com_Memcpy(&cmd_text.data[cmd_text.cursize], text, l);
+
+	Cbuf_Write(cmd_text.head + cmd_text.cursize, text, l);
 	cmd_text.cursize += l;
 }
 
@@ -119,30 +213,29 @@ void Cbuf_AddText(const char *text)
  * Adds a \\n to the text
  *
  * @param[in] text
+ *
+ * @note Text that doesn't fit once the buffer reached MAX_CMD_BUFFER is dropped with a message
  */
 void Cbuf_InsertText(const char *text)
 {
-	size_t       len;
-	unsigned int i;
+	size_t len;
 
 	len = strlen(text) + 1;
-	if (len + cmd_text.cursize > cmd_text.maxsize)
+	if (!Cbuf_Reserve(len))
 	{
-		Com_Printf("Cbuf_InsertText overflowed\n");
+		Com_Printf("Cbuf_InsertText: command buffer full, %i bytes not queued\n", (int)len);
 		return;
 	}
 
-	// move the existing command text
-	for (i = cmd_text.cursize - 1 ; i != UINT_MAX; i--)
-	{
-		cmd_text.data[i + len] = cmd_text.data[i];
-	}
+	// the ring buffer lets us prepend by moving the read position back,
+	// so the pending text never has to be moved
+	cmd_text.head = (cmd_text.head - len) & (cmd_text.maxsize - 1);
 
 	// copy the new text in
-	Com_Memcpy(cmd_text.data, text, len - 1);
+	Cbuf_Write(cmd_text.head, text, len - 1);
 
 	// add a \n
-	cmd_text.data[len - 1] = '\n';
+	cmd_text.data[(cmd_text.head + len - 1) & (cmd_text.maxsize - 1)] = '\n';
 
 	cmd_text.cursize += len;
 }
@@ -164,7 +257,7 @@ void Cbuf_ExecuteText(int exec_when, const char *text)
 		}
 		else
 		{
-			Com_DPrintf(S_COLOR_YELLOW "EXEC_NOW %s\n", cmd_text.data);
+			Com_DPrintf(S_COLOR_YELLOW "EXEC_NOW %u bytes of buffered commands\n", cmd_text.cursize);
 			Cbuf_Execute();
 		}
 		break;
@@ -184,8 +277,7 @@ void Cbuf_ExecuteText(int exec_when, const char *text)
  */
 void Cbuf_Execute(void)
 {
-	unsigned int i;
-	char         *text;
+	unsigned int i, len;
 	char         line[MAX_CMD_LINE];
 	int          quotes;
 	// This will keep // style comments all on one line by not breaking on
@@ -205,14 +297,14 @@ void Cbuf_Execute(void)
 		}
 
 		// find a \n or ; line break or comment: // or /* */
-		text = (char *)cmd_text.data;
-
 		quotes = 0;
 		for (i = 0 ; i < cmd_text.cursize ; i++)
 		{
+			char c = CBUF_CHAR(i);
+
 			// FIXME: ignore quoted text
 
-			if (text[i] == '"')
+			if (c == '"')
 			{
 				quotes++;
 			}
@@ -221,15 +313,17 @@ void Cbuf_Execute(void)
 			{
 				if (i < cmd_text.cursize - 1)
 				{
-					if (!in_star_comment && text[i] == '/' && text[i + 1] == '/')
+					char next = CBUF_CHAR(i + 1);
+
+					if (!in_star_comment && c == '/' && next == '/')
 					{
 						in_slash_comment = qtrue;
 					}
-					else if (!in_slash_comment && text[i] == '/' && text[i + 1] == '*')
+					else if (!in_slash_comment && c == '/' && next == '*')
 					{
 						in_star_comment = qtrue;
 					}
-					else if (in_star_comment && text[i] == '*' && text[i + 1] == '/')
+					else if (in_star_comment && c == '*' && next == '/')
 					{
 						in_star_comment = qfalse;
 						// If we are in a star comment, then the part after it is valid
@@ -239,12 +333,12 @@ void Cbuf_Execute(void)
 						break;
 					}
 				}
-				if (!in_slash_comment && !in_star_comment && text[i] == ';')
+				if (!in_slash_comment && !in_star_comment && c == ';')
 				{
 					break;
 				}
 			}
-			if (!in_star_comment && (text[i] == '\n' || text[i] == '\r'))
+			if (!in_star_comment && (c == '\n' || c == '\r'))
 			{
 				in_slash_comment = qfalse;
 				break;
@@ -256,22 +350,31 @@ void Cbuf_Execute(void)
 			i = MAX_CMD_LINE - 1;
 		}
 
-		Com_Memcpy(line, text, i);
+		// copy the line out, it may wrap around the end of the ring buffer
+		len = cmd_text.maxsize - cmd_text.head;
+		if (i <= len)
+		{
+			Com_Memcpy(line, cmd_text.data + cmd_text.head, i);
+		}
+		else
+		{
+			Com_Memcpy(line, cmd_text.data + cmd_text.head, len);
+			Com_Memcpy(line + len, cmd_text.data, i - len);
+		}
 		line[i] = 0;
 
-		// delete the text from the command buffer and move remaining commands down
-		// this is necessary because commands (exec) can insert data at the
-		// beginning of the text buffer
-
+		// consume the line and its terminator, commands (exec) can insert data
+		// in front of the remaining text without anything being moved
 		if (i == cmd_text.cursize)
 		{
 			cmd_text.cursize = 0;
+			cmd_text.head    = 0;
 		}
 		else
 		{
 			i++;
 			cmd_text.cursize -= i;
-			memmove(text, text + i, cmd_text.cursize);
+			cmd_text.head     = (cmd_text.head + i) & (cmd_text.maxsize - 1);
 		}
 
 		// execute the command line
@@ -393,7 +496,8 @@ void Cmd_Echo_f(void)
  */
 typedef struct cmd_function_s
 {
-	struct cmd_function_s *next;
+	struct cmd_function_s *next;            ///< alphabetically sorted list used by cmdlist and completion
+	struct cmd_function_s *hashNext;        ///< bucket chain in cmd_hashTable
 	char *name;
 	char *description;
 	xcommand_t function;
@@ -407,6 +511,10 @@ static char cmd_cmd[BIG_INFO_STRING];                                   ///< the
 
 static cmd_function_t *cmd_functions;                                   ///< possible commands to execute
 
+#define CMD_HASH_SIZE 1024
+static cmd_function_t *cmd_hashTable[CMD_HASH_SIZE];                    ///< case insensitive lookup of cmd_functions
+#define generateHashValue(cname) Q_GenerateHashValue(cname, CMD_HASH_SIZE, qtrue, qtrue)
+
 /**
  * @brief Cmd_Argc
  * @return
@@ -442,25 +550,51 @@ void Cmd_ArgvBuffer(int arg, char *buffer, size_t bufferLength)
 }
 
 /**
- * @brief Cmd_Args
- * @return A single string containing argv(1) to argv(argc()-1)
+ * @brief Joins argv(arg) to argv(max-1) into buffer with single spaces
+ *
+ * @details Only materialized when asked for, and appends at a running
+ * offset instead of rescanning the result for every token.
+ *
+ * @param[in] arg
+ * @param[in] max
+ * @param[out] buffer
+ * @param[in] bufferLength
+ * @return buffer
  */
-char *Cmd_Args(void)
+static char *Cmd_JoinArgs(int arg, int max, char *buffer, size_t bufferLength)
 {
-	static char cmd_args[MAX_STRING_CHARS];
-	int         i;
+	size_t len = 0, tokenLen;
+	int    i;
 
-	cmd_args[0] = 0;
-	for (i = 1 ; i < cmd_argc ; i++)
+	for (i = arg; i < max && len < bufferLength - 1; i++)
 	{
-		Q_strcat(cmd_args, MAX_STRING_CHARS, cmd_argv[i]);
-		if (i != cmd_argc - 1)
+		tokenLen = strlen(cmd_argv[i]);
+		if (tokenLen > bufferLength - 1 - len)
+		{
+			tokenLen = bufferLength - 1 - len;
+		}
+		Com_Memcpy(buffer + len, cmd_argv[i], tokenLen);
+		len += tokenLen;
+
+		if (i != max - 1 && len < bufferLength - 1)
 		{
-			strcat(cmd_args, " ");
+			buffer[len++] = ' ';
 		}
 	}
+	buffer[len] = 0;
+
+	return buffer;
+}
+
+/**
+ * @brief Cmd_Args
+ * @return A single string containing argv(1) to argv(argc()-1)
+ */
+char *Cmd_Args(void)
+{
+	static char cmd_args[MAX_STRING_CHARS];
 
-	return cmd_args;
+	return Cmd_JoinArgs(1, cmd_argc, cmd_args, sizeof(cmd_args));
 }
 
 /**
@@ -471,23 +605,13 @@ char *Cmd_Args(void)
 char *Cmd_ArgsFrom(int arg)
 {
 	static char cmd_args[BIG_INFO_STRING];
-	int         i;
 
-	cmd_args[0] = 0;
 	if (arg < 0)
 	{
 		arg = 0;
 	}
-	for (i = arg ; i < cmd_argc ; i++)
-	{
-		Q_strcat(cmd_args, BIG_INFO_STRING, cmd_argv[i]);
-		if (i != cmd_argc - 1)
-		{
-			strcat(cmd_args, " ");
-		}
-	}
 
-	return cmd_args;
+	return Cmd_JoinArgs(arg, cmd_argc, cmd_args, sizeof(cmd_args));
 }
 
 /**
@@ -499,9 +623,7 @@ char *Cmd_ArgsFrom(int arg)
 char *Cmd_ArgsFromTo(int arg, int max)
 {
 	static char cmd_args[BIG_INFO_STRING];
-	int         i;
 
-	cmd_args[0] = 0;
 	if (arg < 0)
 	{
 		arg = 0;
@@ -517,16 +639,7 @@ char *Cmd_ArgsFromTo(int arg, int max)
 		max = cmd_argc;
 	}
 
-	for (i = arg ; i < max ; i++)
-	{
-		Q_strcat(cmd_args, BIG_INFO_STRING, cmd_argv[i]);
-		if (i != max - 1)
-		{
-			strcat(cmd_args, " ");
-		}
-	}
-
-	return cmd_args;
+	return Cmd_JoinArgs(arg, max, cmd_args, sizeof(cmd_args));
 }
 
 /**
@@ -737,7 +850,7 @@ cmd_function_t *Cmd_FindCommand(const char *cmd_name)
 {
 	cmd_function_t *cmd;
 
-	for (cmd = cmd_functions; cmd; cmd = cmd->next)
+	for (cmd = cmd_hashTable[generateHashValue(cmd_name)]; cmd; cmd = cmd->hashNext)
 	{
 		if (!Q_stricmp(cmd_name, cmd->name))
 		{
@@ -756,7 +869,8 @@ cmd_function_t *Cmd_FindCommand(const char *cmd_name)
  */
 void Cmd_AddSystemCommand(const char *cmd_name, xcommand_t function, const char *description, completionFunc_t complete)
 {
-	cmd_function_t *cmd;
+	cmd_function_t *cmd, **prev;
+	long           hash;
 
 	if (!cmd_name || !cmd_name[0])
 	{
@@ -780,8 +894,17 @@ void Cmd_AddSystemCommand(const char *cmd_name, xcommand_t function, const char
 	cmd->name     = CopyString(cmd_name);
 	cmd->function = function;
 	cmd->complete = complete;
-	cmd->next     = cmd_functions;
-	cmd_functions = cmd;
+
+	// keep the list sorted so cmdlist and completion don't have to
+	for (prev = &cmd_functions; *prev && Q_stricmp((*prev)->name, cmd_name) < 0; prev = &(*prev)->next)
+	{
+	}
+	cmd->next = *prev;
+	*prev     = cmd;
+
+	hash                = generateHashValue(cmd_name);
+	cmd->hashNext       = cmd_hashTable[hash];
+	cmd_hashTable[hash] = cmd;
 
 	if (description && description[0])
 	{
@@ -800,15 +923,11 @@ void Cmd_AddSystemCommand(const char *cmd_name, xcommand_t function, const char
  */
 void Cmd_SetCommandCompletionFunc(const char *command, completionFunc_t complete)
 {
-	cmd_function_t *cmd;
+	cmd_function_t *cmd = Cmd_FindCommand(command);
 
-	for (cmd = cmd_functions; cmd; cmd = cmd->next)
+	if (cmd)
 	{
-		if (!Q_stricmp(command, cmd->name))
-		{
-			cmd->complete = complete;
-			return;
-		}
+		cmd->complete = complete;
 	}
 }
 
@@ -821,14 +940,11 @@ void Cmd_SetCommandCompletionFunc(const char *command, completionFunc_t complete
  */
 void Cmd_SetCommandDescription(const char *command, const char *description)
 {
-	cmd_function_t *cmd;
+	cmd_function_t *cmd = Cmd_FindCommand(command);
 
-	for (cmd = cmd_functions; cmd; cmd = cmd->next)
+	if (cmd)
 	{
-		if (!Q_stricmp(command, cmd->name))
-		{
-			cmd->description = CopyString(description);
-		}
+		cmd->description = CopyString(description);
 	}
 }
 
@@ -838,7 +954,7 @@ void Cmd_SetCommandDescription(const char *command, const char *description)
  */
 void Cmd_RemoveCommand(const char *cmd_name)
 {
-	cmd_function_t *cmd, **back = &cmd_functions;
+	cmd_function_t *cmd, **back = &cmd_functions, **hashBack;
 
 	if (!cmd_name || !cmd_name[0])
 	{
@@ -858,6 +974,15 @@ void Cmd_RemoveCommand(const char *cmd_name)
 		{
 			*back = cmd->next;
 
+			for (hashBack = &cmd_hashTable[generateHashValue(cmd_name)]; *hashBack; hashBack = &(*hashBack)->hashNext)
+			{
+				if (*hashBack == cmd)
+				{
+					*hashBack = cmd->hashNext;
+					break;
+				}
+			}
+
 			Z_Free(cmd->name);
 
 			if (cmd->description)
@@ -946,18 +1071,11 @@ void Cmd_CommandCompletion(void (*callback)(const char *s))
  */
 void Cmd_CompleteArgument(const char *command, char *args, int argNum)
 {
-	cmd_function_t *cmd;
+	cmd_function_t *cmd = Cmd_FindCommand(command);
 
-	for (cmd = cmd_functions; cmd; cmd = cmd->next)
+	if (cmd && cmd->complete)
 	{
-		if (!Q_stricmp(command, cmd->name))
-		{
-			if (cmd->complete)
-			{
-				cmd->complete(args, argNum);
-			}
-			return;
-		}
+		cmd->complete(args, argNum);
 	}
 }
 
@@ -967,7 +1085,7 @@ void Cmd_CompleteArgument(const char *command, char *args, int argNum)
  */
 void Cmd_ExecuteString(const char *text)
 {
-	cmd_function_t *cmd, **prev;
+	cmd_function_t *cmd;
 
 	// execute the command line
 	Cmd_TokenizeString(text);
@@ -977,29 +1095,13 @@ void Cmd_ExecuteString(const char *text)
 	}
 
 	// check registered command functions
-	for (prev = &cmd_functions ; *prev ; prev = &cmd->next)
+	cmd = Cmd_FindCommand(cmd_argv[0]);
+
+	// no function means the cgame or game handles it
+	if (cmd && cmd->function)
 	{
-		cmd = *prev;
-		if (!Q_stricmp(cmd_argv[0], cmd->name))
-		{
-			// rearrange the links so that the command will be
-			// near the head of the list next time it is used
-			*prev         = cmd->next;
-			cmd->next     = cmd_functions;
-			cmd_functions = cmd;
-
-			// perform the action
-			if (!cmd->function)
-			{
-				// let the cgame or game handle it
-				break;
-			}
-			else
-			{
-				cmd->function();
-			}
-			return;
-		}
+		cmd->function();
+		return;
 	}
 
 	// check cvars
@@ -1081,6 +1183,85 @@ void Cmd_CompleteCfgName(char *args, int argNum)
 	}
 }
 
+#ifdef ETLEGACY_DEBUG
+static int cmd_benchCalls;
+
+/**
+ * @brief Target of the generated cmdbench config lines
+ */
+static void Cmd_BenchNop_f(void)
+{
+	cmd_benchCalls++;
+}
+
+/**
+ * @brief Times command lookup and execution of a generated config
+ *
+ * @details Usage: cmdbench [lines]
+ * The config mixes lookups of a registered command in different cases
+ * with 'set' lines, which is what real configs are mostly made of.
+ */
+static void Cmd_Bench_f(void)
+{
+	cmd_function_t *cmd;
+	int            lines = 100000, numCmds = 0, i, found = 0, start, lookupMsec, execMsec;
+	char           line[MAX_CMD_LINE];
+
+	if (Cmd_Argc() > 1)
+	{
+		lines = atoi(Cmd_Argv(1));
+		if (lines <= 0)
+		{
+			lines = 100000;
+		}
+	}
+
+	Cmd_AddCommand("cmdbench_nop", Cmd_BenchNop_f, "cmdbench helper");
+	cmd_benchCalls = 0;
+
+	for (cmd = cmd_functions; cmd; cmd = cmd->next)
+	{
+		numCmds++;
+	}
+
+	// cycle through all registered commands, every 8th lookup is a miss
+	start = Sys_Milliseconds();
+	for (i = 0, cmd = cmd_functions; i < lines; i++)
+	{
+		if (Cmd_FindCommand((i & 7) ? cmd->name : "cmdbench_miss"))
+		{
+			found++;
+		}
+		cmd = cmd->next ? cmd->next : cmd_functions;
+	}
+	lookupMsec = Sys_Milliseconds() - start;
+
+	start = Sys_Milliseconds();
+	for (i = 0; i < lines; i++)
+	{
+		switch (i & 3)
+		{
+		case 0:
+			Com_sprintf(line, sizeof(line), "cmdbench_nop %i", i);
+			break;
+		case 1:
+			Com_sprintf(line, sizeof(line), "CmdBench_Nop \"arg %i\" second third", i);
+			break;
+		default:
+			Com_sprintf(line, sizeof(line), "set cmdbench_var %i", i);
+			break;
+		}
+		Cmd_ExecuteString(line);
+	}
+	execMsec = Sys_Milliseconds() - start;
+
+	Cmd_RemoveCommand("cmdbench_nop");
+
+	Com_Printf("cmdbench: %i registered commands, %i lookups (%i found) in %i msec\n", numCmds, lines, found, lookupMsec);
+	Com_Printf("cmdbench: executed %i config lines (%i command calls) in %i msec\n", lines, cmd_benchCalls, execMsec);
+}
+#endif
+
 /**
  * @brief Cmd_Init
  */
@@ -1093,4 +1274,7 @@ void Cmd_Init(void)
 	Cmd_AddCommand("vstr", Cmd_Vstr_f, "Inserts the current value of a variable as command text.", Cvar_CompleteCvarName);
 	Cmd_AddCommand("echo", Cmd_Echo_f, "Prints quoted text to the console and shows a notification if connected to a server.");
 	Cmd_AddCommand("wait", Cmd_Wait_f, "Causes execution of the remainder of the command buffer to be delayed until next frame.");
+#ifdef ETLEGACY_DEBUG
+	Cmd_AddCommand("cmdbench", Cmd_Bench_f, "Benchmarks command lookup and execution of a generated config.");
+#endif
 }
@@ -86,6 +86,20 @@ int demo_protocols[] =
 
 jmp_buf abortframe;     // an ERR_DROP occured, exit the entire frame
 
+/**
+ * @struct comCatch_s
+ * @brief Where Com_Error returns to on a thread running Com_CatchError
+ */
+typedef struct comCatch_s
+{
+	jmp_buf frame;
+	int code;
+	char message[MAXPRINTMSG];
+} comCatch_t;
+
+/// abortframe belongs to the main thread, other threads catch their errors here
+static Q_THREAD_LOCAL comCatch_t *com_catch = NULL;
+
 void CL_ShutdownCGame(void);
 
 static fileHandle_t logfile;
@@ -348,6 +362,16 @@ void QDECL Com_Error(int code, const char *fmt, ...)
 	static int errorCount;
 	int        currentTime;
 
+	// not the main thread, hand the error back to Com_CatchError
+	if (com_catch)
+	{
+		com_catch->code = code;
+		va_start(argptr, fmt);
+		Q_vsnprintf(com_catch->message, sizeof(com_catch->message), fmt, argptr);
+		va_end(argptr);
+		longjmp(com_catch->frame, -1);
+	}
+
 	// when we are running automated scripts, make sure we
 	// know if anything failed
 	if (com_buildScript && com_buildScript->integer)
@@ -440,6 +464,38 @@ void QDECL Com_Error(int code, const char *fmt, ...)
 	Sys_Error("%s", com_errorMessage);
 }
 
+/**
+ * @brief Run func(arg) on a thread other than the main one and catch a Com_Error it raises
+ *
+ * Com_Error would longjmp to the abortframe of the main thread. Here it stops func
+ * and returns, the caller raises the error again on the main thread.
+ *
+ * @param[in] func
+ * @param[in] arg
+ * @param[out] code - code of the caught error
+ * @param[out] message - message of the caught error
+ * @param[in] size - size of message
+ * @return qtrue if func raised an error
+ */
+qboolean Com_CatchError(sysThreadFunc_t func, void *arg, int *code, char *message, size_t size)
+{
+	comCatch_t catcher;
+
+	if (setjmp(catcher.frame))
+	{
+		com_catch = NULL;
+		*code     = catcher.code;
+		Q_strncpyz(message, catcher.message, size);
+		return qtrue;
+	}
+
+	com_catch = &catcher;
+	func(arg);
+	com_catch = NULL;
+
+	return qfalse;
+}
+
 /**
  * @brief Both client and server can use this, and it will do the appropriate thing.
  */
@@ -1482,6 +1538,8 @@ typedef struct
 {
 	int magic;
 	int size;
+	int tag;
+	int pad;
 } hunkHeader_t;
 
 /**
@@ -1516,6 +1574,35 @@ static hunkUsed_t *hunk_permanent, *hunk_temp;
 static byte *s_hunkData = NULL;
 static int  s_hunkTotal;
 
+/**
+ * @struct hunkArena_s
+ * @brief Per sub-arena usage counters, the memory itself still lives in the two hunk stacks
+ */
+typedef struct
+{
+	const char *name;
+	int mark;
+	int permanent;
+	int permanentHighwater;
+	int temp;
+	int tempHighwater;
+	int allocations;
+} hunkArena_t;
+
+static hunkArena_t s_hunkArenas[HUNK_TAG_MAX] =
+{
+	{ "general",   0, 0, 0, 0, 0, 0 },
+	{ "collision", 0, 0, 0, 0, 0, 0 },
+	{ "renderer",  0, 0, 0, 0, 0, 0 },
+	{ "botlib",    0, 0, 0, 0, 0, 0 },
+	{ "sound",     0, 0, 0, 0, 0, 0 },
+	{ "game",      0, 0, 0, 0, 0, 0 },
+};
+
+static hunkTag_t s_hunkTag = HUNK_TAG_GENERAL;
+
+static cvar_t *com_hunkStatsDump;
+
 static int s_zoneTotal;
 static int s_smallZoneTotal;
 
@@ -1814,6 +1901,108 @@ void Hunk_SmallLog(void)
 	FS_Write(buf, strlen(buf), logfile);
 }
 
+/**
+ * @brief Selects the sub-arena following hunk allocations are accounted to
+ * @param[in] tag
+ * @return The previously active tag so callers can restore it
+ */
+hunkTag_t Hunk_SetTag(hunkTag_t tag)
+{
+	hunkTag_t old = s_hunkTag;
+
+	if (tag < HUNK_TAG_GENERAL || tag >= HUNK_TAG_MAX)
+	{
+		tag = HUNK_TAG_GENERAL;
+	}
+
+	s_hunkTag = tag;
+
+	return old;
+}
+
+/**
+ * @brief Prints per sub-arena hunk usage and high-water marks
+ */
+static void Hunk_Stats_f(void)
+{
+	int i;
+	int permanent = 0, temp = 0;
+
+	if (!s_hunkData)
+	{
+		Com_Printf("Hunk memory system not initialized\n");
+		return;
+	}
+
+	if (Cmd_Argc() > 1 && !Q_stricmp(Cmd_Argv(1), "reset"))
+	{
+		for (i = 0; i < HUNK_TAG_MAX; i++)
+		{
+			s_hunkArenas[i].permanentHighwater = s_hunkArenas[i].permanent;
+			s_hunkArenas[i].tempHighwater      = s_hunkArenas[i].temp;
+		}
+		Com_Printf("Hunk high-water marks reset\n");
+		return;
+	}
+
+	Com_Printf("arena        permanent (MB)   highwater (MB)   temp peak (MB)   allocs\n");
+	Com_Printf("----------   --------------   --------------   --------------   ------\n");
+	for (i = 0; i < HUNK_TAG_MAX; i++)
+	{
+		Com_Printf("%-10s   %14.2f   %14.2f   %14.2f   %6i\n", s_hunkArenas[i].name,
+		           s_hunkArenas[i].permanent / Square(1024.f),
+		           s_hunkArenas[i].permanentHighwater / Square(1024.f),
+		           s_hunkArenas[i].tempHighwater / Square(1024.f),
+		           s_hunkArenas[i].allocations);
+		permanent += s_hunkArenas[i].permanent;
+		temp      += s_hunkArenas[i].temp;
+	}
+	Com_Printf("\n");
+	Com_Printf("%9i bytes (%6.2f MB) permanent in use\n", permanent, permanent / Square(1024.f));
+	Com_Printf("%9i bytes (%6.2f MB) temp in use\n", temp, temp / Square(1024.f));
+	Com_Printf("%9i bytes (%6.2f MB) remaining of %i MB com_hunkMegs\n", Hunk_MemoryRemaining(), Hunk_MemoryRemaining() / Square(1024.f), s_hunkTotal / (1024 * 1024));
+}
+
+/**
+ * @brief Writes the sub-arena usage to hunkstats/<mapname>.json if com_hunkStatsDump is set
+ * @param[in] mapname
+ */
+void Hunk_DumpStats(const char *mapname)
+{
+	fileHandle_t f;
+	int          i;
+
+	if (!com_hunkStatsDump || !com_hunkStatsDump->integer || !s_hunkData || !mapname || !*mapname)
+	{
+		return;
+	}
+
+	f = FS_FOpenFileWrite(va("hunkstats/%s.json", mapname));
+	if (!f)
+	{
+		Com_Printf("Hunk_DumpStats: couldn't write hunkstats/%s.json\n", mapname);
+		return;
+	}
+
+	FS_Printf(f, "{\n");
+	FS_Printf(f, "\t\"map\": \"%s\",\n", mapname);
+	FS_Printf(f, "\t\"hunkTotal\": %i,\n", s_hunkTotal);
+	FS_Printf(f, "\t\"hunkUsed\": %i,\n", hunk_low.permanent + hunk_high.permanent);
+	FS_Printf(f, "\t\"hunkRemaining\": %i,\n", Hunk_MemoryRemaining());
+	FS_Printf(f, "\t\"arenas\": {\n");
+	for (i = 0; i < HUNK_TAG_MAX; i++)
+	{
+		FS_Printf(f, "\t\t\"%s\": { \"permanent\": %i, \"permanentHighwater\": %i, \"tempHighwater\": %i, \"allocations\": %i }%s\n",
+		          s_hunkArenas[i].name, s_hunkArenas[i].permanent, s_hunkArenas[i].permanentHighwater,
+		          s_hunkArenas[i].tempHighwater, s_hunkArenas[i].allocations, (i < HUNK_TAG_MAX - 1) ? "," : "");
+	}
+	FS_Printf(f, "\t}\n");
+	FS_Printf(f, "}\n");
+	FS_FCloseFile(f);
+
+	Com_DPrintf("Wrote hunkstats/%s.json\n", mapname);
+}
+
 /**
  * @brief Com_InitHunkMemory
  */
@@ -1868,7 +2057,11 @@ void Com_InitHunkMemory(void)
 	s_hunkData = ( byte * )(((intptr_t)s_hunkData + 31) & ~31);
 	Hunk_Clear();
 
+	com_hunkStatsDump = Cvar_Get("com_hunkStatsDump", "0", CVAR_ARCHIVE);
+	Cvar_SetDescription(com_hunkStatsDump, "Write hunk sub-arena usage to hunkstats/<mapname>.json after each map load");
+
 	Cmd_AddCommand("meminfo", Com_Meminfo_f, "Displays info about used memory.");
+	Cmd_AddCommand("hunkstats", Hunk_Stats_f, "Displays hunk usage and high-water marks per sub-arena, 'hunkstats reset' resets the high-water marks.");
 #ifdef ZONE_DEBUG
 	Cmd_AddCommand("zonelog", Z_LogHeap, "Writes zone memory info into logfile.");
 #endif
@@ -1890,13 +2083,42 @@ int Hunk_MemoryRemaining(void)
 	return s_hunkTotal - (low + high);
 }
 
+/**
+ * @brief Zone and hunk usage, without walking the blocks like meminfo
+ * @param[out] usage
+ */
+void Com_MemoryUsage(memoryUsage_t *usage)
+{
+	int i;
+
+	usage->zoneUsed      = mainzone->used;
+	usage->zoneSize      = mainzone->size;
+	usage->smallZoneUsed = smallzone->used;
+	usage->smallZoneSize = smallzone->size;
+	usage->hunkUsed      = s_hunkTotal - Hunk_MemoryRemaining();
+	usage->hunkSize      = s_hunkTotal;
+
+	for (i = 0; i < HUNK_TAG_MAX; i++)
+	{
+		usage->hunkArenaNames[i] = s_hunkArenas[i].name;
+		usage->hunkArenaUsed[i]  = s_hunkArenas[i].permanent + s_hunkArenas[i].temp;
+	}
+}
+
 /**
  * @brief The server calls this after the level and game VM have been loaded
  */
 void Hunk_SetMark(void)
 {
+	int i;
+
 	hunk_low.mark  = hunk_low.permanent;
 	hunk_high.mark = hunk_high.permanent;
+
+	for (i = 0; i < HUNK_TAG_MAX; i++)
+	{
+		s_hunkArenas[i].mark = s_hunkArenas[i].permanent;
+	}
 }
 
 /**
@@ -1904,8 +2126,16 @@ void Hunk_SetMark(void)
  */
 void Hunk_ClearToMark(void)
 {
+	int i;
+
 	hunk_low.permanent  = hunk_low.temp = hunk_low.mark;
 	hunk_high.permanent = hunk_high.temp = hunk_high.mark;
+
+	for (i = 0; i < HUNK_TAG_MAX; i++)
+	{
+		s_hunkArenas[i].permanent = s_hunkArenas[i].mark;
+		s_hunkArenas[i].temp      = 0;
+	}
 }
 
 /**
@@ -1929,6 +2159,8 @@ void SV_ShutdownGameProgs(void);
  */
 void Hunk_Clear(void)
 {
+	int i;
+
 #ifndef DEDICATED
 	CL_ShutdownCGame();
 	CL_ShutdownUI();
@@ -1952,6 +2184,16 @@ void Hunk_Clear(void)
 
 	hunk_permanent = &hunk_low;
 	hunk_temp      = &hunk_high;
+	s_hunkTag      = HUNK_TAG_GENERAL;
+
+	// high-water marks are kept across maps so the largest map of a session can be read back
+	for (i = 0; i < HUNK_TAG_MAX; i++)
+	{
+		s_hunkArenas[i].mark        = 0;
+		s_hunkArenas[i].permanent   = 0;
+		s_hunkArenas[i].temp        = 0;
+		s_hunkArenas[i].allocations = 0;
+	}
 
 	Cvar_Set("com_hunkused", va("%i", hunk_low.permanent + hunk_high.permanent));
 	com_hunkusedvalue = hunk_low.permanent + hunk_high.permanent;
@@ -2041,6 +2283,13 @@ void *Hunk_Alloc(unsigned int size, ha_pref preference)
 
 	hunk_permanent->temp = hunk_permanent->permanent;
 
+	s_hunkArenas[s_hunkTag].permanent += size;
+	s_hunkArenas[s_hunkTag].allocations++;
+	if (s_hunkArenas[s_hunkTag].permanent > s_hunkArenas[s_hunkTag].permanentHighwater)
+	{
+		s_hunkArenas[s_hunkTag].permanentHighwater = s_hunkArenas[s_hunkTag].permanent;
+	}
+
 	Com_Memset(buf, 0, size);
 
 #ifdef HUNK_DEBUG
@@ -2118,6 +2367,13 @@ void *Hunk_AllocateTempMemory(unsigned int size)
 
 	hdr->magic = HUNK_MAGIC;
 	hdr->size  = size;
+	hdr->tag   = s_hunkTag;
+
+	s_hunkArenas[s_hunkTag].temp += size;
+	if (s_hunkArenas[s_hunkTag].temp > s_hunkArenas[s_hunkTag].tempHighwater)
+	{
+		s_hunkArenas[s_hunkTag].tempHighwater = s_hunkArenas[s_hunkTag].temp;
+	}
 
 	// don't bother clearing, because we are going to load a file over it
 	return buf;
@@ -2155,7 +2411,8 @@ void Hunk_FreeTempMemory(void *buf)
 	{
 		if (hdr == ( void * )(s_hunkData + hunk_temp->temp - hdr->size))
 		{
-			hunk_temp->temp -= hdr->size;
+			hunk_temp->temp             -= hdr->size;
+			s_hunkArenas[hdr->tag].temp -= hdr->size;
 		}
 		else
 		{
@@ -2166,7 +2423,8 @@ void Hunk_FreeTempMemory(void *buf)
 	{
 		if (hdr == ( void * )(s_hunkData + s_hunkTotal - hunk_temp->temp))
 		{
-			hunk_temp->temp -= hdr->size;
+			hunk_temp->temp             -= hdr->size;
+			s_hunkArenas[hdr->tag].temp -= hdr->size;
 		}
 		else
 		{
@@ -2183,9 +2441,16 @@ void Hunk_FreeTempMemory(void *buf)
  */
 void Hunk_ClearTempMemory(void)
 {
+	int i;
+
 	if (s_hunkData != NULL)
 	{
 		hunk_temp->temp = hunk_temp->permanent;
+
+		for (i = 0; i < HUNK_TAG_MAX; i++)
+		{
+			s_hunkArenas[i].temp = 0;
+		}
 	}
 }
 
@@ -2469,7 +2734,9 @@ void Com_RunAndTimeServerPacket(netadr_t *evFrom, msg_t *buf)
 		t1 = Sys_Milliseconds();
 	}
 
+	Prof_Begin(PROF_SV_PACKET);
 	SV_PacketEvent(*evFrom, buf);
+	Prof_End();
 
 	if (com_speeds->integer)
 	{
@@ -2965,6 +3232,8 @@ void Com_Init(char *commandLine)
 	com_hunkused      = Cvar_Get("com_hunkused", "0", 0);
 	com_hunkusedvalue = 0;
 
+	Prof_Init();
+
 	if (com_dedicated->integer)
 	{
 		if (!com_viewlog->integer)
@@ -2987,6 +3256,10 @@ void Com_Init(char *commandLine)
 
 	Cmd_AddCommand("quit", Com_Quit_f, "Quits the game.");
 	Cmd_AddCommand("changeVectors", MSG_ReportChangeVectors_f, "Prints out a table from the current statistics for copying to code.");
+#ifdef ETLEGACY_DEBUG
+	Cmd_AddCommand("huffbench", MSG_HuffBench_f, "Fuzzes the table driven huffman coder against the tree walk and compares their throughput.");
+	Cmd_AddCommand("msgbench", MSG_DeltaBench_f, "Benchmarks entity and playerstate delta encoding on a synthetic recording.");
+#endif
 	Cmd_AddCommand("writeconfig", Com_WriteConfig_f, "Write the config file to a specific name.");
 	Cmd_AddCommand("update", Com_Update_f, "Updates the game to latest version.");
 
@@ -3303,6 +3576,8 @@ void Com_Frame(void)
 		timeBeforeFirstEvents = Sys_Milliseconds();
 	}
 
+	Prof_Frame();
+
 	if (!com_dedicated->integer && !com_timedemo->integer && !com_developer->integer)
 	{
 		Cvar_CheckRange(com_maxfps, 20, 333, qtrue);
@@ -3380,9 +3655,15 @@ void Com_Frame(void)
 		{
 			NET_Sleep(timeVal - 1);
 		}
+
+		// run the packets held back during the bot think as soon as it is done
+		SV_GameBotThinkPoll();
 	}
 	while (Com_TimeVal(minMsec));
 
+	// the bots may have been thinking while we slept
+	SV_GameBotThinkFinish();
+
 #ifndef DEDICATED
 	IN_Frame();
 #endif
@@ -3411,7 +3692,9 @@ void Com_Frame(void)
 		timeBeforeServer = Sys_Milliseconds();
 	}
 
+	Prof_Begin(PROF_SV_FRAME);
 	SV_Frame(msec);
+	Prof_End();
 
 	// if "dedicated" has been modified, start up
 	// or shut down the client system.
@@ -46,8 +46,13 @@
 #    include <unzip.h>
 #endif
 
+#include "zlib.h"
+
 #ifdef _WIN32
+#include <io.h>
 #define realpath(N, R) _fullpath((R), (N), _MAX_PATH)
+#else
+#include <unistd.h>
 #endif // _WIN32
 
 /*
@@ -331,6 +336,7 @@ typedef struct
 	int zipFilePos;
 	int zipFileLen;
 	qboolean zipFile;
+	struct fsBlockStream_s *blockStream;
 	char name[MAX_ZPATH];
 } fileHandleData_t;
 
@@ -1054,6 +1060,556 @@ void FS_Rename(const char *from, const char *to)
 	}
 }
 
+/*
+=============================================================================
+BLOCK COMPRESSED FILES
+
+Large streams like demos can be written as independently deflated blocks
+followed by a block index, so they shrink without losing random access.
+FS_Read, FS_Write, FS_Seek and FS_FTell work on the uncompressed offsets,
+code reading the stream doesn't know the difference.
+
+header:  magic, version, block size, reserved
+block:   packed length, raw length, packed data (stored as is when deflate doesn't help)
+index:   file offset and raw offset of every block
+trailer: block count, index offset, raw length, magic
+
+A file without a trailer (recording was interrupted) is recovered by
+walking the block headers.
+=============================================================================
+*/
+
+#define FS_BLOCK_MAGIC          0x425a5445  // "ETZB"
+#define FS_BLOCK_VERSION        1
+#define FS_BLOCK_SIZE           0x10000
+#define FS_BLOCK_HEADER_INTS    4
+#define FS_BLOCK_TRAILER_INTS   4
+
+/**
+ * @struct fsBlock_s
+ * @brief Index entry of a compressed block
+ */
+typedef struct fsBlock_s
+{
+	int fileOfs;        ///< offset of the block header in the file
+	int rawOfs;         ///< offset of the first byte in the uncompressed stream
+} fsBlock_t;
+
+/**
+ * @struct fsBlockStream_s
+ * @brief State of a block compressed file handle
+ */
+typedef struct fsBlockStream_s
+{
+	qboolean write;
+	int level;
+
+	fsBlock_t *blocks;
+	int numBlocks;
+	int maxBlocks;
+
+	int rawLength;      ///< length of the uncompressed stream
+	int pos;            ///< position in the uncompressed stream
+
+	int current;        ///< block in raw when reading, -1 if none
+	int rawLen;         ///< bytes in raw, pending bytes when writing
+	qboolean finished;  ///< index and trailer are written, nothing can follow
+
+	byte raw[FS_BLOCK_SIZE];
+	byte packed[1];     ///< compressBound(FS_BLOCK_SIZE) bytes
+} fsBlockStream_t;
+
+/**
+ * @brief FS_BlockAlloc
+ * @param[in] write
+ * @return
+ */
+static fsBlockStream_t *FS_BlockAlloc(qboolean write)
+{
+	fsBlockStream_t *bs = (fsBlockStream_t *)Com_Allocate(sizeof(fsBlockStream_t) + compressBound(FS_BLOCK_SIZE));
+
+	if (!bs)
+	{
+		Com_Error(ERR_DROP, "FS_BlockAlloc: out of memory");
+	}
+
+	Com_Memset(bs, 0, sizeof(*bs));
+	bs->write   = write;
+	bs->current = -1;
+	return bs;
+}
+
+/**
+ * @brief FS_BlockFree
+ * @param[in] bs
+ */
+static void FS_BlockFree(fsBlockStream_t *bs)
+{
+	if (bs->blocks)
+	{
+		Com_Dealloc(bs->blocks);
+	}
+	Com_Dealloc(bs);
+}
+
+/**
+ * @brief Append an entry to the block index
+ * @param[in,out] bs
+ * @param[in] fileOfs
+ * @param[in] rawOfs
+ * @return qfalse if out of memory
+ *
+ * @note Runs on the demo writer thread too, so it must not call Com_Printf or Com_Error
+ */
+static qboolean FS_BlockAddIndex(fsBlockStream_t *bs, int fileOfs, int rawOfs)
+{
+	if (bs->numBlocks == bs->maxBlocks)
+	{
+		int       maxBlocks = bs->maxBlocks ? bs->maxBlocks * 2 : 256;
+		fsBlock_t *blocks   = (fsBlock_t *)Com_Allocate(maxBlocks * sizeof(fsBlock_t));
+
+		if (!blocks)
+		{
+			return qfalse;
+		}
+
+		if (bs->blocks)
+		{
+			Com_Memcpy(blocks, bs->blocks, bs->numBlocks * sizeof(fsBlock_t));
+			Com_Dealloc(bs->blocks);
+		}
+		bs->blocks    = blocks;
+		bs->maxBlocks = maxBlocks;
+	}
+
+	bs->blocks[bs->numBlocks].fileOfs = fileOfs;
+	bs->blocks[bs->numBlocks].rawOfs  = rawOfs;
+	bs->numBlocks++;
+	return qtrue;
+}
+
+/**
+ * @brief Write little endian ints
+ * @param[in] file
+ * @param[in,out] data
+ * @param[in] count
+ * @return
+ */
+static qboolean FS_BlockWriteInts(FILE *file, int *data, int count)
+{
+	int i;
+
+	for (i = 0; i < count; i++)
+	{
+		data[i] = LittleLong(data[i]);
+	}
+	return fwrite(data, sizeof(int), count, file) == (size_t)count;
+}
+
+/**
+ * @brief Read little endian ints
+ * @param[in] file
+ * @param[out] data
+ * @param[in] count
+ * @return
+ */
+static qboolean FS_BlockReadInts(FILE *file, int *data, int count)
+{
+	int i;
+
+	if (fread(data, sizeof(int), count, file) != (size_t)count)
+	{
+		return qfalse;
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		data[i] = LittleLong(data[i]);
+	}
+	return qtrue;
+}
+
+/**
+ * @brief Compress and write the pending bytes as a block
+ * @param[in,out] bs
+ * @param[in] file
+ * @return qfalse if the block couldn't be written
+ */
+static qboolean FS_BlockFlush(fsBlockStream_t *bs, FILE *file)
+{
+	uLongf packedLen = compressBound(FS_BLOCK_SIZE);
+	byte   *data     = bs->packed;
+	int    header[2];
+
+	if (!bs->rawLen)
+	{
+		return qtrue;
+	}
+
+	if (compress2(bs->packed, &packedLen, bs->raw, bs->rawLen, bs->level) != Z_OK || packedLen >= (uLongf)bs->rawLen)
+	{
+		// store it, the packed length equal to the raw length marks it
+		data      = bs->raw;
+		packedLen = bs->rawLen;
+	}
+
+	if (!FS_BlockAddIndex(bs, (int)ftell(file), bs->pos - bs->rawLen))
+	{
+		return qfalse;
+	}
+
+	header[0] = (int)packedLen;
+	header[1] = bs->rawLen;
+	bs->rawLen = 0;
+
+	return FS_BlockWriteInts(file, header, 2) && fwrite(data, 1, packedLen, file) == packedLen;
+}
+
+/**
+ * @brief FS_BlockWrite
+ * @param[in,out] bs
+ * @param[in] file
+ * @param[in] buffer
+ * @param[in] len
+ * @return
+ */
+static int FS_BlockWrite(fsBlockStream_t *bs, FILE *file, const byte *buffer, int len)
+{
+	int remaining = len;
+	int block;
+
+	if (bs->finished)
+	{
+		return 0;
+	}
+
+	while (remaining)
+	{
+		block = MIN(remaining, FS_BLOCK_SIZE - bs->rawLen);
+		Com_Memcpy(bs->raw + bs->rawLen, buffer, block);
+
+		bs->rawLen += block;
+		bs->pos    += block;
+		buffer     += block;
+		remaining  -= block;
+
+		if (bs->rawLen == FS_BLOCK_SIZE && !FS_BlockFlush(bs, file))
+		{
+			return 0;
+		}
+	}
+
+	bs->rawLength = bs->pos;
+	return len;
+}
+
+/**
+ * @brief Write the last block, the index and the trailer
+ * @param[in,out] bs
+ * @param[in] file
+ * @return qfalse if they couldn't be written
+ */
+static qboolean FS_BlockFinish(fsBlockStream_t *bs, FILE *file)
+{
+	int indexOfs, i, data[FS_BLOCK_TRAILER_INTS];
+
+	if (bs->finished)
+	{
+		return qtrue;
+	}
+	bs->finished = qtrue;
+
+	if (!FS_BlockFlush(bs, file))
+	{
+		return qfalse;
+	}
+
+	indexOfs = (int)ftell(file);
+	for (i = 0; i < bs->numBlocks; i++)
+	{
+		data[0] = bs->blocks[i].fileOfs;
+		data[1] = bs->blocks[i].rawOfs;
+		if (!FS_BlockWriteInts(file, data, 2))
+		{
+			return qfalse;
+		}
+	}
+
+	data[0] = bs->numBlocks;
+	data[1] = indexOfs;
+	data[2] = bs->rawLength;
+	data[3] = FS_BLOCK_MAGIC;
+	return FS_BlockWriteInts(file, data, FS_BLOCK_TRAILER_INTS);
+}
+
+/**
+ * @brief Load the block index from the trailer
+ * @param[in,out] bs
+ * @param[in] file
+ * @param[in] fileLength
+ * @return qfalse if there is no valid index
+ */
+static qboolean FS_BlockLoadIndex(fsBlockStream_t *bs, FILE *file, long fileLength)
+{
+	int data[FS_BLOCK_TRAILER_INTS];
+	int numBlocks, indexOfs, rawLength, i;
+
+	if (fileLength < (FS_BLOCK_HEADER_INTS + FS_BLOCK_TRAILER_INTS) * (long)sizeof(int)
+	    || fseek(file, fileLength - FS_BLOCK_TRAILER_INTS * sizeof(int), SEEK_SET)
+	    || !FS_BlockReadInts(file, data, FS_BLOCK_TRAILER_INTS)
+	    || data[3] != FS_BLOCK_MAGIC)
+	{
+		return qfalse;
+	}
+
+	numBlocks = data[0];
+	indexOfs  = data[1];
+	rawLength = data[2];
+	if (numBlocks < 0 || indexOfs < FS_BLOCK_HEADER_INTS * (int)sizeof(int)
+	    || indexOfs + ((long)numBlocks * 2 + FS_BLOCK_TRAILER_INTS) * (long)sizeof(int) != fileLength
+	    || rawLength < 0 || (!numBlocks && rawLength) || fseek(file, indexOfs, SEEK_SET))
+	{
+		return qfalse;
+	}
+
+	// the blocks have to cover the stream from its start, FS_BlockRead relies on it
+	for (i = 0; i < numBlocks; i++)
+	{
+		if (!FS_BlockReadInts(file, data, 2) || data[0] < FS_BLOCK_HEADER_INTS * (int)sizeof(int) || data[0] >= indexOfs
+		    || data[1] >= rawLength || (i == 0 && data[1] != 0)
+		    || (bs->numBlocks && data[1] <= bs->blocks[bs->numBlocks - 1].rawOfs))
+		{
+			bs->numBlocks = 0;
+			return qfalse;
+		}
+		if (!FS_BlockAddIndex(bs, data[0], data[1]))
+		{
+			Com_Error(ERR_DROP, "FS_BlockAddIndex: out of memory");
+		}
+	}
+
+	bs->rawLength = rawLength;
+	return qtrue;
+}
+
+/**
+ * @brief Rebuild the block index of a file that wasn't finished by walking the blocks
+ * @param[in,out] bs
+ * @param[in] file
+ * @param[in] fileLength
+ */
+static void FS_BlockScanIndex(fsBlockStream_t *bs, FILE *file, long fileLength)
+{
+	long fileOfs = FS_BLOCK_HEADER_INTS * sizeof(int);
+	int  rawOfs  = 0;
+	int  header[2];
+
+	bs->numBlocks = 0;
+
+	while (fileOfs + 2 * (long)sizeof(int) <= fileLength
+	       && !fseek(file, fileOfs, SEEK_SET) && FS_BlockReadInts(file, header, 2))
+	{
+		if (header[1] <= 0 || header[1] > FS_BLOCK_SIZE || header[0] <= 0 || header[0] > (int)compressBound(FS_BLOCK_SIZE)
+		    || fileOfs + 2 * (long)sizeof(int) + header[0] > fileLength)
+		{
+			break;
+		}
+
+		if (!FS_BlockAddIndex(bs, (int)fileOfs, rawOfs))
+		{
+			Com_Error(ERR_DROP, "FS_BlockAddIndex: out of memory");
+		}
+		rawOfs  += header[1];
+		fileOfs += 2 * sizeof(int) + header[0];
+	}
+
+	bs->rawLength = rawOfs;
+}
+
+/**
+ * @brief Decompress a block into the raw buffer
+ * @param[in,out] bs
+ * @param[in] file
+ * @param[in] block
+ * @return
+ */
+static qboolean FS_BlockLoad(fsBlockStream_t *bs, FILE *file, int block)
+{
+	int    header[2], expected;
+	uLongf rawLen;
+
+	bs->current = -1;
+
+	// the block has to end where the next one starts, the index may not match the blocks
+	expected = (block + 1 < bs->numBlocks ? bs->blocks[block + 1].rawOfs : bs->rawLength) - bs->blocks[block].rawOfs;
+
+	if (fseek(file, bs->blocks[block].fileOfs, SEEK_SET) || !FS_BlockReadInts(file, header, 2)
+	    || header[1] <= 0 || header[1] > FS_BLOCK_SIZE || header[1] != expected
+	    || header[0] <= 0 || header[0] > (int)compressBound(FS_BLOCK_SIZE))
+	{
+		Com_Printf("FS_BlockLoad: bad block %i\n", block);
+		return qfalse;
+	}
+
+	if (header[0] == header[1])
+	{
+		if (fread(bs->raw, 1, header[1], file) != (size_t)header[1])
+		{
+			return qfalse;
+		}
+	}
+	else
+	{
+		rawLen = header[1];
+		if (fread(bs->packed, 1, header[0], file) != (size_t)header[0]
+		    || uncompress(bs->raw, &rawLen, bs->packed, header[0]) != Z_OK || rawLen != (uLongf)header[1])
+		{
+			Com_Printf("FS_BlockLoad: corrupt block %i\n", block);
+			return qfalse;
+		}
+	}
+
+	bs->current = block;
+	bs->rawLen  = header[1];
+	return qtrue;
+}
+
+/**
+ * @brief Find the block holding a raw offset
+ * @param[in] bs
+ * @param[in] pos
+ * @return
+ */
+static int FS_BlockFind(fsBlockStream_t *bs, int pos)
+{
+	int low = 0, high = bs->numBlocks - 1, mid;
+
+	// reads are sequential most of the time
+	if (bs->current >= 0 && bs->current + 1 < bs->numBlocks && bs->blocks[bs->current + 1].rawOfs == pos)
+	{
+		return bs->current + 1;
+	}
+
+	while (low < high)
+	{
+		mid = (low + high + 1) / 2;
+		if (bs->blocks[mid].rawOfs <= pos)
+		{
+			low = mid;
+		}
+		else
+		{
+			high = mid - 1;
+		}
+	}
+	return low;
+}
+
+/**
+ * @brief FS_BlockRead
+ * @param[in,out] bs
+ * @param[in] file
+ * @param[out] buffer
+ * @param[in] len
+ * @return
+ */
+static int FS_BlockRead(fsBlockStream_t *bs, FILE *file, byte *buffer, int len)
+{
+	int remaining = len;
+	int ofs, block;
+
+	while (remaining && bs->pos < bs->rawLength)
+	{
+		if (bs->current < 0 || bs->pos < bs->blocks[bs->current].rawOfs
+		    || bs->pos >= bs->blocks[bs->current].rawOfs + bs->rawLen)
+		{
+			if (!FS_BlockLoad(bs, file, FS_BlockFind(bs, bs->pos)))
+			{
+				break;
+			}
+		}
+
+		ofs = bs->pos - bs->blocks[bs->current].rawOfs;
+		if (ofs < 0 || ofs >= bs->rawLen)
+		{
+			break;
+		}
+		block = MIN(remaining, bs->rawLen - ofs);
+
+		Com_Memcpy(buffer, bs->raw + ofs, block);
+		bs->pos   += block;
+		buffer    += block;
+		remaining -= block;
+	}
+
+	return len - remaining;
+}
+
+/**
+ * @brief Start writing a freshly opened file as block compressed stream
+ * @param[in] f
+ * @param[in] level deflate level 1-9
+ *
+ * @note Must be called before anything is written to the file.
+ */
+void FS_SetBlockCompression(fileHandle_t f, int level)
+{
+	FILE *file = FS_FileForHandle(f);
+	int  header[FS_BLOCK_HEADER_INTS];
+
+	if (fsh[f].blockStream || ftell(file) != 0)
+	{
+		Com_Error(ERR_DROP, "FS_SetBlockCompression: %s is already written", fsh[f].name);
+	}
+
+	fsh[f].blockStream        = FS_BlockAlloc(qtrue);
+	fsh[f].blockStream->level = Com_Clamp(Z_BEST_SPEED, Z_BEST_COMPRESSION, level);
+
+	header[0] = FS_BLOCK_MAGIC;
+	header[1] = FS_BLOCK_VERSION;
+	header[2] = FS_BLOCK_SIZE;
+	header[3] = 0;
+	(void) FS_BlockWriteInts(file, header, FS_BLOCK_HEADER_INTS);
+}
+
+/**
+ * @brief Check if a file opened for reading is block compressed and read it transparently if so
+ * @param[in] f
+ * @return Length of the uncompressed stream, -1 if the file isn't compressed
+ */
+long FS_DetectBlockCompression(fileHandle_t f)
+{
+	fsBlockStream_t *bs;
+	FILE            *file;
+	long            fileLength;
+	int             header[FS_BLOCK_HEADER_INTS];
+
+	if (!f || fsh[f].zipFile || fsh[f].blockStream)
+	{
+		return fsh[f].blockStream ? fsh[f].blockStream->rawLength : -1;
+	}
+
+	file = FS_FileForHandle(f);
+	if (fseek(file, 0, SEEK_SET) || !FS_BlockReadInts(file, header, FS_BLOCK_HEADER_INTS)
+	    || header[0] != FS_BLOCK_MAGIC || header[1] != FS_BLOCK_VERSION || header[2] != FS_BLOCK_SIZE)
+	{
+		fseek(file, 0, SEEK_SET);
+		return -1;
+	}
+
+	fileLength = FS_fplength(file);
+	bs         = FS_BlockAlloc(qfalse);
+
+	if (!FS_BlockLoadIndex(bs, file, fileLength))
+	{
+		Com_Printf("FS_DetectBlockCompression: %s wasn't finished, recovering the blocks\n", fsh[f].name);
+		FS_BlockScanIndex(bs, file, fileLength);
+	}
+
+	fsh[f].blockStream = bs;
+	return bs->rawLength;
+}
+
 /**
  * @brief If the FILE pointer is an open pak file, leave it open.
  * @param[in] f
@@ -1080,6 +1636,15 @@ void FS_FCloseFile(fileHandle_t f)
 		return;
 	}
 
+	if (fsh[f].blockStream)
+	{
+		if (fsh[f].blockStream->write && !FS_BlockFinish(fsh[f].blockStream, fsh[f].handleFiles.file.o))
+		{
+			Com_Printf("FS_FCloseFile: couldn't finish %s\n", fsh[f].name);
+		}
+		FS_BlockFree(fsh[f].blockStream);
+	}
+
 	// we didn't find it as a pak, so close it as a unique file
 	if (fsh[f].handleFiles.file.o)
 	{
@@ -2038,7 +2603,11 @@ int FS_Read(void *buffer, int len, fileHandle_t f)
 	buf           = (byte *)buffer;
 	fs_readCount += len;
 
-	if (fsh[f].zipFile == qfalse)
+	if (fsh[f].blockStream)
+	{
+		return FS_BlockRead(fsh[f].blockStream, fsh[f].handleFiles.file.o, buf, len);
+	}
+	else if (fsh[f].zipFile == qfalse)
 	{
 		int read, block;
 		int remaining = len;
@@ -2106,6 +2675,16 @@ int FS_Write(const void *buffer, int len, fileHandle_t h)
 	f   = FS_FileForHandle(h);
 	buf = (byte *)buffer;
 
+	if (fsh[h].blockStream)
+	{
+		if (FS_BlockWrite(fsh[h].blockStream, f, buf, len) != len)
+		{
+			Com_Printf("FS_Write: couldn't write a block of %s\n", fsh[h].name);
+			return 0;
+		}
+		return len;
+	}
+
 	remaining = len;
 	tries     = 0;
 	while (remaining)
@@ -2175,7 +2754,34 @@ int FS_Seek(fileHandle_t f, long offset, int origin)
 		return -1;
 	}
 
-	if (fsh[f].zipFile == qtrue)
+	if (fsh[f].blockStream)
+	{
+		fsBlockStream_t *bs = fsh[f].blockStream;
+
+		switch (origin)
+		{
+		case FS_SEEK_CUR:
+			offset += bs->pos;
+			break;
+		case FS_SEEK_END:
+			offset += bs->rawLength;
+			break;
+		case FS_SEEK_SET:
+			break;
+		default:
+			Com_Error(ERR_FATAL, "FS_Seek: Bad origin");
+		}
+
+		// blocks that are written can't be changed anymore
+		if (bs->write || offset < 0 || offset > bs->rawLength)
+		{
+			return -1;
+		}
+
+		bs->pos = (int)offset;
+		return 0;
+	}
+	else if (fsh[f].zipFile == qtrue)
 	{
 		// FIXME: this is really, really
 		// crappy (but better than what was here before)
@@ -3486,6 +4092,114 @@ void FS_Path_f(void)
 	}
 }
 
+/**
+ * @brief Convert a file between the plain and the block compressed format
+ * @param[in] fileName
+ * @param[in] level deflate level, 0 to decompress
+ */
+static void FS_ConvertFile(const char *fileName, int level)
+{
+	char         tmpName[MAX_QPATH];
+	byte         buffer[FS_BLOCK_SIZE];
+	fileHandle_t in, out;
+	long         length, rawLength, packedLength;
+	int          r;
+
+	length = FS_FOpenFileRead(fileName, &in, qtrue);
+	if (!in)
+	{
+		Com_Printf("Couldn't open %s\n", fileName);
+		return;
+	}
+
+	if (fsh[in].zipFile)
+	{
+		Com_Printf("%s is inside a pk3, extract it first\n", fileName);
+		FS_FCloseFile(in);
+		return;
+	}
+
+	rawLength = FS_DetectBlockCompression(in);
+	if ((rawLength >= 0) == (level > 0))
+	{
+		Com_Printf("%s is already %s\n", fileName, level > 0 ? "compressed" : "uncompressed");
+		FS_FCloseFile(in);
+		return;
+	}
+
+	Com_sprintf(tmpName, sizeof(tmpName), "%s.tmp", fileName);
+	out = FS_FOpenFileWrite(tmpName);
+	if (!out)
+	{
+		Com_Printf("Couldn't open %s for writing\n", tmpName);
+		FS_FCloseFile(in);
+		return;
+	}
+
+	if (level > 0)
+	{
+		FS_SetBlockCompression(out, level);
+		rawLength = length;
+	}
+
+	while ((r = FS_Read(buffer, sizeof(buffer), in)) > 0)
+	{
+		if (FS_Write(buffer, r, out) != r)
+		{
+			break;
+		}
+	}
+
+	FS_FCloseFile(out);
+	FS_FCloseFile(in);
+
+	if (r > 0)
+	{
+		Com_Printf("Couldn't write %s\n", tmpName);
+		FS_HomeRemove(tmpName);
+		return;
+	}
+
+	FS_Rename(tmpName, fileName);
+
+	// the block index and trailer are written by the close, so measure the file itself
+	packedLength = FS_SV_FOpenFileRead(va("%s/%s", fs_gamedir, fileName), &out);
+	if (out)
+	{
+		FS_FCloseFile(out);
+	}
+
+	Com_Printf("%s: %ld bytes of data, %ld bytes on disk\n", fileName, rawLength, packedLength);
+}
+
+/**
+ * @brief Compress a file, like a demo, into seekable blocks
+ */
+void FS_PackFile_f(void)
+{
+	if (Cmd_Argc() < 2)
+	{
+		Com_Printf("Usage: packFile <file> [level 1-9]\n");
+		return;
+	}
+
+	FS_ConvertFile(Cmd_Argv(1), Cmd_Argc() > 2 ? Com_Clamp(Z_BEST_SPEED, Z_BEST_COMPRESSION, atoi(Cmd_Argv(2))) : Z_BEST_COMPRESSION);
+}
+
+/**
+ * @brief Turn a block compressed file back into a plain one
+ */
+void FS_UnpackFile_f(void)
+{
+	if (Cmd_Argc() != 2)
+	{
+		Com_Printf("Usage: unpackFile <file>\n");
+		return;
+	}
+
+	FS_ConvertFile(Cmd_Argv(1), 0);
+}
+
 /**
  * @brief Simulates the 'touch' unix command
  */
@@ -4067,6 +4781,8 @@ void FS_Shutdown(qboolean closemfp)
 	Cmd_RemoveCommand("fdir");
 	Cmd_RemoveCommand("touchFile");
 	Cmd_RemoveCommand("which");
+	Cmd_RemoveCommand("packFile");
+	Cmd_RemoveCommand("unpackFile");
 
 #ifdef FS_MISSING
 	if (closemfp)
@@ -4218,6 +4934,8 @@ static void FS_Startup(const char *gameName)
 	Cmd_AddCommand("fdir", FS_NewDir_f, "Prints a filtered directory.");
 	Cmd_AddCommand("touchFile", FS_TouchFile_f, "Simulates the 'touch' unix command.");
 	Cmd_AddCommand("which", FS_Which_f, "Searches for a given file.");
+	Cmd_AddCommand("packFile", FS_PackFile_f, "Compresses a file like a demo into seekable blocks.");
+	Cmd_AddCommand("unpackFile", FS_UnpackFile_f, "Turns a compressed file back into a plain one.");
 
 	// reorder the pure pk3 files according to server order
 	FS_ReorderPurePaks();
@@ -4923,7 +5641,11 @@ int FS_FTell(fileHandle_t f)
 {
 	int pos;
 
-	if (fsh[f].zipFile == qtrue)
+	if (fsh[f].blockStream)
+	{
+		pos = fsh[f].blockStream->pos;
+	}
+	else if (fsh[f].zipFile == qtrue)
 	{
 		pos = unztell(fsh[f].handleFiles.file.z);
 
@@ -4954,6 +5676,76 @@ void FS_Flush(fileHandle_t f)
 	fflush(fsh[f].handleFiles.file.o);
 }
 
+/**
+ * @brief Flush a file opened for writing and ask the OS to commit it to disk
+ * @param[in] f
+ *
+ * @note This blocks until the device acknowledges the write, keep it out of the frame loop.
+ * A block compressed file is finished first: its last block, index and trailer are written
+ * so they reach the disk too, nothing can be written to it afterwards.
+ */
+void FS_Sync(fileHandle_t f)
+{
+	// drops on a bad handle, FS_ThreadSync can't
+	(void) FS_FileForHandle(f);
+
+	if (!FS_ThreadSync(f))
+	{
+		Com_Printf("FS_Sync: couldn't write %s\n", fsh[f].name);
+	}
+}
+
+/**
+ * @brief FS_Write for a thread other than the main one
+ * @param[in] buffer
+ * @param[in] len
+ * @param[in] f - a handle opened for writing on the main thread, not closed before the thread is done
+ * @return qfalse on a write error
+ *
+ * @note Never calls Com_Printf or Com_Error, they belong to the main thread.
+ * The caller reports the failure from there.
+ */
+qboolean FS_ThreadWrite(const void *buffer, int len, fileHandle_t f)
+{
+	FILE *file = fsh[f].handleFiles.file.o;
+
+	if (fsh[f].blockStream)
+	{
+		return FS_BlockWrite(fsh[f].blockStream, file, (const byte *)buffer, len) == len;
+	}
+
+	return fwrite(buffer, 1, len, file) == (size_t)len;
+}
+
+/**
+ * @brief FS_Sync for a thread other than the main one
+ * @param[in] f - a handle opened for writing on the main thread, not closed before the thread is done
+ * @return qfalse on a write error
+ *
+ * @note Never calls Com_Printf or Com_Error, see FS_ThreadWrite
+ */
+qboolean FS_ThreadSync(fileHandle_t f)
+{
+	FILE     *file = fsh[f].handleFiles.file.o;
+	qboolean ok    = qtrue;
+
+	if (fsh[f].blockStream && fsh[f].blockStream->write)
+	{
+		ok = FS_BlockFinish(fsh[f].blockStream, file);
+	}
+
+	if (fflush(file))
+	{
+		ok = qfalse;
+	}
+#ifdef _WIN32
+	(void) _commit(_fileno(file));
+#else
+	(void) fsync(fileno(file));
+#endif
+	return ok;
+}
+
 /**
  * @brief FS_FilenameCompletion
  * @param[in] dir
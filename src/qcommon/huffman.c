@@ -38,7 +38,8 @@
 #include "q_shared.h"
 #include "qcommon.h"
 
-static int bloc = 0;
+/// bit position of the coder, per thread since etldemo parses demos in parallel
+static Q_THREAD_LOCAL int bloc = 0;
 
 /**
  * @brief Clears data along the way so we dont have to memset() it ahead of time
@@ -50,16 +51,14 @@ void Huff_putBit(int bit, byte *fout, int *offset)
 {
 	int x, y;
 
-	bloc = *offset;
-	x    = bloc >> 3;
-	y    = bloc & 7;
+	x = *offset >> 3;
+	y = *offset & 7;
 	if (!y)
 	{
 		fout[x] = 0;
 	}
 	fout[x] |= bit << y;
-	bloc++;
-	*offset = bloc;
+	(*offset)++;
 }
 
 /**
@@ -72,13 +71,82 @@ int Huff_getBit(byte *fin, int *offset)
 {
 	int t;
 
-	bloc = *offset;
-	t    = fin[bloc >> 3] >> (bloc & 7) & 0x1;
-	bloc++;
-	*offset = bloc;
+	t = fin[*offset >> 3] >> (*offset & 7) & 0x1;
+	(*offset)++;
 	return t;
 }
 
+/**
+ * @brief Writes the low nbits of value, least significant bit first, a byte at a time
+ *
+ * @details Produces the same stream as nbits calls of Huff_putBit and
+ * clears data along the way the same way.
+ *
+ * @param[in] value
+ * @param[in] nbits 0 to 32
+ * @param[out] fout
+ * @param[in,out] offset
+ */
+void Huff_putBits(unsigned int value, int nbits, byte *fout, int *offset)
+{
+	int pos = *offset, x, y, n;
+
+	while (nbits > 0)
+	{
+		x = pos >> 3;
+		y = pos & 7;
+		n = 8 - y;
+		if (n > nbits)
+		{
+			n = nbits;
+		}
+		if (!y)
+		{
+			fout[x] = 0;
+		}
+		fout[x] |= (value & ((1u << n) - 1)) << y;
+		value   >>= n;
+		nbits    -= n;
+		pos      += n;
+	}
+
+	*offset = pos;
+}
+
+/**
+ * @brief Reads nbits, least significant bit first, a byte at a time
+ *
+ * @details Same result as nbits calls of Huff_getBit. Only touches the
+ * bytes that hold the requested bits.
+ *
+ * @param[in] fin
+ * @param[in] nbits 0 to 32
+ * @param[in,out] offset
+ * @return
+ */
+unsigned int Huff_getBits(byte *fin, int nbits, int *offset)
+{
+	int          pos = *offset, shift = 0, y, n;
+	unsigned int value = 0;
+
+	while (nbits > 0)
+	{
+		y = pos & 7;
+		n = 8 - y;
+		if (n > nbits)
+		{
+			n = nbits;
+		}
+		value |= (unsigned int)((fin[pos >> 3] >> y) & ((1u << n) - 1)) << shift;
+		shift += n;
+		nbits -= n;
+		pos   += n;
+	}
+
+	*offset = pos;
+	return value;
+}
+
 /**
  * @brief Clears data along the way so we dont have to memset() it ahead of time
  *
@@ -657,3 +725,146 @@ void Huff_Init(huffman_t *huff)
 	huff->compressor.tree->parent = huff->compressor.tree->left = huff->compressor.tree->right = NULL;
 	huff->compressor.loc[NYT]     = huff->compressor.tree;
 }
+
+/**
+ * @brief Flattens a huffman tree into code and decode lookup tables
+ *
+ * @details Only valid as long as the tree isn't updated anymore, which is
+ * the case for the message tree built in MSG_initHuffman.
+ *
+ * @param[out] table
+ * @param[in] huff
+ */
+void Huff_BuildTable(huffTable_t *table, huff_t *huff)
+{
+	int          ch, i, length;
+	unsigned int code;
+	node_t       *node;
+
+	Com_Memset(table, 0, sizeof(*table));
+	table->tree = huff->tree;
+	table->huff = huff;
+
+	for (ch = 0; ch <= HMAX; ch++)
+	{
+		if (!huff->loc[ch])
+		{
+			continue;
+		}
+
+		// walk up to the root, the bit closest to the root is transmitted first
+		code   = 0;
+		length = 0;
+		for (node = huff->loc[ch]; node->parent; node = node->parent)
+		{
+			if (length == 32)
+			{
+				length = 0;
+				break;
+			}
+			code = (code << 1) | (node->parent->right == node ? 1 : 0);
+			length++;
+		}
+
+		if (!length)
+		{
+			continue;
+		}
+
+		table->code[ch]   = code;
+		table->length[ch] = (byte)length;
+
+		// every index that starts with this code decodes to it
+		if (length <= HUFF_LOOKUP_BITS)
+		{
+			for (i = code; i < (1 << HUFF_LOOKUP_BITS); i += (1 << length))
+			{
+				table->lookup[i] = (unsigned short)((ch << 4) | length);
+			}
+		}
+	}
+}
+
+/**
+ * @brief Get a symbol, resolving up to HUFF_LOOKUP_BITS bits per table lookup
+ *
+ * @details Bit-exact with Huff_offsetReceive on the tree the table was built from,
+ * including the behaviour when the code runs past maxoffset.
+ *
+ * @param[in] table
+ * @param[out] ch
+ * @param[in] fin
+ * @param[in,out] offset
+ * @param[in] maxoffset
+ */
+void Huff_tableReceive(const huffTable_t *table, int *ch, byte *fin, int *offset, int maxoffset)
+{
+	int          pos = *offset, lastByte, x, entry, length;
+	unsigned int peek;
+
+	if (pos >= maxoffset)
+	{
+		*ch     = 0;
+		*offset = maxoffset + 1;
+		return;
+	}
+
+	// gather the next bits without reading past the last byte of the message
+	x        = pos >> 3;
+	lastByte = (maxoffset - 1) >> 3;
+	peek     = fin[x];
+	if (x + 1 <= lastByte)
+	{
+		peek |= fin[x + 1] << 8;
+		if (x + 2 <= lastByte)
+		{
+			peek |= fin[x + 2] << 16;
+		}
+	}
+	peek >>= (pos & 7);
+
+	entry = table->lookup[peek & ((1 << HUFF_LOOKUP_BITS) - 1)];
+	if (!entry)
+	{
+		// rare long code
+		Huff_offsetReceive(table->tree, ch, fin, offset, maxoffset);
+		return;
+	}
+
+	length = entry & 15;
+	if (pos + length > maxoffset)
+	{
+		*ch     = 0;
+		*offset = maxoffset + 1;
+		return;
+	}
+
+	*ch     = entry >> 4;
+	*offset = pos + length;
+}
+
+/**
+ * @brief Send the precomputed prefix code of a symbol
+ *
+ * @details Bit-exact with Huff_offsetTransmit on the tree the table was built from.
+ * Clears data along the way like Huff_putBit.
+ *
+ * @param[in] table
+ * @param[in] ch
+ * @param[out] fout
+ * @param[in,out] offset
+ * @param[in] maxoffset
+ */
+void Huff_tableTransmit(const huffTable_t *table, int ch, byte *fout, int *offset, int maxoffset)
+{
+	int length = table->length[ch];
+
+	if (!length || *offset + length > maxoffset)
+	{
+		// long code or overflow, let the tree walk produce the exact partial output
+		Huff_offsetTransmit(table->huff, ch, fout, offset, maxoffset);
+		return;
+	}
+
+	Huff_putBits(table->code[ch], length, fout, offset);
+}
@@ -42,8 +42,9 @@
 // redefined when included, producing a lot of recursive declarations errors...)
 #include "../game/g_public.h"
 
-static huffman_t msgHuff;
-static qboolean  msgInit = qfalse;
+static huffman_t   msgHuff;
+static huffTable_t msgHuffTable;    ///< flattened msgHuff used by MSG_WriteBits/MSG_ReadBits
+static qboolean    msgInit = qfalse;
 
 int pcount[256];
 int wastedbits = 0;
@@ -265,18 +266,15 @@ void MSG_WriteBits(msg_t *msg, int value, int bits)
 				return;
 			}
 
-			for (i = 0; i < nbits; i++)
-			{
-				Huff_putBit((value & 1), msg->data, &msg->bit);
-				value = (value >> 1);
-			}
-			bits = bits - nbits;
+			Huff_putBits(value, nbits, msg->data, &msg->bit);
+			value = (int)((unsigned int)value >> nbits);
+			bits  = bits - nbits;
 		}
 		if (bits)
 		{
 			for (i = 0; i < bits; i += 8)
 			{
-				Huff_offsetTransmit(&msgHuff.compressor, (value & 0xff), msg->data, &msg->bit, msg->maxsize << 3);
+				Huff_tableTransmit(&msgHuffTable, (value & 0xff), msg->data, &msg->bit, msg->maxsize << 3);
 				value = (value >> 8);
 
 				if (msg->bit >= msg->maxsize << 3)
@@ -290,6 +288,47 @@ void MSG_WriteBits(msg_t *msg, int value, int bits)
 	}
 }
 
+/**
+ * @brief Append bits written to another bitstream message
+ *
+ * @details The huffman codes don't depend on their position in the
+ * message, so an encoded part of a message can be reused as is.
+ *
+ * @param[in,out] msg
+ * @param[in] data data of the source message
+ * @param[in] offset first bit to copy
+ * @param[in] bits
+ */
+void MSG_CopyBits(msg_t *msg, byte *data, int offset, int bits)
+{
+	int n;
+
+	if (msg->overflowed)
+	{
+		return;
+	}
+
+	if (msg->oob)
+	{
+		Com_Error(ERR_DROP, "MSG_CopyBits: out of band message");
+	}
+
+	if (msg->bit + bits > msg->maxsize << 3)
+	{
+		msg->overflowed = qtrue;
+		return;
+	}
+
+	while (bits > 0)
+	{
+		n = MIN(bits, 32);
+		Huff_putBits(Huff_getBits(data, n, &offset), n, msg->data, &msg->bit);
+		bits -= n;
+	}
+
+	msg->cursize = (msg->bit >> 3) + 1;
+}
+
 /**
  * @brief MSG_ReadBits
  * @param[in,out] msg
@@ -368,11 +407,8 @@ int MSG_ReadBits(msg_t *msg, int bits)
 				return 0;
 			}
 
-			for (i = 0; i < nbits; i++)
-			{
-				value |= (Huff_getBit(msg->data, &msg->bit) << i);
-			}
-			bits = bits - nbits;
+			value = (int)Huff_getBits(msg->data, nbits, &msg->bit);
+			bits  = bits - nbits;
 		}
 		if (bits)
 		{
@@ -380,7 +416,7 @@ int MSG_ReadBits(msg_t *msg, int bits)
 
 			for (i = 0; i < bits; i += 8)
 			{
-				Huff_offsetReceive(msgHuff.decompressor.tree, &get, msg->data, &msg->bit, msg->cursize << 3);
+				Huff_tableReceive(&msgHuffTable, &get, msg->data, &msg->bit, msg->cursize << 3);
 				value = (unsigned int)value | ((unsigned int)get << (i + nbits));
 
 				if (msg->bit > msg->cursize << 3)
@@ -443,6 +479,10 @@ void MSG_WriteByte(msg_t *msg, int c)
 
 /**
  * @brief MSG_WriteData
+ *
+ * @details Out of band data is byte aligned and copied at once, same result as a MSG_WriteByte per byte.
+ * In a bitstream every byte is a huffman code of its own.
+ *
  * @param[in,out] buf
  * @param[in] data
  * @param[in] length
@@ -451,6 +491,35 @@ void MSG_WriteData(msg_t *buf, const void *data, int length)
 {
 	int i;
 
+	if (buf->oob)
+	{
+		if (length <= 0)
+		{
+			return;
+		}
+
+		oldsize         += length << 3;
+		buf->uncompsize += length << 3;
+
+		if (buf->overflowed)
+		{
+			return;
+		}
+
+		i = MIN(length, buf->maxsize - buf->cursize);
+		if (i > 0)
+		{
+			Com_Memcpy(buf->data + buf->cursize, data, i);
+			buf->cursize += i;
+			buf->bit     += i << 3;
+		}
+		if (i < length)
+		{
+			buf->overflowed = qtrue;
+		}
+		return;
+	}
+
 	for (i = 0; i < length; i++)
 	{
 		MSG_WriteByte(buf, ((const byte *)data)[i]);
@@ -849,6 +918,10 @@ float MSG_ReadAngle16(msg_t *msg)
 
 /**
  * @brief MSG_ReadData
+ *
+ * @details Out of band data is copied at once like MSG_WriteData, the bytes past the end read as 0xff
+ * as they do from MSG_ReadByte.
+ *
  * @param[in] msg
  * @param[in] data
  * @param[in] size
@@ -857,6 +930,36 @@ void MSG_ReadData(msg_t *msg, void *data, int size)
 {
 	int i;
 
+	if (msg->oob)
+	{
+		if (size <= 0)
+		{
+			return;
+		}
+
+		i = MIN(size, msg->cursize - msg->readcount);
+		if (i > 0)
+		{
+			Com_Memcpy(data, msg->data + msg->readcount, i);
+			msg->readcount += i;
+			msg->bit       += i << 3;
+		}
+		else
+		{
+			i = 0;
+		}
+
+		if (i < size)
+		{
+			Com_Memset((byte *)data + i, 0xff, size - i);
+			if (msg->readcount <= msg->cursize)
+			{
+				msg->readcount = msg->cursize + 1;
+			}
+		}
+		return;
+	}
+
 	for (i = 0 ; i < size ; i++)
 	{
 		((byte *)data)[i] = MSG_ReadByte(msg);
@@ -2831,4 +2934,316 @@ void MSG_initHuffman(void)
 			Huff_addRef(&msgHuff.decompressor, (byte)i);  // Do update
 		}
 	}
+
+	// the message tree is fixed from here on
+	Huff_BuildTable(&msgHuffTable, &msgHuff.compressor);
+}
+
+#ifdef ETLEGACY_DEBUG
+/**
+ * @brief Fills buf with bytes shaped roughly like game traffic: mostly small values, some noise
+ * @param[out] buf
+ * @param[in] len
+ */
+static void MSG_HuffBenchFill(byte *buf, int len)
+{
+	int i;
+
+	for (i = 0; i < len; i++)
+	{
+		switch (rand() & 3)
+		{
+		case 0:
+			buf[i] = 0;
+			break;
+		case 1:
+			buf[i] = rand() & 15;
+			break;
+		default:
+			buf[i] = rand() & 255;
+			break;
+		}
+	}
+}
+
+/**
+ * @brief Round-trip fuzz of the table driven huffman coder against the tree walk, then a throughput comparison
+ *
+ * @details Usage: huffbench [iterations]
+ */
+void MSG_HuffBench_f(void)
+{
+	static byte src[MAX_MSGLEN], treeBuf[MAX_MSGLEN * 2], tableBuf[MAX_MSGLEN * 2];
+	int         iterations = 2000, i, j, len, maxoffset, treeBit, tableBit, treeCh, tableCh, failures = 0;
+	int         start, treeMsec, tableMsec, passes;
+	double      mbytes;
+
+	if (!msgInit)
+	{
+		MSG_initHuffman();
+	}
+
+	if (Cmd_Argc() > 1)
+	{
+		iterations = atoi(Cmd_Argv(1));
+		if (iterations <= 0)
+		{
+			iterations = 2000;
+		}
+	}
+
+	srand(0x5eed);
+
+	// fuzz: encoders must produce identical streams, decoders identical symbols and offsets,
+	// also when the stream is cut short at a random bit
+	for (i = 0; i < iterations && failures < 10; i++)
+	{
+		len = 1 + (rand() % 1400);
+		MSG_HuffBenchFill(src, len);
+		maxoffset = (i & 7) ? (int)sizeof(treeBuf) << 3 : (1 + rand() % (len * 8));
+
+		treeBit = tableBit = 0;
+		for (j = 0; j < len; j++)
+		{
+			Huff_offsetTransmit(&msgHuff.compressor, src[j], treeBuf, &treeBit, maxoffset);
+			Huff_tableTransmit(&msgHuffTable, src[j], tableBuf, &tableBit, maxoffset);
+			if (treeBit != tableBit)
+			{
+				break;
+			}
+		}
+
+		if (treeBit != tableBit || memcmp(treeBuf, tableBuf, (MIN(treeBit, maxoffset) + 7) >> 3))
+		{
+			Com_Printf("huffbench: encode mismatch at iteration %i, symbol %i (bits %i vs %i)\n", i, j, treeBit, tableBit);
+			failures++;
+			continue;
+		}
+
+		maxoffset = (i & 3) ? treeBit : (rand() % (treeBit + 1));
+		treeBit   = tableBit = 0;
+		for (j = 0; j < len && treeBit <= maxoffset; j++)
+		{
+			Huff_offsetReceive(msgHuff.decompressor.tree, &treeCh, treeBuf, &treeBit, maxoffset);
+			Huff_tableReceive(&msgHuffTable, &tableCh, treeBuf, &tableBit, maxoffset);
+			if (treeCh != tableCh || treeBit != tableBit)
+			{
+				break;
+			}
+		}
+
+		if (treeCh != tableCh || treeBit != tableBit)
+		{
+			Com_Printf("huffbench: decode mismatch at iteration %i, symbol %i (%i@%i vs %i@%i)\n", i, j, treeCh, treeBit, tableCh, tableBit);
+			failures++;
+		}
+	}
+
+	Com_Printf("huffbench: %i fuzz iterations, %i mismatches\n", i, failures);
+
+	// throughput on a full sized message
+	len = MAX_MSGLEN / 2;
+	MSG_HuffBenchFill(src, len);
+	passes = 200;
+	mbytes = (double)len * passes / (1024.0 * 1024.0);
+
+	start = Sys_Milliseconds();
+	for (i = 0; i < passes; i++)
+	{
+		for (j = 0, treeBit = 0; j < len; j++)
+		{
+			Huff_offsetTransmit(&msgHuff.compressor, src[j], treeBuf, &treeBit, sizeof(treeBuf) << 3);
+		}
+	}
+	treeMsec = Sys_Milliseconds() - start;
+
+	start = Sys_Milliseconds();
+	for (i = 0; i < passes; i++)
+	{
+		for (j = 0, tableBit = 0; j < len; j++)
+		{
+			Huff_tableTransmit(&msgHuffTable, src[j], tableBuf, &tableBit, sizeof(tableBuf) << 3);
+		}
+	}
+	tableMsec = Sys_Milliseconds() - start;
+
+	Com_Printf("huffbench: encode %.1f MB  tree %i msec (%.1f MB/s)  table %i msec (%.1f MB/s)\n", mbytes,
+	           treeMsec, mbytes * 1000.0 / MAX(treeMsec, 1), tableMsec, mbytes * 1000.0 / MAX(tableMsec, 1));
+
+	maxoffset = treeBit;
+
+	start = Sys_Milliseconds();
+	for (i = 0; i < passes; i++)
+	{
+		for (j = 0, treeBit = 0; j < len; j++)
+		{
+			Huff_offsetReceive(msgHuff.decompressor.tree, &treeCh, treeBuf, &treeBit, maxoffset);
+		}
+	}
+	treeMsec = Sys_Milliseconds() - start;
+
+	start = Sys_Milliseconds();
+	for (i = 0; i < passes; i++)
+	{
+		for (j = 0, tableBit = 0; j < len; j++)
+		{
+			Huff_tableReceive(&msgHuffTable, &tableCh, treeBuf, &tableBit, maxoffset);
+		}
+	}
+	tableMsec = Sys_Milliseconds() - start;
+
+	Com_Printf("huffbench: decode %.1f MB  tree %i msec (%.1f MB/s)  table %i msec (%.1f MB/s)\n", mbytes,
+	           treeMsec, mbytes * 1000.0 / MAX(treeMsec, 1), tableMsec, mbytes * 1000.0 / MAX(tableMsec, 1));
 }
+#endif
+
+#ifdef ETLEGACY_DEBUG
+/**
+ * @brief Advances a set of entity and player states the way a recorded match would change them
+ * @param[in,out] ents
+ * @param[in] numEnts
+ * @param[in,out] ps
+ * @param[in] frame
+ */
+static void MSG_DeltaBenchAdvance(entityState_t *ents, int numEnts, playerState_t *ps, int frame)
+{
+	int i;
+
+	for (i = 0; i < numEnts; i++)
+	{
+		entityState_t *es = &ents[i];
+
+		if (!frame)
+		{
+			Com_Memset(es, 0, sizeof(*es));
+			es->number           = i;
+			es->eType            = i & 7;
+			es->modelindex       = i & 63;
+			es->pos.trType       = TR_INTERPOLATE;
+			es->pos.trBase[0]    = (rand() % 8192) - 4096.f;
+			es->pos.trBase[1]    = (rand() % 8192) - 4096.f;
+			es->pos.trBase[2]    = (rand() % 1024);
+			es->pos.trDelta[0]   = (rand() % 640) - 320.f;
+			es->pos.trDelta[1]   = (rand() % 640) - 320.f;
+			es->apos.trBase[YAW] = rand() % 360;
+			continue;
+		}
+
+		// most entities move a little every frame, a few sit still
+		if ((i & 7) == 7)
+		{
+			continue;
+		}
+
+		es->pos.trTime       = frame * 50;
+		es->pos.trBase[0]   += es->pos.trDelta[0] * 0.05f;
+		es->pos.trBase[1]   += es->pos.trDelta[1] * 0.05f;
+		es->apos.trBase[YAW] = AngleNormalize360(es->apos.trBase[YAW] + (i & 3) * 1.5f);
+		es->legsAnim         = (frame >> 3) & 0xff;
+		es->torsoAnim        = (frame >> 4) & 0xff;
+
+		if (!(rand() & 31))
+		{
+			es->event     = (es->event + 1) & 0xff;
+			es->eventParm = rand() & 0xff;
+		}
+	}
+
+	if (!frame)
+	{
+		Com_Memset(ps, 0, sizeof(*ps));
+	}
+	ps->commandTime = frame * 50;
+	ps->origin[0]   = 100.f + frame * 1.25f;
+	ps->origin[1]   = -50.f + (frame & 63) * 0.5f;
+	ps->velocity[0] = 25.f;
+	ps->velocity[1] = (frame & 1) ? 10.f : -10.f;
+	ps->viewangles[YAW]   = AngleNormalize360(frame * 2.3f);
+	ps->viewangles[PITCH] = (frame & 15) - 8.f;
+	ps->weaponTime        = frame % 150;
+	ps->ammoclip[1]       = 30 - (frame % 30);
+}
+
+/**
+ * @brief Encodes and decodes a synthetic recording of entity and player state deltas
+ *
+ * @details Usage: msgbench [frames]
+ * Every decoded state is compared to the one that was encoded.
+ */
+void MSG_DeltaBench_f(void)
+{
+	static entityState_t prev[MAX_CLIENTS * 2], cur[MAX_CLIENTS * 2];
+	static byte          buf[MAX_MSGLEN];
+	entityState_t        decoded;
+	playerState_t        prevPs, curPs, decodedPs;
+	msg_t                msg;
+	int                  frames = 2000, frame, i, numEnts = MAX_CLIENTS * 2, mismatches = 0, bytes = 0;
+	int                  start, writeMsec = 0, readMsec = 0;
+
+	if (!msgInit)
+	{
+		MSG_initHuffman();
+	}
+
+	if (Cmd_Argc() > 1)
+	{
+		frames = atoi(Cmd_Argv(1));
+		if (frames <= 0)
+		{
+			frames = 2000;
+		}
+	}
+
+	srand(0x5eed);
+	MSG_DeltaBenchAdvance(cur, numEnts, &curPs, 0);
+
+	for (frame = 1; frame <= frames; frame++)
+	{
+		Com_Memcpy(prev, cur, sizeof(prev));
+		prevPs = curPs;
+		MSG_DeltaBenchAdvance(cur, numEnts, &curPs, frame);
+
+		MSG_Init(&msg, buf, sizeof(buf));
+		MSG_Bitstream(&msg);
+
+		start = Sys_Milliseconds();
+		MSG_WriteDeltaPlayerstate(&msg, &prevPs, &curPs);
+		for (i = 0; i < numEnts; i++)
+		{
+			MSG_WriteDeltaEntity(&msg, &prev[i], &cur[i], qtrue);
+		}
+		writeMsec += Sys_Milliseconds() - start;
+		bytes     += msg.cursize;
+
+		if (msg.overflowed)
+		{
+			Com_Printf("msgbench: message overflowed at frame %i\n", frame);
+			return;
+		}
+
+		MSG_BeginReading(&msg);
+
+		start = Sys_Milliseconds();
+		MSG_ReadDeltaPlayerstate(&msg, &prevPs, &decodedPs);
+		for (i = 0; i < numEnts; i++)
+		{
+			MSG_ReadDeltaEntity(&msg, &prev[i], &decoded, MSG_ReadBits(&msg, GENTITYNUM_BITS));
+			if (memcmp(&decoded, &cur[i], sizeof(decoded)))
+			{
+				mismatches++;
+			}
+		}
+		readMsec += Sys_Milliseconds() - start;
+
+		if (!VectorCompare(decodedPs.origin, curPs.origin) || !VectorCompare(decodedPs.viewangles, curPs.viewangles)
+		    || decodedPs.commandTime != curPs.commandTime)
+		{
+			mismatches++;
+		}
+	}
+
+	Com_Printf("msgbench: %i frames of %i entities + playerstate, %i bytes (%.1f per frame)\n", frames, numEnts, bytes, bytes / (float)frames);
+	Com_Printf("msgbench: write %i msec (%.2f usec/frame), read %i msec (%.2f usec/frame), %i mismatches\n",
+	           writeMsec, writeMsec * 1000.f / frames, readMsec, readMsec * 1000.f / frames, mismatches);
+}
+#endif
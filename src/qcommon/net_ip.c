@@ -139,6 +139,10 @@ static struct sockaddr socksRelayAddr;
 static SOCKET ip_socket    = INVALID_SOCKET;
 static SOCKET socks_socket = INVALID_SOCKET;
 
+/// loopback socket other threads send to, to wake the main loop out of NET_Sleep
+static SOCKET             wake_socket = INVALID_SOCKET;
+static struct sockaddr_in wake_address;
+
 #ifdef FEATURE_IPV6
 static SOCKET ip6_socket        = INVALID_SOCKET;
 static SOCKET multicast6_socket = INVALID_SOCKET;
@@ -1915,15 +1919,418 @@ static qboolean NET_GetCvars(void)
 	return modified ? qtrue : qfalse;
 }
 
+/*
+=============================================================================
+
+NETWORK FRONT-END
+
+An optional thread owning the receive side of the game sockets. Every packet
+goes through a filter (SV_FrontendFilter) which answers or drops what it can
+on the thread, the rest is queued for the main loop, which takes it from the
+queue in NET_Sleep instead of reading the sockets.
+
+=============================================================================
+*/
+
+#define NET_FRONTEND_QUEUE_SIZE 0x100000    ///< 1 MB, must be a power of two
+#define NET_FRONTEND_QUEUE_MASK (NET_FRONTEND_QUEUE_SIZE - 1)
+#define NET_FRONTEND_BATCH      256         ///< packets read from a socket before looking at the other one
+
+/**
+ * @struct netFrontendPacket_t
+ * @brief Header of a queued packet, the data follows
+ */
+typedef struct
+{
+	netadr_t from;
+	int length;
+} netFrontendPacket_t;
+
+/**
+ * @struct netFrontend_t
+ * @brief The front-end thread and the queue it fills, head is written by the thread, tail by the main loop
+ */
+typedef struct
+{
+	void *thread;
+	netFrontendFilter_t filter;
+
+	byte *data;
+	volatile unsigned int head;
+	volatile unsigned int tail;
+	volatile qboolean quit;
+
+	netFrontendStats_t stats;
+} netFrontend_t;
+
+static netFrontend_t netFrontend;
+
+/**
+ * @brief Copy data into or out of the front-end queue at the given running offset, wrapping around the end of the ring
+ * @param[in] offset
+ * @param[in,out] data
+ * @param[in] len
+ * @param[in] write
+ */
+static void NET_FrontendCopy(unsigned int offset, void *data, unsigned int len, qboolean write)
+{
+	unsigned int pos   = offset & NET_FRONTEND_QUEUE_MASK;
+	unsigned int first = MIN(len, NET_FRONTEND_QUEUE_SIZE - pos);
+
+	if (write)
+	{
+		Com_Memcpy(netFrontend.data + pos, data, first);
+		Com_Memcpy(netFrontend.data, (byte *)data + first, len - first);
+	}
+	else
+	{
+		Com_Memcpy(data, netFrontend.data + pos, first);
+		Com_Memcpy((byte *)data + first, netFrontend.data, len - first);
+	}
+}
+
+/**
+ * @brief Queue a packet for the main loop, it is dropped if the queue is full
+ * @param[in] from
+ * @param[in] msg
+ */
+static void NET_FrontendQueue(netadr_t from, msg_t *msg)
+{
+	netFrontendPacket_t packet;
+	unsigned int        head = netFrontend.head, tail, depth;
+
+	tail = netFrontend.tail;
+	Sys_MemoryBarrier();
+
+	if (NET_FRONTEND_QUEUE_SIZE - (head - tail) < sizeof(packet) + msg->cursize)
+	{
+		netFrontend.stats.queueFull++;
+		return;
+	}
+
+	packet.from   = from;
+	packet.length = msg->cursize;
+	NET_FrontendCopy(head, &packet, sizeof(packet), qtrue);
+	NET_FrontendCopy(head + sizeof(packet), msg->data, msg->cursize, qtrue);
+
+	// publish the packet only once it is complete
+	Sys_MemoryBarrier();
+	netFrontend.head = head + sizeof(packet) + msg->cursize;
+
+	// the main loop had read everything, it may be waiting in NET_Sleep
+	Sys_MemoryBarrier();
+	if (netFrontend.tail == head)
+	{
+		NET_Wake();
+	}
+
+	netFrontend.stats.forwarded++;
+	depth = netFrontend.head - tail;
+	if (depth > netFrontend.stats.maxDepth)
+	{
+		netFrontend.stats.maxDepth = depth;
+	}
+}
+
+/**
+ * @brief Read the pending packets of a socket on the front-end thread
+ * @param[in] sock
+ * @param[in,out] msg receive buffer
+ *
+ * @note Nothing here may print, the console belongs to the main loop
+ */
+static void NET_FrontendRead(SOCKET sock, msg_t *msg)
+{
+	struct sockaddr_storage from;
+	socklen_t               fromlen;
+	netadr_t                adr;
+	int                     ret, i;
+
+	for (i = 0; i < NET_FRONTEND_BATCH; i++)
+	{
+		fromlen = sizeof(from);
+		ret     = recvfrom(sock, (void *)msg->data, msg->maxsize, 0, (struct sockaddr *) &from, &fromlen);
+
+		if (ret == SOCKET_ERROR)
+		{
+			if (socketError != EAGAIN && socketError != ECONNRESET)
+			{
+				netFrontend.stats.errors++;
+			}
+			return;
+		}
+
+		netFrontend.stats.received++;
+
+		if (ret >= msg->maxsize)
+		{
+			netFrontend.stats.errors++;
+			continue;
+		}
+
+		if (from.ss_family == AF_INET)
+		{
+			Com_Memset(((struct sockaddr_in *)&from)->sin_zero, 0, 8);
+		}
+		SockadrToNetadr((struct sockaddr *) &from, &adr);
+
+		msg->cursize   = ret;
+		msg->readcount = 0;
+		msg->bit       = 0;
+
+		if (netFrontend.filter(adr, msg))
+		{
+			netFrontend.stats.filtered++;
+			continue;
+		}
+
+		NET_FrontendQueue(adr, msg);
+	}
+}
+
+/**
+ * @brief Front-end thread, waits on the game sockets until asked to quit
+ * @param arg - unused
+ */
+static void NET_FrontendThread(void *arg)
+{
+	byte           bufData[MAX_MSGLEN + 1];
+	msg_t          msg;
+	fd_set         fdr;
+	struct timeval timeout;
+	SOCKET         highestfd;
+
+	MSG_Init(&msg, bufData, sizeof(bufData));
+
+	while (!netFrontend.quit)
+	{
+		FD_ZERO(&fdr);
+		highestfd = INVALID_SOCKET;
+
+		if (ip_socket != INVALID_SOCKET)
+		{
+			FD_SET(ip_socket, &fdr);
+			highestfd = ip_socket;
+		}
+#ifdef FEATURE_IPV6
+		if (ip6_socket != INVALID_SOCKET)
+		{
+			FD_SET(ip6_socket, &fdr);
+			if (highestfd == INVALID_SOCKET || ip6_socket > highestfd)
+			{
+				highestfd = ip6_socket;
+			}
+		}
+#endif
+
+		// wake up now and then to notice the quit request
+		timeout.tv_sec  = 0;
+		timeout.tv_usec = 10000;
+
+		if (select(highestfd + 1, &fdr, NULL, NULL, &timeout) <= 0)
+		{
+			continue;
+		}
+
+		if (ip_socket != INVALID_SOCKET && FD_ISSET(ip_socket, &fdr))
+		{
+			NET_FrontendRead(ip_socket, &msg);
+		}
+#ifdef FEATURE_IPV6
+		if (ip6_socket != INVALID_SOCKET && FD_ISSET(ip6_socket, &fdr))
+		{
+			NET_FrontendRead(ip6_socket, &msg);
+		}
+#endif
+	}
+}
+
+/**
+ * @brief Start the front-end thread, from now on the main loop gets the packets it forwards
+ * @param[in] filter
+ * @return qfalse if it can't run, the main loop reads the sockets as before then
+ */
+qboolean NET_FrontendStart(netFrontendFilter_t filter)
+{
+	if (netFrontend.thread)
+	{
+		return qtrue;
+	}
+
+	// the socks relay wraps every packet, the front-end only reads plain sockets
+	if (usingSocks)
+	{
+		Com_Printf(S_COLOR_YELLOW "WARNING: the network front-end doesn't work through a socks proxy\n");
+		return qfalse;
+	}
+
+	if (ip_socket == INVALID_SOCKET
+#ifdef FEATURE_IPV6
+	    && ip6_socket == INVALID_SOCKET
+#endif
+	    )
+	{
+		return qfalse;
+	}
+
+	// NET_Sleep would have no way to learn about the queued packets
+	if (wake_socket == INVALID_SOCKET)
+	{
+		Com_Printf(S_COLOR_YELLOW "WARNING: the network front-end needs the wake socket\n");
+		return qfalse;
+	}
+
+	netFrontend.filter = filter;
+	netFrontend.head   = 0;
+	netFrontend.tail   = 0;
+	netFrontend.quit   = qfalse;
+
+	netFrontend.data = Com_Allocate(NET_FRONTEND_QUEUE_SIZE);
+	if (!netFrontend.data)
+	{
+		Com_Printf(S_COLOR_YELLOW "WARNING: couldn't allocate the network front-end queue\n");
+		return qfalse;
+	}
+
+	Sys_MemoryBarrier();
+	netFrontend.thread = Sys_CreateThread(NET_FrontendThread, NULL);
+	if (!netFrontend.thread)
+	{
+		Com_Printf(S_COLOR_YELLOW "WARNING: couldn't start the network front-end thread\n");
+		Com_Dealloc(netFrontend.data);
+		netFrontend.data = NULL;
+		return qfalse;
+	}
+
+	return qtrue;
+}
+
+/**
+ * @brief Stop the front-end thread, the packets still queued are dropped
+ */
+void NET_FrontendStop(void)
+{
+	if (!netFrontend.thread)
+	{
+		return;
+	}
+
+	Sys_MemoryBarrier();
+	netFrontend.quit = qtrue;
+	Sys_JoinThread(netFrontend.thread);
+	netFrontend.thread = NULL;
+
+	Com_Dealloc(netFrontend.data);
+	netFrontend.data = NULL;
+}
+
+/**
+ * @brief NET_FrontendRunning
+ * @return
+ */
+qboolean NET_FrontendRunning(void)
+{
+	return netFrontend.thread != NULL;
+}
+
+/**
+ * @brief Send a packet from the front-end thread, unlike Sys_SendPacket it never prints
+ * @param[in] to
+ * @param[in] data
+ * @param[in] length
+ */
+void NET_FrontendSend(netadr_t to, const void *data, int length)
+{
+	struct sockaddr_storage addr;
+	int                     ret = SOCKET_ERROR;
+
+	Com_Memset(&addr, 0, sizeof(addr));
+	NetadrToSockadr(&to, (struct sockaddr *) &addr);
+
+	if (addr.ss_family == AF_INET && ip_socket != INVALID_SOCKET)
+	{
+		ret = sendto(ip_socket, data, length, 0, (struct sockaddr *) &addr, sizeof(struct sockaddr_in));
+	}
+#ifdef FEATURE_IPV6
+	else if (addr.ss_family == AF_INET6 && ip6_socket != INVALID_SOCKET)
+	{
+		ret = sendto(ip6_socket, data, length, 0, (struct sockaddr *) &addr, sizeof(struct sockaddr_in6));
+	}
+#endif
+
+	if (ret == SOCKET_ERROR && socketError != EAGAIN)
+	{
+		netFrontend.stats.errors++;
+	}
+}
+
+/**
+ * @brief Get the front-end counters
+ * @param[out] stats
+ * @param[in] reset clear them afterwards
+ */
+void NET_FrontendStats(netFrontendStats_t *stats, qboolean reset)
+{
+	*stats = netFrontend.stats;
+
+	if (reset)
+	{
+		Com_Memset(&netFrontend.stats, 0, sizeof(netFrontend.stats));
+	}
+}
+
+/**
+ * @brief Open the loopback socket NET_Wake sends to, NET_Sleep waits on it along with the game sockets
+ */
+static void NET_OpenWake(void)
+{
+	u_long    _true = 1;
+	socklen_t len   = sizeof(wake_address);
+
+	if ((wake_socket = socket(PF_INET, SOCK_DGRAM, IPPROTO_UDP)) == INVALID_SOCKET)
+	{
+		Com_Printf(S_COLOR_YELLOW "WARNING: NET_OpenWake - socket: %s\n", NET_ErrorString());
+		return;
+	}
+
+	Com_Memset(&wake_address, 0, sizeof(wake_address));
+	wake_address.sin_family      = AF_INET;
+	wake_address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	wake_address.sin_port        = 0;
+
+	if (ioctlsocket(wake_socket, FIONBIO, &_true) == SOCKET_ERROR
+	    || bind(wake_socket, (struct sockaddr *)&wake_address, sizeof(wake_address)) == SOCKET_ERROR
+	    || getsockname(wake_socket, (struct sockaddr *)&wake_address, &len) == SOCKET_ERROR)
+	{
+		Com_Printf(S_COLOR_YELLOW "WARNING: NET_OpenWake: %s\n", NET_ErrorString());
+		closesocket(wake_socket);
+		wake_socket = INVALID_SOCKET;
+	}
+}
+
+/**
+ * @brief Wake the main loop out of NET_Sleep, safe to call from any thread
+ */
+void NET_Wake(void)
+{
+	char signal = 0;
+
+	if (wake_socket != INVALID_SOCKET)
+	{
+		sendto(wake_socket, &signal, 1, 0, (struct sockaddr *)&wake_address, sizeof(wake_address));
+	}
+}
+
 /**
  * @brief NET_Config
  * @param[in] enableNetworking
  */
 static void NET_Config(qboolean enableNetworking)
 {
-	qboolean modified;
-	qboolean stop;
-	qboolean start;
+	qboolean            modified;
+	qboolean            stop;
+	qboolean            start;
+	netFrontendFilter_t frontend = NULL;
 
 	// get any latched changes to cvars
 	modified = NET_GetCvars();
@@ -1970,6 +2377,13 @@ static void NET_Config(qboolean enableNetworking)
 
 	if (stop)
 	{
+		// the front-end thread is reading the sockets
+		if (netFrontend.thread)
+		{
+			frontend = netFrontend.filter;
+			NET_FrontendStop();
+		}
+
 		if (ip_socket != INVALID_SOCKET)
 		{
 			closesocket(ip_socket);
@@ -2000,6 +2414,12 @@ static void NET_Config(qboolean enableNetworking)
 			socks_socket = INVALID_SOCKET;
 		}
 
+		if (wake_socket != INVALID_SOCKET)
+		{
+			closesocket(wake_socket);
+			wake_socket = INVALID_SOCKET;
+		}
+
 		Com_Printf("Network shutdown\n");
 	}
 
@@ -2012,7 +2432,13 @@ static void NET_Config(qboolean enableNetworking)
 			NET_SetMulticast6();
 #endif
 		}
+		NET_OpenWake();
 		Com_Printf("Network initialized\n");
+
+		if (frontend)
+		{
+			NET_FrontendStart(frontend);
+		}
 	}
 }
 
@@ -2058,6 +2484,32 @@ void NET_Shutdown(void)
 #endif
 }
 
+/**
+ * @brief Hand a received packet to the server or the client
+ * @param[in] from
+ * @param[in] netmsg
+ */
+static void NET_DispatchPacket(netadr_t *from, msg_t *netmsg)
+{
+	if (net_dropsim->value > 0.0f && net_dropsim->value <= 100.0f)
+	{
+		// com_dropsim->value percent of incoming packets get dropped.
+		if (rand() < (int)(((double)RAND_MAX) / 100.0 * (double)net_dropsim->value))
+		{
+			return;          // drop this packet
+		}
+	}
+
+	if (com_sv_running->integer)
+	{
+		Com_RunAndTimeServerPacket(from, netmsg);
+	}
+	else
+	{
+		CL_PacketEvent(*from, netmsg);
+	}
+}
+
 /**
  * @brief Called from NET_Sleep which uses select() to determine which sockets have seen action.
  * @param fdr
@@ -2074,23 +2526,7 @@ void NET_Event(fd_set *fdr)
 
 		if (NET_GetPacket(&from, &netmsg, fdr))
 		{
-			if (net_dropsim->value > 0.0f && net_dropsim->value <= 100.0f)
-			{
-				// com_dropsim->value percent of incoming packets get dropped.
-				if (rand() < (int)(((double)RAND_MAX) / 100.0 * (double)net_dropsim->value))
-				{
-					continue;          // drop this packet
-				}
-			}
-
-			if (com_sv_running->integer)
-			{
-				Com_RunAndTimeServerPacket(&from, &netmsg);
-			}
-			else
-			{
-				CL_PacketEvent(from, &netmsg);
-			}
+			NET_DispatchPacket(&from, &netmsg);
 		}
 		else
 		{
@@ -2099,6 +2535,45 @@ void NET_Event(fd_set *fdr)
 	}
 }
 
+/**
+ * @brief Handle the packets the front-end thread queued, in place of NET_Event
+ * @return Number of packets handled
+ */
+static int NET_FrontendEvent(void)
+{
+	byte                bufData[MAX_MSGLEN + 1];
+	msg_t               netmsg;
+	netFrontendPacket_t packet;
+	unsigned int        head, tail;
+	int                 count = 0;
+
+	// a packet may stop the front-end, a server shutdown does
+	while (netFrontend.thread)
+	{
+		head = netFrontend.head;
+		tail = netFrontend.tail;
+		Sys_MemoryBarrier();
+
+		if (head == tail)
+		{
+			break;
+		}
+
+		MSG_Init(&netmsg, bufData, sizeof(bufData));
+		NET_FrontendCopy(tail, &packet, sizeof(packet), qfalse);
+		NET_FrontendCopy(tail + sizeof(packet), bufData, packet.length, qfalse);
+		netmsg.cursize = packet.length;
+
+		Sys_MemoryBarrier();
+		netFrontend.tail = tail + sizeof(packet) + packet.length;
+
+		NET_DispatchPacket(&packet.from, &netmsg);
+		count++;
+	}
+
+	return count;
+}
+
 /**
  * @brief Sleeps msec or until something happens on the network
  * @param[in] msec
@@ -2115,23 +2590,41 @@ void NET_Sleep(int msec)
 		msec = 0;
 	}
 
+	// the front-end thread reads the game sockets, it wakes us when it queues a packet
+	if (netFrontend.thread && NET_FrontendEvent())
+	{
+		return;
+	}
+
 	FD_ZERO(&fdset);
 
-	if (ip_socket != INVALID_SOCKET)
+	if (!netFrontend.thread)
 	{
-		FD_SET(ip_socket, &fdset);
-		highestfd = ip_socket;
-	}
+		if (ip_socket != INVALID_SOCKET)
+		{
+			FD_SET(ip_socket, &fdset);
+			highestfd = ip_socket;
+		}
 #ifdef FEATURE_IPV6
-	if (ip6_socket != INVALID_SOCKET)
+		if (ip6_socket != INVALID_SOCKET)
+		{
+			FD_SET(ip6_socket, &fdset);
+			if (highestfd == INVALID_SOCKET || ip6_socket > highestfd)
+			{
+				highestfd = ip6_socket;
+			}
+		}
+#endif
+	}
+
+	if (wake_socket != INVALID_SOCKET)
 	{
-		FD_SET(ip6_socket, &fdset);
-		if (highestfd == INVALID_SOCKET || ip6_socket > highestfd)
+		FD_SET(wake_socket, &fdset);
+		if (highestfd == INVALID_SOCKET || wake_socket > highestfd)
 		{
-			highestfd = ip6_socket;
+			highestfd = wake_socket;
 		}
 	}
-#endif
 
 #ifdef _WIN32
 	if (highestfd == INVALID_SOCKET)
@@ -2152,7 +2645,23 @@ void NET_Sleep(int msec)
 	}
 	else if (retval > 0)
 	{
-		NET_Event(&fdset);
+		if (wake_socket != INVALID_SOCKET && FD_ISSET(wake_socket, &fdset))
+		{
+			char signals[64];
+
+			while (recv(wake_socket, signals, sizeof(signals), 0) > 0)
+			{
+			}
+		}
+
+		if (netFrontend.thread)
+		{
+			NET_FrontendEvent();
+		}
+		else
+		{
+			NET_Event(&fdset);
+		}
 	}
 }
 
@@ -2163,3 +2672,247 @@ void NET_Restart_f(void)
 {
 	NET_Config(networkingEnabled);
 }
+
+/*
+=============================================================================
+
+TCP STREAMS
+
+Non-blocking stream sockets for the server relay, see sv_relay.c
+
+=============================================================================
+*/
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+/**
+ * @brief Make a stream socket non-blocking and disable nagle, the relay sends whole frames
+ * @param[in] sock
+ * @return qfalse on error, the socket is closed then
+ */
+static qboolean NET_TCPSetup(SOCKET sock)
+{
+	u_long _true = 1;
+	int    i     = 1;
+
+	if (ioctlsocket(sock, FIONBIO, &_true) == SOCKET_ERROR)
+	{
+		Com_Printf(S_COLOR_YELLOW "WARNING: NET_TCPSetup - ioctl FIONBIO: %s\n", NET_ErrorString());
+		closesocket(sock);
+		return qfalse;
+	}
+
+	if (setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char *)&i, sizeof(i)) == SOCKET_ERROR)
+	{
+		Com_Printf(S_COLOR_YELLOW "WARNING: NET_TCPSetup - setsockopt TCP_NODELAY: %s\n", NET_ErrorString());
+	}
+
+	return qtrue;
+}
+
+/**
+ * @brief Open a listening stream socket on all IPv4 interfaces, or on the loopback one only
+ * @param[in] port
+ * @param[in] loopback
+ * @return The socket, or -1 on error
+ */
+int NET_TCPListen(int port, qboolean loopback)
+{
+	SOCKET             sock;
+	struct sockaddr_in address;
+	int                i = 1;
+
+	if ((sock = socket(PF_INET, SOCK_STREAM, IPPROTO_TCP)) == INVALID_SOCKET)
+	{
+		Com_Printf(S_COLOR_YELLOW "WARNING: NET_TCPListen - socket: %s\n", NET_ErrorString());
+		return -1;
+	}
+
+	if (setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, (char *)&i, sizeof(i)) == SOCKET_ERROR)
+	{
+		Com_Printf(S_COLOR_YELLOW "WARNING: NET_TCPListen - setsockopt SO_REUSEADDR: %s\n", NET_ErrorString());
+	}
+
+	Com_Memset(&address, 0, sizeof(address));
+	address.sin_family      = AF_INET;
+	address.sin_addr.s_addr = htonl(loopback ? INADDR_LOOPBACK : INADDR_ANY);
+	address.sin_port        = htons((unsigned short)port);
+
+	if (bind(sock, (void *)&address, sizeof(address)) == SOCKET_ERROR || listen(sock, 4) == SOCKET_ERROR)
+	{
+		Com_Printf(S_COLOR_YELLOW "WARNING: NET_TCPListen - bind/listen on port %i: %s\n", port, NET_ErrorString());
+		closesocket(sock);
+		return -1;
+	}
+
+	if (!NET_TCPSetup(sock))
+	{
+		return -1;
+	}
+
+	return (int)sock;
+}
+
+/**
+ * @brief Accept a pending connection
+ * @param[in] sock listening socket
+ * @param[out] from
+ * @return The connected socket, or -1 if there is none
+ */
+int NET_TCPAccept(int sock, netadr_t *from)
+{
+	struct sockaddr_storage address;
+	socklen_t               len = sizeof(address);
+	SOCKET                  client;
+
+	client = accept((SOCKET)sock, (struct sockaddr *)&address, &len);
+	if (client == INVALID_SOCKET)
+	{
+		return -1;
+	}
+
+	if (!NET_TCPSetup(client))
+	{
+		return -1;
+	}
+
+	Com_Memset(from, 0, sizeof(*from));
+	SockadrToNetadr((struct sockaddr *)&address, from);
+
+	return (int)client;
+}
+
+/**
+ * @brief Start connecting a stream socket, see NET_TCPConnected()
+ * @param[in] to
+ * @return The socket, or -1 on error
+ */
+int NET_TCPConnect(netadr_t *to)
+{
+	struct sockaddr_storage address;
+	SOCKET                  sock;
+
+	if (to->type != NA_IP && to->type != NA_IP6)
+	{
+		Com_Printf(S_COLOR_YELLOW "WARNING: NET_TCPConnect - bad address type\n");
+		return -1;
+	}
+
+	Com_Memset(&address, 0, sizeof(address));
+	NetadrToSockadr(to, (struct sockaddr *)&address);
+
+	if ((sock = socket(to->type == NA_IP ? PF_INET : PF_INET6, SOCK_STREAM, IPPROTO_TCP)) == INVALID_SOCKET)
+	{
+		Com_Printf(S_COLOR_YELLOW "WARNING: NET_TCPConnect - socket: %s\n", NET_ErrorString());
+		return -1;
+	}
+
+	if (!NET_TCPSetup(sock))
+	{
+		return -1;
+	}
+
+	if (connect(sock, (struct sockaddr *)&address, to->type == NA_IP ? sizeof(struct sockaddr_in) : sizeof(struct sockaddr_in6)) == SOCKET_ERROR)
+	{
+		int err = socketError;
+
+#ifdef _WIN32
+		if (err != WSAEWOULDBLOCK)
+#else
+		if (err != EINPROGRESS)
+#endif
+		{
+			Com_Printf(S_COLOR_YELLOW "WARNING: NET_TCPConnect - connect: %s\n", NET_ErrorString());
+			closesocket(sock);
+			return -1;
+		}
+	}
+
+	return (int)sock;
+}
+
+/**
+ * @brief Check whether a connection started with NET_TCPConnect() went through
+ * @param[in] sock
+ * @return 1 when connected, 0 while pending, -1 if it failed
+ */
+int NET_TCPConnected(int sock)
+{
+	fd_set         fdw;
+	struct timeval timeout = { 0, 0 };
+	int            err     = 0;
+	socklen_t      len     = sizeof(err);
+
+	FD_ZERO(&fdw);
+	FD_SET((SOCKET)sock, &fdw);
+
+	if (select(sock + 1, NULL, &fdw, NULL, &timeout) <= 0)
+	{
+		return 0;
+	}
+
+	if (getsockopt((SOCKET)sock, SOL_SOCKET, SO_ERROR, (char *)&err, &len) == SOCKET_ERROR || err)
+	{
+		return -1;
+	}
+
+	return 1;
+}
+
+/**
+ * @brief Send as much data as the socket takes without blocking
+ * @param[in] sock
+ * @param[in] data
+ * @param[in] len
+ * @return Bytes sent, -1 if the connection is gone
+ */
+int NET_TCPSend(int sock, const void *data, int len)
+{
+	int ret = send((SOCKET)sock, data, len, MSG_NOSIGNAL);
+
+	if (ret == SOCKET_ERROR)
+	{
+		return socketError == EAGAIN ? 0 : -1;
+	}
+
+	return ret;
+}
+
+/**
+ * @brief Receive what is available without blocking
+ * @param[in] sock
+ * @param[out] data
+ * @param[in] len
+ * @return Bytes received, -1 if the connection is gone
+ */
+int NET_TCPRecv(int sock, void *data, int len)
+{
+	int ret = recv((SOCKET)sock, data, len, 0);
+
+	if (ret == SOCKET_ERROR)
+	{
+		return socketError == EAGAIN ? 0 : -1;
+	}
+
+	// orderly shutdown by the peer
+	if (ret == 0)
+	{
+		return -1;
+	}
+
+	return ret;
+}
+
+/**
+ * @brief NET_TCPClose
+ * @param[in] sock
+ */
+void NET_TCPClose(int sock)
+{
+	if (sock >= 0)
+	{
+		closesocket((SOCKET)sock);
+	}
+}
@@ -0,0 +1,336 @@
+/*
+ * Wolfenstein: Enemy Territory GPL Source Code
+ * Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+ *
+ * ET: Legacy
+ * Copyright (C) 2012-2018 ET:Legacy team <mail@etlegacy.com>
+ *
+ * This file is part of ET: Legacy - http://www.etlegacy.com
+ *
+ * ET: Legacy is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ET: Legacy is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ET: Legacy. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, Wolfenstein: Enemy Territory GPL Source Code is also
+ * subject to certain additional terms. You should have received a copy
+ * of these additional terms immediately following the terms and conditions
+ * of the GNU General Public License which accompanied the source code.
+ * If not, please request a copy in writing from id Software at the address below.
+ *
+ * id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+ */
+/**
+ * @file profiler.c
+ * @brief Scoped timers of the server frame, exported as Chrome trace JSON
+ *
+ * A section is registered once by name and timed with Prof_Begin and Prof_End
+ * on the main thread, the game does the same through G_PROFILER_* syscalls.
+ * Finished sections go to a ring holding the last PROF_MAX_EVENTS of them,
+ * "profiler_dump" writes the ring in the Chrome trace event format, which
+ * chrome://tracing and ui.perfetto.dev open.
+ *
+ * With com_profiler 0 a section costs the test of prof.active. With
+ * com_profilerSpike set, a server frame taking longer than that many msec
+ * dumps the ring by itself, at most once a minute.
+ */
+
+#include "q_shared.h"
+#include "qcommon.h"
+
+#define PROF_MAX_EVENTS     32768       ///< power of two
+#define PROF_MAX_NAMES      128
+#define PROF_MAX_DEPTH      32
+#define PROF_NAME_LENGTH    32
+
+#define PROF_SPIKE_INTERVAL 60000       ///< msec between two automatic dumps
+
+/**
+ * @struct profEvent_t
+ * @brief A finished section
+ */
+typedef struct
+{
+	int64_t start;                      ///< usec since the profiler started
+	int duration;                       ///< usec
+	short name;
+	short thread;
+} profEvent_t;
+
+/**
+ * @struct profSection_t
+ * @brief An open section
+ */
+typedef struct
+{
+	int name;
+	int64_t start;
+} profSection_t;
+
+/**
+ * @struct profiler_s
+ * @brief Profiler state, touched by the main thread only
+ */
+static struct profiler_s
+{
+	qboolean active;                    ///< com_profiler, latched at the start of a frame
+	int64_t base;                       ///< Sys_Microseconds of the start
+
+	char names[PROF_MAX_NAMES][PROF_NAME_LENGTH];
+	int numNames;
+
+	profSection_t stack[PROF_MAX_DEPTH];
+	int depth;                          ///< may be deeper than the stack, those sections are dropped
+
+	profEvent_t events[PROF_MAX_EVENTS];
+	unsigned int numEvents;             ///< events ever recorded, the ring holds the last PROF_MAX_EVENTS
+
+	qboolean spike;                     ///< a frame took longer than com_profilerSpike
+	int lastSpikeDump;
+} prof;
+
+static Q_THREAD_LOCAL qboolean prof_mainThread = qfalse;
+
+cvar_t *com_profiler;
+cvar_t *com_profilerSpike;
+
+/**
+ * @brief Register a section name, the same name gets the same id again
+ * @param[in] name
+ * @return The id to pass to Prof_Begin, -1 when the names are full
+ */
+int Prof_Register(const char *name)
+{
+	char clean[PROF_NAME_LENGTH];
+	int  i;
+
+	// the names go into the JSON as they are
+	for (i = 0; name[i] && i < PROF_NAME_LENGTH - 1; i++)
+	{
+		clean[i] = (name[i] < ' ' || name[i] > '~' || name[i] == '"' || name[i] == '\\') ? '_' : name[i];
+	}
+	clean[i] = '\0';
+
+	for (i = 0; i < prof.numNames; i++)
+	{
+		if (!strcmp(prof.names[i], clean))
+		{
+			return i;
+		}
+	}
+
+	if (prof.numNames == PROF_MAX_NAMES)
+	{
+		Com_DPrintf("Prof_Register: no room for '%s'\n", clean);
+		return -1;
+	}
+
+	Q_strncpyz(prof.names[prof.numNames], clean, PROF_NAME_LENGTH);
+	return prof.numNames++;
+}
+
+/**
+ * @brief Add a finished section to the ring
+ * @param[in] name
+ * @param[in] thread
+ * @param[in] start - Sys_Microseconds
+ * @param[in] duration - usec
+ */
+void Prof_Record(int name, int thread, int64_t start, int64_t duration)
+{
+	profEvent_t *event;
+
+	if (!prof.active || name < 0 || name >= prof.numNames)
+	{
+		return;
+	}
+
+	event           = &prof.events[prof.numEvents++ & (PROF_MAX_EVENTS - 1)];
+	event->start    = start - prof.base;
+	event->duration = (int)duration;
+	event->name     = (short)name;
+	event->thread   = (short)thread;
+
+	if (name == PROF_SV_FRAME && com_profilerSpike->integer > 0 && duration >= com_profilerSpike->integer * 1000)
+	{
+		prof.spike = qtrue;
+	}
+}
+
+/**
+ * @brief Open a section, sections nest and are closed by Prof_End
+ * @param[in] name
+ */
+void Prof_Begin(int name)
+{
+	if (!prof.active || !prof_mainThread)
+	{
+		return;
+	}
+
+	if (prof.depth < PROF_MAX_DEPTH)
+	{
+		prof.stack[prof.depth].name  = name;
+		prof.stack[prof.depth].start = Sys_Microseconds();
+	}
+	prof.depth++;
+}
+
+/**
+ * @brief Close the innermost open section
+ */
+void Prof_End(void)
+{
+	if (!prof.active || !prof_mainThread || !prof.depth)
+	{
+		return;
+	}
+
+	prof.depth--;
+	if (prof.depth < PROF_MAX_DEPTH)
+	{
+		profSection_t *section = &prof.stack[prof.depth];
+
+		Prof_Record(section->name, PROF_THREAD_MAIN, section->start, Sys_Microseconds() - section->start);
+	}
+}
+
+/**
+ * @brief Write the ring in the Chrome trace event format
+ * @param[in] filename
+ */
+static void Prof_Dump(const char *filename)
+{
+	fileHandle_t f;
+	char         buffer[16384];
+	int          length = 0;
+	unsigned int first, i;
+
+	f = FS_FOpenFileWrite(filename);
+	if (!f)
+	{
+		Com_Printf("Couldn't write %s.\n", filename);
+		return;
+	}
+
+	first = prof.numEvents > PROF_MAX_EVENTS ? prof.numEvents - PROF_MAX_EVENTS : 0;
+
+	FS_Printf(f, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	FS_Printf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%i,\"args\":{\"name\":\"main\"}},\n", PROF_THREAD_MAIN);
+	FS_Printf(f, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%i,\"args\":{\"name\":\"bots\"}}", PROF_THREAD_BOTS);
+
+	for (i = first; i < prof.numEvents; i++)
+	{
+		profEvent_t *event = &prof.events[i & (PROF_MAX_EVENTS - 1)];
+
+		if (length > (int)sizeof(buffer) - 256)
+		{
+			FS_Write(buffer, length, f);
+			length = 0;
+		}
+
+		length += Com_sprintf(buffer + length, sizeof(buffer) - length,
+		                      ",\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%i,\"ts\":%lld,\"dur\":%i}",
+		                      prof.names[event->name], event->thread, (long long)event->start, event->duration);
+	}
+
+	FS_Write(buffer, length, f);
+	FS_Printf(f, "\n]}\n");
+	FS_FCloseFile(f);
+
+	Com_Printf("Wrote %u profiler events to %s\n", prof.numEvents - first, filename);
+}
+
+/**
+ * @brief Name of a dump file from the local time
+ * @param[out] filename
+ * @param[in] size
+ * @param[in] prefix
+ */
+static void Prof_DumpName(char *filename, size_t size, const char *prefix)
+{
+	qtime_t now;
+
+	Com_RealTime(&now);
+	Com_sprintf(filename, size, "profiler/%s-%04d%02d%02d-%02d%02d%02d.json", prefix,
+	            1900 + now.tm_year, 1 + now.tm_mon, now.tm_mday, now.tm_hour, now.tm_min, now.tm_sec);
+}
+
+/**
+ * @brief profiler_dump [filename]
+ */
+static void Prof_Dump_f(void)
+{
+	char filename[MAX_QPATH];
+
+	if (!prof.numEvents)
+	{
+		Com_Printf("Nothing profiled, set com_profiler 1 first.\n");
+		return;
+	}
+
+	if (Cmd_Argc() > 1)
+	{
+		Q_strncpyz(filename, Cmd_Argv(1), sizeof(filename));
+		COM_DefaultExtension(filename, sizeof(filename), ".json");
+	}
+	else
+	{
+		Prof_DumpName(filename, sizeof(filename), "trace");
+	}
+
+	Prof_Dump(filename);
+}
+
+/**
+ * @brief Called at the start of a frame, no section is open there
+ */
+void Prof_Frame(void)
+{
+	if (prof.spike)
+	{
+		prof.spike = qfalse;
+
+		if (!prof.lastSpikeDump || Sys_Milliseconds() - prof.lastSpikeDump >= PROF_SPIKE_INTERVAL)
+		{
+			char filename[MAX_QPATH];
+
+			Prof_DumpName(filename, sizeof(filename), "spike");
+			Prof_Dump(filename);
+			prof.lastSpikeDump = Sys_Milliseconds();
+		}
+	}
+
+	prof.active = (com_profiler->integer != 0);
+	prof.depth  = 0;
+}
+
+/**
+ * @brief Called by Com_Init on the main thread
+ */
+void Prof_Init(void)
+{
+	com_profiler      = Cvar_Get("com_profiler", "0", 0);
+	com_profilerSpike = Cvar_Get("com_profilerSpike", "0", 0);
+
+	prof_mainThread = qtrue;
+	prof.base       = Sys_Microseconds();
+
+	// in the order of profSectionName_t
+	Prof_Register("SV_Frame");
+	Prof_Register("SV_PacketEvent");
+	Prof_Register("G_RunFrame");
+	Prof_Register("SV_SendClientMessages");
+	Prof_Register("G_BotThink");
+	Prof_Register("SV_GameBotThinkFinish");
+
+	Cmd_AddCommand("profiler_dump", Prof_Dump_f, "Writes the last server frame sections timed with com_profiler 1 as a Chrome trace JSON file.");
+}
@@ -2074,6 +2074,40 @@ void Com_TruncateLongString(char *buffer, const char *s)
 	}
 }
 
+/**
+ * @brief Rebuild a string from the prefix and suffix it shares with
+ * its previous value, as sent by "csp" configstring splices
+ * @param[out] buffer
+ * @param[in] size
+ * @param[in] old
+ * @param[in] oldLen expected length of old, qfalse is returned on a mismatch
+ * @param[in] prefix chars kept from the start of old
+ * @param[in] suffix chars kept from the end of old
+ * @param[in] middle replaces the rest
+ * @return qfalse if old isn't the string the splice was made against or buffer is too small
+ */
+qboolean Com_SpliceString(char *buffer, size_t size, const char *old, int oldLen, int prefix, int suffix, const char *middle)
+{
+	size_t middleLen = strlen(middle);
+
+	if (oldLen < 0 || prefix < 0 || suffix < 0 || prefix + suffix > oldLen || strlen(old) != (size_t)oldLen)
+	{
+		return qfalse;
+	}
+
+	if (prefix + middleLen + suffix >= size)
+	{
+		return qfalse;
+	}
+
+	Com_Memcpy(buffer, old, prefix);
+	Com_Memcpy(buffer + prefix, middle, middleLen);
+	Com_Memcpy(buffer + prefix + middleLen, old + oldLen - suffix, suffix);
+	buffer[prefix + middleLen + suffix] = '\0';
+
+	return qtrue;
+}
+
 /**
  * @brief This is just a convenience function
  * for making temporary vectors for function calls
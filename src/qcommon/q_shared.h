@@ -775,6 +775,7 @@ char *QDECL va(const char *format, ...) __attribute__ ((format(printf, 1, 2)));
 
 #define TRUNCATE_LENGTH 64
 void Com_TruncateLongString(char *buffer, const char *s);
+qboolean Com_SpliceString(char *buffer, size_t size, const char *old, int oldLen, int prefix, int suffix, const char *middle);
 
 //=============================================
 
@@ -1746,6 +1747,10 @@ typedef struct userAgent_s
 void Com_ParseUA(userAgent_t *ua, const char *string);
 #define Com_IsCompatible(ua, flag) ((ua)->compatible & flag)
 
+/// Features announced by clients in their "etFeatures" userinfo, added to compatible
+#define UA_FEATURE_CSDELTA 0x2 ///< configstring updates as splices ("csp"), baselines delta'd from each other (svc_baselineDelta)
+#define UA_FEATURES        (UA_FEATURE_CSDELTA)
+
 //c99 issue pre 2013 VS do not have support for this
 #if defined(_MSC_VER) && (_MSC_VER < 1800)
 // source http://smackerelofopinion.blogspot.fi/2011/10/determining-number-of-arguments-in-c.html
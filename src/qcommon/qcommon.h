@@ -88,6 +88,7 @@ struct entityState_s;
 struct playerState_s;
 
 void MSG_WriteBits(msg_t *msg, int value, int bits);
+void MSG_CopyBits(msg_t *msg, byte *data, int offset, int bits);
 
 void MSG_WriteChar(msg_t *msg, int c);
 void MSG_WriteByte(msg_t *msg, int c);
@@ -129,6 +130,10 @@ void MSG_WriteDeltaPlayerstate(msg_t *msg, struct playerState_s *from, struct pl
 void MSG_ReadDeltaPlayerstate(msg_t *msg, struct playerState_s *from, struct playerState_s *to);
 
 void MSG_ReportChangeVectors_f(void);
+#ifdef ETLEGACY_DEBUG
+void MSG_HuffBench_f(void);
+void MSG_DeltaBench_f(void);
+#endif
 
 /**
 ==============================================================
@@ -239,6 +244,40 @@ const char *NET_AdrToStringNoPort(netadr_t a);
 int NET_StringToAdr(const char *s, netadr_t *a, netadrtype_t family);
 qboolean NET_GetLoopPacket(netsrc_t sock, netadr_t *net_from, msg_t *net_message);
 void NET_Sleep(int msec);
+void NET_Wake(void);
+
+// non-blocking TCP streams, used by the server relay
+int NET_TCPListen(int port, qboolean loopback);
+int NET_TCPAccept(int sock, netadr_t *from);
+int NET_TCPConnect(netadr_t *to);
+int NET_TCPConnected(int sock);
+int NET_TCPSend(int sock, const void *data, int len);
+int NET_TCPRecv(int sock, void *data, int len);
+void NET_TCPClose(int sock);
+
+/**
+ * @struct netFrontendStats_t
+ * @brief Counters of the network front-end thread
+ */
+typedef struct
+{
+	int received;               ///< packets read from the sockets
+	int filtered;               ///< answered or dropped by the filter
+	int forwarded;              ///< queued for the main loop
+	int queueFull;              ///< dropped as the main loop fell behind
+	int errors;                 ///< socket errors and oversize packets
+	unsigned int maxDepth;      ///< bytes queued at most
+} netFrontendStats_t;
+
+/// runs on the front-end thread, qtrue when the packet was dealt with, qfalse to queue it for the main loop
+typedef qboolean (*netFrontendFilter_t)(netadr_t from, msg_t *msg);
+
+// thread reading the game sockets, see sv_frontend.c
+qboolean NET_FrontendStart(netFrontendFilter_t filter);
+void NET_FrontendStop(void);
+qboolean NET_FrontendRunning(void);
+void NET_FrontendSend(netadr_t to, const void *data, int length);
+void NET_FrontendStats(netFrontendStats_t *stats, qboolean reset);
 
 /**
  * @def MAX_MSGLEN
@@ -428,9 +467,13 @@ enum svc_ops_e
 	svc_serverCommand,          ///< [string] to be executed by client game module
 	svc_download,               ///< [short] size [size bytes]
 	svc_snapshot,
-	svc_EOF
+	svc_EOF,
+	svc_baselineDelta           ///< [4 bits] baselines back to delta from, only in gamestate messages to UA_FEATURE_CSDELTA clients
 };
 
+#define BASELINE_DELTA_BITS     4
+#define BASELINE_DELTA_BACKUP   (1 << BASELINE_DELTA_BITS)   ///< baselines a svc_baselineDelta can refer back to, +1
+
 /**
  * @enum clc_ops_e
  * @brief Client to server
@@ -890,6 +933,17 @@ int FS_FTell(fileHandle_t f);
 // where are we?
 
 void FS_Flush(fileHandle_t f);
+void FS_Sync(fileHandle_t f);
+
+qboolean FS_ThreadWrite(const void *buffer, int len, fileHandle_t f);
+qboolean FS_ThreadSync(fileHandle_t f);
+// write and sync from a thread other than the main one, errors are returned instead of printed
+
+void FS_SetBlockCompression(fileHandle_t f, int level);
+// writes the file as independently compressed blocks, call before the first write
+
+long FS_DetectBlockCompression(fileHandle_t f);
+// reads a block compressed file transparently, returns the uncompressed length or -1 for plain files
 
 void QDECL FS_Printf(fileHandle_t h, const char *fmt, ...);
 // like fprintf
@@ -1087,6 +1141,34 @@ extern int time_game;
 extern int time_frontend;
 extern int time_backend;            // renderer backend time
 
+// frame profiler, profiler.c
+extern cvar_t *com_profiler;
+extern cvar_t *com_profilerSpike;
+
+/**
+ * @enum profSectionName_t
+ * @brief Sections of the engine, registered by Prof_Init
+ */
+typedef enum
+{
+	PROF_SV_FRAME,
+	PROF_SV_PACKET,
+	PROF_GAME_FRAME,
+	PROF_SV_SEND,
+	PROF_BOT_THINK,
+	PROF_BOT_WAIT
+} profSectionName_t;
+
+#define PROF_THREAD_MAIN    1
+#define PROF_THREAD_BOTS    2
+
+void Prof_Init(void);
+void Prof_Frame(void);
+int Prof_Register(const char *name);
+void Prof_Begin(int name);
+void Prof_End(void);
+void Prof_Record(int name, int thread, int64_t start, int64_t duration);
+
 extern int com_frameTime;
 extern int com_expectedhunkusage;
 extern int com_hunkusedvalue;
@@ -1149,6 +1231,42 @@ void Z_Free(void *ptr);
 void Z_FreeTags(int tag);
 void Z_LogHeap(void);
 
+/**
+ * @enum hunkTag_t
+ * @brief Named sub-arenas of the hunk, used for usage accounting only
+ */
+typedef enum
+{
+	HUNK_TAG_GENERAL = 0,
+	HUNK_TAG_COLLISION,     ///< clipmap (cm_*)
+	HUNK_TAG_RENDERER,      ///< renderer world, models, images
+	HUNK_TAG_BOTLIB,        ///< botlib imports
+	HUNK_TAG_SOUND,         ///< sound loading
+	HUNK_TAG_GAME,          ///< game/cgame/ui VMs
+	HUNK_TAG_MAX
+} hunkTag_t;
+
+hunkTag_t Hunk_SetTag(hunkTag_t tag);
+void Hunk_DumpStats(const char *mapname);
+
+/**
+ * @struct memoryUsage_t
+ * @brief Zone and hunk usage in bytes, see Com_MemoryUsage
+ */
+typedef struct
+{
+	int zoneUsed;
+	int zoneSize;
+	int smallZoneUsed;
+	int smallZoneSize;
+	int hunkUsed;
+	int hunkSize;
+	const char *hunkArenaNames[HUNK_TAG_MAX];
+	int hunkArenaUsed[HUNK_TAG_MAX];        ///< permanent and temp
+} memoryUsage_t;
+
+void Com_MemoryUsage(memoryUsage_t *usage);
+
 void Hunk_Clear(void);
 void Hunk_ClearToMark(void);
 void Hunk_SetMark(void);
@@ -1282,6 +1400,8 @@ void SV_PacketEvent(netadr_t from, msg_t *msg);
 qboolean SV_GameCommand(void);
 int SV_FrameMsec();
 int SV_SendQueuedPackets();
+void SV_GameBotThinkFinish(void);
+void SV_GameBotThinkPoll(void);
 
 // UI interface
 
@@ -1372,6 +1492,7 @@ void Sys_Print(const char *msg);
 // Sys_Milliseconds should only be used for profiling purposes,
 // any game related timing information should come from event timestamps
 int Sys_Milliseconds(void);
+int64_t Sys_Microseconds(void);
 
 int Sys_PID(void);
 qboolean Sys_WritePIDFile(void);
@@ -1411,6 +1532,26 @@ qboolean Sys_LowPhysicalMemory(void);
 
 void Sys_SetEnv(const char *name, const char *value);
 
+typedef void (*sysThreadFunc_t)(void *arg);
+
+#ifdef _MSC_VER
+#define Q_THREAD_LOCAL __declspec(thread)
+#else
+#define Q_THREAD_LOCAL __thread
+#endif
+
+void *Sys_CreateThread(sysThreadFunc_t func, void *arg);
+void Sys_JoinThread(void *thread);
+void Sys_ThreadSleep(int msec);
+void Sys_MemoryBarrier(void);
+
+void *Sys_CreateSignal(void);
+void Sys_DestroySignal(void *signal);
+void Sys_RaiseSignal(void *signal);
+void Sys_WaitSignal(void *signal);
+
+qboolean Com_CatchError(sysThreadFunc_t func, void *arg, int *code, char *message, size_t size);
+
 /**
  * @enum dialogResult_t
  * @brief
@@ -1520,6 +1661,31 @@ void Huff_offsetReceive(node_t *node, int *ch, byte *fin, int *offset, int maxof
 void Huff_offsetTransmit(huff_t *huff, int ch, byte *fout, int *offset, int maxoffset);
 void Huff_putBit(int bit, byte *fout, int *offset);
 int Huff_getBit(byte *fin, int *offset);
+void Huff_putBits(unsigned int value, int nbits, byte *fout, int *offset);
+unsigned int Huff_getBits(byte *fin, int nbits, int *offset);
+
+/**
+ * @def HUFF_LOOKUP_BITS
+ * @brief Number of bits resolved per step by the table driven decoder
+ */
+#define HUFF_LOOKUP_BITS 11
+
+/**
+ * @struct huffTable_t
+ * @brief Flattened form of a huff_t that is no longer updated, like the fixed message tree
+ */
+typedef struct
+{
+	unsigned int code[HMAX + 1];                    ///< prefix code of each symbol, first transmitted bit in bit 0
+	byte length[HMAX + 1];                          ///< code length, 0 if it doesn't fit in code
+	unsigned short lookup[1 << HUFF_LOOKUP_BITS];   ///< (symbol << 4) | length indexed by the next bits, 0 for longer codes
+	node_t *tree;                                   ///< used for codes longer than HUFF_LOOKUP_BITS
+	huff_t *huff;                                   ///< used for codes longer than 32 bits
+} huffTable_t;
+
+void Huff_BuildTable(huffTable_t *table, huff_t *huff);
+void Huff_tableReceive(const huffTable_t *table, int *ch, byte *fin, int *offset, int maxoffset);
+void Huff_tableTransmit(const huffTable_t *table, int ch, byte *fout, int *offset, int maxoffset);
 
 extern huffman_t clientHuffTables;
 
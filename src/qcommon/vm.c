@@ -39,7 +39,8 @@
 #include "vm_local.h"
 #include "../sys/sys_local.h"
 
-vm_t *currentVM = NULL;
+/// per thread, the bot think of the game runs on its own thread, see SV_GameBotThinkStart
+Q_THREAD_LOCAL vm_t *currentVM = NULL;
 vm_t *lastVM    = NULL;
 int  vm_debugLevel;
 
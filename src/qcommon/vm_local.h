@@ -194,7 +194,7 @@ struct vm_s
 	qboolean extract;
 };
 
-extern vm_t *currentVM;
+extern Q_THREAD_LOCAL vm_t *currentVM;
 extern int  vm_debugLevel;
 
 void VM_Compile(vm_t *vm, vmHeader_t *header);
@@ -107,7 +107,10 @@ typedef struct
 	int nextFrameTime;                  ///< when time > nextFrameTime, process world
 	char *configstrings[MAX_CONFIGSTRINGS];
 	qboolean configstringsmodified[MAX_CONFIGSTRINGS];
+	char *configstringsPrev[MAX_CONFIGSTRINGS]; ///< value before the pending update, base of the "csp" splice
 	svEntity_t svEntities[MAX_GENTITIES];
+	byte baselineDelta[MAX_GENTITIES];  ///< how many baselines back the gamestate deltas each baseline from, 0 for none
+	int baselineNullBits;               ///< all baselines delta'd from nothing, for csstats
 
 	char *entityParsePoint;             ///< used during game VM init
 
@@ -167,6 +170,7 @@ typedef struct
 	int messageSent;                    ///< time the message was transmitted
 	int messageAcked;                   ///< time the message was acked
 	int messageSize;                    ///< used to rate drop packets
+	int sharedId;                       ///< shared snapshot the frame was built from, 0 for a culled frame
 } clientSnapshot_t;
 
 /**
@@ -195,6 +199,27 @@ typedef struct netchan_buffer_s
 	struct netchan_buffer_s *next;
 } netchan_buffer_t;
 
+#define SV_PACE_SLACK 1000 ///< usec a paced packet may go early, or be credited for going late
+
+/**
+ * @struct netchanStats_s
+ * @typedef netchanStats_t
+ * @brief Transmit queue counters of a client, printed by netchanstats
+ */
+typedef struct netchanStats_s
+{
+	int messages;                           ///< messages handed to the netchan
+	int fragmented;                         ///< messages sent in fragments
+	int fragments;                          ///< fragments sent by the idle loop, after the first one of a message
+	int queued;                             ///< messages which waited behind unsent fragments
+	int queueDepth;                         ///< messages waiting now
+	int maxQueueDepth;
+	int snapshotsDelayed;                   ///< snapshots skipped as fragments were still pending
+	int paced;                              ///< packets sent by the idle loop, fragments and queued messages
+	int64_t lateUsec;                       ///< total delay of the paced packets past their schedule
+	int maxLateUsec;
+} netchanStats_t;
+
 /**
  * @struct client_s
  * @typedef client_t
@@ -269,6 +294,9 @@ typedef struct client_s
 	// buffer them into this queue, and hand them out to netchan as needed
 	netchan_buffer_t *netchan_start_queue;
 	netchan_buffer_t **netchan_end_queue;
+	unsigned int csChecksum[MAX_CONFIGSTRINGS]; ///< checksums of the configstrings the client holds once its reliable commands are through
+	int64_t nextSendTime;                   ///< Sys_Microseconds() at which the rate lets the next packet go
+	netchanStats_t netchanStats;
 
 	int downloadnotify;
 
@@ -300,6 +328,23 @@ typedef struct
 	float avg;
 } svstats_t;
 
+/**
+ * @struct csStats_t
+ * @brief Bytes of the gamestates and configstring updates, printed by csstats
+ */
+typedef struct
+{
+	int gamestates;
+	int gamestateBytes;
+	int baselineBytes;                          ///< baselines as sent
+	int baselineFullBytes;                      ///< the same baselines delta'd from nothing
+
+	int updates;                                ///< configstring updates sent to a client
+	int splices;                                ///< of which sent as splices
+	int updateBytes;                            ///< command chars sent
+	int updateFullBytes;                        ///< command chars whole updates would have taken
+} csStats_t;
+
 /**
  * @def MAX_CHALLENGES
  * @brief Made large to prevent a DoS attack that could
@@ -385,6 +430,7 @@ typedef struct
 	int currentFrameIndex;
 	int serverLoad;
 	svstats_t stats;
+	csStats_t csStats;
 
 	download_t download;
 } serverStatic_t;
@@ -419,6 +465,7 @@ extern cvar_t *sv_reconnectlimit;
 extern cvar_t *sv_tempbanmessage;
 
 extern cvar_t *sv_padPackets;
+extern cvar_t *sv_sharedSnapshots;
 extern cvar_t *sv_killserver;
 extern cvar_t *sv_mapname;
 extern cvar_t *sv_mapChecksum;
@@ -471,6 +518,24 @@ extern cvar_t *sv_demoState;
 extern cvar_t *sv_autoDemo;
 extern cvar_t *sv_freezeDemo;
 extern cvar_t *sv_demoTolerant;
+extern cvar_t *sv_demoAsync;
+extern cvar_t *sv_demoCompress;
+extern cvar_t *sv_demoKeyframeInterval;
+extern cvar_t *sv_demoUsercmds;
+
+// relay servers
+extern cvar_t *sv_relayPassword;
+extern cvar_t *sv_relayPort;
+extern cvar_t *sv_relayDelay;
+
+extern cvar_t *sv_netFrontend;
+
+extern cvar_t *sv_botThread;
+
+extern cvar_t *sv_metrics;
+extern cvar_t *sv_metricsPort;
+extern cvar_t *sv_metricsFile;
+extern cvar_t *sv_metricsInterval;
 
 extern cvar_t *sv_ipMaxClients; ///< limit client connection
 
@@ -486,10 +551,40 @@ void SV_DemoWriteServerCommand(const char *cmd);
 void SV_DemoWriteGameCommand(int clientNum, const char *cmd);
 void SV_DemoWriteConfigString(int cs_index, const char *cs_string);
 void SV_DemoWriteClientUserinfo(client_t *client, const char *userinfo);
+void SV_DemoWriteClientUsercmd(client_t *cl, usercmd_t *cmd);
 qboolean SV_CheckLastCmd(const char *cmd, qboolean onlyStore);
 void SV_DemoStopAll(void);
 void SV_DemoInit(void);
 void SV_DemoShutdown(void);
+qboolean SV_DemoRelayReady(void);
+void SV_DemoRelayPlay(void);
+void SV_DemoRelayReset(void);
+
+// sv_relay.c
+void SV_RelayInit(void);
+void SV_RelayShutdown(void);
+void SV_RelayFrame(void);
+qboolean SV_RelayWaiting(void);
+void SV_RelayStartStreams(msg_t *header);
+void SV_RelayWriteData(const void *data, unsigned int len);
+void SV_RelayStopStreams(void);
+qboolean SV_RelayConnected(void);
+void SV_RelayDisconnect(const char *reason);
+unsigned int SV_RelayAvailable(void);
+void SV_RelayPeek(unsigned int offset, void *buffer, unsigned int len);
+void SV_RelayConsume(unsigned int offset);
+
+// sv_frontend.c
+void SV_FrontendFrame(void);
+void SV_FrontendShutdown(void);
+void SV_FrontendStats_f(void);
+
+// sv_metrics.c
+void SV_MetricsInit(void);
+void SV_MetricsShutdown(void);
+void SV_MetricsFrame(int64_t frameUsec);
+void SV_MetricsPacket(int bytes);
+void SV_MetricsSent(int bytes, int uncompressedBytes);
 
 // sv_demo_ext.c
 //int SV_GentityGetHealthField(sharedEntity_t *gent);   // Test purpose
@@ -505,6 +600,7 @@ void SV_MasterHeartbeat(const char *msg);
 void SV_MasterShutdown(void);
 void SV_MasterGameCompleteStatus(void);
 int SV_RateMsec(client_t *client);
+void SV_RatePace(client_t *client);
 
 typedef struct leakyBucket_s leakyBucket_t;
 
@@ -535,14 +631,36 @@ struct leakyBucket_s
 #define MAX_BUCKETS         16384
 #define MAX_HASHES          1024
 
+/**
+ * @struct leakyBucketTable_t
+ * @brief Per address buckets, the network front-end thread owns its own
+ */
+typedef struct
+{
+	leakyBucket_t buckets[MAX_BUCKETS];
+	leakyBucket_t *hashes[MAX_HASHES];
+} leakyBucketTable_t;
+
+leakyBucket_t *SVC_BucketForAddress(leakyBucketTable_t *table, netadr_t address, int burst, int period);
+qboolean SVC_BucketFull(leakyBucket_t *bucket, int burst, int period);
 qboolean SVC_RateLimit(leakyBucket_t *bucket, int burst, int period);
 qboolean SVC_RateLimitAddress(netadr_t from, int burst, int period);
 extern leakyBucket_t outboundLeakyBucket;
 
+#define DRDOS_NONE      0   ///< may be answered
+#define DRDOS_FLOOD     1   ///< all receipts used in the last 2 seconds
+#define DRDOS_ADDRESS   2   ///< too many answers to this address
+
+qboolean SV_CheckDRDoS(netadr_t from);
+int SV_CheckReceipts(receipt_t *receipts, netadr_t from, int timeNow);
+void SV_InfoString(char *infostring);
+void SV_StatusPlayers(char *status, unsigned int size);
+
 // sv_init.c
 void SV_SetConfigstringNoUpdate(int index, const char *val);
 void SV_SetConfigstring(int index, const char *val);
 void SV_UpdateConfigStrings(void);
+unsigned int SV_ConfigstringChecksum(const char *s);
 void SV_GetConfigstring(int index, char *buffer, unsigned int bufferSize);
 void SV_SetUserinfo(int index, const char *val);
 void SV_GetUserinfo(int index, char *buffer, unsigned int bufferSize);
@@ -584,6 +702,7 @@ void SV_SendClientMessages(void);
 void SV_SendClientSnapshot(client_t *client);
 void SV_CheckClientUserinfoTimer(void);
 void SV_SendClientIdle(client_t *client);
+void SV_SharedSnapshotStats_f(void);
 
 // sv_game.c
 int SV_NumForGentity(sharedEntity_t *ent);
@@ -601,6 +720,11 @@ void SV_GameSendServerCommand(int clientNum, const char *text);
 
 void SV_GameBinaryMessageReceived(int cno, const char *buf, int buflen, int commandTime);
 
+void SV_GameRunFrame(int levelTime);
+void SV_GameBotThinkStart(int64_t frameStart);
+qboolean SV_GameBotThinkDefer(netadr_t from, msg_t *msg);
+void SV_GameBotThinkStats_f(void);
+
 // sv_bot.c
 int SV_BotAllocateClient(int clientNum);
 void SV_BotFreeClient(int clientNum);
@@ -660,6 +784,9 @@ void SV_Trace(trace_t *results, const vec3_t start, const vec3_t mins, const vec
 
 // passEntityNum is explicitly excluded from clipping checks (normally ENTITYNUM_NONE)
 
+void SV_TraceBatch(trace_t *results, const traceRequest_t *requests, int count);
+// SV_Trace for many traces, the traces close to each other share one SV_AreaEntities
+
 void SV_ClipToEntity(trace_t *trace, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int entityNum, int contentmask, qboolean capsule);
 // clip to a specific entity
 
@@ -324,12 +324,19 @@ void BotImport_FreeZoneMemory(void)
  */
 void *BotImport_HunkAlloc(int size)
 {
+	void      *buf;
+	hunkTag_t oldTag;
+
 	if (Hunk_CheckMark())
 	{
 		Com_Error(ERR_DROP, "SV_Bot_HunkAlloc: Alloc with marks already set");
 	}
 
-	return Hunk_Alloc(size, h_high);
+	oldTag = Hunk_SetTag(HUNK_TAG_BOTLIB);
+	buf    = Hunk_Alloc(size, h_high);
+	Hunk_SetTag(oldTag);
+
+	return buf;
 }
 
 /**
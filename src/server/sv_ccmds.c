@@ -323,7 +323,7 @@ static void SV_MapRestart_f(void)
 	// run a few frames to allow everything to settle
 	for (i = 0; i < GAME_INIT_FRAMES; i++)
 	{
-		VM_Call(gvm, GAME_RUN_FRAME, svs.time);
+		SV_GameRunFrame(svs.time);
 		svs.time += FRAMETIME;
 	}
 
@@ -386,7 +386,7 @@ static void SV_MapRestart_f(void)
 	}
 
 	// run another frame to allow things to look at all the players
-	VM_Call(gvm, GAME_RUN_FRAME, svs.time);
+	SV_GameRunFrame(svs.time);
 	svs.time += FRAMETIME;
 }
 
@@ -516,6 +516,95 @@ static void SV_Status_f(void)
 	Com_Printf("\n");
 }
 
+/**
+ * @brief Prints the transmit queue counters of the clients, "netchanstats reset" clears them
+ */
+static void SV_NetchanStats_f(void)
+{
+	int            i;
+	client_t       *cl;
+	netchanStats_t *st;
+	qboolean       reset = (Cmd_Argc() > 1 && !Q_stricmp(Cmd_Argv(1), "reset"));
+
+	// make sure server is running
+	if (!com_sv_running->integer)
+	{
+		Com_Printf("Server is not running.\n");
+		return;
+	}
+
+	if (!reset)
+	{
+		Com_Printf("num name             rate  messages fragmntd fragments queued maxq delayed late avg/max usec\n");
+		Com_Printf("--- ---------------- ----- -------- -------- --------- ------ ---- ------- -----------------\n");
+	}
+
+	for (i = 0, cl = svs.clients ; i < sv_maxclients->integer ; i++, cl++)
+	{
+		if (cl->state < CS_CONNECTED || cl->demoClient || (cl->gentity && (cl->gentity->r.svFlags & SVF_BOT)))
+		{
+			continue;
+		}
+
+		st = &cl->netchanStats;
+
+		if (reset)
+		{
+			Com_Memset(st, 0, sizeof(*st));
+			continue;
+		}
+
+		Com_Printf("%3i %-16.16s %5i %8i %8i %9i %6i %4i %7i %8i/%-8i\n", i, cl->name, cl->rate, st->messages, st->fragmented,
+		           st->fragments, st->queued, st->maxQueueDepth, st->snapshotsDelayed,
+		           st->paced ? (int)(st->lateUsec / st->paced) : 0, st->maxLateUsec);
+	}
+}
+
+/**
+ * @brief Prints the bytes of the gamestates and configstring updates sent, "csstats reset" clears them
+ */
+static void SV_ConfigstringStats_f(void)
+{
+	csStats_t *st = &svs.csStats;
+	client_t  *cl;
+	int       i, capable = 0, clients = 0;
+
+	// make sure server is running
+	if (!com_sv_running->integer)
+	{
+		Com_Printf("Server is not running.\n");
+		return;
+	}
+
+	if (Cmd_Argc() > 1 && !Q_stricmp(Cmd_Argv(1), "reset"))
+	{
+		Com_Memset(st, 0, sizeof(*st));
+		return;
+	}
+
+	for (i = 0, cl = svs.clients ; i < sv_maxclients->integer ; i++, cl++)
+	{
+		if (cl->state < CS_CONNECTED || cl->demoClient || (cl->gentity && (cl->gentity->r.svFlags & SVF_BOT)))
+		{
+			continue;
+		}
+
+		clients++;
+		if (Com_IsCompatible(&cl->agent, UA_FEATURE_CSDELTA))
+		{
+			capable++;
+		}
+	}
+
+	Com_Printf("clients with configstring deltas: %i of %i\n", capable, clients);
+	Com_Printf("gamestates:          %8i, %i bytes avg\n", st->gamestates, st->gamestates ? st->gamestateBytes / st->gamestates : 0);
+	Com_Printf("  baselines:         %8i bytes, %i without deltas (%.1f%%)\n", st->baselineBytes, st->baselineFullBytes,
+	           st->baselineFullBytes ? 100.f * st->baselineBytes / st->baselineFullBytes : 100.f);
+	Com_Printf("configstring updates:%8i, %i as splices\n", st->updates, st->splices);
+	Com_Printf("  commands:          %8i chars, %i without splices (%.1f%%)\n", st->updateBytes, st->updateFullBytes,
+	           st->updateFullBytes ? 100.f * st->updateBytes / st->updateFullBytes : 100.f);
+}
+
 /**
  * @brief SV_ConSay_f
  */
@@ -717,6 +806,11 @@ void SV_AddOperatorCommands(void)
 	}
 
 	Cmd_AddCommand("uptime", SV_Uptime_f, "Prints uptime info.");
+	Cmd_AddCommand("sharedsnapshots", SV_SharedSnapshotStats_f, "Prints the work saved by the shared spectator snapshots, \"sample\" measures the culled snapshots they replace.");
+	Cmd_AddCommand("netchanstats", SV_NetchanStats_f, "Prints the fragment queue and pacing counters of the clients.");
+	Cmd_AddCommand("csstats", SV_ConfigstringStats_f, "Prints the bytes of the gamestates and configstring updates sent.");
+	Cmd_AddCommand("frontendstats", SV_FrontendStats_f, "Prints the counters of the network front-end thread.");
+	Cmd_AddCommand("botthinkstats", SV_GameBotThinkStats_f, "Prints the frame times with inline and threaded bot think.");
 
 #if defined(FEATURE_IRC_SERVER) && defined(DEDICATED)
 	Cmd_AddCommand("irc_connect", IRC_Connect, "Connects to an IRC server.");
@@ -725,6 +819,7 @@ void SV_AddOperatorCommands(void)
 #endif
 
 	SV_DemoInit();
+	SV_RelayInit();
 }
 
 /**
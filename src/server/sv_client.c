@@ -592,6 +592,12 @@ gotnewcl:
 
 	// check client's engine version
 	Com_ParseUA(&newcl->agent, Info_ValueForKey(userinfo, "etVersion"));
+
+	// and the protocol extensions it understands
+	if (Com_IsCompatible(&newcl->agent, 0x1))
+	{
+		newcl->agent.compatible |= atoi(Info_ValueForKey(userinfo, "etFeatures")) & UA_FEATURES;
+	}
 }
 
 /**
@@ -721,10 +727,11 @@ void SV_DropClient(client_t *drop, const char *reason)
  */
 void SV_SendClientGameState(client_t *client)
 {
-	int           start;
-	entityState_t *base, nullstate;
+	int           start, back, count = 0, baselineBits;
+	entityState_t *base, nullstate, *recent[BASELINE_DELTA_BACKUP];
 	msg_t         msg;
 	byte          msgBuffer[MAX_MSGLEN];
+	qboolean      deltas = Com_IsCompatible(&client->agent, UA_FEATURE_CSDELTA);
 
 	Com_DPrintf( "SV_SendClientGameState() for %s\n", client->name );
 
@@ -767,10 +774,14 @@ void SV_SendClientGameState(client_t *client)
 			MSG_WriteShort(&msg, start);
 			MSG_WriteBigString(&msg, sv.configstrings[start]);
 		}
+
+		// the base of the splices in the following configstring updates
+		client->csChecksum[start] = SV_ConfigstringChecksum(sv.configstrings[start]);
 	}
 
-	// write the baselines
+	// write the baselines, deltas from each other for clients that can read them
 	Com_Memset(&nullstate, 0, sizeof(nullstate));
+	baselineBits = msg.bit;
 	for (start = 0 ; start < MAX_GENTITIES; start++)
 	{
 		base = &sv.svEntities[start].baseline;
@@ -779,9 +790,23 @@ void SV_SendClientGameState(client_t *client)
 			continue;
 		}
 
-		MSG_WriteByte(&msg, svc_baseline);
-		MSG_WriteDeltaEntity(&msg, &nullstate, base, qtrue);
+		back = deltas ? sv.baselineDelta[start] : 0;
+		if (back)
+		{
+			MSG_WriteByte(&msg, svc_baselineDelta);
+			MSG_WriteBits(&msg, back, BASELINE_DELTA_BITS);
+			MSG_WriteDeltaEntity(&msg, recent[(count - back) & (BASELINE_DELTA_BACKUP - 1)], base, qtrue);
+		}
+		else
+		{
+			MSG_WriteByte(&msg, svc_baseline);
+			MSG_WriteDeltaEntity(&msg, &nullstate, base, qtrue);
+		}
+
+		recent[count & (BASELINE_DELTA_BACKUP - 1)] = base;
+		count++;
 	}
+	baselineBits = msg.bit - baselineBits;
 
 	MSG_WriteByte(&msg, svc_EOF);
 
@@ -798,6 +823,11 @@ void SV_SendClientGameState(client_t *client)
 	// debug info
 	Com_DPrintf("Sending %i bytes in gamestate to client: %i\n", msg.cursize, (int) (client - svs.clients));
 
+	svs.csStats.gamestates++;
+	svs.csStats.gamestateBytes    += msg.cursize;
+	svs.csStats.baselineBytes     += baselineBits / 8;
+	svs.csStats.baselineFullBytes += sv.baselineNullBits / 8;
+
 	// deliver this to the client
 	SV_SendMessageToClient(&msg, client);
 }
@@ -1372,7 +1402,7 @@ static qboolean SV_WriteDownloadToClient(client_t *cl, msg_t *msg)
 
 /**
  * @brief Send one round of fragments, or queued messages to all clients that have data pending.
- * @return The shortest time interval for sending next packet to client
+ * @return The shortest time interval for sending next packet to client, only clients with data pending count
  */
 int SV_SendQueuedMessages(void)
 {
@@ -1383,7 +1413,7 @@ int SV_SendQueuedMessages(void)
 	{
 		cl = &svs.clients[i];
 
-		if (cl->state)
+		if (cl->state && (cl->netchan.unsentFragments || cl->netchan_start_queue))
 		{
 			nextFragT = SV_RateMsec(cl);
 
@@ -1980,6 +2010,11 @@ void SV_ClientThink(client_t *cl, usercmd_t *cmd)
 		return;     // may have been kicked during the last usercmd
 	}
 
+	if (sv.demoState == DS_RECORDING)
+	{
+		SV_DemoWriteClientUsercmd(cl, cmd);
+	}
+
 	VM_Call(gvm, GAME_CLIENT_THINK, cl - svs.clients);
 }
 
@@ -61,8 +61,8 @@ typedef enum
 	demo_entityState, // gentity_t->entityState_t management
 	demo_entityShared, // gentity_t->entityShared_t management
 	demo_playerState, // players game state event (playerState_t management)
-
-	//demo_clientUsercmd, // players commands/movements packets (usercmd_t management)
+	demo_keyframe, // full configstrings/clients snapshot, the entities and players of the frame following it are delta'd from zero so playback can start there
+	demo_clientUsercmd, // players commands/movements executed during the frame (usercmd_t management), only recorded with sv_demoUsercmds
 } demo_ops_e;
 
 /*** STATIC VARIABLES ***/
@@ -89,8 +89,91 @@ static char *savedFsGame              = savedFsGameVal;
 static char savedPlaybackDemonameVal[MAX_QPATH] = "";
 static char *savedPlaybackDemoname              = savedPlaybackDemonameVal;
 
+#define MAX_DEMO_USERCMDS 32 ///< usercmds buffered per client before they are written in a message of their own
+
+// Usercmds executed by every client since the last demo frame
+static usercmd_t demoUsercmds[MAX_CLIENTS][MAX_DEMO_USERCMDS];
+static int       demoNumUsercmds[MAX_CLIENTS];
+
 static qboolean keepSaved = qfalse; // var that memorizes if we keep the new maxclients and democlients values (in the case that we restart the map/server for these cvars to be affected since they are latched, we need to stop the playback meanwhile we restart, and using this var we can know if the stop is a restart procedure or a real demo end) or if we can restore them (at the end of the demo)
 
+/*** ASYNCHRONOUS WRITER ***/
+
+#define DEMO_QUEUE_SIZE      0x1000000                ///< 16 MB, must be a power of two and larger than buf
+#define DEMO_QUEUE_MASK      (DEMO_QUEUE_SIZE - 1)
+#define DEMO_QUEUE_FRAME_MIN 0x10000                  ///< minimum free space a frame needs before it is recorded at all
+
+/**
+ * @struct demoQueue_s
+ * @brief Lock-free single producer / single consumer ring buffer between the server frame and the demo writer thread
+ *
+ * @note head is only advanced by the server thread and tail only by the writer thread,
+ * both are running byte counts which are masked on access and may wrap around
+ */
+typedef struct demoQueue_s
+{
+	byte *data;
+	void *thread;                       ///< NULL when writing synchronously
+	void *wake;                         ///< raised when the writer has data to write or has to quit
+	void *space;                        ///< raised when the writer made room in the queue
+	fileHandle_t file;
+
+	volatile unsigned int head;
+	volatile unsigned int tail;
+	volatile qboolean quit;
+	volatile qboolean failed;           ///< set by the writer thread, reported by the server thread
+	qboolean failReported;
+
+	volatile unsigned int bytesWritten; ///< updated by the writer thread (or inline when synchronous)
+	unsigned int maxDepth;              ///< high-water mark of queued bytes
+	unsigned int maxFrameSize;          ///< largest encoded frame so far, used to decide whether the next one fits
+	int droppedFrames;                  ///< frames skipped because the queue was too full to take them
+	int stalls;                         ///< messages that had to wait for the writer to make room
+	int stallMsec;
+	unsigned int offset;                ///< file offset of the next message (bytes handed over so far)
+} demoQueue_t;
+
+static demoQueue_t demoQueue;
+
+/*** KEYFRAME INDEX ***/
+
+#define MAX_DEMO_KEYFRAMES 4096
+#define DEMO_INDEX_MAGIC   0x49445653 ///< "SVDI", last 4 bytes of a demo carrying a keyframe index
+
+/**
+ * @struct demoKeyframe_s
+ * @brief Server time of a keyframe and the file offset of its demo_keyframe message
+ */
+typedef struct demoKeyframe_s
+{
+	int time;
+	int offset;
+} demoKeyframe_t;
+
+static demoKeyframe_t demoKeyframes[MAX_DEMO_KEYFRAMES]; // filled while recording, loaded from the trailing index when playing
+static int            demoNumKeyframes;
+static int            demoNextKeyframe;                  // recording: server time of the next keyframe
+
+static int      demoStartTime;  // playback: server time at which the demo was recorded
+static int      demoFrameTime;  // playback: demo time of the last frame read
+static int      demoTimeShift;  // playback: added to demo time so svs.time never goes backward after a rewind
+static qboolean demoSeeking;    // playback: frames are being read back to back to reach a seek target
+
+/*** RELAY STREAM ***/
+
+#define MAX_DEMO_HEADER 4096
+
+static qboolean     demoRelay;                   // playback: reading the stream of a relayed game server instead of sv.demoFile
+static unsigned int demoRelayRead;               // stream offset of the next message to play
+static unsigned int demoRelayScan;               // stream offset of the next message to scan
+static int          demoRelayFrames;             // complete frames between read and scan
+static qboolean     demoRelayEnded;              // demo_endDemo scanned, the next header is scanned once it is played
+static byte         demoRelayHeader[MAX_DEMO_HEADER];
+static int          demoRelayHeaderLen;          // 0 until the header of the stream has been scanned
+static qboolean     demoRelayKeyframeValid;
+static unsigned int demoRelayKeyframe;           // stream offset of the last keyframe scanned, playback (re)starts there
+static int          demoRelayKeyframeFrames;     // complete frames after it
+
 /**
  * @brief Restores all CVARs
  */
@@ -415,6 +498,237 @@ static char *SV_GenerateDateTime(void)
 * Functions used to construct and write demo events
 ***********************************************/
 
+/**
+ * @brief Free space in the demo queue as seen by the server thread
+ * @return
+ */
+static unsigned int SV_DemoQueueFree(void)
+{
+	unsigned int tail = demoQueue.tail;
+
+	Sys_MemoryBarrier();
+	return DEMO_QUEUE_SIZE - (demoQueue.head - tail);
+}
+
+/**
+ * @brief Copy data into the demo queue at the given running offset, wrapping around the end of the ring
+ * @param[in] offset
+ * @param[in] data
+ * @param[in] len
+ */
+static void SV_DemoQueueCopy(unsigned int offset, const void *data, unsigned int len)
+{
+	unsigned int pos   = offset & DEMO_QUEUE_MASK;
+	unsigned int first = DEMO_QUEUE_SIZE - pos;
+
+	if (first >= len)
+	{
+		Com_Memcpy(demoQueue.data + pos, data, len);
+	}
+	else
+	{
+		Com_Memcpy(demoQueue.data + pos, data, first);
+		Com_Memcpy(demoQueue.data, (const byte *)data + first, len - first);
+	}
+}
+
+/**
+ * @brief Demo writer thread, drains the queue into the demo file until asked to quit
+ * @param arg - unused
+ *
+ * @note The file is only synced to disk once the queue is drained at the end of the recording.
+ * Com_Printf and Com_Error belong to the server thread, a write error only sets demoQueue.failed.
+ */
+static void SV_DemoWriterThread(void *arg)
+{
+	unsigned int head, tail, pos, len;
+	qboolean     quit;
+
+	while (1)
+	{
+		quit = demoQueue.quit;
+		Sys_MemoryBarrier();
+		head = demoQueue.head;
+		tail = demoQueue.tail;
+
+		if (head == tail)
+		{
+			if (quit)
+			{
+				break;
+			}
+
+			Sys_WaitSignal(demoQueue.wake);
+			continue;
+		}
+
+		// write up to the end of the ring, the rest goes in the next pass
+		pos = tail & DEMO_QUEUE_MASK;
+		len = MIN(head - tail, DEMO_QUEUE_SIZE - pos);
+
+		// after an error the queue is still drained, the server thread must not stall on it
+		if (!demoQueue.failed)
+		{
+			if (FS_ThreadWrite(demoQueue.data + pos, len, demoQueue.file))
+			{
+				demoQueue.bytesWritten += len;
+			}
+			else
+			{
+				demoQueue.failed = qtrue;
+			}
+		}
+
+		Sys_MemoryBarrier();
+		demoQueue.tail = tail + len;
+		Sys_RaiseSignal(demoQueue.space);
+	}
+
+	if (!demoQueue.failed && !FS_ThreadSync(demoQueue.file))
+	{
+		demoQueue.failed = qtrue;
+	}
+}
+
+/**
+ * @brief Print a write error of the writer thread once
+ */
+static void SV_DemoQueueCheck(void)
+{
+	if (demoQueue.failed && !demoQueue.failReported)
+	{
+		demoQueue.failReported = qtrue;
+		Com_Printf("DEMO: ERROR: Couldn't write %s, the rest of the recording is lost.\n", sv.demoName);
+	}
+}
+
+/**
+ * @brief Prepare the demo queue for a new recording and start the writer thread
+ * @details Falls back to synchronous writes when sv_demoAsync is off or no thread can be started
+ */
+static void SV_DemoQueueStart(void)
+{
+	Com_Memset(&demoQueue, 0, sizeof(demoQueue));
+	demoQueue.file = sv.demoFile;
+
+	if (!sv_demoAsync->integer)
+	{
+		return;
+	}
+
+	demoQueue.data = Com_Allocate(DEMO_QUEUE_SIZE);
+	if (!demoQueue.data)
+	{
+		Com_Printf("DEMO: WARNING: Couldn't allocate the demo queue, writing synchronously.\n");
+		return;
+	}
+
+	demoQueue.wake  = Sys_CreateSignal();
+	demoQueue.space = Sys_CreateSignal();
+	if (demoQueue.wake && demoQueue.space)
+	{
+		demoQueue.thread = Sys_CreateThread(SV_DemoWriterThread, NULL);
+	}
+
+	if (!demoQueue.thread)
+	{
+		Com_Printf("DEMO: WARNING: Couldn't start the demo writer thread, writing synchronously.\n");
+		Sys_DestroySignal(demoQueue.wake);
+		Sys_DestroySignal(demoQueue.space);
+		demoQueue.wake  = NULL;
+		demoQueue.space = NULL;
+		Com_Dealloc(demoQueue.data);
+		demoQueue.data = NULL;
+	}
+}
+
+/**
+ * @brief Wait for the writer thread to drain the queue and sync the file, then release the queue
+ */
+static void SV_DemoQueueStop(void)
+{
+	if (demoQueue.thread)
+	{
+		Sys_MemoryBarrier();
+		demoQueue.quit = qtrue;
+		Sys_RaiseSignal(demoQueue.wake);
+		Sys_JoinThread(demoQueue.thread);
+		demoQueue.thread = NULL;
+
+		Sys_DestroySignal(demoQueue.wake);
+		Sys_DestroySignal(demoQueue.space);
+		demoQueue.wake  = NULL;
+		demoQueue.space = NULL;
+		Com_Dealloc(demoQueue.data);
+		demoQueue.data = NULL;
+
+		SV_DemoQueueCheck();
+	}
+	else
+	{
+		FS_Sync(demoQueue.file);
+	}
+}
+
+/**
+ * @brief Write raw data to the demo file
+ * @param[in] data
+ * @param[in] len
+ *
+ * @details When the writer thread is running the data is only queued,
+ * if the queue is full we wait for the writer as an event can't be dropped without breaking the demo.
+ * The streaming relays get the data as well.
+ */
+static void SV_DemoWriteData(const void *data, unsigned int len)
+{
+	unsigned int depth, head;
+
+	demoQueue.offset += len;
+
+	SV_RelayWriteData(data, len);
+
+	if (!demoQueue.thread)
+	{
+		(void) FS_Write(data, len, sv.demoFile);
+		demoQueue.bytesWritten += len;
+		return;
+	}
+
+	SV_DemoQueueCheck();
+
+	if (SV_DemoQueueFree() < len)
+	{
+		int start = Sys_Milliseconds();
+
+		demoQueue.stalls++;
+		while (SV_DemoQueueFree() < len)
+		{
+			Sys_WaitSignal(demoQueue.space);
+		}
+		demoQueue.stallMsec += Sys_Milliseconds() - start;
+	}
+
+	head = demoQueue.head;
+	SV_DemoQueueCopy(head, data, len);
+
+	// publish the data only once it is complete
+	Sys_MemoryBarrier();
+	demoQueue.head = head + len;
+
+	// the writer had drained the queue, it may be waiting for this
+	Sys_MemoryBarrier();
+	if (demoQueue.tail == head)
+	{
+		Sys_RaiseSignal(demoQueue.wake);
+	}
+
+	depth = demoQueue.head - demoQueue.tail;
+	if (depth > demoQueue.maxDepth)
+	{
+		demoQueue.maxDepth = depth;
+	}
+}
+
 /**
  * @brief Write a message/event to the demo file
  * @param[in,out] msg
@@ -426,11 +740,49 @@ static void SV_DemoWriteMessage(msg_t *msg)
 	// Write the entire message to the file, prefixed by the length
 	MSG_WriteByte(msg, demo_EOF); // append EOF (end-of-file or rather end-of-flux) to the message so that it will tell the demo parser when the demo will be read that the message ends here, and that it can proceed to the next message
 	len = LittleLong(msg->cursize);
-	(void) FS_Write(&len, 4, sv.demoFile);
-	(void) FS_Write(msg->data, msg->cursize, sv.demoFile);
+	SV_DemoWriteData(&len, 4);
+	SV_DemoWriteData(msg->data, msg->cursize);
 	MSG_Clear(msg);
 }
 
+/**
+ * @brief Write the demo header: the meta datas needed to replay the demo
+ * @param[in,out] msg
+ */
+static void SV_DemoWriteHeader(msg_t *msg)
+{
+	// Write number of clients (sv_maxclients < MAX_CLIENTS or else we can't playback)
+	MSG_WriteString(msg, "clients"); // for each demo meta data (infos about the demo), we prepend the name of the var (this allows for fault tolerance and retrocompatibility) - FIXME? We could also use MSG_LookaheadByte() to read a byte, instead of a string, this would save a tiny bit of storage space
+	MSG_WriteByte(msg, sv_maxclients->integer);
+	// Write current server in-game time
+	MSG_WriteString(msg, "time");
+	MSG_WriteLong(msg, svs.time);
+	// Write sv_fps
+	MSG_WriteString(msg, "sv_fps");
+	MSG_WriteLong(msg, sv_fps->integer);
+	// Write g_gametype
+	MSG_WriteString(msg, "g_gametype");
+	MSG_WriteLong(msg, sv_gametype->integer);
+	// Write fs_game (mod name)
+	MSG_WriteString(msg, "fs_game");
+	MSG_WriteString(msg, Cvar_VariableString("fs_game"));
+	// Write map name
+	MSG_WriteString(msg, "map");
+	MSG_WriteString(msg, sv_mapname->string);
+	// Write timelimit
+	MSG_WriteString(msg, "timelimit");
+	MSG_WriteLong(msg, Cvar_VariableIntegerValue("timelimit"));
+	// Write sv_hostname (only for info)
+	MSG_WriteString(msg, "hostname");
+	MSG_WriteString(msg, sv_hostname->string);
+	// Write current datetime (only for info)
+	MSG_WriteString(msg, "datetime");
+	MSG_WriteString(msg, SV_GenerateDateTime());
+
+	// Write end of meta datas (since we will read a string each loop, we need to set a special string to specify the reader that we end the loop, we cannot use a marker because it's a byte)
+	MSG_WriteString(msg, "endMeta");
+}
+
 /**
  * @brief Write a client command to the demo file
  * @param[in] client
@@ -610,50 +962,70 @@ void SV_DemoWriteClientUserinfo(client_t *client, const char *userinfo)
 	SV_DemoWriteMessage(&msg); // commit this demo event in the demo file
 }
 
-/*
- * @brief Write a client usercmd_t for the current packet (called from sv_client.c SV_UserMove) which contains the movements commands for the player
+/**
+ * @brief Write the usercmds a client executed since they were last written
  *
- * @param[in] cl
- * @param[in] delta
- * @param[in] cmdCount
- * @param[in] cmds
- * @param[in] key
+ * @details Every message starts over from a null usercmd, so each of them can be decoded on its own
+ *
+ * @param[in] clientNum
+ */
+static void SV_DemoWriteClientUsercmds(int clientNum)
+{
+	msg_t     msg;
+	usercmd_t nullcmd;
+	usercmd_t *oldcmd;
+	int       i;
+
+	if (!demoNumUsercmds[clientNum])
+	{
+		return;
+	}
+
+	MSG_Init(&msg, buf, sizeof(buf));
+	MSG_WriteByte(&msg, demo_clientUsercmd);
+	MSG_WriteByte(&msg, clientNum);
+	MSG_WriteByte(&msg, demoNumUsercmds[clientNum]);
+
+	Com_Memset(&nullcmd, 0, sizeof(nullcmd));
+	oldcmd = &nullcmd;
+	for (i = 0; i < demoNumUsercmds[clientNum]; i++)
+	{
+		MSG_WriteDeltaUsercmdKey(&msg, 0, oldcmd, &demoUsercmds[clientNum][i]);
+		oldcmd = &demoUsercmds[clientNum][i];
+	}
+
+	SV_DemoWriteMessage(&msg);
+	demoNumUsercmds[clientNum] = 0;
+}
+
+/**
+ * @brief Record a usercmd executed by a client (called from sv_client.c SV_ClientThink)
+ *
+ * @details The usercmds are not needed to play the demo back, entities and playerstates are,
+ * but they let tools replay the player movements (see etlpmove).
+ * They are buffered and written with the frame, before the playerstates they lead to.
  *
- * @note Note: this is unnecessary to make players move, this is handled by entities management.
- * This is only used to add more data to the dama for data analysis AND avoid inactivity timer activation
+ * @param[in] cl
+ * @param[in] cmd
  *
- * @note Enabling this feature will use a LOT more storage space, so enable it only if you will really use it.
- * Generally, you're probably better off leaving it disabled.
-void SV_DemoWriteClientUsercmd( client_t *cl, qboolean delta, int cmdCount, usercmd_t *cmds, int key )
-{
-    msg_t msg;
-    usercmd_t nullcmd;
-    usercmd_t *cmd, *oldcmd;
-    int i;
-
-    //Com_Printf("DebugGBOWriteusercmd: %i\n", cl - svs.clients);
-
-    MSG_Init(&msg, buf, sizeof(buf));
-    MSG_WriteByte(&msg, demo_clientUsercmd);
-    MSG_WriteByte(&msg, cl - svs.clients);
-    if (delta)
-    MSG_WriteByte(&msg, 1);
-    else
-    MSG_WriteByte(&msg, 0);
-    MSG_WriteByte(&msg, cmdCount);
-
-    Com_Memset( &nullcmd, 0, sizeof(nullcmd) );
-    oldcmd = &nullcmd;
-    for ( i = 0 ; i < cmdCount ; i++ )
-    {
-        cmd = &cmds[i];
-        MSG_WriteDeltaUsercmdKey( &msg, key, oldcmd, cmd );
-        oldcmd = cmd;
-    }
-
-    SV_DemoWriteMessage(&msg);
+ * @note This uses a lot more storage space, so it's only done with sv_demoUsercmds enabled.
+ */
+void SV_DemoWriteClientUsercmd(client_t *cl, usercmd_t *cmd)
+{
+	int clientNum = cl - svs.clients;
+
+	if (!sv_demoUsercmds->integer)
+	{
+		return;
+	}
+
+	demoUsercmds[clientNum][demoNumUsercmds[clientNum]++] = *cmd;
+
+	if (demoNumUsercmds[clientNum] == MAX_DEMO_USERCMDS)
+	{
+		SV_DemoWriteClientUsercmds(clientNum);
+	}
 }
-*/
 
 /**
  * @brief Write all active clients playerState (playerState_t)
@@ -765,6 +1137,74 @@ static void SV_DemoWriteAllEntityShared(void)
 	SV_DemoWriteMessage(&msg);
 }
 
+/**
+ * @brief Write a keyframe: all configstrings and clients at once, and reset the delta baselines so the following frame is complete
+ *
+ * @details The keyframe time and file offset are added to the index written at the end of the demo,
+ * seeking jumps to the nearest keyframe and replays the frames from there. Relays start playing at a keyframe too.
+ */
+static void SV_DemoWriteKeyframe(void)
+{
+	msg_t msg;
+	char  userinfo[MAX_STRING_CHARS];
+	byte  header[MAX_DEMO_HEADER];
+	int   i;
+
+	// Waiting relays start their stream here, with a header of their own
+	if (SV_RelayWaiting())
+	{
+		MSG_Init(&msg, header, sizeof(header));
+		SV_DemoWriteHeader(&msg);
+		MSG_WriteByte(&msg, demo_EOF);
+		SV_RelayStartStreams(&msg);
+	}
+
+	if (demoNumKeyframes < MAX_DEMO_KEYFRAMES)
+	{
+		demoKeyframes[demoNumKeyframes].time   = svs.time;
+		demoKeyframes[demoNumKeyframes].offset = demoQueue.offset;
+		demoNumKeyframes++;
+	}
+
+	MSG_Init(&msg, buf, sizeof(buf));
+	MSG_WriteByte(&msg, demo_keyframe);
+	MSG_WriteLong(&msg, svs.time);
+	MSG_WriteByte(&msg, sv_maxclients->integer);
+
+	// Write the configstrings which are set (the player ones go with the clients below), system ones are left out as in SV_CheckConfigString()
+	for (i = CS_MOTD; i < MAX_CONFIGSTRINGS; i++)
+	{
+		if ((i >= CS_PLAYERS && i < CS_PLAYERS + sv_maxclients->integer) || !sv.configstrings[i][0])
+		{
+			continue;
+		}
+
+		MSG_WriteShort(&msg, i);
+		MSG_WriteString(&msg, sv.configstrings[i]);
+	}
+	MSG_WriteShort(&msg, -1);
+
+	// Write every client slot, empty strings tell the player the slot is free
+	for (i = 0; i < sv_maxclients->integer; i++)
+	{
+		userinfo[0] = '\0';
+		if (svs.clients[i].state >= CS_CONNECTED && svs.clients[i].userinfo[0])
+		{
+			Q_strncpyz(userinfo, svs.clients[i].userinfo, sizeof(userinfo));
+			SV_DemoFilterClientUserinfo(userinfo);
+		}
+
+		MSG_WriteString(&msg, sv.configstrings[CS_PLAYERS + i]);
+		MSG_WriteString(&msg, userinfo);
+	}
+
+	SV_DemoWriteMessage(&msg);
+
+	// Delta the next frame from nothing
+	Com_Memset(sv.demoEntities, 0, sizeof(sv.demoEntities));
+	Com_Memset(sv.demoPlayerStates, 0, sizeof(sv.demoPlayerStates));
+}
+
 /**
  * @brief Record all the entities (gentities fields) and players (player_t fields) at the end of every frame (this is the only write function to be called in every frame for sure)
  *
@@ -775,7 +1215,25 @@ static void SV_DemoWriteAllEntityShared(void)
  */
 void SV_DemoWriteFrame(void)
 {
-	msg_t msg;
+	msg_t        msg;
+	unsigned int start = demoQueue.head;
+	int          i;
+
+	// Skip the whole frame rather than stall the server when the writer can't keep up,
+	// the deltas of the next frame are still made against the last recorded one so the demo stays consistent
+	if (demoQueue.thread && SV_DemoQueueFree() < MAX(DEMO_QUEUE_FRAME_MIN, 2 * demoQueue.maxFrameSize))
+	{
+		demoQueue.droppedFrames++;
+		Com_Memset(demoNumUsercmds, 0, sizeof(demoNumUsercmds));
+		return;
+	}
+
+	// STEP0: periodically make this frame a keyframe, or right away when a relay waits for one
+	if ((sv_demoKeyframeInterval->integer > 0 && svs.time >= demoNextKeyframe) || SV_RelayWaiting())
+	{
+		SV_DemoWriteKeyframe();
+		demoNextKeyframe = svs.time + sv_demoKeyframeInterval->integer * 1000;
+	}
 
 	// STEP1: write all entities states at the end of the frame
 
@@ -785,6 +1243,12 @@ void SV_DemoWriteFrame(void)
 	// Write entities (gentity_t->entityShared_t or concretely sv.gentities[num].r, in gamecode level. instead of sv.)
 	SV_DemoWriteAllEntityShared();
 
+	// Write clients usercmds (usercmd_t), ahead of the playerstates they lead to
+	for (i = 0; i < sv_maxclients->integer; i++)
+	{
+		SV_DemoWriteClientUsercmds(i);
+	}
+
 	// Write clients playerState (playerState_t)
 	SV_DemoWriteAllPlayerState();
 
@@ -802,40 +1266,177 @@ void SV_DemoWriteFrame(void)
 
 	// Commit data to the demo file
 	SV_DemoWriteMessage(&msg);
+
+	if (demoQueue.head - start > demoQueue.maxFrameSize)
+	{
+		demoQueue.maxFrameSize = demoQueue.head - start;
+	}
 }
 
 /***********************************************
-* DEMO MANAGEMENT FUNCTIONS
-* Functions to start/stop the recording/playback of a demo file
+* RELAY STREAM FUNCTIONS
+* A relayed game server streams its recording, the messages are scanned as they arrive
+* and the playback only reads complete frames
 ***********************************************/
 
 /**
- * @brief Generates a meaningful demo filename and automatically starts the demo recording.
- *
- * @details This function is used in conjunction with the variable sv_autoDemo 1
- *
- * @note Be careful, if the hostname contains bad characters, the demo may not be able to be saved at all!
- * There's a small filtering in place but a bad filename may pass through!
- *
- * @note this function is called at MapRestart and SpawnServer (called in Map func),
- * but in no way it's called right at the time it's set.
+ * @brief Scan the relay stream for complete frames
  */
-void SV_DemoAutoDemoRecord(void)
+static void SV_DemoRelayScan(void)
 {
-	qtime_t now;
-	char    demoname[MAX_QPATH];
-
-	Com_Memset(demoname, 0, MAX_QPATH);
+	unsigned int available = SV_RelayAvailable();
+	byte         data[64];
+	msg_t        msg;
+	int          len;
 
-	// break if a demo is already being recorded
-	// this should not happen, this is a failsafe but if it's used it means there are redundant calls that we can maybe remove
-	if (sv.demoState == DS_RECORDING)
+	while (!demoRelayEnded && available - demoRelayScan >= 4)
 	{
-		Com_Printf("SV_DemoAutoDemoRecord: already recording a demo!\n");
-		return;
-	}
+		SV_RelayPeek(demoRelayScan, &len, 4);
+		len = LittleLong(len);
 
-	Com_RealTime(&now);
+		if (len <= 0 || len > (int)sizeof(buf) || (!demoRelayHeaderLen && len > MAX_DEMO_HEADER))
+		{
+			SV_RelayDisconnect("corrupted stream");
+			return;
+		}
+
+		if (available - demoRelayScan - 4 < (unsigned int)len)
+		{
+			return;
+		}
+
+		// The first message of a stream is its header, kept aside as the playback may restart the map before using it
+		if (!demoRelayHeaderLen)
+		{
+			SV_RelayPeek(demoRelayScan + 4, demoRelayHeader, len);
+			demoRelayHeaderLen = len;
+			demoRelayScan     += 4 + len;
+			demoRelayRead      = demoRelayScan;
+			demoRelayFrames    = 0;
+			SV_RelayConsume(demoRelayRead);
+			continue;
+		}
+
+		// Every message starts with its marker, a few bytes are enough to decode it
+		MSG_Init(&msg, data, sizeof(data));
+		msg.cursize = MIN(len, (int)sizeof(data));
+		SV_RelayPeek(demoRelayScan + 4, data, msg.cursize);
+
+		switch (MSG_ReadByte(&msg))
+		{
+		case demo_keyframe:
+			demoRelayKeyframeValid  = qtrue;
+			demoRelayKeyframe       = demoRelayScan;
+			demoRelayKeyframeFrames = 0;
+			break;
+		case demo_endDemo:
+			// the next header is scanned once the end of this recording has been played
+			demoRelayEnded = qtrue;
+			demoRelayFrames++;
+			demoRelayKeyframeFrames++;
+			break;
+		case demo_endFrame:
+			demoRelayFrames++;
+			demoRelayKeyframeFrames++;
+			break;
+		default:
+			break;
+		}
+
+		demoRelayScan += 4 + len;
+	}
+}
+
+/**
+ * @brief Reset the relay stream at the end of a recording, the next message is a header
+ */
+static void SV_DemoRelayRestart(void)
+{
+	demoRelayRead          = demoRelayScan;
+	demoRelayFrames        = 0;
+	demoRelayEnded         = qfalse;
+	demoRelayHeaderLen     = 0;
+	demoRelayKeyframeValid = qfalse;
+	SV_RelayConsume(demoRelayRead);
+}
+
+/**
+ * @brief Whether the relay stream can be played, while it isn't the data before its last keyframe is dropped
+ * @return
+ */
+qboolean SV_DemoRelayReady(void)
+{
+	SV_DemoRelayScan();
+
+	if (demoRelayKeyframeValid && (int)(demoRelayKeyframe - demoRelayRead) > 0)
+	{
+		demoRelayRead   = demoRelayKeyframe;
+		demoRelayFrames = demoRelayKeyframeFrames;
+		SV_RelayConsume(demoRelayRead);
+	}
+	else if (demoRelayEnded && (!demoRelayKeyframeValid || demoRelayKeyframe != demoRelayRead))
+	{
+		// the recording ended without a keyframe to start from
+		SV_DemoRelayRestart();
+		SV_DemoRelayScan();
+	}
+
+	return demoRelayHeaderLen && demoRelayKeyframeValid && demoRelayKeyframe == demoRelayRead && demoRelayFrames > 0;
+}
+
+/**
+ * @brief Read from the demo file, or from the relay stream
+ * @param[out] buffer
+ * @param[in] len
+ * @return Bytes read
+ *
+ * @note The relay stream is only read up to the frames scanned, so there is no short read.
+ */
+static int SV_DemoRead(void *buffer, int len)
+{
+	if (demoRelay)
+	{
+		SV_RelayPeek(demoRelayRead, buffer, len);
+		demoRelayRead += len;
+		SV_RelayConsume(demoRelayRead);
+		return len;
+	}
+
+	return FS_Read(buffer, len, sv.demoFile);
+}
+
+/***********************************************
+* DEMO MANAGEMENT FUNCTIONS
+* Functions to start/stop the recording/playback of a demo file
+***********************************************/
+
+/**
+ * @brief Generates a meaningful demo filename and automatically starts the demo recording.
+ *
+ * @details This function is used in conjunction with the variable sv_autoDemo 1
+ *
+ * @note Be careful, if the hostname contains bad characters, the demo may not be able to be saved at all!
+ * There's a small filtering in place but a bad filename may pass through!
+ *
+ * @note this function is called at MapRestart and SpawnServer (called in Map func),
+ * but in no way it's called right at the time it's set.
+ */
+void SV_DemoAutoDemoRecord(void)
+{
+	qtime_t now;
+	char    demoname[MAX_QPATH];
+
+	Com_Memset(demoname, 0, MAX_QPATH);
+
+	// break if a demo is already being recorded
+	// this should not happen, this is a failsafe but if it's used it means there are redundant calls that we can maybe remove
+	if (sv.demoState == DS_RECORDING)
+	{
+		Com_Printf("SV_DemoAutoDemoRecord: already recording a demo!\n");
+		return;
+	}
+
+	Com_RealTime(&now);
 	Q_strncpyz(demoname, va("%s_%04d-%02d-%02d-%02d-%02d-%02d_%s",
 	                        SV_CleanFilename(va("%s", sv_hostname->string)),
 	                        1900 + now.tm_year,
@@ -874,7 +1475,11 @@ static void SV_DemoStopPlayback(void)
 	}
 	
 	// Close demo file after playback
-	FS_FCloseFile(sv.demoFile);
+	if (!demoRelay)
+	{
+		FS_FCloseFile(sv.demoFile);
+	}
+	demoRelay    = qfalse;
 	sv.demoState = DS_NONE;
 	Cvar_SetValue("sv_demoState", DS_NONE);
 	Com_Printf("DEMO: End of demo. Stopped playing demo %s.\n", sv.demoName);
@@ -940,6 +1545,54 @@ void SV_DemoRestartPlayback(void)
 	return;
 }
 
+/**
+ * @brief Load the keyframe index appended to the demo by SV_DemoStopRecord()
+ * @details Without an index (older demos, or keyframes disabled when recording) the demo can only be fast-forwarded.
+ */
+static void SV_DemoLoadIndex(void)
+{
+	int pos, end, count, i;
+	int data[2];
+
+	demoNumKeyframes = 0;
+
+	pos = FS_FTell(sv.demoFile);
+	FS_Seek(sv.demoFile, -(long)sizeof(data), FS_SEEK_END);
+	end = FS_FTell(sv.demoFile) + sizeof(data);
+
+	if (FS_Read(data, sizeof(data), sv.demoFile) == sizeof(data) && LittleLong(data[1]) == DEMO_INDEX_MAGIC)
+	{
+		count = LittleLong(data[0]);
+
+		if (count > 0 && count <= MAX_DEMO_KEYFRAMES && count * (int)sizeof(data) + (int)sizeof(data) <= end)
+		{
+			FS_Seek(sv.demoFile, end - (count + 1) * sizeof(data), FS_SEEK_SET);
+
+			for (i = 0; i < count; i++)
+			{
+				if (FS_Read(data, sizeof(data), sv.demoFile) != sizeof(data))
+				{
+					break;
+				}
+				demoKeyframes[i].time   = LittleLong(data[0]);
+				demoKeyframes[i].offset = LittleLong(data[1]);
+			}
+			demoNumKeyframes = i;
+		}
+	}
+
+	FS_Seek(sv.demoFile, pos, FS_SEEK_SET);
+
+	if (demoNumKeyframes)
+	{
+		Com_Printf("DEMO: %i keyframes, demo_seek and demo_rewind are available.\n", demoNumKeyframes);
+	}
+	else
+	{
+		Com_Printf("DEMO: No keyframe index, demo_seek can only go forward.\n");
+	}
+}
+
 /**
  * @brief Start the playback of a demo
  *
@@ -966,30 +1619,41 @@ static void SV_DemoStartPlayback(void)
 	Com_Memset(hostname, 0, MAX_NAME_LENGTH);
 	Com_Memset(datetime, 0, 1024);
 
+	demoTimeShift = 0;
+	demoSeeking   = qfalse;
+
 	// Initialize the demo message buffer
 	MSG_Init(&msg, buf, sizeof(buf));
 
 	// Get the demo header
-	r = FS_Read(&msg.cursize, 4, sv.demoFile);
-	if (r != 4)
+	if (demoRelay)
 	{
-		SV_DemoPlaybackError("DEMOERROR: SV_DemoReadFrame: demo is corrupted (not initialized correctly!)");
+		msg.cursize = demoRelayHeaderLen;
+		Com_Memcpy(msg.data, demoRelayHeader, msg.cursize);
 	}
-	msg.cursize = LittleLong(msg.cursize);
-	if (msg.cursize == -1)
+	else
 	{
-		SV_DemoPlaybackError("DEMOERROR: SV_DemoReadFrame: demo is corrupted (demo file is empty?)");
-	}
+		r = FS_Read(&msg.cursize, 4, sv.demoFile);
+		if (r != 4)
+		{
+			SV_DemoPlaybackError("DEMOERROR: SV_DemoReadFrame: demo is corrupted (not initialized correctly!)");
+		}
+		msg.cursize = LittleLong(msg.cursize);
+		if (msg.cursize == -1)
+		{
+			SV_DemoPlaybackError("DEMOERROR: SV_DemoReadFrame: demo is corrupted (demo file is empty?)");
+		}
 
-	if (msg.cursize > msg.maxsize)
-	{
-		SV_DemoPlaybackError("DEMOERROR: SV_DemoReadFrame: demo message too long");
-	}
+		if (msg.cursize > msg.maxsize)
+		{
+			SV_DemoPlaybackError("DEMOERROR: SV_DemoReadFrame: demo message too long");
+		}
 
-	r = FS_Read(msg.data, msg.cursize, sv.demoFile);
-	if (r != msg.cursize)
-	{
-		SV_DemoPlaybackError("DEMOERROR: Demo file was truncated.\n");
+		r = FS_Read(msg.data, msg.cursize, sv.demoFile);
+		if (r != msg.cursize)
+		{
+			SV_DemoPlaybackError("DEMOERROR: Demo file was truncated.\n");
+		}
 	}
 
 	// Reading meta-data (infos about the demo)
@@ -1162,7 +1826,7 @@ static void SV_DemoStartPlayback(void)
 	if (!com_sv_running->integer || Q_stricmp(sv_mapname->string, map) ||
 	    Q_stricmp(Cvar_VariableString("fs_game"), fs) ||
 	    !Cvar_VariableIntegerValue("sv_cheats") ||
-	    (time < svs.time && !keepSaved) || // if the demo initial time is below server time AND we didn't already restart for demo playback, then we must restart to reinit the server time (because else, it might happen that the server time is still above demo time if the demo was recorded during a warmup time, in this case we won't restart the demo playback but just iterate a few demo frames in the void to catch up the server time, see below the else statement)
+	    (time < svs.time && !keepSaved && !demoRelay) || // if the demo initial time is below server time AND we didn't already restart for demo playback, then we must restart to reinit the server time (because else, it might happen that the server time is still above demo time if the demo was recorded during a warmup time, in this case we won't restart the demo playback but just iterate a few demo frames in the void to catch up the server time, see below the else statement)
 	    sv_maxclients->modified ||
 	    (sv_gametype->integer != gametype && !(gametype == GT_SINGLE_PLAYER && sv_gametype->integer == GT_COOP))  // check for gametype change (need a restart to take effect since it's a latched var) AND check that the gametype difference is not between SinglePlayer and DM/FFA, which are in fact the same gametype (and the server will automatically change SinglePlayer to FFA, so we need to detect that and ignore this automatic change)
 	    )
@@ -1204,6 +1868,11 @@ static void SV_DemoStartPlayback(void)
 
 		return;
 	}
+	else if (time < svs.time && demoRelay)
+	{
+		// a relay can't run the stream ahead to catch up, shift its time instead as when rewinding
+		demoTimeShift = svs.time + (1000 / sv_fps->integer) - time;
+	}
 	else if (time < svs.time && keepSaved)
 	{
 		// else if the demo time is still below the server time but we already restarted for the demo playback, we just iterate a few demo frames in the void to catch to until we are above the server time. Note: having a server time below the demo time is CRITICAL, else we may send to the clients a server time that is below the previous, making the time going backward, which should NEVER happen!
@@ -1243,6 +1912,16 @@ static void SV_DemoStartPlayback(void)
 		}
 	}
 
+	demoStartTime = time;
+	if (demoRelay)
+	{
+		demoNumKeyframes = 0;
+	}
+	else
+	{
+		SV_DemoLoadIndex();
+	}
+
 	// Start reading the first frame
 	Com_Printf("Playing server-side demo %s.\n", sv.demoName); // log that the demo is started here
 	SV_SendServerCommand(NULL, "chat \"^3DEMO: Server-side demo replay started!\"");   // send a message to player
@@ -1250,7 +1929,9 @@ static void SV_DemoStartPlayback(void)
 	sv.demoState = DS_PLAYBACK; // set state to playback
 	Cvar_SetValue("sv_demoState", DS_PLAYBACK);
 	keepSaved = qfalse; // Don't save values anymore: the next time we stop playback, we will restore previous values (because now we are really launching the playback, so anything that might happen now is either a big bug or the end of demo, in any case we want to restore the values)
+	demoSeeking = demoRelay; // a relay stream starts at a keyframe, which carries the configstrings and clients instead of the initialization events
 	SV_DemoReadFrame(); // reading the first frame, which should contain some initialization events (eg: initial confistrings/userinfo when demo recording started, initial entities states and placement, etc..)
+	demoSeeking = qfalse;
 
 	return;
 }
@@ -1267,38 +1948,16 @@ static void SV_DemoStartRecord(void)
 	// Set democlients to 0 since it's only used for replaying demo
 	Cvar_SetValue("sv_democlients", 0);
 
-	MSG_Init(&msg, buf, sizeof(buf));
+	SV_DemoQueueStart();
 
-	// Write number of clients (sv_maxclients < MAX_CLIENTS or else we can't playback)
-	MSG_WriteString(&msg, "clients"); // for each demo meta data (infos about the demo), we prepend the name of the var (this allows for fault tolerance and retrocompatibility) - FIXME? We could also use MSG_LookaheadByte() to read a byte, instead of a string, this would save a tiny bit of storage space
-	MSG_WriteByte(&msg, sv_maxclients->integer);
-	// Write current server in-game time
-	MSG_WriteString(&msg, "time");
-	MSG_WriteLong(&msg, svs.time);
-	// Write sv_fps
-	MSG_WriteString(&msg, "sv_fps");
-	MSG_WriteLong(&msg, sv_fps->integer);
-	// Write g_gametype
-	MSG_WriteString(&msg, "g_gametype");
-	MSG_WriteLong(&msg, sv_gametype->integer);
-	// Write fs_game (mod name)
-	MSG_WriteString(&msg, "fs_game");
-	MSG_WriteString(&msg, Cvar_VariableString("fs_game"));
-	// Write map name
-	MSG_WriteString(&msg, "map");
-	MSG_WriteString(&msg, sv_mapname->string);
-	// Write timelimit
-	MSG_WriteString(&msg, "timelimit");
-	MSG_WriteLong(&msg, Cvar_VariableIntegerValue("timelimit"));
-	// Write sv_hostname (only for info)
-	MSG_WriteString(&msg, "hostname");
-	MSG_WriteString(&msg, sv_hostname->string);
-	// Write current datetime (only for info)
-	MSG_WriteString(&msg, "datetime");
-	MSG_WriteString(&msg, SV_GenerateDateTime());
+	// The first frame is a keyframe
+	demoNumKeyframes = 0;
+	demoNextKeyframe = 0;
 
-	// Write end of meta datas (since we will read a string each loop, we need to set a special string to specify the reader that we end the loop, we cannot use a marker because it's a byte)
-	MSG_WriteString(&msg, "endMeta");
+	Com_Memset(demoNumUsercmds, 0, sizeof(demoNumUsercmds));
+
+	MSG_Init(&msg, buf, sizeof(buf));
+	SV_DemoWriteHeader(&msg);
 
 	// Write all the above into the demo file
 	SV_DemoWriteMessage(&msg);
@@ -1349,19 +2008,41 @@ static void SV_DemoStartRecord(void)
 static void SV_DemoStopRecord(void)
 {
 	msg_t msg;
+	int   i, data[2];
 
 	// End the demo
 	MSG_Init(&msg, buf, sizeof(buf));
 	MSG_WriteByte(&msg, demo_endDemo);
 	SV_DemoWriteMessage(&msg); // this also writes demo_EOF
 
+	// The relays get the header of the next recording
+	SV_RelayStopStreams();
+
+	// Append the keyframe index after the end marker (players stop reading at demo_endDemo): time/offset pairs, then the count and the magic
+	if (demoNumKeyframes)
+	{
+		for (i = 0; i < demoNumKeyframes; i++)
+		{
+			data[0] = LittleLong(demoKeyframes[i].time);
+			data[1] = LittleLong(demoKeyframes[i].offset);
+			SV_DemoWriteData(data, sizeof(data));
+		}
+
+		data[0] = LittleLong(demoNumKeyframes);
+		data[1] = LittleLong(DEMO_INDEX_MAGIC);
+		SV_DemoWriteData(data, sizeof(data));
+	}
+
+	// Let the writer finish and sync the file to disk
+	SV_DemoQueueStop();
+
 	// Close the file (else it won't be openable until the server is closed)
 	FS_FCloseFile(sv.demoFile);
 	// Change recording state
 	sv.demoState = DS_NONE;
 	Cvar_SetValue("sv_demoState", DS_NONE);
 	// Announce
-	Com_Printf("DEMO: Stopped recording server-side demo %s.\n", sv.demoName);
+	Com_Printf("DEMO: Stopped recording server-side demo %s (%u bytes, %d dropped frames, %d stalls).\n", sv.demoName, demoQueue.bytesWritten, demoQueue.droppedFrames, demoQueue.stalls);
 	SV_SendServerCommand(NULL, "chat \"^3DEMO: Stopped recording server-side demo %s.\"", sv.demoName);
 }
 
@@ -1402,6 +2083,13 @@ static void SV_DemoReadServerCommand(msg_t *msg)
 	char *cmd;
 
 	cmd = MSG_ReadString(msg);
+
+	// don't flood the clients with the commands of the frames skipped by a seek
+	if (demoSeeking)
+	{
+		return;
+	}
+
 	SV_SendServerCommand(NULL, "%s", cmd);
 }
 
@@ -1422,6 +2110,11 @@ static void SV_DemoReadGameCommand(msg_t *msg)
 	MSG_ReadByte(msg); // clientNum, useless here so we don't save it, but we need to read it in order to move the msg cursor
 	cmd = MSG_ReadString(msg);
 
+	if (demoSeeking)
+	{
+		return;
+	}
+
 	if (SV_CheckLastCmd(cmd, qfalse))
 	{
 		// check for duplicates: check that the engine did not already send this very same message resulting from an event (this means that engine gamecommands are never filtered, only demo gamecommands)
@@ -1429,6 +2122,28 @@ static void SV_DemoReadGameCommand(msg_t *msg)
 	}
 }
 
+/**
+ * @brief Load a demo configstring into memory
+ * @param[in] num
+ * @param[in] configstring
+ */
+static void SV_DemoSetConfigString(int num, const char *configstring)
+{
+	if (num >= CS_PLAYERS + sv_democlients->integer && num < CS_PLAYERS + sv_maxclients->integer)
+	{
+		// we make sure to not overwrite real client configstrings (else when the demo starts, normal players will have no name, no model and no status!) - this cannot be done at recording time because we can't know how many sv_maxclients will be set at replaying time
+		return;
+	}
+
+	// after a rewind the level times must follow the shifted server time, else the HUD timers are off
+	if (demoTimeShift && (num == CS_LEVEL_START_TIME || num == CS_INTERMISSION_START_TIME || num == CS_WARMUP || num == CS_VOTE_TIME) && atoi(configstring) > 0)
+	{
+		configstring = va("%i", atoi(configstring) + demoTimeShift);
+	}
+
+	SV_SetConfigstring(num, configstring);
+}
+
 /**
  * @brief Read a configstring from a message and load it into memory
  * @param[in] msg
@@ -1442,29 +2157,21 @@ static void SV_DemoReadConfigString(msg_t *msg)
 	num          = atoi(MSG_ReadString(msg));
 	configstring = MSG_ReadString(msg);
 
-	if (num < CS_PLAYERS + sv_democlients->integer || num >= CS_PLAYERS + sv_maxclients->integer)
-	{
-		// we make sure to not overwrite real client configstrings (else when the demo starts, normal players will have no name, no model and no status!) - this cannot be done at recording time because we can't know how many sv_maxclients will be set at replaying time
-		SV_SetConfigstring(num, configstring);
-	}
+	SV_DemoSetConfigString(num, configstring);
 }
 
 /**
- * @brief Read a demo client configstring from a message, load it into memory and broadcast changes to gamecode and clients
+ * @brief Load a demo client configstring into memory and broadcast changes to gamecode and clients
  * @details This function also manages demo clientbegin at connections and teamchange
  * (which are normally totally handled by the gamecode, so we can't directly access nor store these events in the demo,
  * we must use clever ways to reproduce them at the right time)
  *
- * @param[in] msg
+ * @param[in] num
+ * @param[in] configstring
  */
-static void SV_DemoReadClientConfigString(msg_t *msg)
+static void SV_DemoSetClientConfigString(int num, const char *configstring)
 {
 	client_t *client;
-	char     *configstring;
-	int      num;
-
-	num          = MSG_ReadByte(msg);
-	configstring = MSG_ReadString(msg);
 
 	/**** DEMOCLIENTS CONNECTION MANAGEMENT  ****/
 	// This part manages when a client should begin or be dropped based on the configstrings. This is a workaround because begin and disconnect events are managed in the gamecode, so we here use a clever way to know when these events happen (this is based on a careful reading of how work the mechanisms that manage players in a real game, so this should be OK in any case).
@@ -1549,29 +2256,37 @@ static void SV_DemoReadClientConfigString(msg_t *msg)
 }
 
 /**
- * @brief Read a demo client userinfo string from a message, load it into memory, fills client_t fields by parsing the userinfo and broacast the change to the gamecode and clients
- * @param msg
+ * @brief Read a demo client configstring from a message
+ * @param[in] msg
+ */
+static void SV_DemoReadClientConfigString(msg_t *msg)
+{
+	char *configstring;
+	int  num;
+
+	num          = MSG_ReadByte(msg);
+	configstring = MSG_ReadString(msg);
+
+	SV_DemoSetClientConfigString(num, configstring);
+}
+
+/**
+ * @brief Load a demo client userinfo string into memory, fills client_t fields by parsing the userinfo and broacast the change to the gamecode and clients
+ * @param[in] num
+ * @param[in] userinfo
  *
  * @note This function also manage the initial team of democlients when demo recording has started.
  * Subsequent team changes will be directly handled by clientCommands "team"
  */
-static void SV_DemoReadClientUserinfo(msg_t *msg)
+static void SV_DemoSetClientUserinfo(int num, const char *userinfo)
 {
-	client_t *client;
-	char     *userinfo;
-	int      num;
+	client_t *client = &svs.clients[num];
 	char     svdoldteam[MAX_NAME_LENGTH];
 	char     svdnewteam[MAX_NAME_LENGTH];
 
 	Com_Memset(svdoldteam, 0, MAX_NAME_LENGTH);
 	Com_Memset(svdnewteam, 0, MAX_NAME_LENGTH);
 
-	// Get client
-	num    = MSG_ReadByte(msg);
-	client = &svs.clients[num];
-	// Get userinfo
-	userinfo = MSG_ReadString(msg);
-
 	// Get the old and new team for the client
 	Q_strncpyz(svdoldteam, Info_ValueForKey(client->userinfo, "team"), MAX_NAME_LENGTH);
 	Q_strncpyz(svdnewteam, Info_ValueForKey(userinfo, "team"), MAX_NAME_LENGTH);
@@ -1608,33 +2323,124 @@ static void SV_DemoReadClientUserinfo(msg_t *msg)
 }
 
 /**
- * @brief Read the usercmd_t for a democlient and restituate the movements
+ * @brief Read a demo client userinfo string from a message
+ * @param[in] msg
+ */
+static void SV_DemoReadClientUserinfo(msg_t *msg)
+{
+	char *userinfo;
+	int  num;
+
+	num      = MSG_ReadByte(msg);
+	userinfo = MSG_ReadString(msg);
+
+	SV_DemoSetClientUserinfo(num, userinfo);
+}
+
+/**
+ * @brief Read a keyframe
  *
- * @details This is NOT needed to make democlients move, this is handled by entities management,
- * but it should avoid inactivity timer to activate and can be used for demo analysis
+ * @details The entities and players of the following frame are delta'd from zero, so the baselines are reset and
+ * all entities unlinked (the frame links the ones that exist). The configstrings and clients are only applied
+ * when we got here by seeking, in normal playback they are already up to date.
  *
  * @param[in] msg
+ */
+static void SV_DemoReadKeyframe(msg_t *msg)
+{
+	static qboolean present[MAX_CONFIGSTRINGS];
+	char            configstring[MAX_STRING_CHARS];
+	char            *userinfo;
+	sharedEntity_t  *entity;
+	int             i, num, clients;
+
+	MSG_ReadLong(msg); // keyframe time, the frame following it carries it as well
+	clients = MSG_ReadByte(msg);
+
+	Com_Memset(present, 0, sizeof(present));
+	while ((num = MSG_ReadShort(msg)) >= 0 && num < MAX_CONFIGSTRINGS)
+	{
+		present[num] = qtrue;
+		Q_strncpyz(configstring, MSG_ReadString(msg), sizeof(configstring));
+
+		if (demoSeeking && strcmp(configstring, sv.configstrings[num]))
+		{
+			SV_DemoSetConfigString(num, configstring);
+		}
+	}
+
+	if (demoSeeking)
+	{
+		// configstrings which were empty at the time of the keyframe
+		for (i = CS_MOTD; i < MAX_CONFIGSTRINGS; i++)
+		{
+			if (!present[i] && sv.configstrings[i][0] && (i < CS_PLAYERS || i >= CS_PLAYERS + clients))
+			{
+				SV_DemoSetConfigString(i, "");
+			}
+		}
+	}
+
+	for (i = 0; i < clients; i++)
+	{
+		Q_strncpyz(configstring, MSG_ReadString(msg), sizeof(configstring));
+		userinfo = MSG_ReadString(msg);
+
+		if (!demoSeeking || i >= sv_democlients->integer)
+		{
+			continue;
+		}
+
+		// userinfo first, as when the recording started
+		if (userinfo[0] && (strcmp(Info_ValueForKey(userinfo, "name"), Info_ValueForKey(svs.clients[i].userinfo, "name")) ||
+		                    strcmp(Info_ValueForKey(userinfo, "team"), Info_ValueForKey(svs.clients[i].userinfo, "team"))))
+		{
+			SV_DemoSetClientUserinfo(i, userinfo);
+		}
+		SV_DemoSetClientConfigString(i, configstring);
+	}
+
+	for (i = 0; i < sv.num_entities; i++)
+	{
+		if (i >= sv_democlients->integer && i < MAX_CLIENTS)
+		{
+			continue;
+		}
+
+		entity = SV_GentityNum(i);
+		if (entity->r.linked)
+		{
+			SV_UnlinkEntity(entity);
+		}
+	}
+
+	Com_Memset(sv.demoEntities, 0, sizeof(sv.demoEntities));
+	Com_Memset(sv.demoPlayerStates, 0, sizeof(sv.demoPlayerStates));
+}
+
+/**
+ * @brief Read the usercmds of a democlient
  *
- * @todo FIXME: should set ucmd->serverTime = client->ps.commandTime + 2 to avoid the dropping of the usercmds_t packets, see g_active.c
+ * @details They are NOT needed to make democlients move, this is handled by entities management,
+ * so they are only skipped here. They are recorded for the tools replaying the player movements.
+ *
+ * @param[in] msg
  */
-/*
-static void SV_DemoReadClientUsercmd( msg_t *msg )
-{
-    int num, deltaint;
-    qboolean delta;
-
-    Cmd_SaveCmdContext(); // Save the context (tokenized strings) so that the engine can continue its usual processing normally just after this function
-    num = MSG_ReadByte(msg);
-    deltaint = MSG_ReadByte(msg);
-    if (deltaint)
-        delta = qtrue;
-    else
-        delta = qfalse;
-    //Com_Printf("DebugGBOReadusercmd: %i\n", num);
-    SV_UserMove(&svs.clients[num], msg, delta);
-    Cmd_RestoreCmdContext(); // Restore the context (tokenized strings)
+static void SV_DemoReadClientUsercmd(msg_t *msg)
+{
+	usercmd_t oldcmd, cmd;
+	int       count, i;
+
+	MSG_ReadByte(msg); // client number
+	count = MSG_ReadByte(msg);
+
+	Com_Memset(&oldcmd, 0, sizeof(oldcmd));
+	for (i = 0; i < count; i++)
+	{
+		MSG_ReadDeltaUsercmdKey(msg, 0, &oldcmd, &cmd);
+		oldcmd = cmd;
+	}
 }
-*/
 
 /**
  * @brief Read all democlients playerstate (playerState_t) from a message and store them in a demoPlayerStates array (it will be loaded in memory later when SV_DemoReadRefresh() is called)
@@ -1754,12 +2560,25 @@ static void SV_DemoReadAllEntityShared(msg_t *msg)
 	}
 }
 
+/**
+ * @brief Shift a level time of the demo by demoTimeShift, unset (0) times stay unset
+ * @param[in,out] time
+ */
+static void SV_DemoShiftTime(int *time)
+{
+	if (*time > 0)
+	{
+		*time += demoTimeShift;
+	}
+}
+
 /**
  * @brief Load into memory all stored demo players states and entities (which effectively overwrites the one that were previously written by the game since SV_ReadFrame is called at the very end of every game's frame iteration).
  */
 static void SV_DemoReadRefreshEntities(void)
 {
-	int i;
+	sharedEntity_t *entity;
+	int            i;
 
 	// Overwrite anything the game may have changed
 	for (i = 0; i < sv.num_entities; i++)
@@ -1769,12 +2588,33 @@ static void SV_DemoReadRefreshEntities(void)
 			continue;
 		}
 
-		*SV_GentityNum(i) = sv.demoEntities[i]; // Overwrite entities
+		entity  = SV_GentityNum(i);
+		*entity = sv.demoEntities[i]; // Overwrite entities
+
+		// trajectories are evaluated at the (shifted) server time. s.time and s.time2 hold a level time
+		// for some entity types only and are left alone, their effects may be off right after a rewind.
+		if (demoTimeShift)
+		{
+			entity->s.pos.trTime  += demoTimeShift;
+			entity->s.apos.trTime += demoTimeShift;
+		}
 	}
 
 	for (i = 0; i < sv_democlients->integer; i++)
 	{
-		*SV_GameClientNum(i) = sv.demoPlayerStates[i]; // Overwrite player states
+		playerState_t *ps = SV_GameClientNum(i);
+
+		*ps = sv.demoPlayerStates[i]; // Overwrite player states
+
+		if (demoTimeShift)
+		{
+			// level times kept in the player state, the other timers count down and are left alone
+			ps->commandTime += demoTimeShift;
+			SV_DemoShiftTime(&ps->classWeaponTime);
+			SV_DemoShiftTime(&ps->jumpTime);
+			SV_DemoShiftTime(&ps->powerups[PW_INVULNERABLE]);
+			SV_DemoShiftTime(&ps->powerups[PW_ADRENALINE]);
+		}
 	}
 }
 
@@ -1815,7 +2655,7 @@ void SV_DemoReadFrame(void)
 read_next_demo_frame: // used to read another whole demo frame
 
 	// Demo freezed? Just stop reading the demo frames
-	if (Cvar_VariableIntegerValue("sv_freezeDemo"))
+	if (!demoSeeking && Cvar_VariableIntegerValue("sv_freezeDemo"))
 	{
 		svs.time = memsvtime; // reset server time to the same time as the previous frame, to avoid the time going backward when resuming the demo (which will disconnect every players)
 		return;
@@ -1824,7 +2664,7 @@ read_next_demo_frame: // used to read another whole demo frame
 	// Update timescale
 	currentframe++; // update the current frame number
 
-	if (com_timescale->value < 1.0f && com_timescale->value > 0.0f)
+	if (!demoSeeking && com_timescale->value < 1.0f && com_timescale->value > 0.0f)
 	{
 		// Check timescale: if slowed timescale (below 1.0), then we check that we pass one frame on 1.0/com_timescale (eg: timescale = 0.5, 1.0/0.5=2, so we pass one frame on two)
 		if (currentframe % (int)(1.0f / com_timescale->value) != 0)
@@ -1833,6 +2673,26 @@ read_next_demo_frame: // used to read another whole demo frame
 		}
 	}
 
+	// Relay stream: wait for a complete frame, freezing like sv_freezeDemo
+	if (demoRelay)
+	{
+		SV_DemoRelayScan();
+
+		if (!demoRelayFrames)
+		{
+			if (!SV_RelayConnected())
+			{
+				Com_Printf("RELAY: End of the stream.\n");
+				SV_DemoStopPlayback();
+				return;
+			}
+
+			svs.time = memsvtime;
+			return;
+		}
+		demoRelayFrames--;
+	}
+
 	// Initialize / reinitialize the msg buffer
 	MSG_Init(&msg, buf, sizeof(buf));
 
@@ -1841,7 +2701,7 @@ read_next_demo_frame: // used to read another whole demo frame
 read_next_demo_event: // used to read next demo event
 
 		// Get a message
-		r = FS_Read(&msg.cursize, 4, sv.demoFile);
+		r = SV_DemoRead(&msg.cursize, 4);
 
 		if (r != 4)
 		{
@@ -1854,7 +2714,7 @@ read_next_demo_event: // used to read next demo event
 			SV_DemoPlaybackError("DEMOERROR: SV_DemoReadFrame: demo message too long\n");
 		}
 
-		r = FS_Read(msg.data, msg.cursize, sv.demoFile); // fetch the demo message (using the length we got) from the demo file sv.demoFile, and store it into msg.data (will be accessed automatically by MSG_thing() functions), and store in r the length of the data returned (used to check that it's correct)
+		r = SV_DemoRead(msg.data, msg.cursize); // fetch the demo message (using the length we got) from the demo file sv.demoFile, and store it into msg.data (will be accessed automatically by MSG_thing() functions), and store in r the length of the data returned (used to check that it's correct)
 		if (r != msg.cursize) // if the returned length of the read demo message is not the same as the length we expected (the one that was stored just prior to the demo message), we return an error because we miss the demo message, and the only reason is that the file is truncated, so there's nothing to read after
 		{
 			SV_DemoPlaybackError("DEMOERROR: Demo file was truncated.");
@@ -1908,11 +2768,12 @@ read_next_demo_event: // used to read next demo event
 			case demo_entityShared:     // gentity_t->entityShared_t management (see g_local.h for more infos)
 				SV_DemoReadAllEntityShared(&msg);
 				break;
-			/*
-			case demo_clientUsercmd:
-			    SV_DemoReadClientUsercmd(&msg);
-			    break;
-			*/
+			case demo_keyframe:     // the following frame is complete (seeking starts reading here)
+				SV_DemoReadKeyframe(&msg);
+				break;
+			case demo_clientUsercmd:     // players movements, only useful to tools
+				SV_DemoReadClientUsercmd(&msg);
+				break;
 			case -1: // no more chars in msg FIXME: inspect!
 				Com_DPrintf("SV_DemoReadFrame: no chars [%i %i:%i]", cmd, msg.readcount, msg.cursize);
 				return;
@@ -1924,11 +2785,12 @@ read_next_demo_event: // used to read next demo event
 				// Update all players' health in HUD
 				SV_DemoReadRefreshPlayersHealth();
 				// Set the server time
-				svs.time  = MSG_ReadLong(&msg);    // refresh server in-game time (overwriting any change the game may have done)
-				memsvtime = svs.time;     // keep memory of the last server time, in case we want to freeze the demo
+				demoFrameTime = MSG_ReadLong(&msg);
+				svs.time      = demoFrameTime + demoTimeShift; // refresh server in-game time (overwriting any change the game may have done)
+				memsvtime     = svs.time;     // keep memory of the last server time, in case we want to freeze the demo
 
 				// Check for timescale: if timescale is faster (above 1.0), we read more frames at once (eg: timescale=2, we read 2 frames for one call of this function)
-				if (com_timescale->value > 1.0f)
+				if (!demoSeeking && com_timescale->value > 1.0f)
 				{
 					// Check that we've read all the frames we needed
 					if (currentframe % (int)(com_timescale->value) != 0)
@@ -1937,9 +2799,19 @@ read_next_demo_event: // used to read next demo event
 					}
 				}
 
+				// A relay more than a second behind its delay catches up
+				if (demoRelay && !demoSeeking && demoRelayFrames > sv_fps->integer)
+				{
+					goto read_next_demo_frame;
+				}
+
 				return;     // else we end the current demo frame
 			case demo_endDemo:     // end of the demo file - just stop playback and restore saved cvars
 				Com_Printf("End of demo reached.\n");
+				if (demoRelay)
+				{
+					SV_DemoRelayRestart();
+				}
 				SV_DemoStopPlayback();
 				return;
 			}
@@ -1947,6 +2819,92 @@ read_next_demo_event: // used to read next demo event
 	}
 }
 
+/**
+ * @brief Move the playback to the given demo time
+ *
+ * @details Jumps to the last keyframe before the target (unless we are already past it and going forward)
+ * and reads the frames from there back to back. When going back the demo time is shifted so the server time keeps going forward.
+ *
+ * @param[in] target demo time to reach
+ * @return Time spent in msec
+ */
+static int SV_DemoSeek(int target)
+{
+	int start = Sys_Milliseconds();
+	int lo = 0, hi = demoNumKeyframes - 1, mid, k = -1;
+
+	// last keyframe at or before the target
+	while (lo <= hi)
+	{
+		mid = (lo + hi) / 2;
+		if (demoKeyframes[mid].time <= target)
+		{
+			k  = mid;
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid - 1;
+		}
+	}
+
+	if (k < 0 && target < demoFrameTime)
+	{
+		Com_Printf("DEMO: Can't go back without a keyframe index.\n");
+		return 0;
+	}
+
+	demoSeeking = qtrue;
+
+	if (k >= 0 && (target < demoFrameTime || demoKeyframes[k].time > demoFrameTime))
+	{
+		if (demoKeyframes[k].time < demoFrameTime)
+		{
+			// the keyframe frame will be played one server frame after the current one
+			demoTimeShift = svs.time + (1000 / sv_fps->integer) - demoKeyframes[k].time;
+		}
+
+		FS_Seek(sv.demoFile, demoKeyframes[k].offset, FS_SEEK_SET);
+		SV_DemoReadFrame();
+	}
+
+	while (sv.demoState == DS_PLAYBACK && demoFrameTime < target)
+	{
+		SV_DemoReadFrame();
+	}
+
+	demoSeeking = qfalse;
+
+	return Sys_Milliseconds() - start;
+}
+
+/**
+ * @brief Parse a demo_seek time: seconds or mm:ss since the start of the demo, or +/- seconds from the current position
+ * @param[in] arg
+ * @return Demo time
+ */
+static int SV_DemoParseSeekTime(const char *arg)
+{
+	const char *colon = strchr(arg, ':');
+	int        msec;
+
+	if (arg[0] == '+' || arg[0] == '-')
+	{
+		return demoFrameTime + (int)(atof(arg) * 1000);
+	}
+
+	if (colon)
+	{
+		msec = (atoi(arg) * 60 + atoi(colon + 1)) * 1000;
+	}
+	else
+	{
+		msec = (int)(atof(arg) * 1000);
+	}
+
+	return demoStartTime + msec;
+}
+
 /**
  * @brief SV_DemoStopAll
  */
@@ -2018,6 +2976,11 @@ static void SV_Demo_Record_f(void)
 		return;
 	}
 
+	if (sv_demoCompress->integer > 0)
+	{
+		FS_SetBlockCompression(sv.demoFile, sv_demoCompress->integer);
+	}
+
 	SV_DemoStartRecord();
 }
 
@@ -2059,9 +3022,41 @@ static void SV_Demo_Play_f(void)
 		return;
 	}
 
+	(void) FS_DetectBlockCompression(sv.demoFile);
+
 	SV_DemoStartPlayback();
 }
 
+/**
+ * @brief Play the stream of the relayed game server, called by relay_play once it is ready
+ */
+void SV_DemoRelayPlay(void)
+{
+	if (sv.demoState != DS_NONE || !SV_DemoRelayReady())
+	{
+		return;
+	}
+
+	Q_strncpyz(sv.demoName, "relay stream", sizeof(sv.demoName));
+	demoRelay = qtrue;
+
+	SV_DemoStartPlayback();
+}
+
+/**
+ * @brief Forget the relay stream, a new connection starts with a header
+ */
+void SV_DemoRelayReset(void)
+{
+	if (demoRelay && sv.demoState == DS_PLAYBACK)
+	{
+		SV_DemoStopPlayback();
+	}
+
+	demoRelayScan = 0;
+	SV_DemoRelayRestart();
+}
+
 /**
  * @brief SV_Demo_Stop_f
  */
@@ -2073,9 +3068,130 @@ static void SV_Demo_Stop_f(void)
 		return;
 	}
 
+	// the relay would start playing again
+	if (demoRelay)
+	{
+		SV_RelayDisconnect("demo stopped");
+	}
+
 	SV_DemoStopAll();
 }
 
+/**
+ * @brief SV_Demo_Seek_f
+ */
+static void SV_Demo_Seek_f(void)
+{
+	int target, msec;
+
+	if (sv.demoState != DS_PLAYBACK)
+	{
+		Com_Printf("No demo is currently being played.\n");
+		return;
+	}
+
+	if (demoRelay)
+	{
+		Com_Printf("Can't seek a relayed game server.\n");
+		return;
+	}
+
+	if (Cmd_Argc() != 2)
+	{
+		Com_Printf("Usage: demo_seek <seconds|mm:ss|+seconds|-seconds>\n");
+		return;
+	}
+
+	target = SV_DemoParseSeekTime(Cmd_Argv(1));
+	if (target < demoStartTime)
+	{
+		target = demoStartTime;
+	}
+
+	msec = SV_DemoSeek(target);
+	Com_Printf("DEMO: At %i:%02i (%i msec).\n", (demoFrameTime - demoStartTime) / 60000, ((demoFrameTime - demoStartTime) / 1000) % 60, msec);
+}
+
+/**
+ * @brief SV_Demo_Rewind_f
+ */
+static void SV_Demo_Rewind_f(void)
+{
+	int target, msec;
+
+	if (sv.demoState != DS_PLAYBACK)
+	{
+		Com_Printf("No demo is currently being played.\n");
+		return;
+	}
+
+	if (demoRelay)
+	{
+		Com_Printf("Can't seek a relayed game server.\n");
+		return;
+	}
+
+	target = demoFrameTime - (Cmd_Argc() > 1 ? atoi(Cmd_Argv(1)) : 10) * 1000;
+	if (target < demoStartTime)
+	{
+		target = demoStartTime;
+	}
+
+	msec = SV_DemoSeek(target);
+	Com_Printf("DEMO: At %i:%02i (%i msec).\n", (demoFrameTime - demoStartTime) / 60000, ((demoFrameTime - demoStartTime) / 1000) % 60, msec);
+}
+
+#ifdef ETLEGACY_DEBUG
+/**
+ * @brief Seek the current demo to random positions and print the latency
+ */
+static void SV_Demo_SeekBench_f(void)
+{
+	int i, count, msec, total = 0, worst = 0, end;
+
+	if (sv.demoState != DS_PLAYBACK || !demoNumKeyframes)
+	{
+		Com_Printf("Play a demo with a keyframe index first.\n");
+		return;
+	}
+
+	count = Cmd_Argc() > 1 ? atoi(Cmd_Argv(1)) : 100;
+	end   = demoKeyframes[demoNumKeyframes - 1].time;
+
+	for (i = 0; i < count && sv.demoState == DS_PLAYBACK; i++)
+	{
+		msec   = SV_DemoSeek(demoStartTime + rand() % MAX(1, end - demoStartTime));
+		total += msec;
+		worst  = MAX(worst, msec);
+	}
+
+	Com_Printf("demo_seekbench: %i seeks over %i:%02i, average %.2f msec, worst %i msec\n", i,
+	           (end - demoStartTime) / 60000, ((end - demoStartTime) / 1000) % 60, i ? total / (float)i : 0.f, worst);
+}
+#endif
+
+/**
+ * @brief Print the demo writer counters of the current recording
+ */
+static void SV_Demo_Status_f(void)
+{
+	if (sv.demoState != DS_RECORDING)
+	{
+		Com_Printf("No demo is currently being recorded.\n");
+		return;
+	}
+
+	Com_Printf("Recording %s (%s)\n", sv.demoName, demoQueue.thread ? "async" : "sync");
+	Com_Printf("  bytes written  : %u\n", demoQueue.bytesWritten);
+	if (demoQueue.thread)
+	{
+		Com_Printf("  queue depth    : %u / %u (max %u)\n", demoQueue.head - demoQueue.tail, DEMO_QUEUE_SIZE, demoQueue.maxDepth);
+	}
+	Com_Printf("  max frame size : %u\n", demoQueue.maxFrameSize);
+	Com_Printf("  dropped frames : %d\n", demoQueue.droppedFrames);
+	Com_Printf("  stalls         : %d (%d msec)\n", demoQueue.stalls, demoQueue.stallMsec);
+}
+
 /**
  * @brief SV_CompleteDemoName
  * @param args - unused
@@ -2100,6 +3216,12 @@ void SV_DemoInit(void)
 	Cmd_AddCommand("demo_record", SV_Demo_Record_f, "Starts demo recording.");
 	Cmd_AddCommand("demo_play", SV_Demo_Play_f, "Plays a demo record.", SV_CompleteDemoName);
 	Cmd_AddCommand("demo_stop", SV_Demo_Stop_f, "Stops a demo record.");
+	Cmd_AddCommand("demo_status", SV_Demo_Status_f, "Prints the demo writer counters of the current record.");
+	Cmd_AddCommand("demo_seek", SV_Demo_Seek_f, "Moves the demo playback to the given time.");
+	Cmd_AddCommand("demo_rewind", SV_Demo_Rewind_f, "Moves the demo playback back by the given seconds.");
+#ifdef ETLEGACY_DEBUG
+	Cmd_AddCommand("demo_seekbench", SV_Demo_SeekBench_f, "Measures the demo seek latency.");
+#endif
 }
 
 /**
@@ -2110,4 +3232,10 @@ void SV_DemoShutdown(void) // FIXME: don't remove these on server shutdown/demo
 	Cmd_RemoveCommand("demo_record");
 	Cmd_RemoveCommand("demo_play");
 	Cmd_RemoveCommand("demo_stop");
+	Cmd_RemoveCommand("demo_status");
+	Cmd_RemoveCommand("demo_seek");
+	Cmd_RemoveCommand("demo_rewind");
+#ifdef ETLEGACY_DEBUG
+	Cmd_RemoveCommand("demo_seekbench");
+#endif
 }
@@ -0,0 +1,449 @@
+/*
+ * Wolfenstein: Enemy Territory GPL Source Code
+ * Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+ *
+ * ET: Legacy
+ * Copyright (C) 2012-2018 ET:Legacy team <mail@etlegacy.com>
+ *
+ * This file is part of ET: Legacy - http://www.etlegacy.com
+ *
+ * ET: Legacy is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ET: Legacy is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ET: Legacy. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, Wolfenstein: Enemy Territory GPL Source Code is also
+ * subject to certain additional terms. You should have received a copy
+ * of these additional terms immediately following the terms and conditions
+ * of the GNU General Public License which accompanied the source code.
+ * If not, please request a copy in writing from id Software at the address below.
+ *
+ * id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+ */
+/**
+ * @file sv_frontend.c
+ * @brief Answers getinfo/getstatus on the network front-end thread
+ *
+ * With sv_netFrontend 1 a thread reads the game sockets (see NET_FrontendStart).
+ * Server browsers and masters asking for getinfo/getstatus are answered there from
+ * a copy of the replies the main loop publishes once per frame, floods of them are
+ * dropped there by the same sv_protect checks SVC_Info and SVC_Status do, so only
+ * the game traffic and the other connectionless commands reach the main loop.
+ *
+ * The thread owns its buckets and receipts, it never touches cvars, the console or
+ * the server state. Its drops are summed up in the attack log once a second.
+ */
+
+#include "server.h"
+
+#define FRONTEND_PLAYERS_SIZE   (MAX_MSGLEN / 2)
+#define FRONTEND_CHALLENGE_SIZE 128
+
+/**
+ * @struct svFrontendSnapshot_t
+ * @brief What the thread needs to answer, published by the main loop behind a sequence number
+ *
+ * The sequence is odd while the main loop writes it, a reader that sees it change copied a torn one.
+ */
+typedef struct
+{
+	volatile unsigned int sequence;
+
+	int protect;                                ///< sv_protect
+	qboolean hidden;                            ///< sv_hidden
+
+	char info[MAX_INFO_STRING];                 ///< infoResponse keys, without the challenge
+	char statusInfo[MAX_INFO_STRING];           ///< serverinfo of a statusResponse, without the challenge
+	char players[FRONTEND_PLAYERS_SIZE];        ///< player lines of a statusResponse
+} svFrontendSnapshot_t;
+
+/**
+ * @struct svFrontendCounters_t
+ * @brief Written by the thread only
+ */
+typedef struct
+{
+	volatile int answered;
+	volatile int droppedRate;                   ///< SVP_IOQ3 buckets
+	volatile int droppedDRDoS;                  ///< SVP_OWOLF receipts
+	volatile int droppedBad;                    ///< challenge too long
+	volatile int hidden;                        ///< sv_hidden
+} svFrontendCounters_t;
+
+static svFrontendSnapshot_t published;          ///< written by the main loop
+static svFrontendSnapshot_t local;              ///< the thread's copy
+
+static svFrontendCounters_t counters;
+
+// owned by the thread
+static leakyBucketTable_t frontendBuckets;
+static leakyBucket_t      frontendOutbound;
+static receipt_t          frontendReceipts[MAX_INFO_RECEIPTS];
+
+// owned by the main loop
+static int frontendLogTime;
+static int frontendLogDropped;
+
+/**
+ * @brief Update the thread's copy of the published snapshot
+ * @return qfalse if there is no usable copy, the main loop answers then
+ */
+static qboolean SV_FrontendRefresh(void)
+{
+	unsigned int sequence = published.sequence;
+
+	if (sequence == local.sequence)
+	{
+		return local.sequence != 0;
+	}
+
+	// being written, the previous one is fine meanwhile
+	if (sequence & 1)
+	{
+		return local.sequence != 0;
+	}
+
+	Sys_MemoryBarrier();
+
+	local.sequence = 0;
+	local.protect  = published.protect;
+	local.hidden   = published.hidden;
+	Com_Memcpy(local.info, published.info, sizeof(local.info));
+	Com_Memcpy(local.statusInfo, published.statusInfo, sizeof(local.statusInfo));
+	Com_Memcpy(local.players, published.players, sizeof(local.players));
+
+	Sys_MemoryBarrier();
+
+	if (published.sequence != sequence)
+	{
+		return qfalse;
+	}
+
+	// the main loop never writes NUL-less strings, but a torn copy is never used
+	local.info[sizeof(local.info) - 1]             = '\0';
+	local.statusInfo[sizeof(local.statusInfo) - 1] = '\0';
+	local.players[sizeof(local.players) - 1]       = '\0';
+
+	local.sequence = sequence;
+	return qtrue;
+}
+
+/**
+ * @brief Read a token of a connectionless command line like Cmd_TokenizeString does
+ * @param[in,out] text
+ * @param[in] end
+ * @param[out] token
+ * @param[in] size
+ * @return qfalse if the token doesn't fit
+ */
+static qboolean SV_FrontendToken(const char **text, const char *end, char *token, int size)
+{
+	const char *s = *text;
+	int        len = 0;
+	qboolean   quoted;
+
+	while (s < end && *s && *s <= ' ')
+	{
+		s++;
+	}
+
+	quoted = (s < end && *s == '"');
+	if (quoted)
+	{
+		s++;
+	}
+
+	while (s < end && *s && *s != '\n')
+	{
+		if (quoted ? *s == '"' : *s <= ' ')
+		{
+			break;
+		}
+
+		if (len >= size - 1)
+		{
+			return qfalse;
+		}
+
+		token[len++] = *s++;
+	}
+
+	if (quoted && s < end && *s == '"')
+	{
+		s++;
+	}
+
+	token[len] = '\0';
+	*text      = s;
+	return qtrue;
+}
+
+/**
+ * @brief Whether a challenge can be echoed, Info_SetValueForKey refuses the same characters
+ * @param[in] challenge
+ * @return
+ */
+static qboolean SV_FrontendValidChallenge(const char *challenge)
+{
+	return *challenge && !strchr(challenge, '\\') && !strchr(challenge, ';') && !strchr(challenge, '"');
+}
+
+/**
+ * @brief Apply the sv_protect checks of SV_ConnectionlessPacket, SVC_Info and SVC_Status
+ * @param[in] from
+ * @return qtrue if the request is dropped
+ */
+static qboolean SV_FrontendProtect(netadr_t from)
+{
+	if (local.protect & SVP_OWOLF)
+	{
+		if (SV_CheckReceipts(frontendReceipts, from, Sys_Milliseconds()) != DRDOS_NONE)
+		{
+			counters.droppedDRDoS++;
+			return qtrue;
+		}
+	}
+
+	if (local.protect & SVP_IOQ3)
+	{
+		// Prevent using getinfo/getstatus as an amplifier
+		if (SVC_BucketFull(SVC_BucketForAddress(&frontendBuckets, from, 10, 1000), 10, 1000))
+		{
+			counters.droppedRate++;
+			return qtrue;
+		}
+
+		// Allow getinfo/getstatus to be DoSed relatively easily, but prevent
+		// excess outbound bandwidth usage when being flooded inbound
+		if (SVC_BucketFull(&frontendOutbound, 10, 100))
+		{
+			counters.droppedRate++;
+			return qtrue;
+		}
+	}
+
+	return qfalse;
+}
+
+/**
+ * @brief Front-end filter, answers getinfo and getstatus and hands everything else to the main loop
+ * @param[in] from
+ * @param[in] msg
+ * @return qtrue if the packet was answered or dropped
+ *
+ * @note Runs on the front-end thread
+ */
+static qboolean SV_FrontendFilter(netadr_t from, msg_t *msg)
+{
+	char       command[16];
+	char       challenge[FRONTEND_CHALLENGE_SIZE + 1];
+	char       reply[MAX_MSGLEN];
+	const char *text, *end;
+	qboolean   status;
+	int        length;
+
+	if (msg->cursize < 4 || *(int *)msg->data != -1)
+	{
+		return qfalse;
+	}
+
+	text = (const char *)msg->data + 4;
+	end  = (const char *)msg->data + msg->cursize;
+
+	if (!SV_FrontendToken(&text, end, command, sizeof(command)))
+	{
+		return qfalse;
+	}
+
+	if (!Q_stricmp(command, "getstatus"))
+	{
+		status = qtrue;
+	}
+	else if (!Q_stricmp(command, "getinfo"))
+	{
+		status = qfalse;
+	}
+	else
+	{
+		return qfalse;
+	}
+
+	if (!SV_FrontendRefresh())
+	{
+		return qfalse;
+	}
+
+	if (local.hidden)
+	{
+		counters.hidden++;
+		return qtrue;
+	}
+
+	if (SV_FrontendProtect(from))
+	{
+		return qtrue;
+	}
+
+	// A maximum challenge length of 128 should be more than plenty.
+	if (!SV_FrontendToken(&text, end, challenge, sizeof(challenge)))
+	{
+		counters.droppedBad++;
+		return qtrue;
+	}
+
+	// echo back the parameter to status. so master servers can use it as a challenge
+	// to prevent timed spoofed reply packets that add ghost servers
+	if (!SV_FrontendValidChallenge(challenge))
+	{
+		challenge[0] = '\0';
+	}
+
+	if (status)
+	{
+		length = Com_sprintf(reply, sizeof(reply), "\xff\xff\xff\xffstatusResponse\n%s%s%s\n%s", local.statusInfo,
+		                     challenge[0] ? "\\challenge\\" : "", challenge, local.players);
+	}
+	else
+	{
+		length = Com_sprintf(reply, sizeof(reply), "\xff\xff\xff\xffinfoResponse\n%s%s%s",
+		                     challenge[0] ? "\\challenge\\" : "", challenge, local.info);
+	}
+
+	NET_FrontendSend(from, reply, length);
+	counters.answered++;
+	return qtrue;
+}
+
+/**
+ * @brief Publish the replies for the front-end thread
+ */
+static void SV_FrontendPublish(void)
+{
+	published.sequence++;
+	Sys_MemoryBarrier();
+
+	published.protect = sv_protect->integer;
+	published.hidden  = sv_hidden->integer ? qtrue : qfalse;
+
+	published.info[0] = '\0';
+	SV_InfoString(published.info);
+
+	Q_strncpyz(published.statusInfo, Cvar_InfoString(CVAR_SERVERINFO | CVAR_SERVERINFO_NOUPDATE), sizeof(published.statusInfo));
+	Info_SetValueForKey(published.statusInfo, "version", ET_VERSION);
+
+	SV_StatusPlayers(published.players, sizeof(published.players));
+
+	Sys_MemoryBarrier();
+	published.sequence++;
+}
+
+/**
+ * @brief Start or stop the front-end thread on sv_netFrontend changes and publish the replies
+ */
+void SV_FrontendFrame(void)
+{
+	int dropped;
+
+	if (sv_netFrontend->modified)
+	{
+		sv_netFrontend->modified = qfalse;
+
+		if (sv_netFrontend->integer && !NET_FrontendRunning())
+		{
+			// the thread isn't running, its state can be reset
+			Com_Memset(&local, 0, sizeof(local));
+			Com_Memset(&frontendBuckets, 0, sizeof(frontendBuckets));
+			Com_Memset(&frontendOutbound, 0, sizeof(frontendOutbound));
+			Com_Memset(frontendReceipts, 0, sizeof(frontendReceipts));
+
+			SV_FrontendPublish();
+
+			if (!NET_FrontendStart(SV_FrontendFilter))
+			{
+				Com_Printf(S_COLOR_YELLOW "WARNING: network front-end not started, the main loop reads the sockets\n");
+			}
+		}
+		else if (!sv_netFrontend->integer)
+		{
+			NET_FrontendStop();
+		}
+	}
+
+	if (!NET_FrontendRunning())
+	{
+		return;
+	}
+
+	SV_FrontendPublish();
+
+	// Limit one log every second.
+	if (frontendLogTime + 1000 <= svs.time || frontendLogTime > svs.time)
+	{
+		dropped = counters.droppedRate + counters.droppedDRDoS + counters.droppedBad;
+
+		if (dropped != frontendLogDropped)
+		{
+			SV_WriteAttackLog(va("Network front-end dropped %i getinfo/getstatus connectionless packets\n", dropped - frontendLogDropped));
+			frontendLogDropped = dropped;
+		}
+		frontendLogTime = svs.time;
+	}
+}
+
+/**
+ * @brief Stop the front-end thread, it is started again by the next SV_FrontendFrame
+ */
+void SV_FrontendShutdown(void)
+{
+	NET_FrontendStop();
+
+	if (sv_netFrontend)
+	{
+		sv_netFrontend->modified = qtrue;
+	}
+}
+
+/**
+ * @brief Prints the counters of the network front-end, "frontendstats reset" clears them
+ */
+void SV_FrontendStats_f(void)
+{
+	netFrontendStats_t st;
+	qboolean           reset = (Cmd_Argc() > 1 && !Q_stricmp(Cmd_Argv(1), "reset"));
+
+	if (!NET_FrontendRunning())
+	{
+		Com_Printf("Network front-end is not running.\n");
+		return;
+	}
+
+	NET_FrontendStats(&st, reset);
+
+	if (reset)
+	{
+		// the thread may be writing them, a lost increment doesn't matter here
+		Com_Memset(&counters, 0, sizeof(counters));
+		frontendLogDropped = 0;
+		return;
+	}
+
+	Com_Printf("received:      %10i\n", st.received);
+	Com_Printf("forwarded:     %10i\n", st.forwarded);
+	Com_Printf("filtered:      %10i\n", st.filtered);
+	Com_Printf("  answered:    %10i\n", counters.answered);
+	Com_Printf("  rate limit:  %10i\n", counters.droppedRate);
+	Com_Printf("  DRDoS:       %10i\n", counters.droppedDRDoS);
+	Com_Printf("  bad:         %10i\n", counters.droppedBad);
+	Com_Printf("  hidden:      %10i\n", counters.hidden);
+	Com_Printf("queue full:    %10i\n", st.queueFull);
+	Com_Printf("queue max:     %10u bytes\n", st.maxDepth);
+	Com_Printf("errors:        %10i\n", st.errors);
+}
@@ -507,6 +507,17 @@ intptr_t SV_GameSystemCalls(intptr_t *args)
 	case G_TRACECAPSULE:
 		SV_Trace(VMA(1), VMA(2), VMA(3), VMA(4), VMA(5), args[6], args[7], /* int capsule */ qtrue);
 		return 0;
+	case G_TRACEBATCH:
+		SV_TraceBatch(VMA(1), VMA(2), args[3]);
+		return 0;
+	case G_PROFILER_REGISTER:
+		return Prof_Register(VMA(1));
+	case G_PROFILER_BEGIN:
+		Prof_Begin(args[1]);
+		return 0;
+	case G_PROFILER_END:
+		Prof_End();
+		return 0;
 	case G_POINT_CONTENTS:
 		return SV_PointContents(VMA(1), args[2]);
 	case G_SET_BRUSH_MODEL:
@@ -691,6 +702,395 @@ intptr_t SV_GameSystemCalls(intptr_t *args)
 	return -1;
 }
 
+/**
+ * @struct botThinkTimes_s
+ * @brief Frame times of one bot think mode
+ */
+typedef struct botThinkTimes_s
+{
+	int frames;
+	int64_t think;              ///< usec spent in GAME_BOT_THINK
+	int64_t frame;              ///< usec the main thread spent in SV_Frame and waiting for the think
+	int64_t maxFrame;
+} botThinkTimes_t;
+
+/// client packets held back while the bot think runs on its thread
+#define BOT_THINK_DEFER_PACKETS 1024
+#define BOT_THINK_DEFER_BYTES   (256 * 1024)
+
+/**
+ * @struct botThinkPacket_s
+ * @brief A packet received while the bot think was running
+ */
+typedef struct botThinkPacket_s
+{
+	netadr_t from;
+	int offset;                 ///< into botThink.deferData
+	int size;
+} botThinkPacket_t;
+
+/**
+ * @struct botThink_s
+ * @brief The bot think the game deferred from GAME_RUN_FRAME to GAME_BOT_THINK
+ */
+static struct botThink_s
+{
+	qboolean pending;           ///< the game asked for GAME_BOT_THINK
+
+	void *worker;               ///< thread running the think, started on first use
+	void *start;                ///< raised by the main thread to start a think or quit
+	void *done;                 ///< raised by the worker when the think returned
+	qboolean running;           ///< a think was started and not waited for yet
+	volatile qboolean finished; ///< the worker is done, SV_GameBotThinkPoll can take it without blocking
+	qboolean quit;
+
+	qboolean failed;            ///< the think raised a Com_Error, the main thread raises it again
+	int errorCode;
+	char error[MAXPRINTMSG];
+
+	int64_t frameUsec;          ///< SV_Frame time of the threaded frame
+	int64_t thinkStart;         ///< written by the worker, read after the done signal
+	int64_t thinkUsec;
+
+	botThinkPacket_t deferred[BOT_THINK_DEFER_PACKETS];
+	int numDeferred;
+	int deferBytes;
+	byte deferData[BOT_THINK_DEFER_BYTES];
+
+	botThinkTimes_t inlined;
+	botThinkTimes_t threaded;
+} botThink;
+
+/**
+ * @brief Run GAME_BOT_THINK
+ * @return usec it took
+ */
+static int64_t SV_GameBotThink(void)
+{
+	int64_t start = Sys_Microseconds();
+
+	// the profiler ignores it on the thread, SV_GameBotThinkFinish records it
+	Prof_Begin(PROF_BOT_THINK);
+	VM_Call(gvm, GAME_BOT_THINK);
+	Prof_End();
+
+	return Sys_Microseconds() - start;
+}
+
+/**
+ * @brief The think of one frame on the worker, run under Com_CatchError
+ * @param arg - unused
+ */
+static void SV_GameBotThinkThread(void *arg)
+{
+	botThink.thinkUsec = SV_GameBotThink();
+}
+
+/**
+ * @brief Worker thread, runs a think each time the start signal is raised
+ * @param arg - unused
+ */
+static void SV_GameBotThinkWorker(void *arg)
+{
+	while (1)
+	{
+		Sys_WaitSignal(botThink.start);
+		if (botThink.quit)
+		{
+			return;
+		}
+
+		botThink.thinkStart = Sys_Microseconds();
+		botThink.thinkUsec  = 0;
+		botThink.failed     = Com_CatchError(SV_GameBotThinkThread, NULL, &botThink.errorCode, botThink.error, sizeof(botThink.error));
+
+		Sys_MemoryBarrier();
+		botThink.finished = qtrue;
+		Sys_RaiseSignal(botThink.done);
+
+		// the main loop sleeps in NET_Sleep, let it take the deferred packets
+		NET_Wake();
+	}
+}
+
+/**
+ * @brief Start the worker thread
+ * @return qfalse if the think has to stay inline
+ */
+static qboolean SV_GameBotThinkStartWorker(void)
+{
+	botThink.start = Sys_CreateSignal();
+	botThink.done  = Sys_CreateSignal();
+	botThink.quit  = qfalse;
+	if (botThink.start && botThink.done)
+	{
+		botThink.worker = Sys_CreateThread(SV_GameBotThinkWorker, NULL);
+		if (botThink.worker)
+		{
+			return qtrue;
+		}
+	}
+
+	Com_Printf(S_COLOR_YELLOW "WARNING: can't start the bot think thread, thinking inline\n");
+	Sys_DestroySignal(botThink.start);
+	Sys_DestroySignal(botThink.done);
+	botThink.start = NULL;
+	botThink.done  = NULL;
+	return qfalse;
+}
+
+/**
+ * @brief Add the times of one frame
+ * @param[in,out] times
+ * @param[in] think
+ * @param[in] frame
+ */
+static void SV_GameBotThinkTimes(botThinkTimes_t *times, int64_t think, int64_t frame)
+{
+	times->frames++;
+	times->think += think;
+	times->frame += frame;
+	if (frame > times->maxFrame)
+	{
+		times->maxFrame = frame;
+	}
+}
+
+/**
+ * @brief Run a game frame, the game may return GAME_BOT_THINK to defer its bot think
+ * @param[in] levelTime
+ */
+void SV_GameRunFrame(int levelTime)
+{
+	// the think of the previous frame runs before the world moves again
+	SV_GameBotThinkFinish();
+
+	Prof_Begin(PROF_GAME_FRAME);
+	botThink.pending = (VM_Call(gvm, GAME_RUN_FRAME, levelTime) == GAME_BOT_THINK);
+	Prof_End();
+}
+
+/**
+ * @brief Run the deferred bot think at the end of SV_Frame
+ *
+ * With sv_botThread on a dedicated server it runs on the worker thread. The snapshots
+ * have gone out, and until the think is waited for the main thread only sends queued
+ * packets and sleeps in NET_Sleep. The packets NET_Sleep receives would call into the
+ * game, SV_PacketEvent holds them back with SV_GameBotThinkDefer until then. So the
+ * think sees the world of the finished frame and nothing else runs game code meanwhile.
+ * A listen server runs its client frame there, which traces too, so it stays inline.
+ *
+ * @param[in] frameStart - Sys_Microseconds at the start of SV_Frame
+ */
+void SV_GameBotThinkStart(int64_t frameStart)
+{
+	int64_t think;
+
+	if (!botThink.pending)
+	{
+		return;
+	}
+	botThink.pending = qfalse;
+
+	if (sv_botThread->integer && com_dedicated->integer
+	    && (botThink.worker || SV_GameBotThinkStartWorker()))
+	{
+		botThink.frameUsec = Sys_Microseconds() - frameStart;
+		botThink.finished  = qfalse;
+		botThink.running   = qtrue;
+		Sys_RaiseSignal(botThink.start);
+		return;
+	}
+
+	think = SV_GameBotThink();
+	SV_GameBotThinkTimes(&botThink.inlined, think, Sys_Microseconds() - frameStart);
+}
+
+/**
+ * @brief Wait for the worker to finish the running think
+ * @return qtrue if the think raised an error, it is left in botThink.error
+ */
+static qboolean SV_GameBotThinkWait(void)
+{
+	int64_t start = Sys_Microseconds();
+
+	Prof_Begin(PROF_BOT_WAIT);
+	Sys_WaitSignal(botThink.done);
+	botThink.running = qfalse;
+	Prof_End();
+
+	Prof_Record(PROF_BOT_THINK, PROF_THREAD_BOTS, botThink.thinkStart, botThink.thinkUsec);
+
+	SV_GameBotThinkTimes(&botThink.threaded, botThink.thinkUsec, botThink.frameUsec + Sys_Microseconds() - start);
+
+	return botThink.failed;
+}
+
+/**
+ * @brief Hold back a packet that arrived while the bot think runs on its thread
+ *
+ * Client packets run the client think and commands of the game, connectionless
+ * ones may connect a client or run an rcon command. When the queue is full the
+ * think is waited for and the packet goes through right away.
+ *
+ * @param[in] from
+ * @param[in] msg
+ * @return qtrue if the packet was queued for SV_GameBotThinkFinish
+ */
+qboolean SV_GameBotThinkDefer(netadr_t from, msg_t *msg)
+{
+	botThinkPacket_t *packet;
+
+	if (!botThink.running)
+	{
+		return qfalse;
+	}
+
+	if (botThink.numDeferred == BOT_THINK_DEFER_PACKETS || botThink.deferBytes + msg->cursize > BOT_THINK_DEFER_BYTES)
+	{
+		SV_GameBotThinkFinish();
+		return qfalse;
+	}
+
+	packet         = &botThink.deferred[botThink.numDeferred++];
+	packet->from   = from;
+	packet->offset = botThink.deferBytes;
+	packet->size   = msg->cursize;
+	Com_Memcpy(botThink.deferData + botThink.deferBytes, msg->data, msg->cursize);
+	botThink.deferBytes += msg->cursize;
+
+	return qtrue;
+}
+
+/**
+ * @brief Hand the packets held back during the think to SV_PacketEvent
+ */
+static void SV_GameBotThinkDeferred(void)
+{
+	static byte bufData[MAX_MSGLEN + 1];
+	msg_t       buf;
+	int         i;
+
+	for (i = 0; i < botThink.numDeferred; i++)
+	{
+		botThinkPacket_t *packet = &botThink.deferred[i];
+
+		MSG_Init(&buf, bufData, sizeof(bufData));
+		Com_Memcpy(buf.data, botThink.deferData + packet->offset, packet->size);
+		buf.cursize = packet->size;
+		SV_PacketEvent(packet->from, &buf);
+	}
+
+	botThink.numDeferred = 0;
+	botThink.deferBytes  = 0;
+}
+
+/**
+ * @brief Wait for the bot think thread, or run a think still pending
+ *
+ * Called before anything touches the game again: the end of the main loop sleep,
+ * a full deferred packet queue, the next game frame and a map_restart.
+ */
+void SV_GameBotThinkFinish(void)
+{
+	if (botThink.running)
+	{
+		if (SV_GameBotThinkWait())
+		{
+			botThink.numDeferred = 0;
+			botThink.deferBytes  = 0;
+			botThink.failed      = qfalse;
+			Com_Error(botThink.errorCode, "%s", botThink.error);
+		}
+
+		SV_GameBotThinkDeferred();
+	}
+	else if (botThink.pending)
+	{
+		// frames run outside of SV_Frame, map_restart and the catch up frames
+		botThink.pending = qfalse;
+		SV_GameBotThink();
+	}
+}
+
+/**
+ * @brief Take the think of the worker if it is done, without waiting for it
+ *
+ * Called each time NET_Sleep returns, the worker wakes it when the think is done
+ * so the held back packets don't wait for the end of the frame.
+ */
+void SV_GameBotThinkPoll(void)
+{
+	if (botThink.running && botThink.finished)
+	{
+		SV_GameBotThinkFinish();
+	}
+}
+
+/**
+ * @brief Wait for a running think and stop the worker thread, called when the game shuts down
+ *
+ * It may run from the Com_Error of an ERR_DROP, so an error of the think is only printed
+ * and the held back packets are dropped, the clients send them again.
+ */
+static void SV_GameBotThinkStop(void)
+{
+	if (botThink.running && SV_GameBotThinkWait())
+	{
+		Com_Printf(S_COLOR_YELLOW "WARNING: bot think failed: %s\n", botThink.error);
+		botThink.failed = qfalse;
+	}
+	botThink.pending     = qfalse;
+	botThink.numDeferred = 0;
+	botThink.deferBytes  = 0;
+
+	if (!botThink.worker)
+	{
+		return;
+	}
+
+	botThink.quit = qtrue;
+	Sys_RaiseSignal(botThink.start);
+	Sys_JoinThread(botThink.worker);
+	botThink.worker = NULL;
+
+	Sys_DestroySignal(botThink.start);
+	Sys_DestroySignal(botThink.done);
+	botThink.start = NULL;
+	botThink.done  = NULL;
+}
+
+/**
+ * @brief Prints the frame times with inline and threaded bot think, "botthinkstats reset" clears them
+ */
+void SV_GameBotThinkStats_f(void)
+{
+	const char      *names[2] = { "inline", "threaded" };
+	botThinkTimes_t *modes[2] = { &botThink.inlined, &botThink.threaded };
+	int             i;
+
+	if (Cmd_Argc() > 1 && !Q_stricmp(Cmd_Argv(1), "reset"))
+	{
+		Com_Memset(&botThink.inlined, 0, sizeof(botThink.inlined));
+		Com_Memset(&botThink.threaded, 0, sizeof(botThink.threaded));
+		return;
+	}
+
+	Com_Printf("mode         frames  think avg   frame avg   frame max (usec)\n");
+	for (i = 0; i < 2; i++)
+	{
+		if (!modes[i]->frames)
+		{
+			Com_Printf("%-10s %8i\n", names[i], 0);
+			continue;
+		}
+		Com_Printf("%-10s %8i %10i  %10i  %10i\n", names[i], modes[i]->frames,
+		           (int)(modes[i]->think / modes[i]->frames), (int)(modes[i]->frame / modes[i]->frames),
+		           (int)modes[i]->maxFrame);
+	}
+	Com_Printf("frame is the time the main thread spent in the server frame and waiting for the think\n");
+}
+
 /**
  * @brief Called every time a map changes
  */
@@ -701,6 +1101,8 @@ void SV_ShutdownGameProgs(void)
 		return;
 	}
 
+	SV_GameBotThinkStop();
+
 	// stop any demos
 	SV_DemoStopAll();
 
@@ -730,7 +1132,7 @@ static void SV_InitGameVM(qboolean restart)
 
 	// use the current msec count for a random seed
 	// init for this gamestate
-	VM_Call(gvm, GAME_INIT, svs.time, Com_Milliseconds(), restart, qtrue, ETLEGACY_VERSION_INT);
+	VM_Call(gvm, GAME_INIT, svs.time, Com_Milliseconds(), restart, qtrue, ETLEGACY_VERSION_INT, GAME_ENGINE_FEATURES);
 
 	// start recording a demo
 	if (sv_autoDemo->integer)
@@ -750,6 +1152,7 @@ void SV_RestartGameProgs(void)
 	{
 		return;
 	}
+	SV_GameBotThinkFinish();
 	VM_Call(gvm, GAME_SHUTDOWN, qtrue);
 
 	// do a restart instead of a free
@@ -89,8 +89,19 @@ void SV_SetConfigstring(int index, const char *val)
 		return;
 	}
 
-	// change the string in sv
-	Z_Free(sv.configstrings[index]);
+	// change the string in sv, keeping the value clients hold as the base of the update
+	if (sv.configstringsmodified[index])
+	{
+		Z_Free(sv.configstrings[index]);
+	}
+	else
+	{
+		if (sv.configstringsPrev[index])
+		{
+			Z_Free(sv.configstringsPrev[index]);
+		}
+		sv.configstringsPrev[index] = sv.configstrings[index];
+	}
 	sv.configstrings[index]         = CopyString(val);
 	sv.configstringsmodified[index] = qtrue;
 
@@ -102,17 +113,118 @@ void SV_SetConfigstring(int index, const char *val)
 }
 
 /**
- * @brief Updates the configstring
- * @note It's nice to know this function sends several server commands when a configstring is greater than 1000 usually BIG_INFO_STRINGs
+ * @brief Checksum of a configstring, identifies the base of a splice
+ * @param[in] s
+ * @return
  */
-void SV_UpdateConfigStrings(void)
+unsigned int SV_ConfigstringChecksum(const char *s)
+{
+	return Com_BlockChecksum((void *)s, strlen(s));
+}
+
+/**
+ * @brief Send the whole configstring to a client
+ * @param[in] client
+ * @param[in] index
+ */
+static void SV_SendConfigstring(client_t *client, int index)
 {
-	client_t   *client;
-	int        len, i, index, sent, remaining, cstotal = 0;
+	int        len, sent, remaining;
 	int        maxChunkSize = MAX_STRING_CHARS - 24;
 	const char *cmd;
 	char       buf[MAX_STRING_CHARS];
 
+	len = strlen(sv.configstrings[index]);
+	if (len >= maxChunkSize)
+	{
+		sent      = 0;
+		remaining = len;
+
+		while (remaining > 0)
+		{
+			if (sent == 0)
+			{
+				cmd = "bcs0";
+			}
+			else if (remaining < maxChunkSize)
+			{
+				cmd = "bcs2";
+			}
+			else
+			{
+				cmd = "bcs1";
+			}
+
+			Q_strncpyz(buf, &sv.configstrings[index][sent], maxChunkSize);
+
+			SV_SendServerCommand(client, "%s %i \"%s\"\n", cmd, index, buf);
+
+			sent      += (maxChunkSize - 1);
+			remaining -= (maxChunkSize - 1);
+		}
+	}
+	else
+	{
+		// standard cs, just send it
+		SV_SendServerCommand(client, "cs %i \"%s\"\n", index, sv.configstrings[index]);
+	}
+}
+
+/**
+ * @brief Build the "csp" command turning the value clients hold into the new one
+ * @param[in] index
+ * @param[out] cmd
+ * @param[in] size
+ * @return length of the command, 0 if the whole configstring is as short
+ */
+static int SV_ConfigstringSplice(int index, char *cmd, int size)
+{
+	const char *old = sv.configstringsPrev[index], *s = sv.configstrings[index];
+	int        oldLen, len, prefix = 0, suffix = 0, middleLen;
+
+	if (!old)
+	{
+		return 0;
+	}
+
+	oldLen = strlen(old);
+	len    = strlen(s);
+
+	while (prefix < oldLen && prefix < len && old[prefix] == s[prefix])
+	{
+		prefix++;
+	}
+	while (suffix < oldLen - prefix && suffix < len - prefix && old[oldLen - 1 - suffix] == s[len - 1 - suffix])
+	{
+		suffix++;
+	}
+
+	// the command itself is about 24 chars, not worth it unless the kept part is longer
+	middleLen = len - prefix - suffix;
+	if (middleLen + 24 >= len || middleLen + 32 >= size)
+	{
+		return 0;
+	}
+
+	return Com_sprintf(cmd, size, "csp %i %i %i %i \"%.*s\"\n", index, oldLen, prefix, suffix, middleLen, s + prefix);
+}
+
+/**
+ * @brief Updates the configstring
+ * @note It's nice to know this function sends several server commands when a configstring is greater than 1000 usually BIG_INFO_STRINGs
+ *
+ * Clients announcing UA_FEATURE_CSDELTA and holding the previous value get
+ * only the changed middle of the string as a "csp" splice.
+ */
+void SV_UpdateConfigStrings(void)
+{
+	client_t     *client;
+	int          len, i, index, cstotal = 0;
+	int          maxChunkSize = MAX_STRING_CHARS - 24;
+	int          fullBytes, spliceBytes;
+	unsigned int checksum, prevChecksum;
+	char         splice[MAX_STRING_CHARS - 24];
+
 	for (index = 0; index < MAX_CONFIGSTRINGS; index++)
 	{
 		if (sv.configstrings[index][0])
@@ -142,6 +254,14 @@ void SV_UpdateConfigStrings(void)
 		// spawning a new server
 		if (sv.state == SS_GAME || sv.restarting)
 		{
+			len          = strlen(sv.configstrings[index]);
+			checksum     = SV_ConfigstringChecksum(sv.configstrings[index]);
+			prevChecksum = sv.configstringsPrev[index] ? SV_ConfigstringChecksum(sv.configstringsPrev[index]) : 0;
+			spliceBytes  = SV_ConfigstringSplice(index, splice, sizeof(splice));
+
+			// chars of the cs or bcs0/1/2 commands, only for csstats
+			fullBytes = len + (len >= maxChunkSize ? (len / (maxChunkSize - 1) + 1) * 8 : 5) + strlen(va("%i", index));
+
 			// send the data to all relevent clients
 			for (i = 0, client = svs.clients; i < sv_maxclients->integer ; i++, client++)
 			{
@@ -155,40 +275,21 @@ void SV_UpdateConfigStrings(void)
 					continue;
 				}
 
-				len = strlen(sv.configstrings[index]);
-				if (len >= maxChunkSize)
+				if (spliceBytes && Com_IsCompatible(&client->agent, UA_FEATURE_CSDELTA) && client->csChecksum[index] == prevChecksum)
 				{
-					sent      = 0;
-					remaining = len;
-
-					while (remaining > 0)
-					{
-						if (sent == 0)
-						{
-							cmd = "bcs0";
-						}
-						else if (remaining < maxChunkSize)
-						{
-							cmd = "bcs2";
-						}
-						else
-						{
-							cmd = "bcs1";
-						}
-
-						Q_strncpyz(buf, &sv.configstrings[index][sent], maxChunkSize);
-
-						SV_SendServerCommand(client, "%s %i \"%s\"\n", cmd, index, buf);
-
-						sent      += (maxChunkSize - 1);
-						remaining -= (maxChunkSize - 1);
-					}
+					SV_SendServerCommand(client, "%s", splice);
+					svs.csStats.splices++;
+					svs.csStats.updateBytes += spliceBytes;
 				}
 				else
 				{
-					// standard cs, just send it
-					SV_SendServerCommand(client, "cs %i \"%s\"\n", index, sv.configstrings[index]);
+					SV_SendConfigstring(client, index);
+					svs.csStats.updateBytes += fullBytes;
 				}
+				client->csChecksum[index] = checksum;
+
+				svs.csStats.updates++;
+				svs.csStats.updateFullBytes += fullBytes;
 			}
 		}
 
@@ -272,6 +373,64 @@ void SV_GetUserinfo(int index, char *buffer, unsigned int bufferSize)
 	Q_strncpyz(buffer, svs.clients[index].userinfo, bufferSize);
 }
 
+/**
+ * @brief Pick for each baseline the earlier one of the gamestate it encodes
+ * smallest against, see svc_baselineDelta
+ *
+ * @note The gamestate writes the baselines in entity number order, so the
+ * candidates are the BASELINE_DELTA_BACKUP - 1 baselines written before.
+ * Huffman coding is static, the encoded size doesn't depend on the position.
+ */
+static void SV_ChooseBaselineDeltas(void)
+{
+	entityState_t *recent[BASELINE_DELTA_BACKUP];
+	entityState_t nullstate, *base;
+	msg_t         msg;
+	byte          msgBuffer[MAX_MSGLEN / 4];
+	int           entnum, count = 0, back, bits, bestBits;
+
+	Com_Memset(&nullstate, 0, sizeof(nullstate));
+	MSG_Init(&msg, msgBuffer, sizeof(msgBuffer));
+
+	sv.baselineNullBits = 0;
+
+	for (entnum = 0; entnum < MAX_GENTITIES; entnum++)
+	{
+		base = &sv.svEntities[entnum].baseline;
+
+		sv.baselineDelta[entnum] = 0;
+
+		if (!base->number)
+		{
+			continue;
+		}
+
+		MSG_Clear(&msg);
+		MSG_WriteByte(&msg, svc_baseline);
+		MSG_WriteDeltaEntity(&msg, &nullstate, base, qtrue);
+		bestBits             = msg.bit;
+		sv.baselineNullBits += msg.bit;
+
+		for (back = 1; back < BASELINE_DELTA_BACKUP && back <= count; back++)
+		{
+			MSG_Clear(&msg);
+			MSG_WriteByte(&msg, svc_baselineDelta);
+			MSG_WriteBits(&msg, back, BASELINE_DELTA_BITS);
+			MSG_WriteDeltaEntity(&msg, recent[(count - back) & (BASELINE_DELTA_BACKUP - 1)], base, qtrue);
+			bits = msg.bit;
+
+			if (bits < bestBits)
+			{
+				bestBits                 = bits;
+				sv.baselineDelta[entnum] = back;
+			}
+		}
+
+		recent[count & (BASELINE_DELTA_BACKUP - 1)] = base;
+		count++;
+	}
+}
+
 /**
  * @brief Entity baselines are used to compress non-delta messages
  * to the clients -- only the fields that differ from the
@@ -295,6 +454,8 @@ void SV_CreateBaseline(void)
 		// take current state as baseline
 		sv.svEntities[entnum].baseline = svent->s;
 	}
+
+	SV_ChooseBaselineDeltas();
 }
 
 /**
@@ -612,6 +773,10 @@ static void SV_ClearServer(void)
 		{
 			Z_Free(sv.configstrings[i]);
 		}
+		if (sv.configstringsPrev[i])
+		{
+			Z_Free(sv.configstringsPrev[i]);
+		}
 	}
 
 	Com_Memset(&sv, 0, sizeof(sv));
@@ -651,6 +816,7 @@ void SV_SpawnServer(const char *server)
 	unsigned int checksum;
 	qboolean     isBot;
 	const char   *p;
+	hunkTag_t    oldTag;
 
 	// broadcast a level change to all connected clients
 	if (svs.clients && !com_errorEntered)
@@ -763,16 +929,20 @@ void SV_SpawnServer(const char *server)
 	// to load during actual gameplay
 	sv.state = SS_LOADING;
 
+	oldTag = Hunk_SetTag(HUNK_TAG_GAME);
+
 	// load and spawn all other entities
 	SV_InitGameProgs();
 
 	// run a few frames to allow everything to settle
 	for (i = 0 ; i < GAME_INIT_FRAMES ; i++)
 	{
-		VM_Call(gvm, GAME_RUN_FRAME, svs.time);
+		SV_GameRunFrame(svs.time);
 		svs.time += FRAMETIME;
 	}
 
+	Hunk_SetTag(oldTag);
+
 	// create a baseline for more efficient communications
 	SV_CreateBaseline();
 
@@ -829,7 +999,7 @@ void SV_SpawnServer(const char *server)
 	}
 
 	// run another frame to allow things to look at all the players
-	VM_Call(gvm, GAME_RUN_FRAME, svs.time);
+	SV_GameRunFrame(svs.time);
 
 	svs.time += FRAMETIME;
 
@@ -891,6 +1061,8 @@ void SV_SpawnServer(const char *server)
 
 	Hunk_SetMark();
 
+	Hunk_DumpStats(server);
+
 	SV_UpdateConfigStrings();
 
 	Com_Printf("---------------------------------\n");
@@ -1077,6 +1249,8 @@ void SV_Init(void)
 	sv_tempbanmessage = Cvar_Get("sv_tempbanmessage", "You have been kicked and are temporarily banned from joining this server.", 0);
 
 	sv_padPackets  = Cvar_Get("sv_padPackets", "0", 0);
+	sv_sharedSnapshots = Cvar_Get("sv_sharedSnapshots", "1", CVAR_ARCHIVE);
+	Cvar_SetDescription(sv_sharedSnapshots, "Build one unculled snapshot per frame and share it between the spectators that see the whole map (multiview, shoutcasters)");
 	sv_killserver  = Cvar_Get("sv_killserver", "0", 0);
 	sv_mapChecksum = Cvar_Get("sv_mapChecksum", "", CVAR_ROM);
 
@@ -1133,6 +1307,37 @@ void SV_Init(void)
 	sv_freezeDemo   = Cvar_Get("cl_freezeDemo", "0", CVAR_TEMP); // port from client-side to freeze server-side demos
 	sv_demoTolerant = Cvar_Get("sv_demoTolerant", "0", CVAR_ARCHIVE);
 	sv_demopath     = Cvar_Get("sv_demopath", "", CVAR_ARCHIVE);
+	sv_demoAsync    = Cvar_Get("sv_demoAsync", "1", CVAR_ARCHIVE);
+	Cvar_SetDescription(sv_demoAsync, "Write server-side demos from a separate thread so disk stalls don't hold up server frames");
+	sv_demoCompress = Cvar_Get("sv_demoCompress", "0", CVAR_ARCHIVE);
+	Cvar_SetDescription(sv_demoCompress, "Compress server-side demos into seekable blocks, 1 (fastest) to 9 (smallest), 0 writes plain demos");
+	sv_demoKeyframeInterval = Cvar_Get("sv_demoKeyframeInterval", "0", CVAR_ARCHIVE);
+	Cvar_SetDescription(sv_demoKeyframeInterval, "Seconds between the keyframes of server-side demos, demo_seek jumps to the nearest one (0 disables them, demos with keyframes need sv_demoTolerant 1 on older builds)");
+	sv_demoUsercmds = Cvar_Get("sv_demoUsercmds", "0", CVAR_ARCHIVE);
+	Cvar_SetDescription(sv_demoUsercmds, "Also record the usercmds of the players in server-side demos, so their movements can be replayed by etlpmove");
+
+	sv_relayPassword = Cvar_Get("sv_relayPassword", "", CVAR_TEMP);
+	Cvar_SetDescription(sv_relayPassword, "Password relay servers need to stream this server, relays are refused when empty");
+	sv_relayPort = Cvar_Get("sv_relayPort", "0", CVAR_ARCHIVE);
+	Cvar_SetDescription(sv_relayPort, "TCP port relay servers connect to, 0 uses net_port");
+	sv_relayDelay = Cvar_Get("sv_relayDelay", "0", CVAR_ARCHIVE);
+	Cvar_SetDescription(sv_relayDelay, "Seconds a relay server holds back the game server it relays");
+
+	sv_netFrontend = Cvar_Get("sv_netFrontend", "0", CVAR_ARCHIVE);
+	Cvar_SetDescription(sv_netFrontend, "Read the network on a thread which answers getinfo/getstatus and drops their floods, see frontendstats");
+
+	sv_botThread = Cvar_Get("sv_botThread", "0", CVAR_ARCHIVE);
+	Cvar_SetDescription(sv_botThread, "Run the bot think of the game on a thread against the finished frame, bot input is applied a frame later, see botthinkstats");
+
+	sv_metrics = Cvar_Get("sv_metrics", "0", CVAR_ARCHIVE);
+	Cvar_SetDescription(sv_metrics, "Collect server metrics in the Prometheus text format, served on sv_metricsPort and written to sv_metricsFile");
+	sv_metricsPort = Cvar_Get("sv_metricsPort", "0", CVAR_ARCHIVE);
+	Cvar_SetDescription(sv_metricsPort, "TCP port of the loopback interface answering HTTP requests with the metrics, 0 disables it");
+	sv_metricsFile = Cvar_Get("sv_metricsFile", "metrics.prom", CVAR_ARCHIVE);
+	Cvar_SetDescription(sv_metricsFile, "File in the mod directory of fs_homepath the metrics are written to, empty disables it");
+	sv_metricsInterval = Cvar_Get("sv_metricsInterval", "15", CVAR_ARCHIVE);
+	Cvar_SetDescription(sv_metricsInterval, "Seconds between two writes of sv_metricsFile");
+	SV_MetricsInit();
 
 	// init the botlib here because we need the pre-compiler in the UI
 	SV_BotInitBotLib();
@@ -1226,6 +1431,9 @@ void SV_Shutdown(const char *finalmsg)
 
 	// SV_ShutdownGameProgs calls SV_DemoStopAll();
 	SV_DemoShutdown();
+	SV_RelayShutdown();
+	SV_FrontendShutdown();
+	SV_MetricsShutdown();
 
 	// free current level
 	SV_ClearServer();
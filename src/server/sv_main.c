@@ -54,6 +54,7 @@ cvar_t *sv_reconnectlimit;      // minimum seconds between connect messages
 cvar_t *sv_tempbanmessage;
 
 cvar_t *sv_padPackets;          // add nop bytes to messages
+cvar_t *sv_sharedSnapshots;     // one unculled snapshot per frame for multiview spectators and shoutcasters
 cvar_t *sv_killserver;          // menu system can set to 1 to shut server down
 cvar_t *sv_mapname;
 cvar_t *sv_mapChecksum;
@@ -114,6 +115,23 @@ cvar_t *sv_demoState;
 cvar_t *sv_autoDemo;
 cvar_t *sv_freezeDemo;  // to freeze server-side demos
 cvar_t *sv_demoTolerant;
+cvar_t *sv_demoAsync;
+cvar_t *sv_demoCompress;
+cvar_t *sv_demoKeyframeInterval;
+cvar_t *sv_demoUsercmds;
+
+cvar_t *sv_relayPassword;
+cvar_t *sv_relayPort;
+cvar_t *sv_relayDelay;
+
+cvar_t *sv_netFrontend;
+
+cvar_t *sv_botThread;
+
+cvar_t *sv_metrics;
+cvar_t *sv_metricsPort;
+cvar_t *sv_metricsFile;
+cvar_t *sv_metricsInterval;
 
 cvar_t *sv_ipMaxClients;
 
@@ -548,9 +566,8 @@ CONNECTIONLESS COMMANDS
 ==============================================================================
 */
 
-static leakyBucket_t buckets[MAX_BUCKETS];
-static leakyBucket_t *bucketHashes[MAX_HASHES];
-leakyBucket_t        outboundLeakyBucket;
+static leakyBucketTable_t bucketTable;
+leakyBucket_t             outboundLeakyBucket;
 
 /**
  * @brief SVC_HashForAddress
@@ -593,19 +610,22 @@ static long SVC_HashForAddress(netadr_t address)
 
 /**
  * @brief Find or allocate a bucket for an address
+ * @param[in,out] table
  * @param[in] address
  * @param[in] burst
  * @param[in] period
- * @return
+ * @return NULL if all buckets are in use
+ *
+ * @note The network front-end thread has its own table
  */
-static leakyBucket_t *SVC_BucketForAddress(netadr_t address, int burst, int period)
+leakyBucket_t *SVC_BucketForAddress(leakyBucketTable_t *table, netadr_t address, int burst, int period)
 {
 	leakyBucket_t *bucket = NULL;
 	int           i;
 	long          hash = SVC_HashForAddress(address);
 	int           now  = Sys_Milliseconds();
 
-	for (bucket = bucketHashes[hash]; bucket; bucket = bucket->next)
+	for (bucket = table->hashes[hash]; bucket; bucket = bucket->next)
 	{
 		switch (bucket->type)
 		{
@@ -633,7 +653,7 @@ static leakyBucket_t *SVC_BucketForAddress(netadr_t address, int burst, int peri
 	{
 		int interval;
 
-		bucket   = &buckets[i];
+		bucket   = &table->buckets[i];
 		interval = now - bucket->lastTime;
 
 		// Reclaim expired buckets
@@ -645,7 +665,7 @@ static leakyBucket_t *SVC_BucketForAddress(netadr_t address, int burst, int peri
 			}
 			else
 			{
-				bucketHashes[bucket->hash] = bucket->next;
+				table->hashes[bucket->hash] = bucket->next;
 			}
 
 			if (bucket->next != NULL)
@@ -674,36 +694,32 @@ static leakyBucket_t *SVC_BucketForAddress(netadr_t address, int burst, int peri
 			bucket->hash     = hash;
 
 			// Add to the head of the relevant hash chain
-			bucket->next = bucketHashes[hash];
-			if (bucketHashes[hash] != NULL)
+			bucket->next = table->hashes[hash];
+			if (table->hashes[hash] != NULL)
 			{
-				bucketHashes[hash]->prev = bucket;
+				table->hashes[hash]->prev = bucket;
 			}
 
-			bucket->prev       = NULL;
-			bucketHashes[hash] = bucket;
+			bucket->prev        = NULL;
+			table->hashes[hash] = bucket;
 
 			return bucket;
 		}
 	}
 
-	// Couldn't allocate a bucket for this address
-	// Write the info to the attack log since this is relevant information as the system is malfunctioning
-	SV_WriteAttackLogD(va("SVC_BucketForAddress: Could not allocate a bucket for client from %s\n", NET_AdrToString(address)));
-
 	return NULL;
 }
 
 /**
- * @brief SVC_RateLimit
+ * @brief Leak the bucket and add a drop if there is room
  * @param[in,out] bucket
  * @param[in] burst
  * @param[in] period
- * @return
+ * @return qtrue if the bucket is full (or NULL) and the request must be dropped
  *
- * @note Don't call if sv_protect 1 (SVP_IOQ3) flag is not set!
+ * @note Doesn't log, the network front-end thread uses it too
  */
-qboolean SVC_RateLimit(leakyBucket_t *bucket, int burst, int period)
+qboolean SVC_BucketFull(leakyBucket_t *bucket, int burst, int period)
 {
 	if (bucket != NULL)
 	{
@@ -728,10 +744,30 @@ qboolean SVC_RateLimit(leakyBucket_t *bucket, int burst, int period)
 			bucket->burst++;
 			return qfalse;
 		}
-		else
-		{
-			SV_WriteAttackLogD(va("SVC_RateLimit: burst limit exceeded for bucket: %i limit: %i\n", bucket->burst, burst));
-		}
+	}
+
+	return qtrue;
+}
+
+/**
+ * @brief SVC_RateLimit
+ * @param[in,out] bucket
+ * @param[in] burst
+ * @param[in] period
+ * @return
+ *
+ * @note Don't call if sv_protect 1 (SVP_IOQ3) flag is not set!
+ */
+qboolean SVC_RateLimit(leakyBucket_t *bucket, int burst, int period)
+{
+	if (!SVC_BucketFull(bucket, burst, period))
+	{
+		return qfalse;
+	}
+
+	if (bucket != NULL)
+	{
+		SV_WriteAttackLogD(va("SVC_RateLimit: burst limit exceeded for bucket: %i limit: %i\n", bucket->burst, burst));
 	}
 
 	return qtrue;
@@ -748,7 +784,14 @@ qboolean SVC_RateLimit(leakyBucket_t *bucket, int burst, int period)
  */
 qboolean SVC_RateLimitAddress(netadr_t from, int burst, int period)
 {
-	leakyBucket_t *bucket = SVC_BucketForAddress(from, burst, period);
+	leakyBucket_t *bucket = SVC_BucketForAddress(&bucketTable, from, burst, period);
+
+	if (!bucket)
+	{
+		// Couldn't allocate a bucket for this address
+		// Write the info to the attack log since this is relevant information as the system is malfunctioning
+		SV_WriteAttackLogD(va("SVC_BucketForAddress: Could not allocate a bucket for client from %s\n", NET_AdrToString(from)));
+	}
 
 	return SVC_RateLimit(bucket, burst, period);
 }
@@ -764,14 +807,8 @@ qboolean SVC_RateLimitAddress(netadr_t from, int burst, int period)
  */
 static void SVC_Status(netadr_t from, qboolean force)
 {
-	char          player[1024];
-	char          status[MAX_MSGLEN];
-	int           i;
-	client_t      *cl;
-	playerState_t *ps;
-	unsigned int  statusLength;
-	unsigned int  playerLength;
-	char          infostring[MAX_INFO_STRING];
+	char status[MAX_MSGLEN];
+	char infostring[MAX_INFO_STRING];
 
 	if (!force && (sv_protect->integer & SVP_IOQ3))
 	{
@@ -806,8 +843,26 @@ static void SVC_Status(netadr_t from, qboolean force)
 	Info_SetValueForKey(infostring, "challenge", Cmd_Argv(1));
 	Info_SetValueForKey(infostring, "version", ET_VERSION);
 
-	status[0]    = 0;
-	statusLength = 0;
+	SV_StatusPlayers(status, sizeof(status));
+
+	NET_OutOfBandPrint(NS_SERVER, from, "statusResponse\n%s\n%s", infostring, status);
+}
+
+/**
+ * @brief The player lines of a statusResponse
+ * @param[out] status
+ * @param[in] size
+ */
+void SV_StatusPlayers(char *status, unsigned int size)
+{
+	char          player[1024];
+	int           i;
+	client_t      *cl;
+	playerState_t *ps;
+	unsigned int  statusLength = 0;
+	unsigned int  playerLength;
+
+	status[0] = 0;
 
 	for (i = 0 ; i < sv_maxclients->integer ; i++)
 	{
@@ -818,7 +873,7 @@ static void SVC_Status(netadr_t from, qboolean force)
 			Com_sprintf(player, sizeof(player), "%i %i \"%s\"\n",
 			            ps->persistant[PERS_SCORE], cl->ping, cl->name);
 			playerLength = strlen(player);
-			if (statusLength + playerLength >= sizeof(status))
+			if (statusLength + playerLength >= size)
 			{
 				break;      // can't hold any more
 			}
@@ -827,8 +882,6 @@ static void SVC_Status(netadr_t from, qboolean force)
 			statusLength += playerLength;
 		}
 	}
-
-	NET_OutOfBandPrint(NS_SERVER, from, "statusResponse\n%s\n%s", infostring, status);
 }
 
 /**
@@ -839,12 +892,7 @@ static void SVC_Status(netadr_t from, qboolean force)
  */
 void SVC_Info(netadr_t from)
 {
-	int  i, players = 0, humans = 0;
-	char *gamedir;
 	char infostring[MAX_INFO_STRING];
-	char *antilag;
-	char *weaprestrict;
-	char *balancedteams;
 
 	if (sv_protect->integer & SVP_IOQ3)
 	{
@@ -874,6 +922,29 @@ void SVC_Info(netadr_t from)
 		return;
 	}
 
+	infostring[0] = 0;
+
+	// echo back the parameter to status. so servers can use it as a challenge
+	// to prevent timed spoofed reply packets that add ghost servers
+	Info_SetValueForKey(infostring, "challenge", Cmd_Argv(1));
+
+	SV_InfoString(infostring);
+
+	NET_OutOfBandPrint(NS_SERVER, from, "infoResponse\n%s", infostring);
+}
+
+/**
+ * @brief Add the keys of an infoResponse
+ * @param[in,out] infostring
+ */
+void SV_InfoString(char *infostring)
+{
+	int  i, players = 0, humans = 0;
+	char *gamedir;
+	char *antilag;
+	char *weaprestrict;
+	char *balancedteams;
+
 	// don't count privateclients
 	for (i = sv_privateClients->integer ; i < sv_maxclients->integer ; i++)
 	{
@@ -887,12 +958,6 @@ void SVC_Info(netadr_t from)
 		}
 	}
 
-	infostring[0] = 0;
-
-	// echo back the parameter to status. so servers can use it as a challenge
-	// to prevent timed spoofed reply packets that add ghost servers
-	Info_SetValueForKey(infostring, "challenge", Cmd_Argv(1));
-
 	Info_SetValueForKey(infostring, "version", ET_VERSION);
 	Info_SetValueForKey(infostring, "protocol", va("%i", PROTOCOL_VERSION));
 	Info_SetValueForKey(infostring, "hostname", sv_hostname->string);
@@ -940,8 +1005,6 @@ void SVC_Info(netadr_t from)
 	{
 		Info_SetValueForKey(infostring, "balancedteams", balancedteams);
 	}
-
-	NET_OutOfBandPrint(NS_SERVER, from, "infoResponse\n%s", infostring);
 }
 
 /**
@@ -967,27 +1030,11 @@ static void SV_FlushRedirect(char *outputbuf)
 qboolean SV_CheckDRDoS(netadr_t from)
 {
 	int        i;
-	int        globalCount;
-	int        specificCount;
 	int        timeNow;
-	receipt_t  *receipt;
-	netadr_t   exactFrom;
-	int        oldest;
-	int        oldestTime;
 	static int lastGlobalLogTime   = 0;
 	static int lastSpecificLogTime = 0;
 
-	// Usually the network is smart enough to not allow incoming UDP packets
-	// with a source address being a spoofed LAN address.  Even if that's not
-	// the case, sending packets to other hosts in the LAN is not a big deal.
-	// NA_LOOPBACK qualifies as a LAN address.
-	if (Sys_IsLANAddress(from))
-	{
-		return qfalse;
-	}
-
-	timeNow   = svs.time;
-	exactFrom = from;
+	timeNow = svs.time;
 
 	// Time has wrapped
 	if (lastGlobalLogTime > timeNow || lastSpecificLogTime > timeNow)
@@ -1005,6 +1052,56 @@ qboolean SV_CheckDRDoS(netadr_t from)
 		}
 	}
 
+	switch (SV_CheckReceipts(svs.infoReceipts, from, timeNow))
+	{
+	case DRDOS_FLOOD:
+		if (lastGlobalLogTime + 1000 <= timeNow)  // Limit one log every second.
+		{
+			SV_WriteAttackLog("Detected flood of getinfo/getstatus connectionless packets\n");
+			lastGlobalLogTime = timeNow;
+		}
+		return qtrue;
+	case DRDOS_ADDRESS:
+		if (lastSpecificLogTime + 1000 <= timeNow)   // Limit one log every second.
+		{
+			SV_WriteAttackLog(va("Possible DRDoS attack to address %s, ignoring getinfo/getstatus connectionless packet\n",
+			                     NET_AdrToString(from)));
+			lastSpecificLogTime = timeNow;
+		}
+		return qtrue;
+	default:
+		return qfalse;
+	}
+}
+
+/**
+ * @brief Count the getinfo/getstatus/getchallenge answers of the last 2 seconds
+ * and record this one if it may be answered, see SV_CheckDRDoS
+ * @param[in,out] receipts MAX_INFO_RECEIPTS of them
+ * @param[in] from
+ * @param[in] timeNow
+ * @return DRDOS_NONE if the request may be answered
+ *
+ * @note Doesn't log, the network front-end thread uses it too
+ */
+int SV_CheckReceipts(receipt_t *receipts, netadr_t from, int timeNow)
+{
+	int       i;
+	int       globalCount;
+	int       specificCount;
+	receipt_t *receipt;
+	int       oldest;
+	int       oldestTime;
+
+	// Usually the network is smart enough to not allow incoming UDP packets
+	// with a source address being a spoofed LAN address.  Even if that's not
+	// the case, sending packets to other hosts in the LAN is not a big deal.
+	// NA_LOOPBACK qualifies as a LAN address.
+	if (Sys_IsLANAddress(from))
+	{
+		return DRDOS_NONE;
+	}
+
 	if (from.type == NA_IP)
 	{
 		from.ip[3] = 0; // xx.xx.xx.0
@@ -1017,7 +1114,7 @@ qboolean SV_CheckDRDoS(netadr_t from)
 	// Count receipts in last 2 seconds.
 	globalCount   = 0;
 	specificCount = 0;
-	receipt       = &svs.infoReceipts[0];
+	receipt       = &receipts[0];
 	oldest        = 0;
 	oldestTime    = 0x7fffffff;
 	for (i = 0; i < MAX_INFO_RECEIPTS; i++, receipt++)
@@ -1048,30 +1145,17 @@ qboolean SV_CheckDRDoS(netadr_t from)
 
 	if (globalCount == MAX_INFO_RECEIPTS)   // All receipts happened in last 2 seconds.
 	{
-		if (lastGlobalLogTime + 1000 <= timeNow)  // Limit one log every second.
-		{
-			SV_WriteAttackLog("Detected flood of getinfo/getstatus connectionless packets\n");
-			lastGlobalLogTime = timeNow;
-		}
-
-		return qtrue;
+		return DRDOS_FLOOD;
 	}
 	if (specificCount >= 3)   // Already sent 3 to this IP in last 2 seconds.
 	{
-		if (lastSpecificLogTime + 1000 <= timeNow)   // Limit one log every second.
-		{
-			SV_WriteAttackLog(va("Possible DRDoS attack to address %s, ignoring getinfo/getstatus connectionless packet\n",
-			                     NET_AdrToString(exactFrom)));
-			lastSpecificLogTime = timeNow;
-		}
-
-		return qtrue;
+		return DRDOS_ADDRESS;
 	}
 
-	receipt       = &svs.infoReceipts[oldest];
+	receipt       = &receipts[oldest];
 	receipt->adr  = from;
 	receipt->time = timeNow;
-	return qfalse;
+	return DRDOS_NONE;
 }
 
 /**
@@ -1270,6 +1354,17 @@ void SV_PacketEvent(netadr_t from, msg_t *msg)
 	client_t *cl;
 	int      qport;
 
+	// the game is busy with the bot think, counted when it comes back
+	if (SV_GameBotThinkDefer(from, msg))
+	{
+		return;
+	}
+
+	if (sv_metrics->integer)
+	{
+		SV_MetricsPacket(msg->cursize);
+	}
+
 	// check for connectionless packet (0xffffffff) first
 	if (msg->cursize >= 4 && *(int *)msg->data == -1)
 	{
@@ -1567,6 +1662,7 @@ void SV_Frame(int msec)
 	int        startTime;
 	char       mapname[MAX_QPATH];
 	int        frameStartTime = 0;
+	int64_t    frameStartUsec = Sys_Microseconds();
 	static int start, end;
 
 	start           = Sys_Milliseconds();
@@ -1693,7 +1789,7 @@ void SV_Frame(int msec)
 		svs.time        += frameMsec;
 
 		// let everything in the world think and move
-		VM_Call(gvm, GAME_RUN_FRAME, svs.time);
+		SV_GameRunFrame(svs.time);
 
 		// play/record demo frame (if enabled)
 		if (sv.demoState == DS_RECORDING) // Record the frame
@@ -1716,6 +1812,12 @@ void SV_Frame(int msec)
 		time_game = Sys_Milliseconds() - startTime;
 	}
 
+	// feed the relays, or read the relayed game server
+	SV_RelayFrame();
+
+	// publish the getinfo/getstatus replies for the network front-end
+	SV_FrontendFrame();
+
 	// check timeouts
 	SV_CheckTimeouts();
 
@@ -1723,11 +1825,21 @@ void SV_Frame(int msec)
 	SV_CheckClientUserinfoTimer();
 
 	// send messages back to the clients
+	Prof_Begin(PROF_SV_SEND);
 	SV_SendClientMessages();
+	Prof_End();
 
 	// send a heartbeat to the master if needed
 	SV_MasterHeartbeat(HEARTBEAT_GAME);
 
+	// let the bots think on the finished frame
+	SV_GameBotThinkStart(frameStartUsec);
+
+	if (sv_metrics->integer || sv_metrics->modified)
+	{
+		SV_MetricsFrame(Sys_Microseconds() - frameStartUsec);
+	}
+
 	if (com_dedicated->integer)
 	{
 		int frameEndTime = Sys_Milliseconds();
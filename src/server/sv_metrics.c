@@ -0,0 +1,527 @@
+/*
+ * Wolfenstein: Enemy Territory GPL Source Code
+ * Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+ *
+ * ET: Legacy
+ * Copyright (C) 2012-2018 ET:Legacy team <mail@etlegacy.com>
+ *
+ * This file is part of ET: Legacy - http://www.etlegacy.com
+ *
+ * ET: Legacy is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ET: Legacy is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ET: Legacy. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, Wolfenstein: Enemy Territory GPL Source Code is also
+ * subject to certain additional terms. You should have received a copy
+ * of these additional terms immediately following the terms and conditions
+ * of the GNU General Public License which accompanied the source code.
+ * If not, please request a copy in writing from id Software at the address below.
+ *
+ * id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+ */
+/**
+ * @file sv_metrics.c
+ * @brief Server metrics in the Prometheus text exposition format
+ *
+ * With sv_metrics 1 the server counts its frame times and traffic, and exposes
+ * them with the client, entity and memory gauges in two ways:
+ * - on sv_metricsPort, a TCP port of the loopback interface answering any HTTP
+ *   request with the metrics, for a scraper on the same host or behind a proxy
+ * - to sv_metricsFile every sv_metricsInterval seconds, written aside and renamed
+ *   over the old one, for the textfile collector of the node exporter
+ *
+ * With sv_metrics 0 the frame path only tests the cvar.
+ */
+
+#include "server.h"
+
+#define METRICS_BUFFER_SIZE     0x10000
+#define METRICS_REQUEST_SIZE    1024
+#define MAX_METRICS_CONNECTIONS 4
+#define METRICS_TIMEOUT         5000
+
+#define METRICS_FRAME_BUCKETS   8
+
+/**
+ * @var metricsFrameBuckets
+ * @brief Upper bounds of the frame time histogram, in seconds
+ */
+static const double metricsFrameBuckets[METRICS_FRAME_BUCKETS] =
+{
+	0.001, 0.0025, 0.005, 0.01, 0.025, 0.05, 0.1, 0.25
+};
+
+/**
+ * @struct metricsBuffer_t
+ * @brief A rendered exposition
+ */
+typedef struct
+{
+	char data[METRICS_BUFFER_SIZE];
+	int length;
+} metricsBuffer_t;
+
+/**
+ * @struct metricsConnection_t
+ * @brief A scraper connected to sv_metricsPort
+ */
+typedef struct
+{
+	int sock;                               ///< -1 when free
+	int acceptTime;
+	char request[METRICS_REQUEST_SIZE];
+	int requestLength;
+	qboolean replying;                      ///< the request is in, reply is being sent
+	int sent;
+	metricsBuffer_t reply;
+} metricsConnection_t;
+
+/**
+ * @struct svMetrics_s
+ * @brief Counters since sv_metrics was turned on
+ */
+static struct svMetrics_s
+{
+	int64_t frames[METRICS_FRAME_BUCKETS + 1];  ///< per bucket, the last one is +Inf
+	int64_t frameCount;
+	double frameSum;                            ///< seconds
+
+	int64_t packetsIn;
+	int64_t bytesIn;
+	int64_t bytesOut;                           ///< snapshot bytes on the wire
+	int64_t bytesOutUncompressed;               ///< the same before the huffman coding
+
+	int nextWrite;                              ///< Sys_Milliseconds of the next sv_metricsFile
+
+	int listenSocket;
+	int listenPort;
+	metricsConnection_t connections[MAX_METRICS_CONNECTIONS];
+} svMetrics;
+
+static metricsBuffer_t metricsBody;
+
+/**
+ * @brief Append to a rendered exposition, silently truncated when it is full
+ * @param[in,out] buf
+ * @param[in] fmt
+ */
+static void QDECL SV_MetricsPrintf(metricsBuffer_t *buf, const char *fmt, ...)
+{
+	va_list argptr;
+	int     len;
+
+	if (buf->length >= METRICS_BUFFER_SIZE - 1)
+	{
+		return;
+	}
+
+	va_start(argptr, fmt);
+	len = Q_vsnprintf(buf->data + buf->length, METRICS_BUFFER_SIZE - buf->length, fmt, argptr);
+	va_end(argptr);
+
+	if (len < 0 || buf->length + len >= METRICS_BUFFER_SIZE)
+	{
+		buf->length = METRICS_BUFFER_SIZE - 1;
+		return;
+	}
+
+	buf->length += len;
+}
+
+/**
+ * @brief The HELP and TYPE lines of a metric
+ * @param[in,out] buf
+ * @param[in] name
+ * @param[in] type
+ * @param[in] help
+ */
+static void SV_MetricsHeader(metricsBuffer_t *buf, const char *name, const char *type, const char *help)
+{
+	SV_MetricsPrintf(buf, "# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+/**
+ * @brief Render all metrics
+ * @param[out] buf
+ */
+static void SV_MetricsRender(metricsBuffer_t *buf)
+{
+	memoryUsage_t memory;
+	client_t      *cl;
+	int64_t       cumulative = 0;
+	int           connected = 0, active = 0, linked = 0;
+	int           i;
+
+	buf->length = 0;
+
+	SV_MetricsHeader(buf, "etl_frame_seconds", "histogram", "Time of a server frame.");
+	for (i = 0; i < METRICS_FRAME_BUCKETS; i++)
+	{
+		cumulative += svMetrics.frames[i];
+		SV_MetricsPrintf(buf, "etl_frame_seconds_bucket{le=\"%g\"} %lld\n", metricsFrameBuckets[i], (long long)cumulative);
+	}
+	SV_MetricsPrintf(buf, "etl_frame_seconds_bucket{le=\"+Inf\"} %lld\n", (long long)svMetrics.frameCount);
+	SV_MetricsPrintf(buf, "etl_frame_seconds_sum %f\n", svMetrics.frameSum);
+	SV_MetricsPrintf(buf, "etl_frame_seconds_count %lld\n", (long long)svMetrics.frameCount);
+
+	SV_MetricsHeader(buf, "etl_server_load", "gauge", "Average frame time of the dedicated server in percent of the frame, -1 when unknown.");
+	SV_MetricsPrintf(buf, "etl_server_load %i\n", svs.serverLoad);
+
+	SV_MetricsHeader(buf, "etl_server_time_seconds", "gauge", "Server time.");
+	SV_MetricsPrintf(buf, "etl_server_time_seconds %.3f\n", svs.time / 1000.0);
+
+	SV_MetricsHeader(buf, "etl_received_packets_total", "counter", "Packets received by the server.");
+	SV_MetricsPrintf(buf, "etl_received_packets_total %lld\n", (long long)svMetrics.packetsIn);
+	SV_MetricsHeader(buf, "etl_received_bytes_total", "counter", "Bytes received by the server.");
+	SV_MetricsPrintf(buf, "etl_received_bytes_total %lld\n", (long long)svMetrics.bytesIn);
+
+	SV_MetricsHeader(buf, "etl_sent_bytes_total", "counter", "Bytes of the messages sent to the clients.");
+	SV_MetricsPrintf(buf, "etl_sent_bytes_total %lld\n", (long long)svMetrics.bytesOut);
+	SV_MetricsHeader(buf, "etl_sent_uncompressed_bytes_total", "counter", "Bytes of the messages sent to the clients before the huffman coding.");
+	SV_MetricsPrintf(buf, "etl_sent_uncompressed_bytes_total %lld\n", (long long)svMetrics.bytesOutUncompressed);
+	SV_MetricsHeader(buf, "etl_huffman_ratio", "gauge", "Sent bytes per uncompressed byte.");
+	SV_MetricsPrintf(buf, "etl_huffman_ratio %f\n", svMetrics.bytesOutUncompressed ? (double)svMetrics.bytesOut / svMetrics.bytesOutUncompressed : 0.0);
+
+	SV_MetricsHeader(buf, "etl_client_ping_milliseconds", "gauge", "Ping of a client.");
+	for (i = 0, cl = svs.clients; i < sv_maxclients->integer; i++, cl++)
+	{
+		if (cl->state >= CS_CONNECTED)
+		{
+			SV_MetricsPrintf(buf, "etl_client_ping_milliseconds{client=\"%i\",bot=\"%i\"} %i\n", i,
+			                 (cl->gentity && (cl->gentity->r.svFlags & SVF_BOT)) ? 1 : 0, cl->ping);
+		}
+	}
+
+	SV_MetricsHeader(buf, "etl_client_snapshot_interval_milliseconds", "gauge", "Snapshot interval a client asked for.");
+	for (i = 0, cl = svs.clients; i < sv_maxclients->integer; i++, cl++)
+	{
+		if (cl->state >= CS_CONNECTED)
+		{
+			SV_MetricsPrintf(buf, "etl_client_snapshot_interval_milliseconds{client=\"%i\"} %i\n", i, cl->snapshotMsec);
+		}
+	}
+
+	SV_MetricsHeader(buf, "etl_client_messages_total", "counter", "Messages sent to a client, their rate is the snapshot rate it gets.");
+	for (i = 0, cl = svs.clients; i < sv_maxclients->integer; i++, cl++)
+	{
+		if (cl->state >= CS_CONNECTED)
+		{
+			SV_MetricsPrintf(buf, "etl_client_messages_total{client=\"%i\"} %i\n", i, cl->netchan.outgoingSequence);
+		}
+
+		if (cl->state == CS_ACTIVE)
+		{
+			active++;
+		}
+		else if (cl->state >= CS_CONNECTED)
+		{
+			connected++;
+		}
+	}
+
+	SV_MetricsHeader(buf, "etl_clients", "gauge", "Clients by state.");
+	SV_MetricsPrintf(buf, "etl_clients{state=\"connecting\"} %i\n", connected);
+	SV_MetricsPrintf(buf, "etl_clients{state=\"active\"} %i\n", active);
+	SV_MetricsPrintf(buf, "etl_clients{state=\"free\"} %i\n", sv_maxclients->integer - connected - active);
+
+	if (sv.state == SS_GAME)
+	{
+		for (i = 0; i < sv.num_entities; i++)
+		{
+			if (SV_GentityNum(i)->r.linked)
+			{
+				linked++;
+			}
+		}
+	}
+
+	SV_MetricsHeader(buf, "etl_entities", "gauge", "Entities of the game.");
+	SV_MetricsPrintf(buf, "etl_entities %i\n", sv.state == SS_GAME ? sv.num_entities : 0);
+	SV_MetricsHeader(buf, "etl_entities_linked", "gauge", "Entities of the game linked into the world.");
+	SV_MetricsPrintf(buf, "etl_entities_linked %i\n", linked);
+
+	Com_MemoryUsage(&memory);
+
+	SV_MetricsHeader(buf, "etl_zone_used_bytes", "gauge", "Bytes used of a zone.");
+	SV_MetricsPrintf(buf, "etl_zone_used_bytes{zone=\"main\"} %i\n", memory.zoneUsed);
+	SV_MetricsPrintf(buf, "etl_zone_used_bytes{zone=\"small\"} %i\n", memory.smallZoneUsed);
+	SV_MetricsHeader(buf, "etl_zone_size_bytes", "gauge", "Size of a zone.");
+	SV_MetricsPrintf(buf, "etl_zone_size_bytes{zone=\"main\"} %i\n", memory.zoneSize);
+	SV_MetricsPrintf(buf, "etl_zone_size_bytes{zone=\"small\"} %i\n", memory.smallZoneSize);
+
+	SV_MetricsHeader(buf, "etl_hunk_used_bytes", "gauge", "Bytes used of the hunk.");
+	SV_MetricsPrintf(buf, "etl_hunk_used_bytes %i\n", memory.hunkUsed);
+	SV_MetricsHeader(buf, "etl_hunk_size_bytes", "gauge", "Size of the hunk, com_hunkMegs.");
+	SV_MetricsPrintf(buf, "etl_hunk_size_bytes %i\n", memory.hunkSize);
+	SV_MetricsHeader(buf, "etl_hunk_arena_bytes", "gauge", "Bytes of the hunk accounted to a sub-arena.");
+	for (i = 0; i < HUNK_TAG_MAX; i++)
+	{
+		SV_MetricsPrintf(buf, "etl_hunk_arena_bytes{arena=\"%s\"} %i\n", memory.hunkArenaNames[i], memory.hunkArenaUsed[i]);
+	}
+}
+
+/**
+ * @brief Count a received packet
+ * @param[in] bytes
+ */
+void SV_MetricsPacket(int bytes)
+{
+	svMetrics.packetsIn++;
+	svMetrics.bytesIn += bytes;
+}
+
+/**
+ * @brief Count the messages of a SV_SendClientMessages
+ * @param[in] bytes
+ * @param[in] uncompressedBytes
+ */
+void SV_MetricsSent(int bytes, int uncompressedBytes)
+{
+	svMetrics.bytesOut             += bytes;
+	svMetrics.bytesOutUncompressed += uncompressedBytes;
+}
+
+/**
+ * @brief Close a scraper connection
+ * @param[in,out] conn
+ */
+static void SV_MetricsClose(metricsConnection_t *conn)
+{
+	NET_TCPClose(conn->sock);
+	conn->sock = -1;
+}
+
+/**
+ * @brief Close the port and the connections, and clear the counters
+ */
+static void SV_MetricsReset(void)
+{
+	int i;
+
+	for (i = 0; i < MAX_METRICS_CONNECTIONS; i++)
+	{
+		if (svMetrics.connections[i].sock >= 0)
+		{
+			SV_MetricsClose(&svMetrics.connections[i]);
+		}
+	}
+
+	NET_TCPClose(svMetrics.listenSocket);
+
+	Com_Memset(&svMetrics, 0, sizeof(svMetrics));
+	svMetrics.listenSocket = -1;
+	for (i = 0; i < MAX_METRICS_CONNECTIONS; i++)
+	{
+		svMetrics.connections[i].sock = -1;
+	}
+}
+
+/**
+ * @brief Accept scrapers, read their requests and send the replies
+ */
+static void SV_MetricsServe(void)
+{
+	metricsConnection_t *conn;
+	netadr_t            from;
+	int                 sock, i, ret;
+
+	while ((sock = NET_TCPAccept(svMetrics.listenSocket, &from)) >= 0)
+	{
+		for (i = 0; i < MAX_METRICS_CONNECTIONS; i++)
+		{
+			if (svMetrics.connections[i].sock < 0)
+			{
+				break;
+			}
+		}
+
+		if (i == MAX_METRICS_CONNECTIONS)
+		{
+			NET_TCPClose(sock);
+			continue;
+		}
+
+		conn                = &svMetrics.connections[i];
+		conn->sock          = sock;
+		conn->acceptTime    = Sys_Milliseconds();
+		conn->requestLength = 0;
+		conn->replying      = qfalse;
+		conn->sent          = 0;
+	}
+
+	for (i = 0, conn = svMetrics.connections; i < MAX_METRICS_CONNECTIONS; i++, conn++)
+	{
+		if (conn->sock < 0)
+		{
+			continue;
+		}
+
+		if (Sys_Milliseconds() - conn->acceptTime > METRICS_TIMEOUT)
+		{
+			SV_MetricsClose(conn);
+			continue;
+		}
+
+		if (!conn->replying)
+		{
+			ret = NET_TCPRecv(conn->sock, conn->request + conn->requestLength, METRICS_REQUEST_SIZE - 1 - conn->requestLength);
+			if (ret < 0)
+			{
+				SV_MetricsClose(conn);
+				continue;
+			}
+
+			conn->requestLength                += ret;
+			conn->request[conn->requestLength] = '\0';
+
+			// any request gets the metrics, once its header is complete
+			if (!strstr(conn->request, "\r\n\r\n") && !strstr(conn->request, "\n\n") && conn->requestLength < METRICS_REQUEST_SIZE - 1)
+			{
+				continue;
+			}
+
+			SV_MetricsRender(&metricsBody);
+
+			conn->reply.length = 0;
+			SV_MetricsPrintf(&conn->reply, "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\nContent-Length: %i\r\nConnection: close\r\n\r\n", metricsBody.length);
+			if (conn->reply.length + metricsBody.length > METRICS_BUFFER_SIZE)
+			{
+				SV_MetricsClose(conn);
+				continue;
+			}
+			Com_Memcpy(conn->reply.data + conn->reply.length, metricsBody.data, metricsBody.length);
+			conn->reply.length += metricsBody.length;
+			conn->replying      = qtrue;
+		}
+
+		ret = NET_TCPSend(conn->sock, conn->reply.data + conn->sent, conn->reply.length - conn->sent);
+		if (ret < 0)
+		{
+			SV_MetricsClose(conn);
+			continue;
+		}
+
+		conn->sent += ret;
+		if (conn->sent == conn->reply.length)
+		{
+			SV_MetricsClose(conn);
+		}
+	}
+}
+
+/**
+ * @brief Write sv_metricsFile aside and rename it over the old one
+ */
+static void SV_MetricsWriteFile(void)
+{
+	char         tempName[MAX_QPATH];
+	fileHandle_t f;
+
+	Com_sprintf(tempName, sizeof(tempName), "%s.tmp", sv_metricsFile->string);
+
+	f = FS_FOpenFileWrite(tempName);
+	if (!f)
+	{
+		Com_Printf(S_COLOR_YELLOW "WARNING: couldn't write the metrics to %s\n", tempName);
+		return;
+	}
+
+	SV_MetricsRender(&metricsBody);
+	FS_Write(metricsBody.data, metricsBody.length, f);
+	FS_FCloseFile(f);
+
+	FS_Rename(tempName, sv_metricsFile->string);
+}
+
+/**
+ * @brief Count a server frame, serve sv_metricsPort and write sv_metricsFile
+ *
+ * Called at the end of SV_Frame while sv_metrics is on, and once after it is turned off.
+ *
+ * @param[in] frameUsec - time the frame took
+ */
+void SV_MetricsFrame(int64_t frameUsec)
+{
+	double seconds = frameUsec / 1000000.0;
+	int    i;
+
+	if (sv_metrics->modified)
+	{
+		sv_metrics->modified = qfalse;
+		SV_MetricsReset();
+		if (!sv_metrics->integer)
+		{
+			return;
+		}
+	}
+
+	for (i = 0; i < METRICS_FRAME_BUCKETS && seconds > metricsFrameBuckets[i]; i++)
+	{
+	}
+	svMetrics.frames[i]++;
+	svMetrics.frameCount++;
+	svMetrics.frameSum += seconds;
+
+	if (svMetrics.listenSocket >= 0 && sv_metricsPort->integer != svMetrics.listenPort)
+	{
+		NET_TCPClose(svMetrics.listenSocket);
+		svMetrics.listenSocket = -1;
+	}
+
+	if (svMetrics.listenSocket < 0 && sv_metricsPort->integer > 0 && sv_metricsPort->integer != svMetrics.listenPort)
+	{
+		svMetrics.listenSocket = NET_TCPListen(sv_metricsPort->integer, qtrue);
+		svMetrics.listenPort   = sv_metricsPort->integer;
+
+		if (svMetrics.listenSocket >= 0)
+		{
+			Com_Printf("Serving the metrics on 127.0.0.1:%i\n", svMetrics.listenPort);
+		}
+	}
+
+	if (svMetrics.listenSocket >= 0)
+	{
+		SV_MetricsServe();
+	}
+
+	if (sv_metricsFile->string[0] && Sys_Milliseconds() - svMetrics.nextWrite >= 0)
+	{
+		svMetrics.nextWrite = Sys_Milliseconds() + 1000 * MAX(sv_metricsInterval->integer, 1);
+		SV_MetricsWriteFile();
+	}
+}
+
+/**
+ * @brief Called by SV_Init
+ */
+void SV_MetricsInit(void)
+{
+	int i;
+
+	svMetrics.listenSocket = -1;
+	for (i = 0; i < MAX_METRICS_CONNECTIONS; i++)
+	{
+		svMetrics.connections[i].sock = -1;
+	}
+}
+
+/**
+ * @brief Close the metrics port, it is opened again by the next SV_MetricsFrame
+ */
+void SV_MetricsShutdown(void)
+{
+	if (sv_metrics)
+	{
+		SV_MetricsReset();
+		sv_metrics->modified = qtrue;
+	}
+}
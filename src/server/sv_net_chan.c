@@ -162,6 +162,25 @@ void SV_Netchan_ClearQueue(client_t *client)
 
 	client->netchan_start_queue = NULL;
 	client->netchan_end_queue   = &client->netchan_start_queue;
+
+	client->netchanStats.queueDepth = 0;
+}
+
+/**
+ * @brief Hand a message to the netchan and schedule the next packet
+ * @param[in,out] client
+ * @param[in] msg encoded message
+ */
+static void SV_Netchan_TransmitMessage(client_t *client, msg_t *msg)
+{
+	Netchan_Transmit(&client->netchan, msg->cursize, msg->data);
+	SV_RatePace(client);
+
+	client->netchanStats.messages++;
+	if (client->netchan.unsentFragments)
+	{
+		client->netchanStats.fragmented++;
+	}
 }
 
 /**
@@ -177,7 +196,8 @@ void SV_Netchan_TransmitNextInQueue(client_t *client)
 
 	SV_Netchan_Encode(client, &netbuf->msg, netbuf->lastClientCommandString);
 
-	Netchan_Transmit(&client->netchan, netbuf->msg.cursize, netbuf->msg.data);
+	SV_Netchan_TransmitMessage(client, &netbuf->msg);
+	client->netchanStats.queueDepth--;
 
 	// pop from queue
 	client->netchan_start_queue = netbuf->next;
@@ -195,24 +215,45 @@ void SV_Netchan_TransmitNextInQueue(client_t *client)
 }
 
 /**
- * @brief SV_Netchan_TransmitNextFragment
+ * @brief Send the next fragment, or queued message, once the rate allows it
  * @param[in] client
- * @return
+ * @return The number of msec until the next one is due, -1 when nothing is left
  */
 int SV_Netchan_TransmitNextFragment(client_t *client)
 {
+	int64_t late;
+
+	if (!client->netchan.unsentFragments && !client->netchan_start_queue)
+	{
+		return -1;
+	}
+
+	// how far past its schedule this packet goes
+	late = Sys_Microseconds() - client->nextSendTime;
+	client->netchanStats.paced++;
+	if (late > 0)
+	{
+		client->netchanStats.lateUsec   += late;
+		client->netchanStats.maxLateUsec = MAX(client->netchanStats.maxLateUsec, (int)late);
+	}
+
 	if (client->netchan.unsentFragments)
 	{
 		Netchan_TransmitNextFragment(&client->netchan);
-		return SV_RateMsec(client);
+		SV_RatePace(client);
+		client->netchanStats.fragments++;
 	}
-	else if (client->netchan_start_queue)
+	else
 	{
 		SV_Netchan_TransmitNextInQueue(client);
-		return SV_RateMsec(client);
 	}
 
-	return -1;
+	if (!client->netchan.unsentFragments && !client->netchan_start_queue)
+	{
+		return -1;
+	}
+
+	return SV_RateMsec(client);
 }
 
 /**
@@ -267,11 +308,15 @@ void SV_Netchan_Transmit(client_t *client, msg_t *msg)
 		// insert it in the queue, the message will be encoded and sent later
 		*client->netchan_end_queue = netbuf;
 		client->netchan_end_queue  = &(*client->netchan_end_queue)->next;
+
+		client->netchanStats.queued++;
+		client->netchanStats.queueDepth++;
+		client->netchanStats.maxQueueDepth = MAX(client->netchanStats.maxQueueDepth, client->netchanStats.queueDepth);
 	}
 	else
 	{
 		SV_Netchan_Encode(client, msg, client->lastClientCommandString);
-		Netchan_Transmit(&client->netchan, msg->cursize, msg->data);
+		SV_Netchan_TransmitMessage(client, msg);
 	}
 }
 
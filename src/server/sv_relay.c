@@ -0,0 +1,855 @@
+/*
+ * Wolfenstein: Enemy Territory GPL Source Code
+ * Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+ *
+ * ET: Legacy
+ * Copyright (C) 2012-2018 ET:Legacy team <mail@etlegacy.com>
+ *
+ * This file is part of ET: Legacy - http://www.etlegacy.com
+ *
+ * ET: Legacy is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ET: Legacy is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ET: Legacy. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, Wolfenstein: Enemy Territory GPL Source Code is also
+ * subject to certain additional terms. You should have received a copy
+ * of these additional terms immediately following the terms and conditions
+ * of the GNU General Public License which accompanied the source code.
+ * If not, please request a copy in writing from id Software at the address below.
+ *
+ * id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+ */
+/**
+ * @file sv_relay.c
+ * @brief Relay servers, re-serving a game server to more spectators than it has slots
+ *
+ * A game server with sv_relayPassword set accepts relays on the TCP port sv_relayPort
+ * and streams its server-side demo to them: a demo header at the next keyframe, then
+ * everything it records. A relay (relay_connect) plays that stream back like a
+ * server-side demo, sv_relayDelay seconds late, so its own clients get snapshots built
+ * and delta compressed by the relay. The democlients of the relay take client slots,
+ * so each relay adds sv_maxclients minus the game server's slots of spectators.
+ *
+ * This file only moves the bytes, sv_demo.c writes and plays the stream.
+ */
+
+#include "server.h"
+
+#define RELAY_PROTOCOL          1
+#define MAX_RELAY_SUBSCRIBERS   8
+#define RELAY_SEND_SIZE         0x400000    ///< 4 MB per relay, must be a power of two, a relay that can't keep up is dropped
+#define RELAY_SEND_MASK         (RELAY_SEND_SIZE - 1)
+#define RELAY_RECV_SIZE         0x1000000   ///< 16 MB, must be a power of two, holds the delayed part of the stream
+#define RELAY_RECV_MASK         (RELAY_RECV_SIZE - 1)
+#define MAX_RELAY_MARKS         4096        ///< arrival times of the received data, for the delay
+#define RELAY_HANDSHAKE_TIME    5000
+
+/**
+ * @enum relayState_t
+ * @brief State of a relay connection, on the game server and on the relay
+ */
+typedef enum
+{
+	RS_FREE = 0,
+	RS_CONNECTING,          ///< relay: TCP connection pending
+	RS_HANDSHAKE,           ///< waiting for the password line or its answer
+	RS_WAITING,             ///< game server: authenticated, streaming starts at the next keyframe
+	RS_STREAMING
+} relayState_t;
+
+/**
+ * @struct relaySubscriber_s
+ * @typedef relaySubscriber_t
+ * @brief A relay connected to this game server
+ */
+typedef struct relaySubscriber_s
+{
+	relayState_t state;
+	int sock;
+	netadr_t address;
+	int connectTime;
+
+	char line[MAX_STRING_CHARS];        ///< handshake line
+	int lineLen;
+
+	byte *data;                         ///< pending output
+	unsigned int head;
+	unsigned int tail;
+	unsigned int bytesSent;
+} relaySubscriber_t;
+
+/**
+ * @struct relayMark_s
+ * @typedef relayMark_t
+ * @brief Stream offset reached at a given time
+ */
+typedef struct relayMark_s
+{
+	unsigned int offset;
+	int time;
+} relayMark_t;
+
+/**
+ * @struct relayUpstream_s
+ * @typedef relayUpstream_t
+ * @brief The game server this relay streams from
+ */
+typedef struct relayUpstream_s
+{
+	relayState_t state;
+	int sock;
+	netadr_t address;
+	char password[MAX_CVAR_VALUE_STRING];
+	int connectTime;
+
+	char line[64];                      ///< handshake answer
+	int lineLen;
+
+	byte *data;                         ///< received stream, offsets are running byte counts
+	unsigned int head;                  ///< received so far
+	unsigned int tail;                  ///< released by the playback
+
+	relayMark_t marks[MAX_RELAY_MARKS];
+	int firstMark;
+	int numMarks;
+} relayUpstream_t;
+
+static int               relayListenSocket = -1;
+static int               relayListenPort;
+static relaySubscriber_t relaySubscribers[MAX_RELAY_SUBSCRIBERS];
+static relayUpstream_t   relayUpstream;
+static int               relayRecordRequest;
+
+/*
+=============================================================================
+
+GAME SERVER SIDE
+
+=============================================================================
+*/
+
+/**
+ * @brief Close a relay connection
+ * @param[in,out] sub
+ * @param[in] reason
+ */
+static void SV_RelayDropSubscriber(relaySubscriber_t *sub, const char *reason)
+{
+	Com_Printf("RELAY: %s dropped: %s (%u bytes sent)\n", NET_AdrToString(sub->address), reason, sub->bytesSent);
+
+	NET_TCPClose(sub->sock);
+	if (sub->data)
+	{
+		Com_Dealloc(sub->data);
+	}
+	Com_Memset(sub, 0, sizeof(*sub));
+	sub->sock = -1;
+}
+
+/**
+ * @brief Queue data for a relay
+ * @param[in,out] sub
+ * @param[in] data
+ * @param[in] len
+ * @return qfalse if it didn't fit, the relay has been dropped then
+ */
+static qboolean SV_RelayQueue(relaySubscriber_t *sub, const void *data, unsigned int len)
+{
+	unsigned int pos, first;
+
+	if (RELAY_SEND_SIZE - (sub->head - sub->tail) < len)
+	{
+		SV_RelayDropSubscriber(sub, "too far behind");
+		return qfalse;
+	}
+
+	pos   = sub->head & RELAY_SEND_MASK;
+	first = RELAY_SEND_SIZE - pos;
+
+	if (first >= len)
+	{
+		Com_Memcpy(sub->data + pos, data, len);
+	}
+	else
+	{
+		Com_Memcpy(sub->data + pos, data, first);
+		Com_Memcpy(sub->data, (const byte *)data + first, len - first);
+	}
+	sub->head += len;
+
+	return qtrue;
+}
+
+/**
+ * @brief Check the password line of a relay
+ * @param[in,out] sub
+ */
+static void SV_RelayHandshake(relaySubscriber_t *sub)
+{
+	const char *reason = NULL;
+	int        ret;
+
+	while (sub->lineLen < (int)sizeof(sub->line) - 1)
+	{
+		ret = NET_TCPRecv(sub->sock, sub->line + sub->lineLen, 1);
+		if (ret < 0)
+		{
+			SV_RelayDropSubscriber(sub, "connection closed");
+			return;
+		}
+		if (!ret)
+		{
+			if (Sys_Milliseconds() - sub->connectTime > RELAY_HANDSHAKE_TIME)
+			{
+				SV_RelayDropSubscriber(sub, "handshake timed out");
+			}
+			return;
+		}
+		if (sub->line[sub->lineLen] == '\n')
+		{
+			break;
+		}
+		sub->lineLen++;
+	}
+	sub->line[sub->lineLen] = '\0';
+
+	Cmd_TokenizeString(sub->line);
+
+	if (Q_stricmp(Cmd_Argv(0), "relay") || atoi(Cmd_Argv(1)) != RELAY_PROTOCOL)
+	{
+		reason = "protocol mismatch";
+	}
+	else if (!sv_relayPassword->string[0] || strcmp(Cmd_Argv(2), sv_relayPassword->string))
+	{
+		reason = "bad password";
+	}
+
+	if (reason)
+	{
+		(void) NET_TCPSend(sub->sock, va("ERR %s\n", reason), strlen(reason) + 5);
+		SV_RelayDropSubscriber(sub, reason);
+		return;
+	}
+
+	(void) NET_TCPSend(sub->sock, "OK\n", 3);
+
+	sub->data  = Com_Allocate(RELAY_SEND_SIZE);
+	sub->state = RS_WAITING;
+	Com_Printf("RELAY: %s connected, streaming from the next keyframe.\n", NET_AdrToString(sub->address));
+}
+
+/**
+ * @brief Accept, authenticate and feed the relays of this game server
+ */
+static void SV_RelayServeFrame(void)
+{
+	relaySubscriber_t *sub;
+	netadr_t          from;
+	int               i, sock, port, ret;
+	unsigned int      pos, len;
+	qboolean          waiting = qfalse;
+
+	port = sv_relayPort->integer ? sv_relayPort->integer : Cvar_VariableIntegerValue("net_port");
+
+	if (relayListenSocket >= 0 && (!sv_relayPassword->string[0] || port != relayListenPort))
+	{
+		NET_TCPClose(relayListenSocket);
+		relayListenSocket = -1;
+	}
+
+	if (relayListenSocket < 0 && sv_relayPassword->string[0] && port != relayListenPort)
+	{
+		relayListenSocket = NET_TCPListen(port, qfalse);
+		relayListenPort   = port;
+
+		if (relayListenSocket >= 0)
+		{
+			Com_Printf("RELAY: Accepting relays on TCP port %i.\n", port);
+		}
+	}
+
+	if (!sv_relayPassword->string[0])
+	{
+		relayListenPort = 0;
+	}
+
+	while (relayListenSocket >= 0 && (sock = NET_TCPAccept(relayListenSocket, &from)) >= 0)
+	{
+		for (i = 0, sub = relaySubscribers; i < MAX_RELAY_SUBSCRIBERS; i++, sub++)
+		{
+			if (sub->state == RS_FREE)
+			{
+				break;
+			}
+		}
+
+		if (i == MAX_RELAY_SUBSCRIBERS)
+		{
+			(void) NET_TCPSend(sock, "ERR server full\n", 16);
+			NET_TCPClose(sock);
+			continue;
+		}
+
+		Com_Memset(sub, 0, sizeof(*sub));
+		sub->state       = RS_HANDSHAKE;
+		sub->sock        = sock;
+		sub->address     = from;
+		sub->connectTime = Sys_Milliseconds();
+	}
+
+	for (i = 0, sub = relaySubscribers; i < MAX_RELAY_SUBSCRIBERS; i++, sub++)
+	{
+		if (sub->state == RS_HANDSHAKE)
+		{
+			SV_RelayHandshake(sub);
+		}
+
+		if (sub->state == RS_WAITING)
+		{
+			waiting = qtrue;
+		}
+
+		// send up to the end of the ring, the rest goes in the next pass
+		while (sub->state >= RS_WAITING && sub->head != sub->tail)
+		{
+			pos = sub->tail & RELAY_SEND_MASK;
+			len = MIN(sub->head - sub->tail, RELAY_SEND_SIZE - pos);
+
+			ret = NET_TCPSend(sub->sock, sub->data + pos, len);
+			if (ret < 0)
+			{
+				SV_RelayDropSubscriber(sub, "connection closed");
+				break;
+			}
+
+			sub->tail      += ret;
+			sub->bytesSent += ret;
+
+			if ((unsigned int)ret < len)
+			{
+				break;
+			}
+		}
+	}
+
+	// relays are fed by the server-side demo
+	if (waiting && sv.state == SS_GAME && sv.demoState == DS_NONE && sv_demoState->integer == DS_NONE &&
+	    (!relayRecordRequest || Sys_Milliseconds() - relayRecordRequest > 5000))
+	{
+		relayRecordRequest = Sys_Milliseconds();
+		SV_DemoAutoDemoRecord();
+	}
+}
+
+/**
+ * @brief Whether a relay waits for a keyframe to start streaming
+ * @return
+ */
+qboolean SV_RelayWaiting(void)
+{
+	int i;
+
+	for (i = 0; i < MAX_RELAY_SUBSCRIBERS; i++)
+	{
+		if (relaySubscribers[i].state == RS_WAITING)
+		{
+			return qtrue;
+		}
+	}
+
+	return qfalse;
+}
+
+/**
+ * @brief Start streaming to the waiting relays, a keyframe is about to be recorded
+ * @param[in] header demo header message
+ */
+void SV_RelayStartStreams(msg_t *header)
+{
+	relaySubscriber_t *sub;
+	int               i, len = LittleLong(header->cursize);
+
+	for (i = 0, sub = relaySubscribers; i < MAX_RELAY_SUBSCRIBERS; i++, sub++)
+	{
+		if (sub->state != RS_WAITING)
+		{
+			continue;
+		}
+
+		if (SV_RelayQueue(sub, &len, 4) && SV_RelayQueue(sub, header->data, header->cursize))
+		{
+			sub->state = RS_STREAMING;
+		}
+	}
+}
+
+/**
+ * @brief Send recorded demo data to the streaming relays
+ * @param[in] data
+ * @param[in] len
+ */
+void SV_RelayWriteData(const void *data, unsigned int len)
+{
+	int i;
+
+	for (i = 0; i < MAX_RELAY_SUBSCRIBERS; i++)
+	{
+		if (relaySubscribers[i].state == RS_STREAMING)
+		{
+			(void) SV_RelayQueue(&relaySubscribers[i], data, len);
+		}
+	}
+}
+
+/**
+ * @brief The recording ended, streams restart with the next one
+ */
+void SV_RelayStopStreams(void)
+{
+	int i;
+
+	for (i = 0; i < MAX_RELAY_SUBSCRIBERS; i++)
+	{
+		if (relaySubscribers[i].state == RS_STREAMING)
+		{
+			relaySubscribers[i].state = RS_WAITING;
+		}
+	}
+}
+
+/*
+=============================================================================
+
+RELAY SIDE
+
+=============================================================================
+*/
+
+/**
+ * @brief Close the connection to the game server
+ * @param[in] reason
+ */
+void SV_RelayDisconnect(const char *reason)
+{
+	if (relayUpstream.state == RS_FREE)
+	{
+		return;
+	}
+
+	Com_Printf("RELAY: Disconnected from %s: %s (%u bytes received)\n", NET_AdrToString(relayUpstream.address), reason, relayUpstream.head);
+
+	NET_TCPClose(relayUpstream.sock);
+	relayUpstream.sock  = -1;
+	relayUpstream.state = RS_FREE;
+}
+
+/**
+ * @brief Read the stream of the game server
+ */
+static void SV_RelayReceiveFrame(void)
+{
+	char         answer[64];
+	int          ret;
+	unsigned int pos, len, received = 0;
+	relayMark_t  *mark;
+
+	switch (relayUpstream.state)
+	{
+	case RS_CONNECTING:
+		ret = NET_TCPConnected(relayUpstream.sock);
+		if (ret < 0)
+		{
+			SV_RelayDisconnect("connection refused");
+			return;
+		}
+		if (!ret)
+		{
+			if (Sys_Milliseconds() - relayUpstream.connectTime > RELAY_HANDSHAKE_TIME)
+			{
+				SV_RelayDisconnect("connection timed out");
+			}
+			return;
+		}
+
+		Com_sprintf(answer, sizeof(answer), "relay %i ", RELAY_PROTOCOL);
+		if (NET_TCPSend(relayUpstream.sock, answer, strlen(answer)) < 0 ||
+		    NET_TCPSend(relayUpstream.sock, relayUpstream.password, strlen(relayUpstream.password)) < 0 ||
+		    NET_TCPSend(relayUpstream.sock, "\n", 1) < 0)
+		{
+			SV_RelayDisconnect("connection closed");
+			return;
+		}
+		relayUpstream.state = RS_HANDSHAKE;
+		return;
+	case RS_HANDSHAKE:
+		// the answer is a single line, read it byte by byte so no stream data is taken along
+		while (relayUpstream.lineLen < (int)sizeof(relayUpstream.line) - 1)
+		{
+			ret = NET_TCPRecv(relayUpstream.sock, relayUpstream.line + relayUpstream.lineLen, 1);
+			if (ret < 0)
+			{
+				SV_RelayDisconnect("connection closed");
+				return;
+			}
+			if (!ret)
+			{
+				if (Sys_Milliseconds() - relayUpstream.connectTime > RELAY_HANDSHAKE_TIME)
+				{
+					SV_RelayDisconnect("handshake timed out");
+				}
+				return;
+			}
+			if (relayUpstream.line[relayUpstream.lineLen] == '\n')
+			{
+				break;
+			}
+			relayUpstream.lineLen++;
+		}
+		relayUpstream.line[relayUpstream.lineLen] = '\0';
+
+		if (strcmp(relayUpstream.line, "OK"))
+		{
+			SV_RelayDisconnect(relayUpstream.line);
+			return;
+		}
+
+		Com_Printf("RELAY: Connected to %s, waiting for the stream.\n", NET_AdrToString(relayUpstream.address));
+		relayUpstream.state = RS_STREAMING;
+		return;
+	case RS_STREAMING:
+		break;
+	default:
+		return;
+	}
+
+	while (1)
+	{
+		if (RELAY_RECV_SIZE - (relayUpstream.head - relayUpstream.tail) == 0)
+		{
+			SV_RelayDisconnect("stream buffer full, reduce sv_relayDelay");
+			return;
+		}
+
+		pos = relayUpstream.head & RELAY_RECV_MASK;
+		len = MIN(RELAY_RECV_SIZE - (relayUpstream.head - relayUpstream.tail), RELAY_RECV_SIZE - pos);
+
+		ret = NET_TCPRecv(relayUpstream.sock, relayUpstream.data + pos, len);
+		if (ret < 0)
+		{
+			SV_RelayDisconnect("connection closed");
+			return;
+		}
+		if (!ret)
+		{
+			break;
+		}
+
+		relayUpstream.head += ret;
+		received           += ret;
+	}
+
+	if (!received)
+	{
+		return;
+	}
+
+	// note when the data arrived, merging into the last mark if they are all used
+	if (relayUpstream.numMarks == MAX_RELAY_MARKS)
+	{
+		mark = &relayUpstream.marks[(relayUpstream.firstMark + relayUpstream.numMarks - 1) % MAX_RELAY_MARKS];
+	}
+	else
+	{
+		mark = &relayUpstream.marks[(relayUpstream.firstMark + relayUpstream.numMarks) % MAX_RELAY_MARKS];
+		relayUpstream.numMarks++;
+	}
+	mark->offset = relayUpstream.head;
+	mark->time   = Sys_Milliseconds();
+}
+
+/**
+ * @brief Whether the relay is connected to a game server
+ * @return
+ */
+qboolean SV_RelayConnected(void)
+{
+	return relayUpstream.state != RS_FREE;
+}
+
+/**
+ * @brief End of the stream data old enough to be played
+ * @return Stream offset
+ */
+unsigned int SV_RelayAvailable(void)
+{
+	int          now = Sys_Milliseconds() - (int)(sv_relayDelay->value * 1000);
+	unsigned int available;
+	relayMark_t  *mark;
+
+	available = relayUpstream.tail;
+
+	while (relayUpstream.numMarks)
+	{
+		mark = &relayUpstream.marks[relayUpstream.firstMark];
+		if (mark->time > now)
+		{
+			break;
+		}
+
+		available = mark->offset;
+
+		// only the last due mark matters, drop the ones before it
+		if (relayUpstream.numMarks == 1)
+		{
+			break;
+		}
+		if (relayUpstream.marks[(relayUpstream.firstMark + 1) % MAX_RELAY_MARKS].time > now)
+		{
+			break;
+		}
+		relayUpstream.firstMark = (relayUpstream.firstMark + 1) % MAX_RELAY_MARKS;
+		relayUpstream.numMarks--;
+	}
+
+	return available;
+}
+
+/**
+ * @brief Copy stream data, the caller checks it is available
+ * @param[in] offset stream offset
+ * @param[out] buffer
+ * @param[in] len
+ */
+void SV_RelayPeek(unsigned int offset, void *buffer, unsigned int len)
+{
+	unsigned int pos   = offset & RELAY_RECV_MASK;
+	unsigned int first = RELAY_RECV_SIZE - pos;
+
+	if (first >= len)
+	{
+		Com_Memcpy(buffer, relayUpstream.data + pos, len);
+	}
+	else
+	{
+		Com_Memcpy(buffer, relayUpstream.data + pos, first);
+		Com_Memcpy((byte *)buffer + first, relayUpstream.data, len - first);
+	}
+}
+
+/**
+ * @brief Release the stream data before the given offset
+ * @param[in] offset
+ */
+void SV_RelayConsume(unsigned int offset)
+{
+	relayUpstream.tail = offset;
+}
+
+/*
+=============================================================================
+
+COMMANDS
+
+=============================================================================
+*/
+
+/**
+ * @brief Poll the relay connections, called once per server frame
+ */
+void SV_RelayFrame(void)
+{
+	SV_RelayServeFrame();
+
+	if (relayUpstream.state == RS_FREE)
+	{
+		return;
+	}
+
+	SV_RelayReceiveFrame();
+
+	// play the stream once its header and first frame are there
+	if (sv.state == SS_GAME && sv.demoState == DS_NONE && sv_demoState->integer == DS_NONE && SV_DemoRelayReady())
+	{
+		Cbuf_AddText("relay_play\n");
+	}
+}
+
+/**
+ * @brief SV_Relay_Connect_f
+ */
+static void SV_Relay_Connect_f(void)
+{
+	netadr_t adr;
+
+	if (Cmd_Argc() != 3)
+	{
+		Com_Printf("Usage: relay_connect <address[:port]> <password>\n");
+		return;
+	}
+
+	if (!com_sv_running->integer)
+	{
+		Com_Printf("Server is not running.\n");
+		return;
+	}
+
+	if (!NET_StringToAdr(Cmd_Argv(1), &adr, NA_UNSPEC))
+	{
+		Com_Printf("RELAY: Bad address %s\n", Cmd_Argv(1));
+		return;
+	}
+
+	if (adr.type == NA_LOOPBACK)
+	{
+		adr.type  = NA_IP;
+		adr.ip[0] = 127;
+		adr.ip[1] = 0;
+		adr.ip[2] = 0;
+		adr.ip[3] = 1;
+		adr.port  = BigShort(PORT_SERVER);
+	}
+
+	SV_RelayDisconnect("reconnecting");
+
+	if (!relayUpstream.data)
+	{
+		relayUpstream.data = Com_Allocate(RELAY_RECV_SIZE);
+	}
+
+	relayUpstream.sock = NET_TCPConnect(&adr);
+	if (relayUpstream.sock < 0)
+	{
+		return;
+	}
+
+	relayUpstream.state       = RS_CONNECTING;
+	relayUpstream.address     = adr;
+	relayUpstream.connectTime = Sys_Milliseconds();
+	relayUpstream.lineLen     = 0;
+	relayUpstream.head        = 0;
+	relayUpstream.tail        = 0;
+	relayUpstream.firstMark   = 0;
+	relayUpstream.numMarks    = 0;
+	Q_strncpyz(relayUpstream.password, Cmd_Argv(2), sizeof(relayUpstream.password));
+
+	SV_DemoRelayReset();
+
+	Com_Printf("RELAY: Connecting to %s...\n", NET_AdrToString(adr));
+}
+
+/**
+ * @brief SV_Relay_Disconnect_f
+ */
+static void SV_Relay_Disconnect_f(void)
+{
+	if (relayUpstream.state == RS_FREE)
+	{
+		Com_Printf("Not connected to a game server.\n");
+		return;
+	}
+
+	SV_RelayDisconnect("disconnected by the operator");
+}
+
+/**
+ * @brief SV_Relay_Status_f
+ */
+static void SV_Relay_Status_f(void)
+{
+	relaySubscriber_t *sub;
+	int               i;
+	static const char *states[] = { "free", "connecting", "handshake", "waiting", "streaming" };
+
+	if (relayUpstream.state != RS_FREE)
+	{
+		Com_Printf("Relaying %s (%s), delay %.1f sec\n", NET_AdrToString(relayUpstream.address), states[relayUpstream.state], sv_relayDelay->value);
+		Com_Printf("  bytes received : %u\n", relayUpstream.head);
+		Com_Printf("  bytes buffered : %u / %u\n", relayUpstream.head - relayUpstream.tail, RELAY_RECV_SIZE);
+	}
+
+	if (relayListenSocket >= 0)
+	{
+		Com_Printf("Accepting relays on TCP port %i\n", relayListenPort);
+	}
+
+	for (i = 0, sub = relaySubscribers; i < MAX_RELAY_SUBSCRIBERS; i++, sub++)
+	{
+		if (sub->state != RS_FREE)
+		{
+			Com_Printf("  %-22s %-10s %u bytes sent, %u queued\n", NET_AdrToString(sub->address), states[sub->state], sub->bytesSent, sub->head - sub->tail);
+		}
+	}
+}
+
+/**
+ * @brief SV_Relay_Play_f
+ */
+static void SV_Relay_Play_f(void)
+{
+	if (relayUpstream.state == RS_FREE)
+	{
+		Com_Printf("Not connected to a game server.\n");
+		return;
+	}
+
+	SV_DemoRelayPlay();
+}
+
+/**
+ * @brief SV_RelayInit
+ */
+void SV_RelayInit(void)
+{
+	int i;
+
+	for (i = 0; i < MAX_RELAY_SUBSCRIBERS; i++)
+	{
+		relaySubscribers[i].sock = -1;
+	}
+
+	Cmd_AddCommand("relay_connect", SV_Relay_Connect_f, "Relays the given game server to the clients of this server.");
+	Cmd_AddCommand("relay_disconnect", SV_Relay_Disconnect_f, "Stops relaying the game server.");
+	Cmd_AddCommand("relay_status", SV_Relay_Status_f, "Prints the relay connections.");
+	Cmd_AddCommand("relay_play", SV_Relay_Play_f, "Plays the stream of the relayed game server.");
+}
+
+/**
+ * @brief Close all relay connections
+ */
+void SV_RelayShutdown(void)
+{
+	int i;
+
+	for (i = 0; i < MAX_RELAY_SUBSCRIBERS; i++)
+	{
+		if (relaySubscribers[i].state != RS_FREE)
+		{
+			SV_RelayDropSubscriber(&relaySubscribers[i], "server shutdown");
+		}
+	}
+
+	NET_TCPClose(relayListenSocket);
+	relayListenSocket = -1;
+	relayListenPort   = 0;
+
+	SV_RelayDisconnect("server shutdown");
+	if (relayUpstream.data)
+	{
+		Com_Dealloc(relayUpstream.data);
+		relayUpstream.data = NULL;
+	}
+
+	Cmd_RemoveCommand("relay_connect");
+	Cmd_RemoveCommand("relay_disconnect");
+	Cmd_RemoveCommand("relay_status");
+	Cmd_RemoveCommand("relay_play");
+}
@@ -56,13 +56,163 @@ A normal server packet will look like:
 =============================================================================
 */
 
+#define MAX_SHARED_SNAPSHOT_ENTITIES    512     ///< the client truncates snapshots above MAX_ENTITIES_IN_SNAPSHOT
+#define MAX_SHARED_DELTAS               4
+#define SHARED_SNAPSHOT_SAMPLE          32      ///< every n-th shared snapshot is also built culled to measure the savings
+#define SHARED_SNAPSHOT_SAMPLES         256     ///< samples "sharedsnapshots sample" takes before it stops
+
+/**
+ * @struct sharedDelta_s
+ * @typedef sharedDelta_t
+ * @brief Entity deltas between two shared snapshots, encoded once and
+ * copied into the message of every subscriber using the same delta base
+ */
+typedef struct sharedDelta_s
+{
+	int fromId;                         ///< shared snapshot the deltas start from, 0 for the baselines
+	int toId;
+	int lastUsed;
+
+	int ofs[MAX_GENTITIES];             ///< first bit of the entity in msg, -1 if not encoded yet
+	int bits[MAX_GENTITIES];
+	int ubits[MAX_GENTITIES];           ///< uncompressed size, net debugging
+
+	msg_t msg;
+	byte data[MAX_MSGLEN];
+} sharedDelta_t;
+
+/**
+ * @struct sharedSnapshot_s
+ * @typedef sharedSnapshot_t
+ * @brief The unculled snapshot built once per frame for the spectators that
+ * see the whole map anyway (shoutcasters and multiview)
+ */
+typedef struct sharedSnapshot_s
+{
+	qboolean active;                    ///< SV_SendClientMessages is running, entities won't change
+	int time;                           ///< svs.time of that run
+	qboolean built;                     ///< built for this frame, successfully or not
+	qboolean valid;
+
+	int id;                             ///< never reused, so stale frames can't match a delta cache
+	int areabytes;
+	int first_entity;                   ///< into the circular svs.snapshotEntities[]
+	int num_entities;
+
+	byte forced[MAX_GENTITIES];         ///< sent through a visibility dummy
+	int conditional[MAX_SHARED_SNAPSHOT_ENTITIES];  ///< entities depending on the receiving client
+	int numConditional;
+
+	sharedDelta_t deltas[MAX_SHARED_DELTAS];
+	int deltaCounter;
+
+	// stats
+	int builds;
+	int64_t buildTime;
+	int fallbacks;                      ///< too many entities for the client
+	int snapshots;
+	int64_t snapshotTime;
+	int zeroCopy;                       ///< snapshots referencing the shared entities without copying
+	int deltasEncoded;
+	int deltasReused;
+	int64_t bitsReused;
+	int sampling;                       ///< samples left to take, armed by "sharedsnapshots sample"
+	int samples;
+	int64_t sampleTime;                 ///< culled build of the sampled snapshots
+	int64_t sampleSharedTime;           ///< shared build of the sampled snapshots
+} sharedSnapshot_t;
+
+static sharedSnapshot_t sharedSnap;
+
+/**
+ * @brief Find or set up the delta cache between two shared snapshots
+ * @param[in] fromId
+ * @param[in] toId
+ * @return
+ */
+static sharedDelta_t *SV_SharedDeltaCache(int fromId, int toId)
+{
+	sharedDelta_t *cache, *oldest = NULL;
+	int           i;
+
+	for (i = 0, cache = sharedSnap.deltas; i < MAX_SHARED_DELTAS; i++, cache++)
+	{
+		if (cache->fromId == fromId && cache->toId == toId)
+		{
+			cache->lastUsed = ++sharedSnap.deltaCounter;
+			return cache;
+		}
+
+		if (!oldest || cache->lastUsed < oldest->lastUsed)
+		{
+			oldest = cache;
+		}
+	}
+
+	oldest->fromId   = fromId;
+	oldest->toId     = toId;
+	oldest->lastUsed = ++sharedSnap.deltaCounter;
+	Com_Memset(oldest->ofs, -1, sizeof(oldest->ofs));
+	MSG_Init(&oldest->msg, oldest->data, sizeof(oldest->data));
+
+	return oldest;
+}
+
+/**
+ * @brief Write an entity delta, encoding it only once per delta cache
+ * @param[in,out] msg
+ * @param[in,out] cache NULL to encode directly
+ * @param[in] from
+ * @param[in] to
+ * @param[in] force
+ */
+static void SV_WriteSharedDeltaEntity(msg_t *msg, sharedDelta_t *cache, entityState_t *from, entityState_t *to, qboolean force)
+{
+	int num = to->number;
+
+	if (!cache)
+	{
+		MSG_WriteDeltaEntity(msg, from, to, force);
+		return;
+	}
+
+	if (cache->ofs[num] < 0)
+	{
+		int bit        = cache->msg.bit;
+		int uncompsize = cache->msg.uncompsize;
+
+		MSG_WriteDeltaEntity(&cache->msg, from, to, force);
+
+		if (cache->msg.overflowed)
+		{
+			MSG_WriteDeltaEntity(msg, from, to, force);
+			return;
+		}
+
+		cache->ofs[num]   = bit;
+		cache->bits[num]  = cache->msg.bit - bit;
+		cache->ubits[num] = cache->msg.uncompsize - uncompsize;
+		sharedSnap.deltasEncoded++;
+	}
+	else
+	{
+		sharedSnap.deltasReused++;
+		sharedSnap.bitsReused += cache->bits[num];
+	}
+
+	MSG_CopyBits(msg, cache->msg.data, cache->ofs[num], cache->bits[num]);
+	msg->uncompsize += cache->ubits[num];
+}
+
 /**
  * @brief Writes a delta update of an entityState_t list to the message.
  * @param[in] from
  * @param[in] to
  * @param[in] msg
+ * @param[in] deltaCache deltas from the shared snapshot of from, NULL if not shared
+ * @param[in] baseCache deltas from the baselines, NULL if not shared
  */
-static void SV_EmitPacketEntities(clientSnapshot_t *from, clientSnapshot_t *to, msg_t *msg)
+static void SV_EmitPacketEntities(clientSnapshot_t *from, clientSnapshot_t *to, msg_t *msg, sharedDelta_t *deltaCache, sharedDelta_t *baseCache)
 {
 	entityState_t *oldent = NULL, *newent = NULL;
 	int           oldindex = 0, newindex = 0;
@@ -106,7 +256,7 @@ static void SV_EmitPacketEntities(clientSnapshot_t *from, clientSnapshot_t *to,
 			// delta update from old position
 			// because the force parm is qfalse, this will not result
 			// in any bytes being emited if the entity has not changed at all
-			MSG_WriteDeltaEntity(msg, oldent, newent, qfalse);
+			SV_WriteSharedDeltaEntity(msg, deltaCache, oldent, newent, qfalse);
 			oldindex++;
 			newindex++;
 			continue;
@@ -120,7 +270,7 @@ static void SV_EmitPacketEntities(clientSnapshot_t *from, clientSnapshot_t *to,
 			}
 
 			// this is a new entity, send it from the baseline
-			MSG_WriteDeltaEntity(msg, &sv.svEntities[newnum].baseline, newent, qtrue);
+			SV_WriteSharedDeltaEntity(msg, baseCache, &sv.svEntities[newnum].baseline, newent, qtrue);
 			newindex++;
 			continue;
 		}
@@ -138,48 +288,62 @@ static void SV_EmitPacketEntities(clientSnapshot_t *from, clientSnapshot_t *to,
 }
 
 /**
- * @brief SV_WriteSnapshotToClient
+ * @brief Pick the last frame acknowledged by the client as the delta source
  * @param[in] client
- * @param[in] msg
+ * @param[out] lastframe
+ * @return NULL if the snapshot has to be sent uncompressed
  */
-static void SV_WriteSnapshotToClient(client_t *client, msg_t *msg)
+static clientSnapshot_t *SV_SnapshotDeltaFrame(client_t *client, int *lastframe)
 {
-	clientSnapshot_t *frame, *oldframe;
-	int              lastframe;
-	int              snapFlags;
-
-	// this is the snapshot we are creating
-	frame = &client->frames[client->netchan.outgoingSequence & PACKET_MASK];
+	clientSnapshot_t *oldframe;
 
 	// try to use a previous frame as the source for delta compressing the snapshot
 	if (client->deltaMessage <= 0 || client->state != CS_ACTIVE)
 	{
 		// client is asking for a retransmit
-		oldframe  = NULL;
-		lastframe = 0;
+		*lastframe = 0;
+		return NULL;
 	}
-	else if (client->netchan.outgoingSequence - client->deltaMessage >= (PACKET_BACKUP - 3))
+
+	if (client->netchan.outgoingSequence - client->deltaMessage >= (PACKET_BACKUP - 3))
 	{
 		// client hasn't gotten a good message through in a long time
 		Com_DPrintf("%s: Delta request from out of date packet.\n", client->name);
-		oldframe  = NULL;
-		lastframe = 0;
+		*lastframe = 0;
+		return NULL;
 	}
-	else
-	{
-		// we have a valid snapshot to delta from
-		oldframe  = &client->frames[client->deltaMessage & PACKET_MASK];
-		lastframe = client->netchan.outgoingSequence - client->deltaMessage;
 
-		// the snapshot's entities may still have rolled off the buffer, though
-		if (oldframe->first_entity <= svs.nextSnapshotEntities - svs.numSnapshotEntities)
-		{
-			Com_DPrintf("%s: Delta request from out of date entities.\n", client->name);
-			oldframe  = NULL;
-			lastframe = 0;
-		}
+	// we have a valid snapshot to delta from
+	oldframe   = &client->frames[client->deltaMessage & PACKET_MASK];
+	*lastframe = client->netchan.outgoingSequence - client->deltaMessage;
+
+	// the snapshot's entities may still have rolled off the buffer, though
+	if (oldframe->first_entity <= svs.nextSnapshotEntities - svs.numSnapshotEntities)
+	{
+		Com_DPrintf("%s: Delta request from out of date entities.\n", client->name);
+		*lastframe = 0;
+		return NULL;
 	}
 
+	return oldframe;
+}
+
+/**
+ * @brief SV_WriteSnapshotToClient
+ * @param[in] client
+ * @param[in] msg
+ * @param[in] oldframe
+ * @param[in] lastframe
+ */
+static void SV_WriteSnapshotToClient(client_t *client, msg_t *msg, clientSnapshot_t *oldframe, int lastframe)
+{
+	clientSnapshot_t *frame;
+	sharedDelta_t    *deltaCache = NULL, *baseCache = NULL;
+	int              snapFlags;
+
+	// this is the snapshot we are creating
+	frame = &client->frames[client->netchan.outgoingSequence & PACKET_MASK];
+
 	MSG_WriteByte(msg, svc_snapshot);
 
 	// NOTE, MRE: now sent at the start of every message from server to client
@@ -226,8 +390,18 @@ static void SV_WriteSnapshotToClient(client_t *client, msg_t *msg)
 	//Com_Printf( "Playerstate delta size: %f\n", ((msg->cursize - sz) * sv_fps->integer) / 8.f );
 	//}
 
+	// shared snapshots delta'd from shared snapshots only need to be encoded once
+	if (frame->sharedId && (!oldframe || oldframe->sharedId))
+	{
+		if (oldframe)
+		{
+			deltaCache = SV_SharedDeltaCache(oldframe->sharedId, frame->sharedId);
+		}
+		baseCache = SV_SharedDeltaCache(0, frame->sharedId);
+	}
+
 	// delta encode the entities
-	SV_EmitPacketEntities(oldframe, frame, msg);
+	SV_EmitPacketEntities(oldframe, frame, msg, deltaCache, baseCache);
 
 	// padding for rate debugging
 	if (sv_padPackets->integer)
@@ -639,11 +813,11 @@ static void SV_AddEntitiesVisibleFromPoint(vec3_t origin, clientSnapshot_t *fram
  * For viewing through other player's eyes, clent can be something other than client->gentity
  *
  * @param[in,out] client
+ * @param[out] frame
  */
-static void SV_BuildClientSnapshot(client_t *client)
+static void SV_BuildClientSnapshot(client_t *client, clientSnapshot_t *frame)
 {
 	vec3_t                  org;
-	clientSnapshot_t        *frame;
 	snapshotEntityNumbers_t entityNumbers;
 	int                     i;
 	sharedEntity_t          *ent;
@@ -656,14 +830,12 @@ static void SV_BuildClientSnapshot(client_t *client)
 	// bump the counter used to prevent double adding
 	sv.snapshotCounter++;
 
-	// this is the frame we are creating
-	frame = &client->frames[client->netchan.outgoingSequence & PACKET_MASK];
-
 	// clear everything in this snapshot
 	entityNumbers.numSnapshotEntities = 0;
 	Com_Memset(frame->areabits, 0, sizeof(frame->areabits));
 
 	frame->num_entities = 0;
+	frame->sharedId     = 0;
 
 	clent = client->gentity;
 	if (!clent || client->state == CS_ZOMBIE)
@@ -760,24 +932,377 @@ static void SV_BuildClientSnapshot(client_t *client)
 	}
 }
 
-#define UDPIP_HEADER_SIZE 28
-#define UDPIP6_HEADER_SIZE 48
+/**
+ * @brief Copy the states of everything a client could possibly see into the
+ * snapshot ring once, for all the subscribers of this frame.
+ *
+ * The entities depending on the receiving client (single client flags and
+ * snapshot callbacks) are kept and noted, SV_BuildSharedClientSnapshot
+ * filters them per client.
+ */
+static void SV_BuildSharedSnapshot(void)
+{
+	int64_t        start = Sys_Microseconds();
+	int            e, h;
+	byte           areabits[MAX_MAP_AREA_BYTES];
+	sharedEntity_t *ent, *ment;
+	svEntity_t     *svEnt;
+
+	sharedSnap.built          = qtrue;
+	sharedSnap.valid          = qfalse;
+	sharedSnap.num_entities   = 0;
+	sharedSnap.numConditional = 0;
+	Com_Memset(sharedSnap.forced, 0, sizeof(sharedSnap.forced));
+
+	if (!sv.state)
+	{
+		return;
+	}
+
+	// visibility dummies add their masters even if these aren't visible
+	for (e = 0 ; e < sv.num_entities ; e++)
+	{
+		ent = SV_GentityNum(e);
+
+		if (!ent->r.linked || (ent->r.svFlags & SVF_NOCLIENT))
+		{
+			continue;
+		}
+
+		if (ent->r.svFlags & SVF_VISDUMMY)
+		{
+			if (ent->s.otherEntityNum >= 0 && ent->s.otherEntityNum < MAX_GENTITIES)
+			{
+				sharedSnap.forced[ent->s.otherEntityNum] = 1;
+			}
+		}
+		else if (ent->r.svFlags & SVF_VISDUMMY_MULTIPLE)
+		{
+			for (h = 0 ; h < sv.num_entities ; h++)
+			{
+				ment = SV_GentityNum(h);
+
+				if (h != e && ment->r.linked && !(ment->r.svFlags & SVF_NOCLIENT) && ment->s.otherEntityNum == e)
+				{
+					sharedSnap.forced[h] = 1;
+				}
+			}
+		}
+	}
+
+	sharedSnap.id++;
+	sharedSnap.first_entity = svs.nextSnapshotEntities;
+
+	for (e = 0 ; e < sv.num_entities ; e++)
+	{
+		ent = SV_GentityNum(e);
+
+		// never send entities that aren't linked in
+		if (!ent->r.linked)
+		{
+			continue;
+		}
+
+		if (ent->s.number != e)
+		{
+			Com_DPrintf("FIXING ENT->S.NUMBER!!!\n");
+			ent->s.number = e;
+		}
+
+		if (!sharedSnap.forced[e])
+		{
+			if (ent->r.svFlags & (SVF_NOCLIENT | SVF_VISDUMMY | SVF_VISDUMMY_MULTIPLE))
+			{
+				continue;
+			}
+
+			// entities outside of the world aren't visible from anywhere
+			svEnt = SV_SvEntityForGentity(ent);
+			if (!svEnt->numClusters && !(ent->r.svFlags & (SVF_BROADCAST | SVF_IGNOREBMODELEXTENTS)))
+			{
+				continue;
+			}
+		}
+
+		if (sharedSnap.num_entities == MAX_SHARED_SNAPSHOT_ENTITIES)
+		{
+			// the subscribers get culled snapshots this frame
+			sharedSnap.fallbacks++;
+			svs.nextSnapshotEntities = sharedSnap.first_entity;
+			return;
+		}
+
+		if (ent->r.snapshotCallback || (!sharedSnap.forced[e] && (ent->r.svFlags & (SVF_SINGLECLIENT | SVF_NOTSINGLECLIENT))))
+		{
+			sharedSnap.conditional[sharedSnap.numConditional++] = sharedSnap.num_entities;
+		}
+
+		svs.snapshotEntities[svs.nextSnapshotEntities % svs.numSnapshotEntities] = ent->s;
+
+		svs.nextSnapshotEntities++;
+		// this should never hit, map should always be restarted first in SV_Frame
+		if (svs.nextSnapshotEntities >= 0x7FFFFFFE)
+		{
+			Com_Error(ERR_FATAL, "SV_BuildSharedSnapshot: svs.nextSnapshotEntities wrapped");
+		}
+
+		sharedSnap.num_entities++;
+	}
+
+	// every area is visible
+	sharedSnap.areabytes = CM_WriteAreaBits(areabits, 0);
+	sharedSnap.valid     = qtrue;
+
+	sharedSnap.builds++;
+	sharedSnap.buildTime += Sys_Microseconds() - start;
+}
 
 /**
- * @brief Return the number of msec until another message can be sent to
- * a client based on its rate settings
+ * @brief Check whether a client gets the shared snapshot, building it if
+ * this is the first subscriber of the frame
+ * @param[in] client
+ * @return
+ */
+static qboolean SV_UseSharedSnapshot(client_t *client)
+{
+	if (!sharedSnap.active || sharedSnap.time != svs.time || !sv_sharedSnapshots->integer || client->state != CS_ACTIVE)
+	{
+		return qfalse;
+	}
+
+	if (!client->gentity || (client->gentity->r.svFlags & SVF_BOT) || !(client->gentity->r.svFlags & SVF_SHAREDSNAPSHOT))
+	{
+		return qfalse;
+	}
+
+	if (!sharedSnap.built)
+	{
+		SV_BuildSharedSnapshot();
+	}
+
+	return sharedSnap.valid;
+}
+
+/**
+ * @brief Set up a client frame from the shared snapshot.
+ *
+ * The frame references the shared entities directly unless the client's
+ * own entity or an entity depending on the receiving client has to be
+ * left out, then the remaining states are copied.
  *
  * @param[in] client
+ * @param[out] frame
+ */
+static void SV_BuildSharedClientSnapshot(client_t *client, clientSnapshot_t *frame)
+{
+	byte           excluded[MAX_SHARED_SNAPSHOT_ENTITIES];
+	int            numExcluded = 0;
+	int            i, lo, hi, mid, clientNum;
+	entityState_t  *state;
+	sharedEntity_t *ent;
+
+	frame->ps = *SV_GameClientNum(client - svs.clients);
+
+	clientNum = frame->ps.clientNum;
+	if (clientNum < 0 || clientNum >= MAX_GENTITIES)
+	{
+		Com_Error(ERR_DROP, "SV_BuildSharedClientSnapshot: bad gEnt");
+	}
+
+	frame->sharedId  = sharedSnap.id;
+	frame->areabytes = sharedSnap.areabytes;
+	Com_Memset(frame->areabits, 0, sizeof(frame->areabits));
+	Com_Memset(excluded, 0, sharedSnap.num_entities);
+
+	// never send client's own entity, because it can
+	// be regenerated from the playerstate
+	lo = 0;
+	hi = sharedSnap.num_entities - 1;
+	while (lo <= hi)
+	{
+		mid   = (lo + hi) / 2;
+		state = &svs.snapshotEntities[(sharedSnap.first_entity + mid) % svs.numSnapshotEntities];
+
+		if (state->number == clientNum)
+		{
+			excluded[mid] = 1;
+			numExcluded++;
+			break;
+		}
+
+		if (state->number < clientNum)
+		{
+			lo = mid + 1;
+		}
+		else
+		{
+			hi = mid - 1;
+		}
+	}
+
+	for (i = 0 ; i < sharedSnap.numConditional ; i++)
+	{
+		mid   = sharedSnap.conditional[i];
+		state = &svs.snapshotEntities[(sharedSnap.first_entity + mid) % svs.numSnapshotEntities];
+		ent   = SV_GentityNum(state->number);
+
+		if (excluded[mid])
+		{
+			continue;
+		}
+
+		if (!sharedSnap.forced[state->number])
+		{
+			// entities can be flagged to be sent to only one client
+			if ((ent->r.svFlags & SVF_SINGLECLIENT) && ent->r.singleClient != clientNum)
+			{
+				excluded[mid] = 1;
+				numExcluded++;
+				continue;
+			}
+
+			// entities can be flagged to be sent to everyone but one client
+			if ((ent->r.svFlags & SVF_NOTSINGLECLIENT) && ent->r.singleClient == clientNum)
+			{
+				excluded[mid] = 1;
+				numExcluded++;
+				continue;
+			}
+		}
+
+		if (ent->r.snapshotCallback && !(qboolean)(VM_Call(gvm, GAME_SNAPSHOT_CALLBACK, state->number, clientNum)))
+		{
+			excluded[mid] = 1;
+			numExcluded++;
+		}
+	}
+
+	if (!numExcluded)
+	{
+		frame->first_entity = sharedSnap.first_entity;
+		frame->num_entities = sharedSnap.num_entities;
+		sharedSnap.zeroCopy++;
+		return;
+	}
+
+	frame->first_entity = svs.nextSnapshotEntities;
+	frame->num_entities = 0;
+	for (i = 0 ; i < sharedSnap.num_entities ; i++)
+	{
+		if (excluded[i])
+		{
+			continue;
+		}
+
+		svs.snapshotEntities[svs.nextSnapshotEntities % svs.numSnapshotEntities] = svs.snapshotEntities[(sharedSnap.first_entity + i) % svs.numSnapshotEntities];
+
+		svs.nextSnapshotEntities++;
+		if (svs.nextSnapshotEntities >= 0x7FFFFFFE)
+		{
+			Com_Error(ERR_FATAL, "SV_BuildSharedClientSnapshot: svs.nextSnapshotEntities wrapped");
+		}
+
+		frame->num_entities++;
+	}
+}
+
+/**
+ * @brief Build and encode the culled snapshot a subscriber would have got,
+ * to estimate the time the shared snapshot saves.
  *
- * @return The number of msec
+ * @param[in] client
+ * @param[in] oldframe
+ * @param[in] sharedTime time the shared snapshot of the client took
  */
-int SV_RateMsec(client_t *client)
+static void SV_SampleCulledSnapshot(client_t *client, clientSnapshot_t *oldframe, int64_t sharedTime)
 {
-	int rate, rateMsec;
-	int messageSize;
+	static clientSnapshot_t culled;
+	static byte             msg_buf[MAX_MSGLEN];
+	msg_t                   msg;
+	int64_t                 start;
 
-	messageSize = client->netchan.lastSentSize;
-	rate        = client->rate;
+	MSG_Init(&msg, msg_buf, sizeof(msg_buf));
+	msg.allowoverflow = qtrue;
+
+	start = Sys_Microseconds();
+
+	SV_BuildClientSnapshot(client, &culled);
+	MSG_WriteDeltaPlayerstate(&msg, oldframe ? &oldframe->ps : NULL, &culled.ps);
+	SV_EmitPacketEntities(oldframe, &culled, &msg, NULL, NULL);
+
+	sharedSnap.sampleTime       += Sys_Microseconds() - start;
+	sharedSnap.sampleSharedTime += sharedTime;
+	sharedSnap.samples++;
+}
+
+/**
+ * @brief Print the work saved by the shared snapshots, "sharedsnapshots sample" measures
+ * the culled snapshots they replace, "sharedsnapshots reset" clears the counters
+ */
+void SV_SharedSnapshotStats_f(void)
+{
+	double saved = 0.0;
+
+	// building the culled snapshots costs what the shared ones save, only do it when asked
+	if (Cmd_Argc() > 1 && !Q_stricmp(Cmd_Argv(1), "sample"))
+	{
+		sharedSnap.sampling = SHARED_SNAPSHOT_SAMPLES;
+		Com_Printf("sampling every %ith subscriber snapshot culled, %i samples\n", SHARED_SNAPSHOT_SAMPLE, SHARED_SNAPSHOT_SAMPLES);
+		return;
+	}
+
+	if (Cmd_Argc() > 1 && !Q_stricmp(Cmd_Argv(1), "reset"))
+	{
+		sharedSnap.builds           = 0;
+		sharedSnap.buildTime        = 0;
+		sharedSnap.fallbacks        = 0;
+		sharedSnap.snapshots        = 0;
+		sharedSnap.snapshotTime     = 0;
+		sharedSnap.zeroCopy         = 0;
+		sharedSnap.deltasEncoded    = 0;
+		sharedSnap.deltasReused     = 0;
+		sharedSnap.bitsReused       = 0;
+		sharedSnap.sampling         = 0;
+		sharedSnap.samples          = 0;
+		sharedSnap.sampleTime       = 0;
+		sharedSnap.sampleSharedTime = 0;
+		return;
+	}
+
+	Com_Printf("shared snapshots     : %s\n", sv_sharedSnapshots->integer ? "enabled" : "disabled");
+	Com_Printf("builds               : %i (%.1f usec avg), %i fallbacks to culled\n", sharedSnap.builds,
+	           sharedSnap.builds ? (double)sharedSnap.buildTime / sharedSnap.builds : 0.0, sharedSnap.fallbacks);
+	Com_Printf("subscriber snapshots : %i (%.1f usec avg), %i without copies\n", sharedSnap.snapshots,
+	           sharedSnap.snapshots ? (double)sharedSnap.snapshotTime / sharedSnap.snapshots : 0.0, sharedSnap.zeroCopy);
+	Com_Printf("entity deltas        : %i encoded, %i reused (%lld bytes)\n", sharedSnap.deltasEncoded,
+	           sharedSnap.deltasReused, (long long)(sharedSnap.bitsReused >> 3));
+
+	if (!sharedSnap.samples)
+	{
+		Com_Printf("run \"sharedsnapshots sample\" to estimate the cpu time saved\n");
+		return;
+	}
+
+	// the sampled snapshots were built both ways, scale their difference to all of them
+	saved = (double)(sharedSnap.sampleTime - sharedSnap.sampleSharedTime) / sharedSnap.samples * sharedSnap.snapshots - sharedSnap.buildTime;
+
+	Com_Printf("culled estimate      : %.1f usec per snapshot (%i samples%s)\n", (double)sharedSnap.sampleTime / sharedSnap.samples, sharedSnap.samples,
+	           sharedSnap.sampling ? ", sampling" : "");
+	Com_Printf("cpu time saved       : %.1f msec total, %.1f usec per frame\n", saved / 1000.0,
+	           sharedSnap.builds ? saved / sharedSnap.builds : 0.0);
+}
+
+#define UDPIP_HEADER_SIZE 28
+#define UDPIP6_HEADER_SIZE 48
+
+/**
+ * @brief Return the rate of a client in bytes per second, within sv_minRate and sv_maxRate
+ * @param[in] client
+ * @return
+ */
+static int SV_ClientRate(client_t *client)
+{
+	int rate = client->rate;
 
 	if (sv_maxRate->integer)
 	{
@@ -803,6 +1328,30 @@ int SV_RateMsec(client_t *client)
 		}
 	}
 
+	if (com_timescale->value > 0.f)
+	{
+		rate = (int)(rate * com_timescale->value);
+	}
+
+	return MAX(rate, 1);
+}
+
+/**
+ * @brief Schedule the next packet to a client, once one has been sent
+ *
+ * @details Packets are spread evenly within the client rate on a microsecond schedule.
+ * A packet the idle loop sends late is credited up to SV_PACE_SLACK so timer granularity
+ * doesn't eat into the rate, without letting more than one packet go in a burst.
+ *
+ * @param[in,out] client
+ */
+void SV_RatePace(client_t *client)
+{
+	int64_t now = Sys_Microseconds();
+	int     messageSize;
+
+	messageSize = client->netchan.lastSentSize;
+
 	if (client->netchan.remoteAddress.type == NA_IP6)
 	{
 		messageSize += UDPIP6_HEADER_SIZE;
@@ -812,24 +1361,31 @@ int SV_RateMsec(client_t *client)
 		messageSize += UDPIP_HEADER_SIZE;
 	}
 
-	if (com_timescale->value > 0.f)
-	{
-		rateMsec = messageSize * 1000 / ((int)(rate * com_timescale->value));
-	}
-	else
+	if (client->nextSendTime < now - SV_PACE_SLACK)
 	{
-		rateMsec = messageSize * 1000 / rate;
+		client->nextSendTime = now - SV_PACE_SLACK;
 	}
-	rate = Sys_Milliseconds() - client->netchan.lastSentTime;
+	client->nextSendTime += (int64_t)messageSize * 1000000 / SV_ClientRate(client);
+}
+
+/**
+ * @brief Return the number of msec until another message can be sent to
+ * a client based on its rate settings
+ *
+ * @param[in] client
+ *
+ * @return The number of msec, 0 when the next packet is due within SV_PACE_SLACK
+ */
+int SV_RateMsec(client_t *client)
+{
+	int64_t wait = client->nextSendTime - Sys_Microseconds();
 
-	if (rate > rateMsec)
+	if (wait < SV_PACE_SLACK)
 	{
 		return 0;
 	}
-	else
-	{
-		return rateMsec - rate;
-	}
+
+	return (int)((wait + 999) / 1000);
 }
 
 /**
@@ -901,8 +1457,11 @@ void SV_SendClientIdle(client_t *client)
  */
 void SV_SendClientSnapshot(client_t *client)
 {
-	byte  msg_buf[MAX_MSGLEN];
-	msg_t msg;
+	byte             msg_buf[MAX_MSGLEN];
+	msg_t            msg;
+	clientSnapshot_t *frame, *oldframe;
+	int              lastframe;
+	int64_t          start = 0, sharedTime = 0;
 
 	if (client->state < CS_ACTIVE)
 	{
@@ -915,8 +1474,20 @@ void SV_SendClientSnapshot(client_t *client)
 		}
 	}
 
+	// this is the frame we are creating
+	frame = &client->frames[client->netchan.outgoingSequence & PACKET_MASK];
+
 	// build the snapshot
-	SV_BuildClientSnapshot(client);
+	if (SV_UseSharedSnapshot(client))
+	{
+		start = Sys_Microseconds();
+		SV_BuildSharedClientSnapshot(client, frame);
+		sharedTime = Sys_Microseconds() - start;
+	}
+	else
+	{
+		SV_BuildClientSnapshot(client, frame);
+	}
 
 	// bots need to have their snapshots build, but
 	// the query them directly without needing to be sent
@@ -942,7 +1513,27 @@ void SV_SendClientSnapshot(client_t *client)
 
 	// send over all the relevant entityState_t
 	// and the playerState_t
-	SV_WriteSnapshotToClient(client, &msg);
+	oldframe = SV_SnapshotDeltaFrame(client, &lastframe);
+
+	if (frame->sharedId)
+	{
+		start = Sys_Microseconds();
+		SV_WriteSnapshotToClient(client, &msg, oldframe, lastframe);
+		sharedTime += Sys_Microseconds() - start;
+
+		sharedSnap.snapshots++;
+		sharedSnap.snapshotTime += sharedTime;
+
+		if (sharedSnap.sampling && !(sharedSnap.snapshots % SHARED_SNAPSHOT_SAMPLE))
+		{
+			SV_SampleCulledSnapshot(client, oldframe, sharedTime);
+			sharedSnap.sampling--;
+		}
+	}
+	else
+	{
+		SV_WriteSnapshotToClient(client, &msg, oldframe, lastframe);
+	}
 
     if (SV_CheckForMsgOverflow(client, &msg))
     {
@@ -970,6 +1561,11 @@ void SV_SendClientMessages(void)
 	// update any changed configstrings from this frame
 	SV_UpdateConfigStrings();
 
+	// the shared snapshot is built by the first client needing it
+	sharedSnap.active = qtrue;
+	sharedSnap.time   = svs.time;
+	sharedSnap.built  = qfalse;
+
 	// send a message to each connected client
 	for (i = 0; i < sv_maxclients->integer; i++)
 	{
@@ -1012,6 +1608,7 @@ void SV_SendClientMessages(void)
 
 		if (c->netchan.unsentFragments || c->netchan_start_queue)
 		{
+			c->netchanStats.snapshotsDelayed++;
 			c->rateDelayed = qtrue;
 			continue;       // Drop this snapshot if the packet queue is still full or delta compression will break
 		}
@@ -1036,6 +1633,13 @@ void SV_SendClientMessages(void)
 		c->rateDelayed      = qfalse;
 	}
 
+	sharedSnap.active = qfalse;
+
+	if (sv_metrics->integer)
+	{
+		SV_MetricsSent(sv.bpsTotalBytes, sv.ubpsTotalBytes);
+	}
+
 	// net debugging
 	if (sv_showAverageBPS->integer && numclients > 0)
 	{
@@ -590,21 +590,21 @@ void SV_ClipToEntity(trace_t *trace, const vec3_t start, const vec3_t mins, cons
 #define BOX_MODEL_HANDLE        511
 
 /**
- * @brief SV_ClipMoveToEntities
+ * @brief Clip a move to the entities of a touch list
  * @param[in,out] clip
+ * @param[in] touchlist
+ * @param[in] num
+ * @param[in] cull skip the entities outside of the move box, for a list shared by several moves
  */
-void SV_ClipMoveToEntities(moveclip_t *clip)
+static void SV_ClipMoveToEntityList(moveclip_t *clip, const int *touchlist, int num, qboolean cull)
 {
-	int            i, num;
-	int            touchlist[MAX_GENTITIES];
+	int            i;
 	sharedEntity_t *touch;
 	int            passOwnerNum;
 	trace_t        trace;
 	clipHandle_t   clipHandle;
 	float          *origin, *angles;
 
-	num = SV_AreaEntities(clip->boxmins, clip->boxmaxs, touchlist, MAX_GENTITIES);
-
 	if (clip->passEntityNum != ENTITYNUM_NONE)
 	{
 		passOwnerNum = (SV_GentityNum(clip->passEntityNum))->r.ownerNum;
@@ -626,6 +626,16 @@ void SV_ClipMoveToEntities(moveclip_t *clip)
 		}
 		touch = SV_GentityNum(touchlist[i]);
 
+		if (cull && (touch->r.absmin[0] > clip->boxmaxs[0]
+		             || touch->r.absmin[1] > clip->boxmaxs[1]
+		             || touch->r.absmin[2] > clip->boxmaxs[2]
+		             || touch->r.absmax[0] < clip->boxmins[0]
+		             || touch->r.absmax[1] < clip->boxmins[1]
+		             || touch->r.absmax[2] < clip->boxmins[2]))
+		{
+			continue;
+		}
+
 		// see if we should ignore this entity
 		if (clip->passEntityNum != ENTITYNUM_NONE)
 		{
@@ -713,6 +723,74 @@ void SV_ClipMoveToEntities(moveclip_t *clip)
 	}
 }
 
+/**
+ * @brief SV_ClipMoveToEntities
+ * @param[in,out] clip
+ */
+void SV_ClipMoveToEntities(moveclip_t *clip)
+{
+	int touchlist[MAX_GENTITIES];
+	int num = SV_AreaEntities(clip->boxmins, clip->boxmaxs, touchlist, MAX_GENTITIES);
+
+	SV_ClipMoveToEntityList(clip, touchlist, num, qfalse);
+}
+
+/**
+ * @brief Trace against the world and set up the clip to the entities
+ * @param[out] clip
+ * @param[in] start
+ * @param[in] mins
+ * @param[in] maxs
+ * @param[in] end
+ * @param[in] passEntityNum
+ * @param[in] contentmask
+ * @param[in] capsule
+ * @return qfalse if the entities don't need to be checked
+ */
+static qboolean SV_ClipMoveToWorld(moveclip_t *clip, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, qboolean capsule)
+{
+	int i;
+
+	Com_Memset(clip, 0, sizeof(moveclip_t));
+
+	// clip to world
+	CM_BoxTrace(&clip->trace, start, end, mins, maxs, 0, contentmask, capsule);
+	clip->trace.entityNum = clip->trace.fraction != 1.0f ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
+	if (clip->trace.fraction == 0.f || passEntityNum == -2)
+	{
+		return qfalse;     // blocked immediately by the world
+	}
+
+	clip->contentmask = contentmask;
+	clip->start       = start;
+	//VectorCopy(clip->trace.endpos, clip->end);
+	VectorCopy(end, clip->end);
+	clip->mins          = mins;
+	clip->maxs          = maxs;
+	clip->passEntityNum = passEntityNum;
+	clip->capsule       = capsule;
+
+	// create the bounding box of the entire move
+	// we can limit it to the part of the move not
+	// already clipped off by the world, which can be
+	// a significant savings for line of sight and shot traces
+	for (i = 0 ; i < 3 ; i++)
+	{
+		if (end[i] > start[i])
+		{
+			clip->boxmins[i] = clip->start[i] + clip->mins[i] - 1;
+			clip->boxmaxs[i] = clip->end[i] + clip->maxs[i] + 1;
+		}
+		else
+		{
+			clip->boxmins[i] = clip->end[i] + clip->mins[i] - 1;
+			clip->boxmaxs[i] = clip->start[i] + clip->maxs[i] + 1;
+		}
+	}
+
+	return qtrue;
+}
+
 /**
  * @brief Moves the given mins/maxs volume through the world from start to end.
  * passEntityNum and entities owned by passEntityNum are explicitly not checked.
@@ -729,7 +807,6 @@ void SV_ClipMoveToEntities(moveclip_t *clip)
 void SV_Trace(trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentmask, qboolean capsule)
 {
 	moveclip_t clip;
-	int        i;
 
 	if (!mins)
 	{
@@ -740,48 +817,124 @@ void SV_Trace(trace_t *results, const vec3_t start, const vec3_t mins, const vec
 		maxs = vec3_origin;
 	}
 
-	Com_Memset(&clip, 0, sizeof(moveclip_t));
+	if (SV_ClipMoveToWorld(&clip, start, mins, maxs, end, passEntityNum, contentmask, capsule))
+	{
+		// clip to other solid entities
+		SV_ClipMoveToEntities(&clip);
+	}
 
-	// clip to world
-	CM_BoxTrace(&clip.trace, start, end, mins, maxs, 0, contentmask, capsule);
-	clip.trace.entityNum = clip.trace.fraction != 1.0f ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
-	if (clip.trace.fraction == 0.f || passEntityNum == -2)
+	*results = clip.trace;
+}
+
+/// largest box of traces sharing an entity list, the list is culled per trace so it must stay short
+#define TRACE_BATCH_EXTENT  2048
+
+/**
+ * @brief Clip the grouped moves of a batch to the entities of their box
+ * @param[in,out] clips
+ * @param[in] num
+ * @param[in] mins
+ * @param[in] maxs
+ */
+static void SV_ClipBatchToEntities(moveclip_t *clips, int num, const vec3_t mins, const vec3_t maxs)
+{
+	int touchlist[MAX_GENTITIES];
+	int touched, i;
+
+	if (num == 1)
 	{
-		*results = clip.trace;
-		return;     // blocked immediately by the world
+		SV_ClipMoveToEntities(clips);
+		return;
 	}
 
-	clip.contentmask = contentmask;
-	clip.start       = start;
-	//VectorCopy(clip.trace.endpos, clip.end);
-	VectorCopy(end, clip.end);
-	clip.mins          = mins;
-	clip.maxs          = maxs;
-	clip.passEntityNum = passEntityNum;
-	clip.capsule       = capsule;
+	touched = SV_AreaEntities(mins, maxs, touchlist, MAX_GENTITIES);
 
-	// create the bounding box of the entire move
-	// we can limit it to the part of the move not
-	// already clipped off by the world, which can be
-	// a significant savings for line of sight and shot traces
-	for (i = 0 ; i < 3 ; i++)
+	for (i = 0; i < num; i++)
 	{
-		if (end[i] > start[i])
+		SV_ClipMoveToEntityList(&clips[i], touchlist, touched, qtrue);
+	}
+}
+
+/**
+ * @brief SV_Trace for a batch of traces, the world is traced first, then the
+ * traces whose moves fit in a TRACE_BATCH_EXTENT box look up the entities once
+ *
+ * @param[out] results
+ * @param[in] requests
+ * @param[in] count at most MAX_TRACE_BATCH
+ */
+void SV_TraceBatch(trace_t *results, const traceRequest_t *requests, int count)
+{
+	static moveclip_t clips[MAX_TRACE_BATCH];
+	int               group[MAX_TRACE_BATCH];
+	int               grouped = 0;
+	vec3_t            mins, maxs, newMins, newMaxs;
+	moveclip_t        *clip;
+	int               i, j;
+
+	if (count > MAX_TRACE_BATCH)
+	{
+		Com_Error(ERR_DROP, "SV_TraceBatch: %i traces, more than %i", count, MAX_TRACE_BATCH);
+	}
+
+	for (i = 0; i < count; i++)
+	{
+		clip = &clips[grouped];
+
+		if (!SV_ClipMoveToWorld(clip, requests[i].start, requests[i].mins, requests[i].maxs, requests[i].end,
+		                        requests[i].passEntityNum, requests[i].contentmask, qfalse))
 		{
-			clip.boxmins[i] = clip.start[i] + clip.mins[i] - 1;
-			clip.boxmaxs[i] = clip.end[i] + clip.maxs[i] + 1;
+			results[i] = clip->trace;
+			continue;
 		}
-		else
+
+		if (grouped)
 		{
-			clip.boxmins[i] = clip.end[i] + clip.mins[i] - 1;
-			clip.boxmaxs[i] = clip.start[i] + clip.maxs[i] + 1;
+			for (j = 0; j < 3; j++)
+			{
+				newMins[j] = MIN(mins[j], clip->boxmins[j]);
+				newMaxs[j] = MAX(maxs[j], clip->boxmaxs[j]);
+			}
+
+			if (newMaxs[0] - newMins[0] > TRACE_BATCH_EXTENT
+			    || newMaxs[1] - newMins[1] > TRACE_BATCH_EXTENT
+			    || newMaxs[2] - newMins[2] > TRACE_BATCH_EXTENT)
+			{
+				// too far from the group, it starts the next one
+				SV_ClipBatchToEntities(clips, grouped, mins, maxs);
+				for (j = 0; j < grouped; j++)
+				{
+					results[group[j]] = clips[j].trace;
+				}
+
+				clips[0] = *clip;
+				clip     = &clips[0];
+				grouped  = 0;
+			}
+			else
+			{
+				VectorCopy(newMins, mins);
+				VectorCopy(newMaxs, maxs);
+			}
 		}
-	}
 
-	// clip to other solid entities
-	SV_ClipMoveToEntities(&clip);
+		if (!grouped)
+		{
+			VectorCopy(clip->boxmins, mins);
+			VectorCopy(clip->boxmaxs, maxs);
+		}
 
-	*results = clip.trace;
+		group[grouped++] = i;
+	}
+
+	if (grouped)
+	{
+		SV_ClipBatchToEntities(clips, grouped, mins, maxs);
+		for (j = 0; j < grouped; j++)
+		{
+			results[group[j]] = clips[j].trace;
+		}
+	}
 }
 
 /**
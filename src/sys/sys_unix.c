@@ -57,6 +57,7 @@
 #include <libgen.h>
 #include <fcntl.h>
 #include <sys/wait.h>
+#include <pthread.h>
 
 qboolean stdinIsATTY;
 
@@ -180,6 +181,19 @@ int Sys_Milliseconds(void)
 	return curtime;
 }
 
+/**
+ * @brief Current time in microseconds, for profiling
+ * @return
+ */
+int64_t Sys_Microseconds(void)
+{
+	struct timeval tp;
+
+	gettimeofday(&tp, NULL);
+
+	return (int64_t)tp.tv_sec * 1000000 + tp.tv_usec;
+}
+
 /**
  * @param[in,out] v Vector
  */
@@ -1120,6 +1134,184 @@ void Sys_SetEnv(const char *name, const char *value)
 	}
 }
 
+/**
+ * @struct sysThreadStart_s
+ * @brief Entry point and argument handed over to a new thread
+ */
+typedef struct sysThreadStart_s
+{
+	sysThreadFunc_t func;
+	void *arg;
+} sysThreadStart_t;
+
+/**
+ * @brief Sys_ThreadProc
+ * @param[in] start
+ * @return
+ */
+static void *Sys_ThreadProc(void *start)
+{
+	sysThreadStart_t s = *(sysThreadStart_t *)start;
+
+	free(start);
+	s.func(s.arg);
+	return NULL;
+}
+
+/**
+ * @brief Start a native thread running func(arg)
+ * @param[in] func
+ * @param[in] arg
+ * @return Thread handle to pass to Sys_JoinThread, NULL on failure
+ */
+void *Sys_CreateThread(sysThreadFunc_t func, void *arg)
+{
+	pthread_t        *thread;
+	sysThreadStart_t *start;
+
+	thread = malloc(sizeof(*thread));
+	start  = malloc(sizeof(*start));
+	if (!thread || !start)
+	{
+		free(thread);
+		free(start);
+		return NULL;
+	}
+
+	start->func = func;
+	start->arg  = arg;
+
+	if (pthread_create(thread, NULL, Sys_ThreadProc, start) != 0)
+	{
+		free(thread);
+		free(start);
+		return NULL;
+	}
+
+	return thread;
+}
+
+/**
+ * @brief Wait for a thread started with Sys_CreateThread to finish and release its handle
+ * @param[in] thread
+ */
+void Sys_JoinThread(void *thread)
+{
+	if (!thread)
+	{
+		return;
+	}
+
+	pthread_join(*(pthread_t *)thread, NULL);
+	free(thread);
+}
+
+/**
+ * @brief Put the calling thread to sleep, unlike Sys_Sleep this never waits on stdin
+ * @param[in] msec
+ */
+void Sys_ThreadSleep(int msec)
+{
+	usleep(msec * 1000);
+}
+
+/**
+ * @brief Full memory barrier for data shared between threads without a lock
+ */
+void Sys_MemoryBarrier(void)
+{
+	__sync_synchronize();
+}
+
+/**
+ * @struct sysSignal_s
+ * @brief Auto-reset event built on a condition variable
+ */
+typedef struct sysSignal_s
+{
+	pthread_mutex_t mutex;
+	pthread_cond_t cond;
+	qboolean raised;
+} sysSignal_t;
+
+/**
+ * @brief Create an auto-reset signal, one Sys_WaitSignal returns for each Sys_RaiseSignal
+ * @return Signal handle, NULL on failure
+ */
+void *Sys_CreateSignal(void)
+{
+	sysSignal_t *signal = malloc(sizeof(*signal));
+
+	if (!signal)
+	{
+		return NULL;
+	}
+
+	if (pthread_mutex_init(&signal->mutex, NULL) != 0)
+	{
+		free(signal);
+		return NULL;
+	}
+	if (pthread_cond_init(&signal->cond, NULL) != 0)
+	{
+		pthread_mutex_destroy(&signal->mutex);
+		free(signal);
+		return NULL;
+	}
+	signal->raised = qfalse;
+
+	return signal;
+}
+
+/**
+ * @brief Release a signal nobody waits on anymore
+ * @param[in] signal
+ */
+void Sys_DestroySignal(void *signal)
+{
+	sysSignal_t *s = (sysSignal_t *)signal;
+
+	if (!s)
+	{
+		return;
+	}
+
+	pthread_cond_destroy(&s->cond);
+	pthread_mutex_destroy(&s->mutex);
+	free(s);
+}
+
+/**
+ * @brief Raise a signal, it stays raised until a waiter takes it
+ * @param[in] signal
+ */
+void Sys_RaiseSignal(void *signal)
+{
+	sysSignal_t *s = (sysSignal_t *)signal;
+
+	pthread_mutex_lock(&s->mutex);
+	s->raised = qtrue;
+	pthread_cond_signal(&s->cond);
+	pthread_mutex_unlock(&s->mutex);
+}
+
+/**
+ * @brief Wait until a signal is raised and lower it again
+ * @param[in] signal
+ */
+void Sys_WaitSignal(void *signal)
+{
+	sysSignal_t *s = (sysSignal_t *)signal;
+
+	pthread_mutex_lock(&s->mutex);
+	while (!s->raised)
+	{
+		pthread_cond_wait(&s->cond, &s->mutex);
+	}
+	s->raised = qfalse;
+	pthread_mutex_unlock(&s->mutex);
+}
+
 /**
  * @return PID of current process
 */
@@ -115,6 +115,25 @@ int Sys_Milliseconds(void)
 	return sys_curtime;
 }
 
+/**
+ * @brief Current time in microseconds, for profiling
+ * @return
+ */
+int64_t Sys_Microseconds(void)
+{
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER        counter;
+
+	if (!frequency.QuadPart)
+	{
+		QueryPerformanceFrequency(&frequency);
+	}
+
+	QueryPerformanceCounter(&counter);
+
+	return (int64_t)(counter.QuadPart / frequency.QuadPart) * 1000000 + (counter.QuadPart % frequency.QuadPart) * 1000000 / frequency.QuadPart;
+}
+
 /**
  * @brief Sys_SnapVector
  * @param[in,out] v
@@ -732,6 +751,131 @@ void Sys_SetEnv(const char *name, const char *value)
 	_putenv(va("%s=%s", name, value));
 }
 
+/**
+ * @struct sysThreadStart_s
+ * @brief Entry point and argument handed over to a new thread
+ */
+typedef struct sysThreadStart_s
+{
+	sysThreadFunc_t func;
+	void *arg;
+} sysThreadStart_t;
+
+/**
+ * @brief Sys_ThreadProc
+ * @param[in] start
+ * @return
+ */
+static DWORD WINAPI Sys_ThreadProc(LPVOID start)
+{
+	sysThreadStart_t s = *(sysThreadStart_t *)start;
+
+	free(start);
+	s.func(s.arg);
+	return 0;
+}
+
+/**
+ * @brief Start a native thread running func(arg)
+ * @param[in] func
+ * @param[in] arg
+ * @return Thread handle to pass to Sys_JoinThread, NULL on failure
+ */
+void *Sys_CreateThread(sysThreadFunc_t func, void *arg)
+{
+	HANDLE           thread;
+	sysThreadStart_t *start;
+
+	start = malloc(sizeof(*start));
+	if (!start)
+	{
+		return NULL;
+	}
+
+	start->func = func;
+	start->arg  = arg;
+
+	thread = CreateThread(NULL, 0, Sys_ThreadProc, start, 0, NULL);
+	if (!thread)
+	{
+		free(start);
+		return NULL;
+	}
+
+	return thread;
+}
+
+/**
+ * @brief Wait for a thread started with Sys_CreateThread to finish and release its handle
+ * @param[in] thread
+ */
+void Sys_JoinThread(void *thread)
+{
+	if (!thread)
+	{
+		return;
+	}
+
+	WaitForSingleObject((HANDLE)thread, INFINITE);
+	CloseHandle((HANDLE)thread);
+}
+
+/**
+ * @brief Put the calling thread to sleep, unlike Sys_Sleep this never waits on stdin
+ * @param[in] msec
+ */
+void Sys_ThreadSleep(int msec)
+{
+	Sleep(msec);
+}
+
+/**
+ * @brief Full memory barrier for data shared between threads without a lock
+ */
+void Sys_MemoryBarrier(void)
+{
+	MemoryBarrier();
+}
+
+/**
+ * @brief Create an auto-reset signal, one Sys_WaitSignal returns for each Sys_RaiseSignal
+ * @return Signal handle, NULL on failure
+ */
+void *Sys_CreateSignal(void)
+{
+	return CreateEvent(NULL, FALSE, FALSE, NULL);
+}
+
+/**
+ * @brief Release a signal nobody waits on anymore
+ * @param[in] signal
+ */
+void Sys_DestroySignal(void *signal)
+{
+	if (signal)
+	{
+		CloseHandle((HANDLE)signal);
+	}
+}
+
+/**
+ * @brief Raise a signal, it stays raised until a waiter takes it
+ * @param[in] signal
+ */
+void Sys_RaiseSignal(void *signal)
+{
+	SetEvent((HANDLE)signal);
+}
+
+/**
+ * @brief Wait until a signal is raised and lower it again
+ * @param[in] signal
+ */
+void Sys_WaitSignal(void *signal)
+{
+	WaitForSingleObject((HANDLE)signal, INFINITE);
+}
+
 /**
  * @brief Sys_PID
  * @return
@@ -0,0 +1,1654 @@
+/*
+ * ET: Legacy
+ * Copyright (C) 2012-2018 ET:Legacy team <mail@etlegacy.com>
+ *
+ * This file is part of ET: Legacy - http://www.etlegacy.com
+ *
+ * ET: Legacy is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ET: Legacy is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ET: Legacy. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, Wolfenstein: Enemy Territory GPL Source Code is also
+ * subject to certain additional terms. You should have received a copy
+ * of these additional terms immediately following the terms and conditions
+ * of the GNU General Public License which accompanied the source code.
+ * If not, please request a copy in writing from id Software at the address below.
+ *
+ * id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+ */
+/**
+ * @file etldemo.c
+ * @brief Headless batch analyzer for client demos (.dm_84)
+ *
+ * Streams demos through the engine message and huffman code without a client,
+ * renderer or sound and writes the game events as JSON lines or CSV.
+ * The server message parsing mirrors CL_ParseServerMessage, but keeps all state
+ * in a per thread context so many demos are processed in parallel.
+ *
+ * Events:
+ * - gamestate: time, text (map)
+ * - kill: time, client (attacker), target (victim), mod, weapon, name (attacker), text (victim)
+ * - announce: time, text (cp/cpm messages, objectives and such)
+ * - accuracy: time, client, name, accuracy, headshots (intermission weapon stats)
+ * - player: client, name, team, kills, deaths, teamkills, suicides, accuracy, headshots (per demo summary)
+ * - error: text (the demo was cut short)
+ *
+ * Usage: etldemo [-threads n] [-csv] [-o file] [-list file] demo...
+ */
+
+#include "../../qcommon/q_shared.h"
+#include "../../qcommon/qcommon.h"
+#include "../../game/bg_public.h"
+
+#include <setjmp.h>
+#include <time.h>
+
+#ifdef _WIN32
+#include <windows.h>
+#define DP_THREAD_LOCAL __declspec(thread)
+#else
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/time.h>
+#define DP_THREAD_LOCAL __thread
+#endif
+
+#define MAX_PARSE_ENTITIES  2048
+#define DP_MAX_THREADS      64
+#define DP_MAX_ARGS         (MAX_CLIENTS * 2 + 8)
+#define DP_BLOCK_MAGIC      0x425a5445  ///< FS_BLOCK_MAGIC of files.c
+
+cvar_t *cl_shownet = NULL;      ///< referenced by msg.c
+
+/**
+ * @struct dpSnapshot_t
+ * @brief Trimmed down clSnapshot_t
+ */
+typedef struct
+{
+	qboolean valid;
+	int snapFlags;
+	int serverTime;
+	int messageNum;
+	int deltaNum;
+	playerState_t ps;
+	int numEntities;
+	int parseEntitiesNum;
+} dpSnapshot_t;
+
+/**
+ * @struct dpClient_t
+ * @brief Per client totals of a demo
+ */
+typedef struct
+{
+	int kills;
+	int deaths;
+	int teamkills;
+	int suicides;
+	float accuracy;
+	float headshots;
+} dpClient_t;
+
+/**
+ * @struct dpEvent_t
+ * @brief One output record, unset fields are -1 or NULL and left out of the JSON
+ */
+typedef struct
+{
+	const char *type;
+	int time;
+	int client;
+	int target;
+	int mod;
+	int weapon;
+	int team;
+	int kills;
+	int deaths;
+	int teamkills;
+	int suicides;
+	float accuracy;
+	float headshots;
+	const char *name;
+	const char *text;
+} dpEvent_t;
+
+/**
+ * @struct demoParse_t
+ * @brief State of a worker thread, reused for every demo it parses
+ */
+typedef struct
+{
+	const char *path;
+
+	byte *file;
+	long fileSize;
+	long fileMax;
+
+	char *out;
+	size_t outSize;
+	size_t outMax;
+
+	int serverMessageSequence;
+	int serverCommandSequence;
+
+	char *cs[MAX_CONFIGSTRINGS];
+	char bigConfigString[BIG_INFO_STRING];
+
+	entityState_t baselines[MAX_GENTITIES];
+	entityState_t parseEntities[MAX_PARSE_ENTITIES];
+	int parseEntitiesNum;
+	dpSnapshot_t snapshots[PACKET_BACKUP];
+	dpSnapshot_t snap;
+
+	byte eventSeen[MAX_GENTITIES];  ///< temp entity events stay in several snapshots, fire them once
+	byte eventLive[MAX_GENTITIES];
+
+	dpClient_t clients[MAX_CLIENTS];
+
+	char tokenBuf[BIG_INFO_STRING];
+	char *argv[DP_MAX_ARGS];
+	int argc;
+
+	int numMessages;
+	int numDemos;
+	long numBytes;
+
+	jmp_buf abortFrame;
+	char error[MAX_STRING_CHARS];
+} demoParse_t;
+
+static DP_THREAD_LOCAL demoParse_t *dp_current;
+
+static const char **dp_paths;
+static int        dp_numPaths;
+static int        dp_nextPath;
+static qboolean   dp_csv;
+static FILE       *dp_output;
+
+#ifdef _WIN32
+static CRITICAL_SECTION dp_lock;
+#define DP_Lock() EnterCriticalSection(&dp_lock)
+#define DP_Unlock() LeaveCriticalSection(&dp_lock)
+#else
+static pthread_mutex_t dp_lock = PTHREAD_MUTEX_INITIALIZER;
+#define DP_Lock() pthread_mutex_lock(&dp_lock)
+#define DP_Unlock() pthread_mutex_unlock(&dp_lock)
+#endif
+
+/*
+=======================================================================
+ENGINE GLUE
+=======================================================================
+*/
+
+/**
+ * @brief Errors of the message code only abort the demo being parsed
+ * @param code - unused
+ * @param[in] fmt
+ */
+void QDECL Com_Error(int code, const char *fmt, ...)
+{
+	va_list argptr;
+	char    text[MAX_STRING_CHARS];
+
+	va_start(argptr, fmt);
+	Q_vsnprintf(text, sizeof(text), fmt, argptr);
+	va_end(argptr);
+
+	if (dp_current)
+	{
+		Q_strncpyz(dp_current->error, text, sizeof(dp_current->error));
+		longjmp(dp_current->abortFrame, 1);
+	}
+
+	fprintf(stderr, "etldemo: %s\n", text);
+	exit(1);
+}
+
+/**
+ * @brief Com_Printf
+ * @param[in] fmt
+ */
+void QDECL Com_Printf(const char *fmt, ...)
+{
+	va_list argptr;
+
+	va_start(argptr, fmt);
+	vfprintf(stderr, fmt, argptr);
+	va_end(argptr);
+}
+
+/**
+ * @brief Com_DPrintf
+ * @param fmt - unused
+ */
+void QDECL Com_DPrintf(const char *fmt, ...)
+{
+}
+
+#ifdef ETLEGACY_DEBUG
+/**
+ * @brief The message benchmarks aren't registered in the tool
+ * @return
+ */
+int Cmd_Argc(void)
+{
+	return 0;
+}
+
+/**
+ * @brief Cmd_Argv
+ * @param arg - unused
+ * @return
+ */
+char *Cmd_Argv(int arg)
+{
+	return "";
+}
+#endif
+
+/**
+ * @brief Wall clock in milliseconds
+ * @return
+ */
+int Sys_Milliseconds(void)
+{
+#ifdef _WIN32
+	return (int)GetTickCount();
+#else
+	struct timeval tp;
+
+	gettimeofday(&tp, NULL);
+	return (int)(tp.tv_sec * 1000 + tp.tv_usec / 1000);
+#endif
+}
+
+/*
+=======================================================================
+OUTPUT
+=======================================================================
+*/
+
+/**
+ * @brief Append text to the output of the current demo
+ * @param[in,out] dp
+ * @param[in] text
+ * @param[in] len
+ */
+static void DP_Append(demoParse_t *dp, const char *text, size_t len)
+{
+	if (dp->outSize + len + 1 > dp->outMax)
+	{
+		size_t outMax = MAX(dp->outMax * 2, dp->outSize + len + 0x10000);
+		char   *out   = (char *)realloc(dp->out, outMax);
+
+		if (!out)
+		{
+			fprintf(stderr, "etldemo: out of memory\n");
+			exit(1);
+		}
+
+		dp->out    = out;
+		dp->outMax = outMax;
+	}
+
+	Com_Memcpy(dp->out + dp->outSize, text, len);
+	dp->outSize += len;
+}
+
+/**
+ * @brief Append a formatted string to the output of the current demo
+ * @param[in,out] dp
+ * @param[in] fmt
+ */
+static void QDECL DP_Printf(demoParse_t *dp, const char *fmt, ...)
+{
+	va_list argptr;
+	char    text[MAX_STRING_CHARS];
+	int     len;
+
+	va_start(argptr, fmt);
+	len = Q_vsnprintf(text, sizeof(text), fmt, argptr);
+	va_end(argptr);
+
+	if (len < 0 || len >= (int)sizeof(text))
+	{
+		len = strlen(text);
+	}
+
+	DP_Append(dp, text, len);
+}
+
+/**
+ * @brief Append a quoted string, escaped for JSON or CSV
+ * @param[in,out] dp
+ * @param[in] s
+ */
+static void DP_Quote(demoParse_t *dp, const char *s)
+{
+	char c;
+
+	DP_Append(dp, "\"", 1);
+	for (; *s; s++)
+	{
+		c = *s;
+		if (c == '"')
+		{
+			DP_Append(dp, dp_csv ? "\"\"" : "\\\"", 2);
+		}
+		else if (c == '\\' && !dp_csv)
+		{
+			DP_Append(dp, "\\\\", 2);
+		}
+		else if ((unsigned char)c < ' ')
+		{
+			if (!dp_csv)
+			{
+				DP_Printf(dp, "\\u%04x", c);
+			}
+		}
+		else
+		{
+			DP_Append(dp, &c, 1);
+		}
+	}
+	DP_Append(dp, "\"", 1);
+}
+
+/**
+ * @brief DP_InitEvent
+ * @param[out] ev
+ * @param[in] type
+ * @param[in] time
+ */
+static void DP_InitEvent(dpEvent_t *ev, const char *type, int time)
+{
+	ev->type      = type;
+	ev->time      = time;
+	ev->client    = -1;
+	ev->target    = -1;
+	ev->mod       = -1;
+	ev->weapon    = -1;
+	ev->team      = -1;
+	ev->kills     = -1;
+	ev->deaths    = -1;
+	ev->teamkills = -1;
+	ev->suicides  = -1;
+	ev->accuracy  = -1.f;
+	ev->headshots = -1.f;
+	ev->name      = NULL;
+	ev->text      = NULL;
+}
+
+/**
+ * @brief Write the CSV header
+ */
+static void DP_WriteHeader(void)
+{
+	if (dp_csv)
+	{
+		fprintf(dp_output, "demo,type,time,client,target,mod,weapon,team,kills,deaths,teamkills,suicides,accuracy,headshots,name,text\n");
+	}
+}
+
+/**
+ * @brief Write a JSON int field if it is set, or a CSV column
+ * @param[in,out] dp
+ * @param[in] key
+ * @param[in] value
+ */
+static void DP_IntField(demoParse_t *dp, const char *key, int value)
+{
+	if (dp_csv)
+	{
+		if (value >= 0)
+		{
+			DP_Printf(dp, ",%i", value);
+		}
+		else
+		{
+			DP_Append(dp, ",", 1);
+		}
+	}
+	else if (value >= 0)
+	{
+		DP_Printf(dp, ",\"%s\":%i", key, value);
+	}
+}
+
+/**
+ * @brief Write a JSON float field if it is set, or a CSV column
+ * @param[in,out] dp
+ * @param[in] key
+ * @param[in] value
+ */
+static void DP_FloatField(demoParse_t *dp, const char *key, float value)
+{
+	if (dp_csv)
+	{
+		if (value >= 0.f)
+		{
+			DP_Printf(dp, ",%.1f", value);
+		}
+		else
+		{
+			DP_Append(dp, ",", 1);
+		}
+	}
+	else if (value >= 0.f)
+	{
+		DP_Printf(dp, ",\"%s\":%.1f", key, value);
+	}
+}
+
+/**
+ * @brief Write a JSON string field if it is set, or a CSV column
+ * @param[in,out] dp
+ * @param[in] key
+ * @param[in] value
+ */
+static void DP_StringField(demoParse_t *dp, const char *key, const char *value)
+{
+	if (dp_csv)
+	{
+		DP_Append(dp, ",", 1);
+		if (value)
+		{
+			DP_Quote(dp, value);
+		}
+	}
+	else if (value)
+	{
+		DP_Printf(dp, ",\"%s\":", key);
+		DP_Quote(dp, value);
+	}
+}
+
+/**
+ * @brief Write one event line
+ * @param[in,out] dp
+ * @param[in] ev
+ */
+static void DP_Emit(demoParse_t *dp, const dpEvent_t *ev)
+{
+	if (dp_csv)
+	{
+		DP_Quote(dp, dp->path);
+		DP_Printf(dp, ",%s", ev->type);
+	}
+	else
+	{
+		DP_Append(dp, "{\"demo\":", 8);
+		DP_Quote(dp, dp->path);
+		DP_Printf(dp, ",\"type\":\"%s\"", ev->type);
+	}
+
+	DP_IntField(dp, "time", ev->time);
+	DP_IntField(dp, "client", ev->client);
+	DP_IntField(dp, "target", ev->target);
+	DP_IntField(dp, "mod", ev->mod);
+	DP_IntField(dp, "weapon", ev->weapon);
+	DP_IntField(dp, "team", ev->team);
+	DP_IntField(dp, "kills", ev->kills);
+	DP_IntField(dp, "deaths", ev->deaths);
+	DP_IntField(dp, "teamkills", ev->teamkills);
+	DP_IntField(dp, "suicides", ev->suicides);
+	DP_FloatField(dp, "accuracy", ev->accuracy);
+	DP_FloatField(dp, "headshots", ev->headshots);
+	DP_StringField(dp, "name", ev->name);
+	DP_StringField(dp, "text", ev->text);
+
+	DP_Append(dp, dp_csv ? "\n" : "}\n", dp_csv ? 1 : 2);
+}
+
+/*
+=======================================================================
+GAME STATE
+=======================================================================
+*/
+
+/**
+ * @brief Reentrant Info_ValueForKey, the shared one uses static buffers
+ * @param[in] info
+ * @param[in] key
+ * @param[out] value
+ * @param[in] size
+ */
+static void DP_InfoValue(const char *info, const char *key, char *value, size_t size)
+{
+	const char *s = info;
+	size_t     keyLen = strlen(key);
+
+	*value = '\0';
+
+	while (s && *s)
+	{
+		const char *k, *v;
+		size_t     len;
+
+		if (*s == '\\')
+		{
+			s++;
+		}
+
+		k = s;
+		while (*s && *s != '\\')
+		{
+			s++;
+		}
+		if (!*s)
+		{
+			return;
+		}
+
+		v = ++s;
+		while (*s && *s != '\\')
+		{
+			s++;
+		}
+
+		if ((size_t)(v - 1 - k) == keyLen && !Q_stricmpn(k, key, keyLen))
+		{
+			len = MIN((size_t)(s - v), size - 1);
+			Com_Memcpy(value, v, len);
+			value[len] = '\0';
+			return;
+		}
+	}
+}
+
+/**
+ * @brief DP_SetConfigstring
+ * @param[in,out] dp
+ * @param[in] index
+ * @param[in] s
+ */
+static void DP_SetConfigstring(demoParse_t *dp, int index, const char *s)
+{
+	size_t len;
+
+	if (index < 0 || index >= MAX_CONFIGSTRINGS)
+	{
+		Com_Error(ERR_DROP, "configstring < 0 or configstring >= MAX_CONFIGSTRINGS");
+	}
+
+	free(dp->cs[index]);
+	dp->cs[index] = NULL;
+
+	if (s[0])
+	{
+		len           = strlen(s) + 1;
+		dp->cs[index] = (char *)malloc(len);
+		if (!dp->cs[index])
+		{
+			Com_Error(ERR_FATAL, "out of memory");
+		}
+		Com_Memcpy(dp->cs[index], s, len);
+	}
+}
+
+/**
+ * @brief DP_Configstring
+ * @param[in] dp
+ * @param[in] index
+ * @return
+ */
+static const char *DP_Configstring(demoParse_t *dp, int index)
+{
+	return dp->cs[index] ? dp->cs[index] : "";
+}
+
+/**
+ * @brief Name and team of a client from its configstring
+ * @param[in] dp
+ * @param[in] clientNum
+ * @param[out] name
+ * @param[in] size
+ * @return Team of the client, -1 if the slot is empty
+ */
+static int DP_ClientInfo(demoParse_t *dp, int clientNum, char *name, size_t size)
+{
+	const char *info;
+	char       team[16];
+
+	*name = '\0';
+	if (clientNum < 0 || clientNum >= MAX_CLIENTS)
+	{
+		return -1;
+	}
+
+	info = DP_Configstring(dp, CS_PLAYERS + clientNum);
+	if (!info[0])
+	{
+		return -1;
+	}
+
+	DP_InfoValue(info, "n", name, size);
+	Q_CleanStr(name);
+	DP_InfoValue(info, "t", team, sizeof(team));
+	return atoi(team);
+}
+
+/**
+ * @brief Split a server command into arguments like Cmd_TokenizeString
+ * @param[in,out] dp
+ * @param[in] text
+ */
+static void DP_Tokenize(demoParse_t *dp, const char *text)
+{
+	char *out = dp->tokenBuf;
+	char *end = dp->tokenBuf + sizeof(dp->tokenBuf) - 1;
+
+	dp->argc = 0;
+
+	while (*text && dp->argc < DP_MAX_ARGS)
+	{
+		while (*text && *text <= ' ')
+		{
+			text++;
+		}
+		if (!*text)
+		{
+			break;
+		}
+
+		dp->argv[dp->argc++] = out;
+
+		if (*text == '"')
+		{
+			text++;
+			while (*text && *text != '"' && out < end)
+			{
+				*out++ = *text++;
+			}
+			if (*text == '"')
+			{
+				text++;
+			}
+		}
+		else
+		{
+			while (*text > ' ' && out < end)
+			{
+				*out++ = *text++;
+			}
+		}
+
+		if (out >= end)
+		{
+			break;
+		}
+		*out++ = '\0';
+	}
+	*out = '\0';
+}
+
+/**
+ * @brief DP_Argv
+ * @param[in] dp
+ * @param[in] arg
+ * @return
+ */
+static const char *DP_Argv(demoParse_t *dp, int arg)
+{
+	return arg < dp->argc ? dp->argv[arg] : "";
+}
+
+/**
+ * @brief Handle a reliable server command, mirrors CL_GetServerCommand
+ * @param[in,out] dp
+ * @param[in] s
+ */
+static void DP_ServerCommand(demoParse_t *dp, const char *s)
+{
+	const char *cmd;
+	dpEvent_t  ev;
+	int        i;
+
+	DP_Tokenize(dp, s);
+rescan:
+	cmd = DP_Argv(dp, 0);
+
+	if (!strcmp(cmd, "bcs0"))
+	{
+		Com_sprintf(dp->bigConfigString, sizeof(dp->bigConfigString), "cs %s \"%s", DP_Argv(dp, 1), DP_Argv(dp, 2));
+	}
+	else if (!strcmp(cmd, "bcs1"))
+	{
+		Q_strcat(dp->bigConfigString, sizeof(dp->bigConfigString), DP_Argv(dp, 2));
+	}
+	else if (!strcmp(cmd, "bcs2"))
+	{
+		char text[BIG_INFO_STRING];
+
+		Q_strcat(dp->bigConfigString, sizeof(dp->bigConfigString), DP_Argv(dp, 2));
+		Q_strcat(dp->bigConfigString, sizeof(dp->bigConfigString), "\"");
+		Q_strncpyz(text, dp->bigConfigString, sizeof(text));
+		DP_Tokenize(dp, text);
+		goto rescan;
+	}
+	else if (!strcmp(cmd, "csp"))
+	{
+		char splice[BIG_INFO_STRING];
+
+		i = atoi(DP_Argv(dp, 1));
+		if (i >= 0 && i < MAX_CONFIGSTRINGS
+		    && Com_SpliceString(splice, sizeof(splice), DP_Configstring(dp, i), atoi(DP_Argv(dp, 2)), atoi(DP_Argv(dp, 3)), atoi(DP_Argv(dp, 4)), DP_Argv(dp, 5)))
+		{
+			DP_SetConfigstring(dp, i, splice);
+		}
+	}
+	else if (!strcmp(cmd, "cs"))
+	{
+		char value[BIG_INFO_STRING];
+
+		// everything after "cs <num>"
+		value[0] = '\0';
+		for (i = 2; i < dp->argc; i++)
+		{
+			if (i > 2)
+			{
+				Q_strcat(value, sizeof(value), " ");
+			}
+			Q_strcat(value, sizeof(value), dp->argv[i]);
+		}
+		DP_SetConfigstring(dp, atoi(DP_Argv(dp, 1)), value);
+	}
+	else if (!strcmp(cmd, "cp") || !strcmp(cmd, "cpm"))
+	{
+		char text[MAX_STRING_CHARS];
+
+		Q_strncpyz(text, DP_Argv(dp, 1), sizeof(text));
+		Q_CleanStr(text);
+		if (text[0])
+		{
+			DP_InitEvent(&ev, "announce", dp->snap.serverTime);
+			ev.text = text;
+			DP_Emit(dp, &ev);
+		}
+	}
+	else if (!strcmp(cmd, "imwa"))
+	{
+		char name[MAX_NAME_LENGTH * 2];
+
+		// accuracy and headshot percentage of every client slot
+		for (i = 0; i < MAX_CLIENTS && 1 + i * 2 + 1 < dp->argc; i++)
+		{
+			if (DP_ClientInfo(dp, i, name, sizeof(name)) < 0)
+			{
+				continue;
+			}
+
+			dp->clients[i].accuracy  = atof(dp->argv[1 + i * 2]);
+			dp->clients[i].headshots = atof(dp->argv[2 + i * 2]);
+
+			DP_InitEvent(&ev, "accuracy", dp->snap.serverTime);
+			ev.client    = i;
+			ev.name      = name;
+			ev.accuracy  = dp->clients[i].accuracy;
+			ev.headshots = dp->clients[i].headshots;
+			DP_Emit(dp, &ev);
+		}
+	}
+}
+
+/**
+ * @brief Count a kill and write the event
+ * @param[in,out] dp
+ * @param[in] es obituary temp entity
+ */
+static void DP_Obituary(demoParse_t *dp, const entityState_t *es)
+{
+	char      attackerName[MAX_NAME_LENGTH * 2], targetName[MAX_NAME_LENGTH * 2];
+	int       target   = es->otherEntityNum;
+	int       attacker = es->otherEntityNum2;
+	int       attackerTeam, targetTeam;
+	dpEvent_t ev;
+
+	if (target < 0 || target >= MAX_CLIENTS)
+	{
+		return;
+	}
+
+	targetTeam   = DP_ClientInfo(dp, target, targetName, sizeof(targetName));
+	attackerTeam = DP_ClientInfo(dp, attacker, attackerName, sizeof(attackerName));
+
+	dp->clients[target].deaths++;
+	if (attacker < 0 || attacker >= MAX_CLIENTS || attacker == target)
+	{
+		dp->clients[target].suicides++;
+		attacker = -1;
+	}
+	else if (attackerTeam == targetTeam)
+	{
+		dp->clients[attacker].teamkills++;
+	}
+	else
+	{
+		dp->clients[attacker].kills++;
+	}
+
+	DP_InitEvent(&ev, "kill", dp->snap.serverTime);
+	ev.client = attacker;
+	ev.target = target;
+	ev.mod    = es->eventParm;
+	ev.weapon = es->weapon;
+	ev.name   = attacker >= 0 ? attackerName : NULL;
+	ev.text   = targetName;
+	DP_Emit(dp, &ev);
+}
+
+/**
+ * @brief Fire the temp entity events that are new in the current snapshot
+ * @param[in,out] dp
+ */
+static void DP_SnapshotEvents(demoParse_t *dp)
+{
+	entityState_t *es;
+	int           i;
+
+	Com_Memset(dp->eventLive, 0, sizeof(dp->eventLive));
+
+	for (i = 0; i < dp->snap.numEntities; i++)
+	{
+		es = &dp->parseEntities[(dp->snap.parseEntitiesNum + i) & (MAX_PARSE_ENTITIES - 1)];
+		if (es->eType <= ET_EVENTS)
+		{
+			continue;
+		}
+
+		dp->eventLive[es->number] = 1;
+		if (dp->eventSeen[es->number])
+		{
+			continue;
+		}
+
+		if (((es->eType - ET_EVENTS) & ~EV_EVENT_BITS) == EV_OBITUARY)
+		{
+			DP_Obituary(dp, es);
+		}
+	}
+
+	Com_Memcpy(dp->eventSeen, dp->eventLive, sizeof(dp->eventSeen));
+}
+
+/*
+=======================================================================
+MESSAGE PARSING
+=======================================================================
+*/
+
+/**
+ * @brief Read a string without the static buffer of MSG_ReadString
+ * @param[in,out] msg
+ * @param[out] s
+ * @param[in] size
+ */
+static void DP_ReadString(msg_t *msg, char *s, size_t size)
+{
+	size_t l = 0;
+	int    c;
+
+	while (1)
+	{
+		c = MSG_ReadByte(msg);
+		if (c == -1 || c == 0)
+		{
+			break;
+		}
+
+		if (c == '%')
+		{
+			c = '.';
+		}
+
+		if (l < size - 1)
+		{
+			s[l++] = c;
+		}
+	}
+
+	s[l] = '\0';
+}
+
+/**
+ * @brief DP_ParseGamestate
+ * @param[in,out] dp
+ * @param[in,out] msg
+ */
+static void DP_ParseGamestate(demoParse_t *dp, msg_t *msg)
+{
+	char          s[BIG_INFO_STRING];
+	char          mapname[MAX_QPATH];
+	entityState_t nullstate;
+	int           cmd, i, back, count = 0;
+	int           recent[BASELINE_DELTA_BACKUP];
+	dpEvent_t     ev;
+
+	for (i = 0; i < MAX_CONFIGSTRINGS; i++)
+	{
+		DP_SetConfigstring(dp, i, "");
+	}
+	Com_Memset(dp->baselines, 0, sizeof(dp->baselines));
+	Com_Memset(dp->snapshots, 0, sizeof(dp->snapshots));
+	Com_Memset(&dp->snap, 0, sizeof(dp->snap));
+	Com_Memset(dp->eventSeen, 0, sizeof(dp->eventSeen));
+
+	dp->serverCommandSequence = MSG_ReadLong(msg);
+
+	while (1)
+	{
+		cmd = MSG_ReadByte(msg);
+
+		if (cmd == svc_EOF)
+		{
+			break;
+		}
+
+		if (cmd == svc_configstring)
+		{
+			i = MSG_ReadShort(msg);
+			DP_ReadString(msg, s, sizeof(s));
+			DP_SetConfigstring(dp, i, s);
+		}
+		else if (cmd == svc_baseline)
+		{
+			i = MSG_ReadBits(msg, GENTITYNUM_BITS);
+			if (i < 0 || i >= MAX_GENTITIES)
+			{
+				Com_Error(ERR_DROP, "Baseline number out of range: %i", i);
+			}
+			Com_Memset(&nullstate, 0, sizeof(nullstate));
+			MSG_ReadDeltaEntity(msg, &nullstate, &dp->baselines[i], i);
+
+			recent[count++ & (BASELINE_DELTA_BACKUP - 1)] = i;
+		}
+		else if (cmd == svc_baselineDelta)
+		{
+			back = MSG_ReadBits(msg, BASELINE_DELTA_BITS);
+			i    = MSG_ReadBits(msg, GENTITYNUM_BITS);
+			if (back < 1 || back > count || i < 0 || i >= MAX_GENTITIES)
+			{
+				Com_Error(ERR_DROP, "Baseline delta out of range: %i %i", back, i);
+			}
+			MSG_ReadDeltaEntity(msg, &dp->baselines[recent[(count - back) & (BASELINE_DELTA_BACKUP - 1)]], &dp->baselines[i], i);
+
+			recent[count++ & (BASELINE_DELTA_BACKUP - 1)] = i;
+		}
+		else
+		{
+			Com_Error(ERR_DROP, "DP_ParseGamestate: bad command byte");
+		}
+	}
+
+	(void) MSG_ReadLong(msg);   // clientNum
+	(void) MSG_ReadLong(msg);   // checksumFeed
+
+	DP_InfoValue(DP_Configstring(dp, CS_SERVERINFO), "mapname", mapname, sizeof(mapname));
+
+	DP_InitEvent(&ev, "gamestate", atoi(DP_Configstring(dp, CS_LEVEL_START_TIME)));
+	ev.text = mapname;
+	DP_Emit(dp, &ev);
+}
+
+/**
+ * @brief Mirrors CL_DeltaEntity
+ * @param[in,out] dp
+ * @param[in,out] msg
+ * @param[in,out] frame
+ * @param[in] newnum
+ * @param[in] old
+ * @param[in] unchanged
+ */
+static void DP_DeltaEntity(demoParse_t *dp, msg_t *msg, dpSnapshot_t *frame, int newnum, entityState_t *old, qboolean unchanged)
+{
+	entityState_t *state = &dp->parseEntities[dp->parseEntitiesNum & (MAX_PARSE_ENTITIES - 1)];
+
+	if (unchanged)
+	{
+		*state = *old;
+	}
+	else
+	{
+		MSG_ReadDeltaEntity(msg, old, state, newnum);
+	}
+
+	if (state->number == (MAX_GENTITIES - 1))
+	{
+		return;     // entity was delta removed
+	}
+
+	dp->parseEntitiesNum++;
+	frame->numEntities++;
+}
+
+/**
+ * @brief Mirrors CL_ParsePacketEntities
+ * @param[in,out] dp
+ * @param[in,out] msg
+ * @param[in] oldframe
+ * @param[in,out] newframe
+ */
+static void DP_ParsePacketEntities(demoParse_t *dp, msg_t *msg, dpSnapshot_t *oldframe, dpSnapshot_t *newframe)
+{
+	entityState_t *oldstate = NULL;
+	int           oldindex  = 0;
+	int           newnum, oldnum;
+
+	newframe->parseEntitiesNum = dp->parseEntitiesNum;
+	newframe->numEntities      = 0;
+
+	if (!oldframe || oldindex >= oldframe->numEntities)
+	{
+		oldnum = MAX_GENTITIES;
+	}
+	else
+	{
+		oldstate = &dp->parseEntities[(oldframe->parseEntitiesNum + oldindex) & (MAX_PARSE_ENTITIES - 1)];
+		oldnum   = oldstate->number;
+	}
+
+	while (1)
+	{
+		newnum = MSG_ReadBits(msg, GENTITYNUM_BITS);
+
+		if (newnum >= (MAX_GENTITIES - 1))
+		{
+			break;
+		}
+
+		if (msg->readcount > msg->cursize)
+		{
+			Com_Error(ERR_DROP, "DP_ParsePacketEntities: end of message");
+		}
+
+		while (oldnum < newnum)
+		{
+			DP_DeltaEntity(dp, msg, newframe, oldnum, oldstate, qtrue);
+
+			oldindex++;
+			if (!oldframe || oldindex >= oldframe->numEntities)
+			{
+				oldnum = MAX_GENTITIES;
+			}
+			else
+			{
+				oldstate = &dp->parseEntities[(oldframe->parseEntitiesNum + oldindex) & (MAX_PARSE_ENTITIES - 1)];
+				oldnum   = oldstate->number;
+			}
+		}
+
+		if (oldnum == newnum)
+		{
+			DP_DeltaEntity(dp, msg, newframe, newnum, oldstate, qfalse);
+
+			oldindex++;
+			if (oldindex >= oldframe->numEntities)
+			{
+				oldnum = MAX_GENTITIES;
+			}
+			else
+			{
+				oldstate = &dp->parseEntities[(oldframe->parseEntitiesNum + oldindex) & (MAX_PARSE_ENTITIES - 1)];
+				oldnum   = oldstate->number;
+			}
+		}
+		else if (oldnum > newnum)
+		{
+			DP_DeltaEntity(dp, msg, newframe, newnum, &dp->baselines[newnum], qfalse);
+		}
+	}
+
+	// any remaining entities in the old frame are copied over
+	while (oldnum != MAX_GENTITIES)
+	{
+		DP_DeltaEntity(dp, msg, newframe, oldnum, oldstate, qtrue);
+
+		oldindex++;
+		if (oldindex >= oldframe->numEntities)
+		{
+			oldnum = MAX_GENTITIES;
+		}
+		else
+		{
+			oldstate = &dp->parseEntities[(oldframe->parseEntitiesNum + oldindex) & (MAX_PARSE_ENTITIES - 1)];
+			oldnum   = oldstate->number;
+		}
+	}
+}
+
+/**
+ * @brief Mirrors CL_ParseSnapshot
+ * @param[in,out] dp
+ * @param[in,out] msg
+ */
+static void DP_ParseSnapshot(demoParse_t *dp, msg_t *msg)
+{
+	dpSnapshot_t newSnap, *old = NULL;
+	byte         areamask[MAX_MAP_AREA_BYTES];
+	int          len, deltaNum, oldMessageNum;
+
+	Com_Memset(&newSnap, 0, sizeof(newSnap));
+	newSnap.serverTime = MSG_ReadLong(msg);
+	newSnap.messageNum = dp->serverMessageSequence;
+
+	deltaNum         = MSG_ReadByte(msg);
+	newSnap.deltaNum = deltaNum ? newSnap.messageNum - deltaNum : -1;
+	newSnap.snapFlags = MSG_ReadByte(msg);
+
+	if (newSnap.deltaNum <= 0)
+	{
+		newSnap.valid = qtrue;      // uncompressed frame
+	}
+	else
+	{
+		old = &dp->snapshots[newSnap.deltaNum & PACKET_MASK];
+		if (old->valid && old->messageNum == newSnap.deltaNum
+		    && dp->parseEntitiesNum - old->parseEntitiesNum <= MAX_PARSE_ENTITIES - 128)
+		{
+			newSnap.valid = qtrue;
+		}
+	}
+
+	len = MSG_ReadByte(msg);
+	if (len > (int)sizeof(areamask))
+	{
+		Com_Error(ERR_DROP, "DP_ParseSnapshot: Invalid size %d for areamask", len);
+	}
+	MSG_ReadData(msg, areamask, len);
+
+	MSG_ReadDeltaPlayerstate(msg, old ? &old->ps : NULL, &newSnap.ps);
+	DP_ParsePacketEntities(dp, msg, old, &newSnap);
+
+	if (!newSnap.valid)
+	{
+		return;
+	}
+
+	// invalidate the frames dropped in between
+	oldMessageNum = dp->snap.messageNum + 1;
+	if (newSnap.messageNum - oldMessageNum >= PACKET_BACKUP)
+	{
+		oldMessageNum = newSnap.messageNum - (PACKET_BACKUP - 1);
+	}
+	for (; oldMessageNum < newSnap.messageNum; oldMessageNum++)
+	{
+		dp->snapshots[oldMessageNum & PACKET_MASK].valid = qfalse;
+	}
+
+	dp->snap                                            = newSnap;
+	dp->snapshots[dp->snap.messageNum & PACKET_MASK] = dp->snap;
+
+	DP_SnapshotEvents(dp);
+}
+
+/**
+ * @brief Mirrors CL_ParseServerMessage
+ * @param[in,out] dp
+ * @param[in,out] msg
+ */
+static void DP_ParseServerMessage(demoParse_t *dp, msg_t *msg)
+{
+	char s[MAX_STRING_CHARS];
+	int  cmd, seq;
+
+	MSG_Bitstream(msg);
+	(void) MSG_ReadLong(msg);   // reliableAcknowledge
+
+	while (1)
+	{
+		if (msg->readcount > msg->cursize)
+		{
+			Com_Error(ERR_DROP, "DP_ParseServerMessage: read past end of server message");
+		}
+
+		cmd = MSG_ReadByte(msg);
+		if (cmd == svc_EOF)
+		{
+			break;
+		}
+
+		switch (cmd)
+		{
+		default:
+			Com_Error(ERR_DROP, "DP_ParseServerMessage: Illegible server message %d", cmd);
+		case svc_nop:
+			break;
+		case svc_serverCommand:
+			seq = MSG_ReadLong(msg);
+			DP_ReadString(msg, s, sizeof(s));
+			if (seq > dp->serverCommandSequence)
+			{
+				dp->serverCommandSequence = seq;
+				DP_ServerCommand(dp, s);
+			}
+			break;
+		case svc_gamestate:
+			DP_ParseGamestate(dp, msg);
+			break;
+		case svc_snapshot:
+			DP_ParseSnapshot(dp, msg);
+			break;
+		case svc_download:
+			Com_Error(ERR_DROP, "DP_ParseServerMessage: download in demo");
+		}
+	}
+}
+
+/**
+ * @brief Load a whole demo file into the context buffer
+ * @param[in,out] dp
+ * @return qfalse if the file can't be read
+ */
+static qboolean DP_LoadFile(demoParse_t *dp)
+{
+	FILE *f = fopen(dp->path, "rb");
+	long size;
+
+	if (!f)
+	{
+		return qfalse;
+	}
+
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	if (size < 0)
+	{
+		fclose(f);
+		return qfalse;
+	}
+
+	if (size > dp->fileMax)
+	{
+		byte *file = (byte *)realloc(dp->file, size);
+
+		if (!file)
+		{
+			fclose(f);
+			return qfalse;
+		}
+		dp->file    = file;
+		dp->fileMax = size;
+	}
+
+	dp->fileSize = (long)fread(dp->file, 1, size, f);
+	fclose(f);
+
+	return dp->fileSize == size;
+}
+
+/**
+ * @brief Write the per client totals of a demo
+ * @param[in,out] dp
+ */
+static void DP_Summary(demoParse_t *dp)
+{
+	char      name[MAX_NAME_LENGTH * 2];
+	dpEvent_t ev;
+	int       i, team;
+
+	for (i = 0; i < MAX_CLIENTS; i++)
+	{
+		team = DP_ClientInfo(dp, i, name, sizeof(name));
+		if (team < 0)
+		{
+			continue;
+		}
+
+		DP_InitEvent(&ev, "player", dp->snap.serverTime);
+		ev.client    = i;
+		ev.name      = name;
+		ev.team      = team;
+		ev.kills     = dp->clients[i].kills;
+		ev.deaths    = dp->clients[i].deaths;
+		ev.teamkills = dp->clients[i].teamkills;
+		ev.suicides  = dp->clients[i].suicides;
+		ev.accuracy  = dp->clients[i].accuracy;
+		ev.headshots = dp->clients[i].headshots;
+		DP_Emit(dp, &ev);
+	}
+}
+
+/**
+ * @brief Parse one demo and write its events
+ * @param[in,out] dp
+ * @param[in] path
+ */
+static void DP_ParseDemo(demoParse_t *dp, const char *path)
+{
+	dpEvent_t ev;
+	msg_t     msg;
+	long      pos = 0;
+	int       i, len;
+
+	dp->path                  = path;
+	dp->outSize               = 0;
+	dp->serverMessageSequence = 0;
+	dp->serverCommandSequence = 0;
+	dp->parseEntitiesNum      = 0;
+	dp->error[0]              = '\0';
+	Com_Memset(dp->snapshots, 0, sizeof(dp->snapshots));
+	Com_Memset(&dp->snap, 0, sizeof(dp->snap));
+	Com_Memset(dp->eventSeen, 0, sizeof(dp->eventSeen));
+	for (i = 0; i < MAX_CLIENTS; i++)
+	{
+		Com_Memset(&dp->clients[i], 0, sizeof(dp->clients[i]));
+		dp->clients[i].accuracy  = -1.f;
+		dp->clients[i].headshots = -1.f;
+	}
+	for (i = 0; i < MAX_CONFIGSTRINGS; i++)
+	{
+		DP_SetConfigstring(dp, i, "");
+	}
+
+	if (!DP_LoadFile(dp))
+	{
+		DP_InitEvent(&ev, "error", -1);
+		ev.text = "couldn't read demo";
+		DP_Emit(dp, &ev);
+		return;
+	}
+
+	if (!setjmp(dp->abortFrame))
+	{
+		if (dp->fileSize >= 4 && LittleLong(*(int *)dp->file) == DP_BLOCK_MAGIC)
+		{
+			Com_Error(ERR_DROP, "block compressed demo, convert it with unpackFile first");
+		}
+
+		// int sequence, int length, length bytes of message, terminated by a length of -1
+		while (pos + 8 <= dp->fileSize)
+		{
+			dp->serverMessageSequence = LittleLong(*(int *)(dp->file + pos));
+			len                       = LittleLong(*(int *)(dp->file + pos + 4));
+			pos                      += 8;
+
+			if (len == -1)
+			{
+				break;
+			}
+
+			if (len < 0 || len > MAX_MSGLEN || pos + len > dp->fileSize)
+			{
+				Com_Error(ERR_DROP, "demo file was truncated");
+			}
+
+			MSG_Init(&msg, dp->file + pos, len);
+			msg.cursize = len;
+			pos        += len;
+
+			DP_ParseServerMessage(dp, &msg);
+			dp->numMessages++;
+		}
+	}
+	else
+	{
+		DP_InitEvent(&ev, "error", dp->snap.serverTime);
+		ev.text = dp->error;
+		DP_Emit(dp, &ev);
+	}
+
+	DP_Summary(dp);
+
+	dp->numDemos++;
+	dp->numBytes += dp->fileSize;
+}
+
+/*
+=======================================================================
+DRIVER
+=======================================================================
+*/
+
+/**
+ * @brief Worker thread, takes the next demo until none is left
+ * @param[in,out] arg the demoParse_t of the thread
+ */
+#ifdef _WIN32
+static DWORD WINAPI DP_Worker(LPVOID arg)
+#else
+static void *DP_Worker(void *arg)
+#endif
+{
+	demoParse_t *dp = (demoParse_t *)arg;
+	int         index;
+
+	dp_current = dp;
+
+	while (1)
+	{
+		DP_Lock();
+		index = dp_nextPath++;
+		DP_Unlock();
+
+		if (index >= dp_numPaths)
+		{
+			break;
+		}
+
+		DP_ParseDemo(dp, dp_paths[index]);
+
+		DP_Lock();
+		fwrite(dp->out, 1, dp->outSize, dp_output);
+		DP_Unlock();
+	}
+
+	dp_current = NULL;
+	return 0;
+}
+
+/**
+ * @brief Number of online cores
+ * @return
+ */
+static int DP_NumCores(void)
+{
+#ifdef _WIN32
+	SYSTEM_INFO info;
+
+	GetSystemInfo(&info);
+	return (int)info.dwNumberOfProcessors;
+#else
+	long cores = sysconf(_SC_NPROCESSORS_ONLN);
+
+	return cores > 0 ? (int)cores : 1;
+#endif
+}
+
+/**
+ * @brief Add the demos listed in a file, one path per line
+ * @param[in] listFile
+ * @param[in,out] maxPaths
+ */
+static void DP_AddList(const char *listFile, int *maxPaths)
+{
+	FILE *f = strcmp(listFile, "-") ? fopen(listFile, "r") : stdin;
+	char line[MAX_OSPATH];
+
+	if (!f)
+	{
+		fprintf(stderr, "etldemo: couldn't open %s\n", listFile);
+		exit(1);
+	}
+
+	while (fgets(line, sizeof(line), f))
+	{
+		size_t len = strlen(line);
+
+		while (len && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+		{
+			line[--len] = '\0';
+		}
+		if (!len)
+		{
+			continue;
+		}
+
+		if (dp_numPaths == *maxPaths)
+		{
+			*maxPaths = *maxPaths ? *maxPaths * 2 : 1024;
+			dp_paths  = (const char **)realloc((void *)dp_paths, *maxPaths * sizeof(*dp_paths));
+			if (!dp_paths)
+			{
+				fprintf(stderr, "etldemo: out of memory\n");
+				exit(1);
+			}
+		}
+		dp_paths[dp_numPaths++] = strdup(line);
+	}
+
+	if (f != stdin)
+	{
+		fclose(f);
+	}
+}
+
+/**
+ * @brief DP_Usage
+ */
+static void DP_Usage(void)
+{
+	fprintf(stderr, "usage: etldemo [-threads n] [-csv] [-o file] [-list file|-] demo...\n");
+	exit(1);
+}
+
+/**
+ * @brief main
+ * @param[in] argc
+ * @param[in] argv
+ * @return
+ */
+int main(int argc, char **argv)
+{
+	static demoParse_t *contexts[DP_MAX_THREADS];
+	int                numThreads = 0, maxPaths = 0, i;
+	int                start, msec, numDemos = 0, numMessages = 0;
+	long               numBytes = 0;
+	msg_t              msg;
+	byte               dummy[1];
+#ifdef _WIN32
+	HANDLE threads[DP_MAX_THREADS];
+#else
+	pthread_t threads[DP_MAX_THREADS];
+#endif
+
+	dp_output = stdout;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-threads") && i + 1 < argc)
+		{
+			numThreads = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-csv"))
+		{
+			dp_csv = qtrue;
+		}
+		else if (!strcmp(argv[i], "-o") && i + 1 < argc)
+		{
+			dp_output = fopen(argv[++i], "wb");
+			if (!dp_output)
+			{
+				fprintf(stderr, "etldemo: couldn't write %s\n", argv[i]);
+				return 1;
+			}
+		}
+		else if (!strcmp(argv[i], "-list") && i + 1 < argc)
+		{
+			DP_AddList(argv[++i], &maxPaths);
+		}
+		else if (argv[i][0] == '-')
+		{
+			DP_Usage();
+		}
+		else
+		{
+			if (dp_numPaths == maxPaths)
+			{
+				maxPaths = maxPaths ? maxPaths * 2 : 1024;
+				dp_paths = (const char **)realloc((void *)dp_paths, maxPaths * sizeof(*dp_paths));
+				if (!dp_paths)
+				{
+					fprintf(stderr, "etldemo: out of memory\n");
+					return 1;
+				}
+			}
+			dp_paths[dp_numPaths++] = argv[i];
+		}
+	}
+
+	if (!dp_numPaths)
+	{
+		DP_Usage();
+	}
+
+	if (numThreads <= 0)
+	{
+		numThreads = DP_NumCores();
+	}
+	numThreads = MIN(numThreads, MIN(DP_MAX_THREADS, dp_numPaths));
+
+	// build the huffman tables before the threads share them
+	MSG_Init(&msg, dummy, sizeof(dummy));
+
+#ifdef _WIN32
+	InitializeCriticalSection(&dp_lock);
+#endif
+
+	DP_WriteHeader();
+	start = Sys_Milliseconds();
+
+	for (i = 0; i < numThreads; i++)
+	{
+		contexts[i] = (demoParse_t *)calloc(1, sizeof(demoParse_t));
+		if (!contexts[i])
+		{
+			fprintf(stderr, "etldemo: out of memory\n");
+			return 1;
+		}
+#ifdef _WIN32
+		threads[i] = CreateThread(NULL, 0, DP_Worker, contexts[i], 0, NULL);
+#else
+		pthread_create(&threads[i], NULL, DP_Worker, contexts[i]);
+#endif
+	}
+
+	for (i = 0; i < numThreads; i++)
+	{
+#ifdef _WIN32
+		WaitForSingleObject(threads[i], INFINITE);
+		CloseHandle(threads[i]);
+#else
+		pthread_join(threads[i], NULL);
+#endif
+		numDemos    += contexts[i]->numDemos;
+		numMessages += contexts[i]->numMessages;
+		numBytes    += contexts[i]->numBytes;
+	}
+
+	msec = MAX(Sys_Milliseconds() - start, 1);
+
+	fflush(dp_output);
+	if (dp_output != stdout)
+	{
+		fclose(dp_output);
+	}
+
+	fprintf(stderr, "etldemo: %i demos, %i messages, %.1f MB in %.2f s on %i threads: %.1f demos/s, %.1f MB/s\n",
+	        numDemos, numMessages, numBytes / 1024.0 / 1024.0, msec / 1000.0, numThreads,
+	        numDemos * 1000.0 / msec, numBytes / 1024.0 / 1024.0 * 1000.0 / msec);
+
+	return 0;
+}
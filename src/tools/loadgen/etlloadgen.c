@@ -0,0 +1,451 @@
+/*
+ * Wolfenstein: Enemy Territory GPL Source Code
+ * Copyright (C) 1999-2010 id Software LLC, a ZeniMax Media company.
+ *
+ * ET: Legacy
+ * Copyright (C) 2012-2018 ET:Legacy team <mail@etlegacy.com>
+ *
+ * This file is part of ET: Legacy - http://www.etlegacy.com
+ *
+ * ET: Legacy is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ET: Legacy is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ET: Legacy. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, Wolfenstein: Enemy Territory GPL Source Code is also
+ * subject to certain additional terms. You should have received a copy
+ * of these additional terms immediately following the terms and conditions
+ * of the GNU General Public License which accompanied the source code.
+ * If not, please request a copy in writing from id Software at the address below.
+ *
+ * id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+ */
+/**
+ * @file etlloadgen.c
+ * @brief Connectionless packet load generator for a local test server
+ *
+ * Sends getinfo (or getstatus) at a fixed rate from several sockets and counts the
+ * answers, while a probe socket sends a getchallenge now and then. getchallenge is
+ * always answered by the server's main loop, so the probe round trip shows how much
+ * the query flood delays the game frame, with sv_netFrontend 0 and 1.
+ *
+ * Run the server with sv_protect 0, or the rate limits drop most of the flood and
+ * the probes. frontendstats on the server shows where the packets went.
+ *
+ * Usage: etlloadgen [-pps n] [-time s] [-sockets n] [-probe ms] [-status] host[:port]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#define LG_CLOSE closesocket
+#else
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <netinet/in.h>
+#include <netdb.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+typedef int SOCKET;
+#define INVALID_SOCKET (-1)
+#define LG_CLOSE close
+#endif
+
+#define LG_DEFAULT_PORT     27960
+#define LG_MAX_SOCKETS      64
+#define LG_MAX_PROBES       65536
+#define LG_PACKET_SIZE      16384
+
+/**
+ * @struct lgStats_t
+ * @brief Counters of a run or of the last second
+ */
+typedef struct
+{
+	long sent;
+	long answered;
+	long probes;
+	long probeAnswers;
+	double probeTotal;          ///< ms
+	double probeMax;            ///< ms
+} lgStats_t;
+
+static SOCKET       sockets[LG_MAX_SOCKETS];
+static int          numSockets = 8;
+static SOCKET       probeSocket;
+static double       probeSent;  ///< when the pending probe was sent, 0 if none
+static double       probeTimes[LG_MAX_PROBES];
+static int          numProbeTimes;
+static lgStats_t    total, second;
+
+/**
+ * @brief Monotonic time
+ * @return seconds
+ */
+static double LG_Time(void)
+{
+#ifdef _WIN32
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER        now;
+
+	if (!frequency.QuadPart)
+	{
+		QueryPerformanceFrequency(&frequency);
+	}
+	QueryPerformanceCounter(&now);
+	return (double)now.QuadPart / (double)frequency.QuadPart;
+#else
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return now.tv_sec + now.tv_nsec / 1e9;
+#endif
+}
+
+/**
+ * @brief Open a non-blocking UDP socket on an ephemeral port
+ * @return INVALID_SOCKET on failure
+ */
+static SOCKET LG_OpenSocket(void)
+{
+	SOCKET sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+#ifdef _WIN32
+	u_long nonBlocking = 1;
+#endif
+
+	if (sock == INVALID_SOCKET)
+	{
+		return INVALID_SOCKET;
+	}
+
+#ifdef _WIN32
+	ioctlsocket(sock, FIONBIO, &nonBlocking);
+#else
+	fcntl(sock, F_SETFL, fcntl(sock, F_GETFL, 0) | O_NONBLOCK);
+#endif
+	return sock;
+}
+
+/**
+ * @brief Send a connectionless packet
+ * @param[in] sock
+ * @param[in] to
+ * @param[in] text
+ * @return 1 if sent
+ */
+static int LG_Send(SOCKET sock, const struct sockaddr_in *to, const char *text)
+{
+	char packet[256];
+	int  len = snprintf(packet, sizeof(packet), "\xff\xff\xff\xff%s", text);
+
+	return sendto(sock, packet, len, 0, (const struct sockaddr *)to, sizeof(*to)) == len;
+}
+
+/**
+ * @brief Read everything pending on the sockets
+ * @param[in] now
+ */
+static void LG_Receive(double now)
+{
+	static char packet[LG_PACKET_SIZE];
+	int         i, len;
+	double      rtt;
+
+	for (i = 0; i < numSockets; i++)
+	{
+		while ((len = recv(sockets[i], packet, sizeof(packet) - 1, 0)) > 4)
+		{
+			packet[len] = '\0';
+			if (!strncmp(packet + 4, "infoResponse", 12) || !strncmp(packet + 4, "statusResponse", 14))
+			{
+				total.answered++;
+				second.answered++;
+			}
+		}
+	}
+
+	while ((len = recv(probeSocket, packet, sizeof(packet) - 1, 0)) > 4)
+	{
+		packet[len] = '\0';
+		if (probeSent > 0 && !strncmp(packet + 4, "challengeResponse", 17))
+		{
+			rtt       = (now - probeSent) * 1000;
+			probeSent = 0;
+
+			total.probeAnswers++;
+			second.probeAnswers++;
+			total.probeTotal  += rtt;
+			second.probeTotal += rtt;
+			if (rtt > total.probeMax)
+			{
+				total.probeMax = rtt;
+			}
+			if (rtt > second.probeMax)
+			{
+				second.probeMax = rtt;
+			}
+			if (numProbeTimes < LG_MAX_PROBES)
+			{
+				probeTimes[numProbeTimes++] = rtt;
+			}
+		}
+	}
+}
+
+/**
+ * @brief Wait for an answer up to the given time
+ * @param[in] seconds
+ */
+static void LG_Wait(double seconds)
+{
+	fd_set         fdr;
+	struct timeval timeout;
+	SOCKET         highest = probeSocket;
+	int            i;
+
+	FD_ZERO(&fdr);
+	FD_SET(probeSocket, &fdr);
+	for (i = 0; i < numSockets; i++)
+	{
+		FD_SET(sockets[i], &fdr);
+		if (sockets[i] > highest)
+		{
+			highest = sockets[i];
+		}
+	}
+
+	timeout.tv_sec  = 0;
+	timeout.tv_usec = (long)(seconds * 1e6);
+	select((int)highest + 1, &fdr, NULL, NULL, &timeout);
+}
+
+/**
+ * @brief Compare two doubles for qsort
+ * @param[in] a
+ * @param[in] b
+ * @return
+ */
+static int LG_CompareTimes(const void *a, const void *b)
+{
+	double d = *(const double *)a - *(const double *)b;
+
+	return d < 0 ? -1 : d > 0;
+}
+
+/**
+ * @brief Print the counters of a period
+ * @param[in] label
+ * @param[in] st
+ * @param[in] seconds
+ */
+static void LG_Print(const char *label, const lgStats_t *st, double seconds)
+{
+	printf("%s sent %7.0f/s answered %7.0f/s (%5.1f%%) probe %ld/%ld avg %7.2f ms max %7.2f ms\n", label,
+	       st->sent / seconds, st->answered / seconds, st->sent ? 100.0 * st->answered / st->sent : 0.0,
+	       st->probeAnswers, st->probes, st->probeAnswers ? st->probeTotal / st->probeAnswers : 0.0, st->probeMax);
+	fflush(stdout);
+}
+
+/**
+ * @brief Print the usage and quit
+ */
+static void LG_Usage(void)
+{
+	fprintf(stderr, "Usage: etlloadgen [-pps n] [-time s] [-sockets n] [-probe ms] [-status] host[:port]\n"
+	        "  -pps n      queries sent per second (default 10000)\n"
+	        "  -time s     seconds to run (default 10)\n"
+	        "  -sockets n  source sockets to spread the queries over (default 8, max %i)\n"
+	        "  -probe ms   interval of the getchallenge probes of the main loop latency (default 100)\n"
+	        "  -status     send getstatus instead of getinfo\n"
+	        "Run the server with sv_protect 0 so the rate limits don't drop the load.\n", LG_MAX_SOCKETS);
+	exit(1);
+}
+
+/**
+ * @brief main
+ * @param[in] argc
+ * @param[in] argv
+ * @return
+ */
+int main(int argc, char **argv)
+{
+	struct sockaddr_in to;
+	struct addrinfo    hints, *res;
+	const char         *host  = NULL;
+	const char         *query = "getinfo";
+	char               hostname[256], text[64], *port;
+	double             pps = 10000, duration = 10, probeInterval = 0.1;
+	double             start, now, nextSend, nextProbe, nextReport, lastReport;
+	long               queries = 0;
+	int                i;
+#ifdef _WIN32
+	WSADATA wsaData;
+
+	WSAStartup(MAKEWORD(2, 2), &wsaData);
+#endif
+
+	for (i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-pps") && i + 1 < argc)
+		{
+			pps = atof(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-time") && i + 1 < argc)
+		{
+			duration = atof(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-sockets") && i + 1 < argc)
+		{
+			numSockets = atoi(argv[++i]);
+		}
+		else if (!strcmp(argv[i], "-probe") && i + 1 < argc)
+		{
+			probeInterval = atof(argv[++i]) / 1000;
+		}
+		else if (!strcmp(argv[i], "-status"))
+		{
+			query = "getstatus";
+		}
+		else if (argv[i][0] == '-' || host)
+		{
+			LG_Usage();
+		}
+		else
+		{
+			host = argv[i];
+		}
+	}
+
+	if (!host || pps <= 0 || duration <= 0 || probeInterval <= 0 || numSockets < 1 || numSockets > LG_MAX_SOCKETS)
+	{
+		LG_Usage();
+	}
+
+	snprintf(hostname, sizeof(hostname), "%s", host);
+	port = strchr(hostname, ':');
+	if (port)
+	{
+		*port++ = '\0';
+	}
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family   = AF_INET;
+	hints.ai_socktype = SOCK_DGRAM;
+	if (getaddrinfo(hostname, NULL, &hints, &res) || !res)
+	{
+		fprintf(stderr, "etlloadgen: can't resolve %s\n", hostname);
+		return 1;
+	}
+	memcpy(&to, res->ai_addr, sizeof(to));
+	to.sin_port = htons((unsigned short)(port ? atoi(port) : LG_DEFAULT_PORT));
+	freeaddrinfo(res);
+
+	probeSocket = LG_OpenSocket();
+	for (i = 0; i < numSockets; i++)
+	{
+		sockets[i] = LG_OpenSocket();
+		if (sockets[i] == INVALID_SOCKET)
+		{
+			probeSocket = INVALID_SOCKET;
+			break;
+		}
+	}
+	if (probeSocket == INVALID_SOCKET)
+	{
+		fprintf(stderr, "etlloadgen: can't open the sockets\n");
+		return 1;
+	}
+
+	printf("%s to %s:%i at %.0f/s from %i sockets for %.0f s, probing every %.0f ms\n", query, hostname,
+	       ntohs(to.sin_port), pps, numSockets, duration, probeInterval * 1000);
+
+	start      = LG_Time();
+	nextSend   = start;
+	nextProbe  = start;
+	lastReport = start;
+	nextReport = start + 1;
+
+	while ((now = LG_Time()) < start + duration)
+	{
+		// catch up with the schedule, but don't burst more than 10 ms of it at once
+		if (nextSend < now - 0.01)
+		{
+			nextSend = now - 0.01;
+		}
+		while (nextSend <= now)
+		{
+			snprintf(text, sizeof(text), "%s %ld", query, queries);
+			if (LG_Send(sockets[queries % numSockets], &to, text))
+			{
+				total.sent++;
+				second.sent++;
+			}
+			queries++;
+			nextSend += 1 / pps;
+		}
+
+		if (now >= nextProbe)
+		{
+			// an unanswered probe counts as lost
+			probeSent = now;
+			LG_Send(probeSocket, &to, "getchallenge");
+			total.probes++;
+			second.probes++;
+			nextProbe = now + probeInterval;
+		}
+
+		LG_Receive(LG_Time());
+
+		if (now >= nextReport)
+		{
+			LG_Print("     ", &second, now - lastReport);
+			memset(&second, 0, sizeof(second));
+			lastReport = now;
+			nextReport = now + 1;
+		}
+
+		now = LG_Time();
+		if (nextSend > now)
+		{
+			LG_Wait(nextSend - now < 0.001 ? nextSend - now : 0.001);
+		}
+	}
+
+	// late answers
+	LG_Wait(0.2);
+	LG_Receive(LG_Time());
+
+	LG_Print("total", &total, duration);
+
+	if (numProbeTimes)
+	{
+		qsort(probeTimes, numProbeTimes, sizeof(probeTimes[0]), LG_CompareTimes);
+		printf("probe round trip: median %.2f ms, 99%% %.2f ms, lost %ld of %ld\n", probeTimes[numProbeTimes / 2],
+		       probeTimes[(numProbeTimes * 99) / 100], total.probes - total.probeAnswers, total.probes);
+	}
+
+	for (i = 0; i < numSockets; i++)
+	{
+		LG_CLOSE(sockets[i]);
+	}
+	LG_CLOSE(probeSocket);
+
+#ifdef _WIN32
+	WSACleanup();
+#endif
+	return 0;
+}
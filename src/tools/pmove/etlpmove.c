@@ -0,0 +1,1131 @@
+/*
+ * ET: Legacy
+ * Copyright (C) 2012-2018 ET:Legacy team <mail@etlegacy.com>
+ *
+ * This file is part of ET: Legacy - http://www.etlegacy.com
+ *
+ * ET: Legacy is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * ET: Legacy is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with ET: Legacy. If not, see <http://www.gnu.org/licenses/>.
+ *
+ * In addition, Wolfenstein: Enemy Territory GPL Source Code is also
+ * subject to certain additional terms. You should have received a copy
+ * of these additional terms immediately following the terms and conditions
+ * of the GNU General Public License which accompanied the source code.
+ * If not, please request a copy in writing from id Software at the address below.
+ *
+ * id Software LLC, c/o ZeniMax Media Inc., Suite 120, Rockville, Maryland 20850 USA.
+ */
+/**
+ * @file etlpmove.c
+ * @brief Deterministic Pmove replay harness and benchmark
+ *
+ * Loads the map of a server-side demo through the collision code and replays the usercmds
+ * it recorded (sv_demoUsercmds 1) through the game Pmove, without a server or a game module.
+ * Only the world is clipped against, the entities of the demo are left out.
+ *
+ * Every client gets a stream of usercmds per keyframe interval, starting from the playerstate
+ * recorded right before the first of them, so the replay can't wander too far from the game.
+ * The streams are replayed once to hash the playerstate after every move, which is written to
+ * or checked against a golden file, then timed for a few passes.
+ *
+ * -nomemo replays without the trace memo of Pmove, verifying a golden file recorded with it
+ * checks the memo doesn't change any move.
+ *
+ * Usage: etlpmove [-basepath dir] [-bsp file] [-passes n] [-nomemo] [-record file | -verify file] demo
+ */
+
+#include "../../qcommon/q_shared.h"
+#include "../../qcommon/qcommon.h"
+#include "../../game/bg_public.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+#define PM_BLOCK_MAGIC      0x425a5445  ///< FS_BLOCK_MAGIC of files.c
+#define PM_MAX_CVARS        32
+
+/// Demo markers of sv_demo.c, only the ones the replay needs
+typedef enum
+{
+	pm_demo_endDemo,
+	pm_demo_EOF,
+	pm_demo_endFrame,
+	pm_demo_playerState   = 11,
+	pm_demo_keyframe      = 12,
+	pm_demo_clientUsercmd = 13,
+} pmDemoOps_t;
+
+/**
+ * @struct pmStream_t
+ * @brief The usercmds of a client from a recorded playerstate on
+ */
+typedef struct
+{
+	int clientNum;
+	playerState_t start;
+	usercmd_t *cmds;
+	int numCmds;
+	int maxCmds;
+} pmStream_t;
+
+/**
+ * @struct pmClient_t
+ * @brief Demo parsing state of a client slot
+ */
+typedef struct
+{
+	playerState_t baseline;     ///< what the next playerstate is delta'd from
+	playerState_t ps;           ///< last playerstate, valid while the client is in the game
+	qboolean valid;
+	qboolean seen;              ///< a playerstate was recorded this frame
+	int stream;                 ///< stream the usercmds go to, -1 starts a new one
+} pmClient_t;
+
+cvar_t *cl_shownet = NULL;      ///< referenced by msg.c
+
+// Pmove settings, the game defaults
+vmCvar_t g_developer        = { 0, 0, 0.f, 0, "0" };
+vmCvar_t team_riflegrenades = { 0, 0, 1.f, 1, "1" };
+vmCvar_t g_fixedphysics     = { 0, 0, 1.f, 1, "1" };
+vmCvar_t g_fixedphysicsfps  = { 0, 0, 125.f, 125, "125" };
+vmCvar_t g_pronedelay       = { 0, 0, 0.f, 0, "0" };
+
+void trap_Cvar_Set(const char *varName, const char *value);
+void trap_SnapVector(float *v);
+void ClientStoreSurfaceFlags(int clientNum, int surfaceFlags);
+
+static const char *pm_basepath = ".";
+
+static cvar_t pm_cvars[PM_MAX_CVARS];
+static int    pm_numCvars;
+
+static pmStream_t *pm_streams;
+static int        pm_numStreams;
+static int        pm_maxStreams;
+static int        pm_numMoves;
+
+static pmClient_t pm_clients[MAX_CLIENTS];
+
+static char pm_mapname[MAX_QPATH];
+static int  pm_gametype;
+
+static int      pm_numTraces;
+static int      pm_numTraceHits;
+static int      pm_numPointContents;
+static qboolean pm_noTraceMemo;
+
+static animScriptData_t pm_animScriptData;
+static animModelInfo_t  pm_animModelInfo;
+static bg_character_t   pm_character;
+
+/*
+=======================================================================
+ENGINE GLUE
+=======================================================================
+*/
+
+/**
+ * @brief Any error ends the replay
+ * @param code - unused
+ * @param[in] fmt
+ */
+void QDECL Com_Error(int code, const char *fmt, ...)
+{
+	va_list argptr;
+	char    text[MAX_STRING_CHARS];
+
+	va_start(argptr, fmt);
+	Q_vsnprintf(text, sizeof(text), fmt, argptr);
+	va_end(argptr);
+
+	fprintf(stderr, "etlpmove: %s\n", text);
+	exit(1);
+}
+
+/**
+ * @brief Com_Printf
+ * @param[in] fmt
+ */
+void QDECL Com_Printf(const char *fmt, ...)
+{
+	va_list argptr;
+
+	va_start(argptr, fmt);
+	vfprintf(stderr, fmt, argptr);
+	va_end(argptr);
+}
+
+/**
+ * @brief Com_DPrintf
+ * @param fmt - unused
+ */
+void QDECL Com_DPrintf(const char *fmt, ...)
+{
+}
+
+#ifdef ETLEGACY_DEBUG
+/**
+ * @brief The message benchmarks aren't registered in the tool
+ * @return
+ */
+int Cmd_Argc(void)
+{
+	return 0;
+}
+
+/**
+ * @brief Cmd_Argv
+ * @param arg - unused
+ * @return
+ */
+char *Cmd_Argv(int arg)
+{
+	return "";
+}
+
+/**
+ * @brief Only used by the message benchmarks
+ * @return
+ */
+int Sys_Milliseconds(void)
+{
+	return 0;
+}
+
+void trap_Cvar_VariableStringBuffer(const char *varName, char *buffer, int bufsize);
+
+/**
+ * @brief The debug cvars of the game are off
+ * @param varName - unused
+ * @param[out] buffer
+ * @param[in] bufsize
+ */
+void trap_Cvar_VariableStringBuffer(const char *varName, char *buffer, int bufsize)
+{
+	if (bufsize > 0)
+	{
+		buffer[0] = '\0';
+	}
+}
+#endif
+
+/**
+ * @brief The collision code cvars keep their default value
+ * @param[in] varName
+ * @param[in] value
+ * @param flags - unused
+ * @return
+ */
+cvar_t *Cvar_Get(const char *varName, const char *value, int flags)
+{
+	cvar_t *var;
+	int    i;
+
+	for (i = 0; i < pm_numCvars; i++)
+	{
+		if (!Q_stricmp(pm_cvars[i].name, varName))
+		{
+			return &pm_cvars[i];
+		}
+	}
+
+	if (pm_numCvars == PM_MAX_CVARS)
+	{
+		Com_Error(ERR_FATAL, "Cvar_Get: too many cvars");
+	}
+
+	var          = &pm_cvars[pm_numCvars++];
+	var->name    = (char *)varName;
+	var->string  = (char *)value;
+	var->value   = (float)atof(value);
+	var->integer = atoi(value);
+
+	return var;
+}
+
+#ifdef HUNK_DEBUG
+/**
+ * @brief The map stays loaded until the tool exits
+ * @param[in] size
+ * @param preference - unused
+ * @param label - unused
+ * @param file - unused
+ * @param line - unused
+ * @return
+ */
+void *Hunk_AllocDebug(unsigned int size, ha_pref preference, char *label, char *file, int line)
+#else
+/**
+ * @brief The map stays loaded until the tool exits
+ * @param[in] size
+ * @param preference - unused
+ * @return
+ */
+void *Hunk_Alloc(unsigned int size, ha_pref preference)
+#endif
+{
+	void *buf = calloc(1, size);
+
+	if (!buf)
+	{
+		Com_Error(ERR_FATAL, "Hunk_Alloc: failed on allocation of %u bytes", size);
+	}
+
+	return buf;
+}
+
+/**
+ * @brief Hunk_SetTag
+ * @param[in] tag
+ * @return
+ */
+hunkTag_t Hunk_SetTag(hunkTag_t tag)
+{
+	return tag;
+}
+
+#ifdef ZONE_DEBUG
+/**
+ * @brief Z_MallocDebug
+ * @param[in] size
+ * @param label - unused
+ * @param file - unused
+ * @param line - unused
+ * @return
+ */
+void *Z_MallocDebug(int size, char *label, char *file, int line)
+#else
+/**
+ * @brief Z_Malloc
+ * @param[in] size
+ * @return
+ */
+void *Z_Malloc(int size)
+#endif
+{
+	void *buf = calloc(1, size);
+
+	if (!buf)
+	{
+		Com_Error(ERR_FATAL, "Z_Malloc: failed on allocation of %i bytes", size);
+	}
+
+	return buf;
+}
+
+/**
+ * @brief Z_Free
+ * @param[in] ptr
+ */
+void Z_Free(void *ptr)
+{
+	free(ptr);
+}
+
+/**
+ * @brief Read a file as given, or from the base path
+ * @param[in] qpath
+ * @param[out] buffer
+ * @return Length of the file, -1 when it can't be read
+ */
+int FS_ReadFile(const char *qpath, void **buffer)
+{
+	char path[MAX_OSPATH];
+	FILE *f;
+	long len;
+	byte *buf;
+
+	f = fopen(qpath, "rb");
+	if (!f)
+	{
+		Com_sprintf(path, sizeof(path), "%s/%s", pm_basepath, qpath);
+		f = fopen(path, "rb");
+	}
+
+	if (!f)
+	{
+		if (buffer)
+		{
+			*buffer = NULL;
+		}
+		return -1;
+	}
+
+	fseek(f, 0, SEEK_END);
+	len = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	if (!buffer || len < 0)
+	{
+		fclose(f);
+		return (int)len;
+	}
+
+	buf = (byte *)malloc(len + 1);
+	if (!buf || (long)fread(buf, 1, len, f) != len)
+	{
+		free(buf);
+		fclose(f);
+		*buffer = NULL;
+		return -1;
+	}
+	fclose(f);
+
+	buf[len] = 0;
+	*buffer  = buf;
+
+	return (int)len;
+}
+
+/**
+ * @brief FS_FreeFile
+ * @param[in] buffer
+ */
+void FS_FreeFile(void *buffer)
+{
+	free(buffer);
+}
+
+/**
+ * @brief The Pmove settings are fixed
+ * @param varName - unused
+ * @param value - unused
+ */
+void trap_Cvar_Set(const char *varName, const char *value)
+{
+}
+
+/**
+ * @brief Same as the engine Sys_SnapVector
+ * @param[in,out] v
+ */
+void trap_SnapVector(float *v)
+{
+	v[0] = (float)rint(v[0]);
+	v[1] = (float)rint(v[1]);
+	v[2] = (float)rint(v[2]);
+}
+
+/**
+ * @brief Nothing to store without the game
+ * @param clientNum - unused
+ * @param surfaceFlags - unused
+ */
+void ClientStoreSurfaceFlags(int clientNum, int surfaceFlags)
+{
+}
+
+/**
+ * @brief No script parsing, the animations of the characters aren't loaded
+ * @param filename - unused
+ * @return
+ */
+int trap_PC_LoadSource(const char *filename)
+{
+	return 0;
+}
+
+/**
+ * @brief trap_PC_FreeSource
+ * @param handle - unused
+ * @return
+ */
+int trap_PC_FreeSource(int handle)
+{
+	return 0;
+}
+
+/**
+ * @brief trap_PC_ReadToken
+ * @param handle - unused
+ * @param pc_token - unused
+ * @return
+ */
+int trap_PC_ReadToken(int handle, pc_token_t *pc_token)
+{
+	return 0;
+}
+
+/**
+ * @brief trap_PC_SourceFileAndLine
+ * @param handle - unused
+ * @param filename - unused
+ * @param line - unused
+ * @return
+ */
+int trap_PC_SourceFileAndLine(int handle, char *filename, int *line)
+{
+	return 0;
+}
+
+/**
+ * @brief Monotonic clock in nanoseconds
+ * @return
+ */
+static int64_t PM_Nanoseconds(void)
+{
+#ifdef _WIN32
+	static LARGE_INTEGER frequency;
+	LARGE_INTEGER        counter;
+
+	if (!frequency.QuadPart)
+	{
+		QueryPerformanceFrequency(&frequency);
+	}
+	QueryPerformanceCounter(&counter);
+
+	return (int64_t)((double)counter.QuadPart * 1000000000.0 / (double)frequency.QuadPart);
+#else
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+#endif
+}
+
+/*
+=======================================================================
+DEMO PARSING
+=======================================================================
+*/
+
+/**
+ * @brief Load a whole file
+ * @param[in] path
+ * @param[out] size
+ * @return
+ */
+static byte *PM_LoadFile(const char *path, long *size)
+{
+	FILE *f = fopen(path, "rb");
+	byte *data;
+
+	if (!f)
+	{
+		return NULL;
+	}
+
+	fseek(f, 0, SEEK_END);
+	*size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+
+	data = *size > 0 ? (byte *)malloc(*size) : NULL;
+	if (!data || (long)fread(data, 1, *size, f) != *size)
+	{
+		free(data);
+		fclose(f);
+		return NULL;
+	}
+	fclose(f);
+
+	return data;
+}
+
+/**
+ * @brief Read the meta datas of the demo header (see SV_DemoWriteHeader)
+ * @param[in] msg
+ */
+static void PM_ParseHeader(msg_t *msg)
+{
+	char key[MAX_STRING_CHARS];
+
+	while (1)
+	{
+		Q_strncpyz(key, MSG_ReadString(msg), sizeof(key));
+
+		if (!key[0] || !Q_stricmp(key, "endMeta"))
+		{
+			break;
+		}
+		else if (!Q_stricmp(key, "clients"))
+		{
+			MSG_ReadByte(msg);
+		}
+		else if (!Q_stricmp(key, "map"))
+		{
+			Q_strncpyz(pm_mapname, MSG_ReadString(msg), sizeof(pm_mapname));
+		}
+		else if (!Q_stricmp(key, "g_gametype"))
+		{
+			pm_gametype = MSG_ReadLong(msg);
+		}
+		else if (!Q_stricmp(key, "fs_game") || !Q_stricmp(key, "hostname") || !Q_stricmp(key, "datetime"))
+		{
+			MSG_ReadString(msg);
+		}
+		else
+		{
+			MSG_ReadLong(msg);
+		}
+	}
+
+	if (!pm_mapname[0])
+	{
+		Com_Error(ERR_FATAL, "no map in the demo header");
+	}
+}
+
+/**
+ * @brief Add usercmds to the stream of a client, starting one from its last playerstate if needed
+ * @param[in] msg
+ */
+static void PM_ParseUsercmds(msg_t *msg)
+{
+	int        clientNum = MSG_ReadByte(msg);
+	int        count     = MSG_ReadByte(msg);
+	pmClient_t *cl;
+	pmStream_t *stream = NULL;
+	usercmd_t  oldcmd, cmd;
+	int        i;
+
+	if (clientNum < 0 || clientNum >= MAX_CLIENTS)
+	{
+		Com_Error(ERR_FATAL, "bad usercmd client %i", clientNum);
+	}
+	cl = &pm_clients[clientNum];
+
+	// a client without a playerstate yet has nothing to start from
+	if (cl->valid)
+	{
+		if (cl->stream < 0)
+		{
+			if (pm_numStreams == pm_maxStreams)
+			{
+				pm_maxStreams = pm_maxStreams ? pm_maxStreams * 2 : 256;
+				pm_streams    = (pmStream_t *)realloc(pm_streams, pm_maxStreams * sizeof(*pm_streams));
+				if (!pm_streams)
+				{
+					Com_Error(ERR_FATAL, "out of memory");
+				}
+			}
+
+			cl->stream = pm_numStreams++;
+			stream     = &pm_streams[cl->stream];
+			Com_Memset(stream, 0, sizeof(*stream));
+			stream->clientNum = clientNum;
+			stream->start     = cl->ps;
+		}
+
+		stream = &pm_streams[cl->stream];
+	}
+
+	Com_Memset(&oldcmd, 0, sizeof(oldcmd));
+	for (i = 0; i < count; i++)
+	{
+		MSG_ReadDeltaUsercmdKey(msg, 0, &oldcmd, &cmd);
+		oldcmd = cmd;
+
+		if (!stream)
+		{
+			continue;
+		}
+
+		if (stream->numCmds == stream->maxCmds)
+		{
+			stream->maxCmds = stream->maxCmds ? stream->maxCmds * 2 : 1024;
+			stream->cmds    = (usercmd_t *)realloc(stream->cmds, stream->maxCmds * sizeof(*stream->cmds));
+			if (!stream->cmds)
+			{
+				Com_Error(ERR_FATAL, "out of memory");
+			}
+		}
+		stream->cmds[stream->numCmds++] = cmd;
+		pm_numMoves++;
+	}
+}
+
+/**
+ * @brief Split the demo in usercmd streams
+ * @param[in] path
+ */
+static void PM_ParseDemo(const char *path)
+{
+	byte     *file;
+	long     size, offset = 0;
+	msg_t    msg;
+	int      len, cmd, i;
+	qboolean header = qtrue;
+
+	file = PM_LoadFile(path, &size);
+	if (!file)
+	{
+		Com_Error(ERR_FATAL, "couldn't read %s", path);
+	}
+
+	if (size >= 4 && LittleLong(*(int *)file) == PM_BLOCK_MAGIC)
+	{
+		Com_Error(ERR_FATAL, "%s is block compressed, convert it with unpackFile first", path);
+	}
+
+	for (i = 0; i < MAX_CLIENTS; i++)
+	{
+		pm_clients[i].stream = -1;
+	}
+
+	while (offset + 4 <= size)
+	{
+		Com_Memcpy(&len, file + offset, 4);
+		len     = LittleLong(len);
+		offset += 4;
+
+		if (len <= 0 || len > size - offset)
+		{
+			Com_Error(ERR_FATAL, "%s is truncated", path);
+		}
+
+		MSG_Init(&msg, file + offset, len);
+		msg.cursize = len;
+		offset     += len;
+
+		if (header)
+		{
+			PM_ParseHeader(&msg);
+			header = qfalse;
+			continue;
+		}
+
+		// a message holds one kind of event, the others are of no use here
+		cmd = MSG_ReadByte(&msg);
+
+		switch (cmd)
+		{
+		case pm_demo_playerState:
+			do
+			{
+				i = MSG_ReadByte(&msg);
+				if (i < 0 || i >= MAX_CLIENTS)
+				{
+					Com_Error(ERR_FATAL, "bad playerstate client %i", i);
+				}
+
+				MSG_ReadDeltaPlayerstate(&msg, &pm_clients[i].baseline, &pm_clients[i].ps);
+				pm_clients[i].baseline = pm_clients[i].ps;
+				pm_clients[i].valid    = qtrue;
+				pm_clients[i].seen     = qtrue;
+			}
+			while (MSG_ReadByte(&msg) == pm_demo_playerState);
+			break;
+		case pm_demo_clientUsercmd:
+			PM_ParseUsercmds(&msg);
+			break;
+		case pm_demo_keyframe:
+			// the playerstates are delta'd from zero again, and the streams restart from them
+			for (i = 0; i < MAX_CLIENTS; i++)
+			{
+				Com_Memset(&pm_clients[i].baseline, 0, sizeof(pm_clients[i].baseline));
+				pm_clients[i].stream = -1;
+			}
+			break;
+		case pm_demo_endFrame:
+			// clients left out of the frame aren't in the game anymore
+			for (i = 0; i < MAX_CLIENTS; i++)
+			{
+				if (!pm_clients[i].seen)
+				{
+					pm_clients[i].valid  = qfalse;
+					pm_clients[i].stream = -1;
+				}
+				pm_clients[i].seen = qfalse;
+			}
+			break;
+		case pm_demo_endDemo:
+			offset = size;
+			break;
+		default:
+			break;
+		}
+	}
+
+	free(file);
+}
+
+/*
+=======================================================================
+REPLAY
+=======================================================================
+*/
+
+/**
+ * @brief World only trap_TraceCapsule, as SV_ClipMoveToWorld
+ * @param[out] results
+ * @param[in] start
+ * @param[in] mins
+ * @param[in] maxs
+ * @param[in] end
+ * @param passEntityNum - unused
+ * @param[in] contentMask
+ */
+static void PM_Trace(trace_t *results, const vec3_t start, const vec3_t mins, const vec3_t maxs, const vec3_t end, int passEntityNum, int contentMask)
+{
+	pm_numTraces++;
+
+	CM_BoxTrace(results, start, end, mins ? mins : vec3_origin, maxs ? maxs : vec3_origin, 0, contentMask, qtrue);
+	results->entityNum = results->fraction != 1.0f ? ENTITYNUM_WORLD : ENTITYNUM_NONE;
+}
+
+/**
+ * @brief World only trap_PointContents
+ * @param[in] point
+ * @param passEntityNum - unused
+ * @return
+ */
+static int PM_PointContents(const vec3_t point, int passEntityNum)
+{
+	pm_numPointContents++;
+
+	return CM_PointContents(point, 0);
+}
+
+/**
+ * @brief Characters without animations, the animation conditions of the clients are still updated by Pmove
+ */
+static void PM_InitCharacter(void)
+{
+	char script[1] = "";
+
+	BG_AnimParseAnimScript(&pm_animModelInfo, &pm_animScriptData, "etlpmove", script);
+	pm_character.animModelInfo = &pm_animModelInfo;
+}
+
+/**
+ * @brief FNV-1a hash of a playerstate
+ * @param[in] ps
+ * @return
+ */
+static unsigned long long PM_HashPlayerState(const playerState_t *ps)
+{
+	const byte         *p   = (const byte *)ps;
+	unsigned long long hash = 14695981039346656037ULL;
+	size_t             i;
+
+	for (i = 0; i < sizeof(*ps); i++)
+	{
+		hash ^= p[i];
+		hash *= 1099511628211ULL;
+	}
+
+	return hash;
+}
+
+/**
+ * @brief Replay a stream the way ClientThink_real sets up Pmove
+ * @param[in] stream
+ * @param[out] hashes playerstate hash after each move, NULL when timing
+ */
+static void PM_ReplayStream(const pmStream_t *stream, unsigned long long *hashes)
+{
+	int           skill[SK_NUM_SKILLS];
+	playerState_t ps = stream->start;
+	pmoveExt_t    pmext;
+	pmove_t       pm;
+	usercmd_t     oldcmd;
+	int           i;
+
+	Com_Memset(&pmext, 0, sizeof(pmext));
+	Com_Memset(&oldcmd, 0, sizeof(oldcmd));
+	Com_Memset(skill, 0, sizeof(skill));
+
+	for (i = 0; i < stream->numCmds; i++)
+	{
+		Com_Memset(&pm, 0, sizeof(pm));
+
+		pm.ps        = &ps;
+		pm.pmext     = &pmext;
+		pm.character = &pm_character;
+		pm.cmd       = stream->cmds[i];
+		pm.oldcmd    = oldcmd;
+		pm.trace     = PM_Trace;
+		if (ps.pm_type == PM_DEAD)
+		{
+			pm.tracemask = MASK_PLAYERSOLID & ~CONTENTS_BODY;
+			ps.eFlags   |= EF_DEAD;
+		}
+		else if (ps.pm_type != PM_SPECTATOR)
+		{
+			pm.tracemask = MASK_PLAYERSOLID;
+		}
+		pm.pointcontents = PM_PointContents;
+		pm.pmove_msec    = 8;
+		pm.noTraceMemo   = pm_noTraceMemo;
+
+		pm.gametype            = pm_gametype;
+		pm.ltChargeTime        = 40000;
+		pm.soldierChargeTime   = 20000;
+		pm.engineerChargeTime  = 30000;
+		pm.medicChargeTime     = 45000;
+		pm.covertopsChargeTime = 30000;
+		pm.skill               = skill;
+
+		pmext.airleft = HOLDBREATHTIME;
+
+		Pmove(&pm);
+		pm_numTraceHits += pm.numTraceHits;
+
+		oldcmd = stream->cmds[i];
+
+		if (hashes)
+		{
+			hashes[i] = PM_HashPlayerState(&ps);
+		}
+	}
+}
+
+/**
+ * @brief Replay every stream once, writing or checking the playerstate hashes
+ * @param[in] record golden file to write, or NULL
+ * @param[in] verify golden file to check, or NULL
+ * @return Number of moves which don't match the golden file
+ */
+static int PM_Check(FILE *record, FILE *verify)
+{
+	unsigned long long *hashes, golden;
+	char               line[128];
+	int                i, j, clientNum, serverTime, mismatches = 0;
+	qboolean           ended = qfalse;
+
+	if (record)
+	{
+		fprintf(record, "# etlpmove %s %i streams %i moves\n", pm_mapname, pm_numStreams, pm_numMoves);
+	}
+
+	for (i = 0; i < pm_numStreams; i++)
+	{
+		hashes = (unsigned long long *)malloc(MAX(pm_streams[i].numCmds, 1) * sizeof(*hashes));
+		if (!hashes)
+		{
+			Com_Error(ERR_FATAL, "out of memory");
+		}
+
+		PM_ReplayStream(&pm_streams[i], hashes);
+
+		for (j = 0; j < pm_streams[i].numCmds; j++)
+		{
+			if (record)
+			{
+				fprintf(record, "%i %i %016llx\n", pm_streams[i].clientNum, pm_streams[i].cmds[j].serverTime, hashes[j]);
+			}
+
+			if (!verify || ended)
+			{
+				continue;
+			}
+
+			do
+			{
+				if (!fgets(line, sizeof(line), verify))
+				{
+					Com_Printf("golden file ends before stream %i move %i\n", i, j);
+					ended = qtrue;
+					mismatches++;
+					break;
+				}
+			}
+			while (line[0] == '#');
+
+			if (ended)
+			{
+				continue;
+			}
+
+			if (sscanf(line, "%i %i %llx", &clientNum, &serverTime, &golden) != 3
+			    || clientNum != pm_streams[i].clientNum || serverTime != pm_streams[i].cmds[j].serverTime)
+			{
+				Com_Error(ERR_FATAL, "golden file doesn't match the demo at stream %i move %i", i, j);
+			}
+
+			if (golden != hashes[j])
+			{
+				if (!mismatches)
+				{
+					Com_Printf("first mismatch: stream %i move %i, client %i serverTime %i\n", i, j, clientNum, serverTime);
+				}
+				mismatches++;
+			}
+		}
+
+		free(hashes);
+	}
+
+	if (verify && !ended && fgets(line, sizeof(line), verify))
+	{
+		Com_Printf("golden file has more moves than the demo\n");
+		mismatches++;
+	}
+
+	return mismatches;
+}
+
+/**
+ * @brief Replay every stream and time it
+ * @return Nanoseconds
+ */
+static int64_t PM_Time(void)
+{
+	int64_t start = PM_Nanoseconds();
+	int     i;
+
+	for (i = 0; i < pm_numStreams; i++)
+	{
+		PM_ReplayStream(&pm_streams[i], NULL);
+	}
+
+	return PM_Nanoseconds() - start;
+}
+
+/*
+=======================================================================
+MAIN
+=======================================================================
+*/
+
+/**
+ * @brief Print usage and exit
+ */
+static void PM_Usage(void)
+{
+	fprintf(stderr, "usage: etlpmove [-basepath dir] [-bsp file] [-passes n] [-nomemo] [-record file | -verify file] demo\n");
+	exit(1);
+}
+
+/**
+ * @brief main
+ * @param[in] argc
+ * @param[in] argv
+ * @return
+ */
+int main(int argc, char **argv)
+{
+	const char   *demo = NULL, *bsp = NULL, *recordPath = NULL, *verifyPath = NULL;
+	FILE         *record = NULL, *verify = NULL;
+	char         mapPath[MAX_QPATH];
+	unsigned int checksum;
+	int          passes = 3, mismatches, traces, traceHits, pointContents, i;
+	int64_t      nsec, best = 0;
+
+	for (i = 1; i < argc; i++)
+	{
+		if (!strcmp(argv[i], "-basepath") && i + 1 < argc)
+		{
+			pm_basepath = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-bsp") && i + 1 < argc)
+		{
+			bsp = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-passes") && i + 1 < argc)
+		{
+			passes = MAX(atoi(argv[++i]), 1);
+		}
+		else if (!strcmp(argv[i], "-nomemo"))
+		{
+			pm_noTraceMemo = qtrue;
+		}
+		else if (!strcmp(argv[i], "-record") && i + 1 < argc)
+		{
+			recordPath = argv[++i];
+		}
+		else if (!strcmp(argv[i], "-verify") && i + 1 < argc)
+		{
+			verifyPath = argv[++i];
+		}
+		else if (argv[i][0] == '-' || demo)
+		{
+			PM_Usage();
+		}
+		else
+		{
+			demo = argv[i];
+		}
+	}
+
+	if (!demo || (recordPath && verifyPath))
+	{
+		PM_Usage();
+	}
+
+	PM_ParseDemo(demo);
+
+	if (!bsp)
+	{
+		Com_sprintf(mapPath, sizeof(mapPath), "maps/%s.bsp", pm_mapname);
+		bsp = mapPath;
+	}
+	CM_LoadMap(bsp, qfalse, &checksum);
+	PM_InitCharacter();
+
+	if (!pm_numMoves)
+	{
+		Com_Error(ERR_FATAL, "%s has no usercmds, record it with sv_demoUsercmds 1", demo);
+	}
+
+	if (recordPath)
+	{
+		record = fopen(recordPath, "w");
+		if (!record)
+		{
+			Com_Error(ERR_FATAL, "couldn't write %s", recordPath);
+		}
+	}
+	if (verifyPath)
+	{
+		verify = fopen(verifyPath, "r");
+		if (!verify)
+		{
+			Com_Error(ERR_FATAL, "couldn't read %s", verifyPath);
+		}
+	}
+
+	// the checked pass also warms up the caches, the traces are counted there
+	mismatches    = PM_Check(record, verify);
+	traces        = pm_numTraces;
+	traceHits     = pm_numTraceHits;
+	pointContents = pm_numPointContents;
+
+	if (record)
+	{
+		fclose(record);
+	}
+	if (verify)
+	{
+		fclose(verify);
+	}
+
+	for (i = 0; i < passes; i++)
+	{
+		nsec = PM_Time();
+		if (!i || nsec < best)
+		{
+			best = nsec;
+		}
+	}
+
+	printf("etlpmove: %s, %i streams, %i moves, %.2f traces/move (%.2f without the trace memo), %.2f pointcontents/move\n",
+	       pm_mapname, pm_numStreams, pm_numMoves, traces / (double)pm_numMoves, (traces + traceHits) / (double)pm_numMoves,
+	       pointContents / (double)pm_numMoves);
+	printf("etlpmove: best of %i passes %.1f ms, %.0f ns/move\n", passes, best / 1000000.0, best / (double)pm_numMoves);
+
+	if (verify)
+	{
+		if (mismatches)
+		{
+			printf("etlpmove: %i moves don't match %s\n", mismatches, verifyPath);
+			return 1;
+		}
+		printf("etlpmove: all moves match %s\n", verifyPath);
+	}
+
+	return 0;
+}